@@ -80,6 +80,16 @@ typedef enum _NTRU_ENCRYPT_PARAM_SET_ID {
 } NTRU_ENCRYPT_PARAM_SET_ID;
 
 
+/* opaque public-key context */
+
+typedef struct _NTRU_ENCRYPT_PUBKEY_CTX NTRU_ENCRYPT_PUBKEY_CTX;
+
+
+/* opaque private-key context */
+
+typedef struct _NTRU_ENCRYPT_PRIVKEY_CTX NTRU_ENCRYPT_PRIVKEY_CTX;
+
+
 /* error codes */
 
 #define NTRU_OK                     0
@@ -99,6 +109,20 @@ typedef enum _NTRU_ENCRYPT_PARAM_SET_ID {
 #define NTRU_RET(r)      return NTRU_RESULT((r))
 
 
+/* required alignment, in octets, of workspaces passed to the *_ex()
+ * functions
+ */
+
+#define NTRU_SCRATCH_ALIGNMENT     16
+
+
+/* no. of octets in a shared key from ntru_crypto_kem_encaps() and
+ * ntru_crypto_kem_decaps()
+ */
+
+#define NTRU_KEM_SHARED_KEY_LEN    32
+
+
 /* function declarations */
 
 /* ntru_crypto_ntru_encrypt
@@ -149,6 +173,192 @@ ntru_crypto_ntru_encrypt(
     uint8_t        *ct);             /*    out - address for ciphertext */
 
 
+/* ntru_crypto_ntru_encrypt_scratch_size
+ *
+ * Returns in scratch_len the number of octets of workspace needed by
+ * ntru_crypto_ntru_encrypt_ex() for the parameter set.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if scratch_len is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_INVALID_PARAMETER_SET if the parameter-set
+ *  ID is invalid.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_scratch_size(
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id, /*  in - parameter set ID */
+    uint32_t                  *scratch_len); /* out - address for no. of
+                                                      octets of workspace */
+
+
+/* ntru_crypto_ntru_encrypt_ex
+ *
+ * Implements NTRU encryption (SVES) as ntru_crypto_ntru_encrypt(), using
+ * a workspace provided by the caller instead of memory allocated from the
+ * heap.
+ *
+ * The workspace must be aligned to NTRU_SCRATCH_ALIGNMENT octets and be
+ * at least the size returned by ntru_crypto_ntru_encrypt_scratch_size()
+ * for the parameter set.  It is cleared before returning.  If scratch is
+ * NULL, memory is allocated from the heap as in ntru_crypto_ntru_encrypt().
+ *
+ * Returns the same values as ntru_crypto_ntru_encrypt(), and:
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  suitably aligned.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_ex(
+    DRBG_HANDLE     drbg_handle,     /*     in - handle for DRBG */
+    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
+                                                 blob */
+    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t        pt_len,          /*     in - no. of octets in plaintext */
+    uint8_t const  *pt,              /*     in - pointer to plaintext */
+    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
+                                                 no. of octets in ciphertext */
+    uint8_t        *ct,              /*    out - address for ciphertext */
+    void           *scratch,         /*     in - workspace, or NULL */
+    uint32_t        scratch_len);    /*     in - no. of octets in workspace */
+
+
+/* ntru_crypto_ntru_encrypt_batch
+ *
+ * Implements NTRU encryption (SVES) of several plaintexts under a single
+ * public key.  The public-key blob is parsed and unpacked once, and a
+ * single scratch buffer is used for all of the encryptions.
+ *
+ * The DRBG requirements are the same as for ntru_crypto_ntru_encrypt().
+ *
+ * The required minimum size of each ciphertext buffer may be queried by
+ * invoking this function with cts = NULL.  In this case, no encryption is
+ * performed, NTRU_OK is returned, and the required minimum size for a
+ * ciphertext is returned in each of the num_msgs elements of ct_lens.
+ *
+ * When cts != NULL, at invocation ct_lens[i] must be the size of the
+ * cts[i] buffer.  Upon return, for each message that was encrypted,
+ * ct_lens[i] is the actual size of the ciphertext.  The status of each
+ * encryption is returned in results[i], using the return codes of
+ * ntru_crypto_ntru_encrypt(); a failure for one message does not stop
+ * the remaining messages from being encrypted.
+ *
+ * Returns NTRU_OK if every message was encrypted successfully.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if one or more messages could not be
+ *  encrypted; results identifies which.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than cts) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len or num_msgs
+ *  is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_batch(
+    DRBG_HANDLE            drbg_handle,     /*     in - handle for DRBG */
+    uint16_t               pubkey_blob_len, /*     in - no. of octets in public
+                                                        key blob */
+    uint8_t const         *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t               num_msgs,        /*     in - no. of plaintexts */
+    uint16_t const        *pt_lens,         /*     in - no. of octets in each
+                                                        plaintext */
+    uint8_t const * const *pts,             /*     in - pointers to
+                                                        plaintexts */
+    uint16_t              *ct_lens,         /* in/out - no. of octets in each
+                                                        ct buffer, addr for
+                                                        no. of octets in each
+                                                        ciphertext */
+    uint8_t * const       *cts,             /*    out - addresses for
+                                                        ciphertexts */
+    uint32_t              *results);        /*    out - status of each
+                                                        encryption */
+
+
+/* ntru_crypto_ntru_encrypt_create_pubkey_ctx
+ *
+ * Creates a public-key context from a public-key blob.  The context holds
+ * the parameter set, the unpacked public key, and the truncated public key
+ * used in forming sData, so that ntru_crypto_ntru_encrypt_with_ctx() does
+ * not need to parse and unpack the blob for each encryption.
+ *
+ * The context does not reference the public-key blob after it is created.
+ * It must be released with ntru_crypto_ntru_encrypt_destroy_pubkey_ctx().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the public key
+ *  uses a parameter set or packing that is not supported.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_create_pubkey_ctx(
+    uint16_t                  pubkey_blob_len, /*  in - no. of octets in public
+                                                        key blob */
+    uint8_t const            *pubkey_blob,     /*  in - pointer to public key */
+    NTRU_ENCRYPT_PUBKEY_CTX **ctx);            /* out - address for pointer to
+                                                        public-key context */
+
+
+/* ntru_crypto_ntru_encrypt_destroy_pubkey_ctx
+ *
+ * Destroys a public-key context created by
+ * ntru_crypto_ntru_encrypt_create_pubkey_ctx().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if ctx is NULL.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_destroy_pubkey_ctx(
+    NTRU_ENCRYPT_PUBKEY_CTX *ctx);  /* in - pointer to public-key context */
+
+
+/* ntru_crypto_ntru_encrypt_with_ctx
+ *
+ * Implements NTRU encryption (SVES) with a public-key context created by
+ * ntru_crypto_ntru_encrypt_create_pubkey_ctx().  Apart from taking the
+ * public key as a context, this behaves as ntru_crypto_ntru_encrypt().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than ct) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pt_len exceeds the
+ *  maximum plaintext length for the parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the ciphertext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_with_ctx(
+    DRBG_HANDLE                    drbg_handle, /*     in - handle for DRBG */
+    NTRU_ENCRYPT_PUBKEY_CTX const *ctx,         /*     in - pointer to
+                                                            public-key
+                                                            context */
+    uint16_t                       pt_len,      /*     in - no. of octets in
+                                                            plaintext */
+    uint8_t const                 *pt,          /*     in - pointer to
+                                                            plaintext */
+    uint16_t                      *ct_len,      /* in/out - no. of octets in
+                                                            ct, addr for no.
+                                                            of octets in
+                                                            ciphertext */
+    uint8_t                       *ct);         /*    out - address for
+                                                            ciphertext */
+
+
 /* ntru_crypto_ntru_decrypt
  *
  * Implements NTRU decryption (SVES) for the parameter set specified in
@@ -190,6 +400,138 @@ ntru_crypto_ntru_decrypt(
     uint8_t       *pt);              /*    out - address for plaintext */
 
 
+/* ntru_crypto_ntru_decrypt_scratch_size
+ *
+ * Returns in scratch_len the number of octets of workspace needed by
+ * ntru_crypto_ntru_decrypt_ex() for the parameter set.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if scratch_len is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_INVALID_PARAMETER_SET if the parameter-set
+ *  ID is invalid.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_decrypt_scratch_size(
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id, /*  in - parameter set ID */
+    uint32_t                  *scratch_len); /* out - address for no. of
+                                                      octets of workspace */
+
+
+/* ntru_crypto_ntru_decrypt_ex
+ *
+ * Implements NTRU decryption (SVES) as ntru_crypto_ntru_decrypt(), using
+ * a workspace provided by the caller instead of memory allocated from the
+ * heap.
+ *
+ * The workspace must be aligned to NTRU_SCRATCH_ALIGNMENT octets and be
+ * at least the size returned by ntru_crypto_ntru_decrypt_scratch_size()
+ * for the parameter set.  It is cleared before returning.  If scratch is
+ * NULL, memory is allocated from the heap as in ntru_crypto_ntru_decrypt().
+ *
+ * Returns the same values as ntru_crypto_ntru_decrypt(), and:
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  suitably aligned.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_decrypt_ex(
+    uint16_t       privkey_blob_len, /*     in - no. of octets in private key
+                                                 blob */
+    uint8_t const *privkey_blob,     /*     in - pointer to private key */
+    uint16_t       ct_len,           /*     in - no. of octets in ciphertext */
+    uint8_t const *ct,               /*     in - pointer to ciphertext */
+    uint16_t      *pt_len,           /* in/out - no. of octets in pt, addr for
+                                                 no. of octets in plaintext */
+    uint8_t       *pt,               /*    out - address for plaintext */
+    void          *scratch,          /*     in - workspace, or NULL */
+    uint32_t       scratch_len);     /*     in - no. of octets in workspace */
+
+
+/* ntru_crypto_ntru_encrypt_create_privkey_ctx
+ *
+ * Creates a private-key context from a private-key blob.  The context holds
+ * the parameter set, the indices of the private key F, the unpacked public
+ * key, and the truncated public key used in forming sData, so that
+ * ntru_crypto_ntru_decrypt_with_ctx() does not need to parse and unpack
+ * the blob for each decryption.
+ *
+ * The context does not reference the private-key blob after it is created.
+ * It must be released with ntru_crypto_ntru_encrypt_destroy_privkey_ctx(),
+ * which clears the key material it holds.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if privkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PRIVATE_KEY if the private-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the private key
+ *  uses a parameter set or packing that is not supported.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_create_privkey_ctx(
+    uint16_t                   privkey_blob_len, /*  in - no. of octets in
+                                                          private key blob */
+    uint8_t const             *privkey_blob,     /*  in - pointer to private
+                                                          key */
+    NTRU_ENCRYPT_PRIVKEY_CTX **ctx);             /* out - address for pointer
+                                                          to private-key
+                                                          context */
+
+
+/* ntru_crypto_ntru_encrypt_destroy_privkey_ctx
+ *
+ * Clears and destroys a private-key context created by
+ * ntru_crypto_ntru_encrypt_create_privkey_ctx().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if ctx is NULL.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_destroy_privkey_ctx(
+    NTRU_ENCRYPT_PRIVKEY_CTX *ctx); /* in - pointer to private-key context */
+
+
+/* ntru_crypto_ntru_decrypt_with_ctx
+ *
+ * Implements NTRU decryption (SVES) with a private-key context created by
+ * ntru_crypto_ntru_encrypt_create_privkey_ctx().  Apart from taking the
+ * private key as a context, this behaves as ntru_crypto_ntru_decrypt().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than pt) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if ct_len is invalid for the
+ *  parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the plaintext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_decrypt_with_ctx(
+    NTRU_ENCRYPT_PRIVKEY_CTX const *ctx,    /*     in - pointer to private-key
+                                                        context */
+    uint16_t                        ct_len, /*     in - no. of octets in
+                                                        ciphertext */
+    uint8_t const                  *ct,     /*     in - pointer to
+                                                        ciphertext */
+    uint16_t                       *pt_len, /* in/out - no. of octets in pt,
+                                                        addr for no. of octets
+                                                        in plaintext */
+    uint8_t                        *pt);    /*    out - address for
+                                                        plaintext */
+
+
 /* ntru_crypto_ntru_encrypt_keygen
  *
  * Implements key generation for NTRUEncrypt for the parameter set specified.
@@ -253,6 +595,167 @@ ntru_crypto_ntru_encrypt_keygen(
                                                              private key blob */
 
 
+/* ntru_crypto_ntru_encrypt_keygen_scratch_size
+ *
+ * Returns in scratch_len the number of octets of workspace needed by
+ * ntru_crypto_ntru_encrypt_keygen_ex() for the parameter set.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if scratch_len is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_INVALID_PARAMETER_SET if the parameter-set
+ *  ID is invalid.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_keygen_scratch_size(
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id, /*  in - parameter set ID */
+    uint32_t                  *scratch_len); /* out - address for no. of
+                                                      octets of workspace */
+
+
+/* ntru_crypto_ntru_encrypt_keygen_ex
+ *
+ * Implements key generation for NTRUEncrypt as
+ * ntru_crypto_ntru_encrypt_keygen(), using a workspace provided by the
+ * caller instead of memory allocated from the heap.
+ *
+ * The workspace must be aligned to NTRU_SCRATCH_ALIGNMENT octets and be
+ * at least the size returned by ntru_crypto_ntru_encrypt_keygen_scratch_size()
+ * for the parameter set.  It is cleared before returning.  If scratch is
+ * NULL, memory is allocated from the heap as in
+ * ntru_crypto_ntru_encrypt_keygen().
+ *
+ * Returns the same values as ntru_crypto_ntru_encrypt_keygen(), and:
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  suitably aligned.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
+ */
+
+NTRUCALL
+ntru_crypto_ntru_encrypt_keygen_ex(
+    DRBG_HANDLE                drbg_handle,      /*     in - handle of DRBG */
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id,     /*     in - parameter set ID */
+    uint16_t                  *pubkey_blob_len,  /* in/out - no. of octets in
+                                                             pubkey_blob, addr
+                                                             for no. of octets
+                                                             in pubkey_blob */
+    uint8_t                   *pubkey_blob,      /*    out - address for
+                                                             public key blob */
+    uint16_t                  *privkey_blob_len, /* in/out - no. of octets in
+                                                             privkey_blob, addr
+                                                             for no. of octets
+                                                             in privkey_blob */
+    uint8_t                   *privkey_blob,     /*    out - address for
+                                                             private key blob */
+    void                      *scratch,          /*     in - workspace, or
+                                                             NULL */
+    uint32_t                   scratch_len);     /*     in - no. of octets in
+                                                             workspace */
+
+
+/* ntru_crypto_kem_keygen
+ *
+ * Generates a key pair for the NTRU key-encapsulation mechanism (KEM).
+ * The key blobs are the same as those of ntru_crypto_ntru_encrypt_keygen(),
+ * which this function calls, and the same requirements and return values
+ * apply.
+ */
+
+NTRUCALL
+ntru_crypto_kem_keygen(
+    DRBG_HANDLE                drbg_handle,      /*     in - handle of DRBG */
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id,     /*     in - parameter set ID */
+    uint16_t                  *pubkey_blob_len,  /* in/out - no. of octets in
+                                                             pubkey_blob, addr
+                                                             for no. of octets
+                                                             in pubkey_blob */
+    uint8_t                   *pubkey_blob,      /*    out - address for
+                                                             public key blob */
+    uint16_t                  *privkey_blob_len, /* in/out - no. of octets in
+                                                             privkey_blob, addr
+                                                             for no. of octets
+                                                             in privkey_blob */
+    uint8_t                   *privkey_blob);    /*    out - address for
+                                                             private key blob */
+
+
+/* ntru_crypto_kem_encaps
+ *
+ * Encapsulates a shared key under a public key.  A secret of
+ * sec_strength_len octets is generated from the DRBG, in the same request
+ * as the random string b used by SVES, and encrypted as the plaintext;
+ * the shared key is the SHA-256 digest of the secret followed by the
+ * ciphertext, so that it is bound to the ciphertext.
+ *
+ * The DRBG requirements are the same as for ntru_crypto_ntru_encrypt().
+ *
+ * The required minimum size of the output ciphertext buffer (ct) may be
+ * queried by invoking this function with ct = NULL.  In this case, no
+ * encapsulation is performed, NTRU_OK is returned, and the required
+ * minimum size for ct is returned in ct_len.
+ *
+ * When ct != NULL, at invocation *ct_len must be the size of the ct buffer.
+ * Upon return it is the actual size of the ciphertext, and shared_key holds
+ * the NTRU_KEM_SHARED_KEY_LEN-octet shared key.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than ct) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the ciphertext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_kem_encaps(
+    DRBG_HANDLE     drbg_handle,     /*     in - handle of DRBG */
+    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
+                                                 blob */
+    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
+                                                 no. of octets in ciphertext */
+    uint8_t        *ct,              /*    out - address for ciphertext */
+    uint8_t        *shared_key);     /*    out - address for shared key */
+
+
+/* ntru_crypto_kem_decaps
+ *
+ * Decapsulates the shared key from a ciphertext produced by
+ * ntru_crypto_kem_encaps(), using the private key.  The ciphertext is
+ * decrypted as by ntru_crypto_ntru_decrypt(), and the recovered plaintext
+ * must be a secret of sec_strength_len octets; the shared key is the
+ * SHA-256 digest of the secret followed by the ciphertext, returned in the
+ * NTRU_KEM_SHARED_KEY_LEN octets at shared_key.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if privkey_blob_len is zero,
+ *  or if ct_len is invalid for the parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PRIVATE_KEY if the private-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs, or if
+ *  the plaintext is not a KEM secret.
+ */
+
+NTRUCALL
+ntru_crypto_kem_decaps(
+    uint16_t       privkey_blob_len, /*  in - no. of octets in private key
+                                              blob */
+    uint8_t const *privkey_blob,     /*  in - pointer to private key */
+    uint16_t       ct_len,           /*  in - no. of octets in ciphertext */
+    uint8_t const *ct,               /*  in - pointer to ciphertext */
+    uint8_t       *shared_key);      /* out - address for shared key */
+
+
 /* ntru_crypto_ntru_encrypt_publicKey2SubjectPublicKeyInfo
  *
  * DER-encodes an NTRUEncrypt public-key from a public-key blob into a
@@ -61,10 +61,12 @@ extern "C" {
  *******************/
 
 #if !defined(DRBG_MAX_INSTANTIATIONS)
-#define DRBG_MAX_INSTANTIATIONS                 4
+#define DRBG_MAX_INSTANTIATIONS                 4   /* default limit */
 #endif
+#define DRBG_MAX_INSTANTIATIONS_LIMIT           0xffff
 #define DRBG_MAX_SEC_STRENGTH_BITS              256
 #define DRBG_MAX_BYTES_PER_BYTE_OF_ENTROPY      8
+#define DRBG_MAX_ADDITIONAL_INPUT_BYTES         256
 
 
 /************************
@@ -75,6 +77,14 @@ extern "C" {
 #define HMAC_DRBG_MAX_BYTES_PER_REQUEST         1024
 
 
+/***********************
+ * CTR_DRBG parameters *
+ ***********************/
+
+#define CTR_DRBG_MAX_PERS_STR_BYTES             32
+#define CTR_DRBG_MAX_BYTES_PER_REQUEST          65536
+
+
 /********************
  * type definitions *
  ********************/
@@ -84,6 +94,7 @@ typedef uint32_t DRBG_HANDLE;               /* drbg handle */
 typedef enum {                              /* drbg types */
     EXTERNAL_DRBG,
     SHA256_HMAC_DRBG,
+    AES256_CTR_DRBG,
 } DRBG_TYPE;
 
 typedef enum {                              /* entropy-function commands */
@@ -96,6 +107,26 @@ typedef uint8_t (*ENTROPY_FN)(              /* get entropy function */
                     uint8_t     *out);      /* address for output */
 
 
+/* Type for bulk entropy functions, such as one reading getrandom().  Must
+ * fill out with num_bytes bytes holding at least min_entropy_bits bits of
+ * entropy, and return 1 on success or 0 on failure */
+typedef uint8_t (*ENTROPY_BULK_FN)(         /* bulk entropy function */
+                    uint8_t  *out,          /* output buffer */
+                    uint32_t  num_bytes,    /* number of bytes */
+                    uint32_t  min_entropy_bits); /* min. bits of entropy */
+
+
+/* Reseed policy of an HMAC_DRBG or CTR_DRBG.  A limit of 0 is no limit. */
+typedef struct {
+    uint32_t max_requests;          /* generate requests between reseeds */
+    uint64_t max_bytes;             /* octets generated between reseeds */
+    uint32_t max_age_secs;          /* seconds between reseeds */
+    bool     background;            /* get the entropy input for the next
+                                       reseed ahead of time on a helper
+                                       thread */
+} DRBG_RESEED_POLICY;
+
+
 /* Type for external PRNG functions. Must return DRBG_OK on success */
 typedef uint32_t (*RANDOM_BYTES_FN)(        /* random bytes function */
                     uint8_t *out,           /* output buffer */
@@ -127,7 +158,8 @@ typedef uint32_t (*RANDOM_BYTES_FN)(        /* random bytes function */
 
 /* ntru_crypto_drbg_instantiate
  *
- * This routine instantiates a drbg with the requested security strength.
+ * This routine instantiates a SHA-256 HMAC_DRBG with the requested security
+ * strength.  It is ntru_crypto_drbg_instantiate_ex with SHA256_HMAC_DRBG.
  * See ANS X9.82: Part 3-2007.
  *
  * Returns DRBG_OK if successful.
@@ -146,6 +178,65 @@ ntru_crypto_drbg_instantiate(
     ENTROPY_FN     entropy_fn,        /*  in - pointer to entropy function */
     DRBG_HANDLE   *handle);           /* out - address for drbg handle */
 
+/* ntru_crypto_drbg_instantiate_ex
+ *
+ * This routine instantiates a drbg of the given type with the requested
+ * security strength.  The type is SHA256_HMAC_DRBG, or AES256_CTR_DRBG for
+ * the AES-256 CTR_DRBG of NIST SP 800-90A.  On CPUs with the AES
+ * instructions the CTR_DRBG generates output about ten times faster than
+ * the HMAC_DRBG; elsewhere it uses portable table-based AES, which is no
+ * faster and whose timing may depend on its state.  The
+ * personalization string may be up to HMAC_DRBG_MAX_PERS_STR_BYTES or
+ * CTR_DRBG_MAX_PERS_STR_BYTES long, and each call to generate may request
+ * up to HMAC_DRBG_MAX_BYTES_PER_REQUEST or CTR_DRBG_MAX_BYTES_PER_REQUEST
+ * bytes.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if an argument pointer is NULL
+ *  or the type is not a type of drbg this routine instantiates.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the security strength requested
+ *  or the personalization string is too large.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if there are no instantiation
+ *  slots available
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the internal state cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_instantiate_ex(
+    DRBG_TYPE      type,              /*  in - type of drbg */
+    uint32_t       sec_strength_bits, /*  in - requested sec strength in bits */
+    uint8_t const *pers_str,          /*  in - ptr to personalization string */
+    uint32_t       pers_str_bytes,    /*  in - no. personalization str bytes */
+    ENTROPY_FN     entropy_fn,        /*  in - pointer to entropy function */
+    DRBG_HANDLE   *handle);           /* out - address for drbg handle */
+
+/* ntru_crypto_drbg_instantiate_bulk
+ *
+ * This routine instantiates a drbg of the given type with the requested
+ * security strength, as ntru_crypto_drbg_instantiate_ex does, but takes
+ * the entropy input for the instantiation and each reseed from a bulk
+ * entropy function in a single call, rather than one call per byte.  The
+ * function is asked for 2 * sec_strength_bits / 8 bytes of full entropy.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_ENTROPY_FAIL if the entropy function fails.
+ * Returns the errors of ntru_crypto_drbg_instantiate_ex if they occur.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_instantiate_bulk(
+    DRBG_TYPE       type,              /*  in - type of drbg */
+    uint32_t        sec_strength_bits, /*  in - requested sec strength in
+                                                bits */
+    uint8_t const  *pers_str,          /*  in - ptr to personalization
+                                                string */
+    uint32_t        pers_str_bytes,    /*  in - no. personalization str
+                                                bytes */
+    ENTROPY_BULK_FN entropy_fn,        /*  in - pointer to bulk entropy
+                                                function */
+    DRBG_HANDLE    *handle);           /* out - address for drbg handle */
+
 /* ntru_crypto_drbg_external_instantiate
  *
  * This routine instruments an external DRBG so that ntru_crypto routines
@@ -165,9 +256,58 @@ ntru_crypto_drbg_external_instantiate(
     RANDOM_BYTES_FN  randombytesfn, /*  in - pointer to random bytes function */
     DRBG_HANDLE     *handle);       /* out - address for drbg handle */
 
+/* ntru_crypto_drbg_thread_local
+ *
+ * This routine returns the calling thread's SHA-256 HMAC_DRBG, first
+ * instantiating it as ntru_crypto_drbg_instantiate does if the thread does
+ * not have one.  The drbg is uninstantiated automatically when the thread
+ * exits, and counts against the instantiation limit while it exists, so
+ * applications with many threads should raise the limit with
+ * ntru_crypto_drbg_set_max_instantiations.  Thread-local storage is
+ * released when the library is unloaded; the drbgs of threads that are still
+ * running at that point are then not uninstantiated.
+ *
+ * Only the first call on each thread instantiates a drbg, so the security
+ * strength, personalization string and entropy function of later calls are
+ * ignored unless the drbg has been uninstantiated in between.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if thread-local storage is
+ *  not available, or if there are no instantiation slots available.
+ * Returns the errors of ntru_crypto_drbg_instantiate if they occur.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_thread_local(
+    uint32_t       sec_strength_bits, /*  in - requested sec strength in bits */
+    uint8_t const *pers_str,          /*  in - ptr to personalization string */
+    uint32_t       pers_str_bytes,    /*  in - no. personalization str bytes */
+    ENTROPY_FN     entropy_fn,        /*  in - pointer to entropy function */
+    DRBG_HANDLE   *handle);           /* out - address for drbg handle */
+
+/* ntru_crypto_drbg_external_thread_local
+ *
+ * This routine returns the calling thread's external DRBG, first
+ * instantiating it with randombytesfn, as
+ * ntru_crypto_drbg_external_instantiate does, if the thread does not have
+ * one.  The drbg is uninstantiated automatically when the thread exits, and
+ * counts against the instantiation limit while it exists.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if thread-local storage is
+ *  not available, or if there are no instantiation slots available.
+ * Returns the errors of ntru_crypto_drbg_external_instantiate if they occur.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_external_thread_local(
+    RANDOM_BYTES_FN  randombytesfn, /*  in - pointer to random bytes function */
+    DRBG_HANDLE     *handle);       /* out - address for drbg handle */
+
 /* ntru_crypto_drbg_uninstantiate
  *
- * This routine frees a drbg given its handle.
+ * This routine frees a drbg given its handle.  The handle must not be in
+ * use by another thread.
  *
  * Returns DRBG_OK if successful.
  * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid.
@@ -178,6 +318,91 @@ ntru_crypto_drbg_uninstantiate(
     DRBG_HANDLE handle);            /* in - drbg handle */
 
 
+/* ntru_crypto_drbg_set_max_instantiations
+ *
+ * This routine sets the maximum number of simultaneous drbg instantiations,
+ * which is DRBG_MAX_INSTANTIATIONS by default.  Lowering the limit below the
+ * current number of instantiations does not affect them, but prevents new
+ * ones until enough have been uninstantiated.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if max_instantiations is zero or
+ *  greater than DRBG_MAX_INSTANTIATIONS_LIMIT.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_set_max_instantiations(
+    uint32_t max_instantiations);   /* in - maximum no. of instantiations */
+
+
+/* ntru_crypto_drbg_set_pool
+ *
+ * This routine makes an instantiated HMAC_DRBG or CTR_DRBG buffer its
+ * output.  The drbg then generates pool_bytes at a time, and requests of
+ * up to pool_bytes are served from the pool, so that many small requests,
+ * such as the ones made for each encryption, share the cost of one
+ * generate call and its update of the internal state.  Bytes are zeroed in
+ * the pool as they are served, and the pool is discarded when the drbg is
+ * reseeded.  Larger requests bypass the pool.  A pool_bytes of 0 turns
+ * buffering off.  The pool is allocated from the heap, and freed when the
+ * drbg is uninstantiated.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or is
+ *  the handle of an external drbg.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if pool_bytes is more than
+ *  HMAC_DRBG_MAX_BYTES_PER_REQUEST or CTR_DRBG_MAX_BYTES_PER_REQUEST.
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the pool cannot be
+ *  allocated from the heap.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_set_pool(
+    DRBG_HANDLE handle,             /* in - drbg handle */
+    uint32_t    pool_bytes);        /* in - pool size, or 0 for no pool */
+
+
+/* ntru_crypto_drbg_set_reseed_policy
+ *
+ * This routine sets the reseed policy of an instantiated HMAC_DRBG or
+ * CTR_DRBG.  Before a generate request that would go past one of the
+ * policy's limits, the drbg reseeds itself; explicit reseeds and
+ * prediction resistance restart the count.  Requests are counted as calls
+ * to the drbg's generate function, so with an output pool a refill of the
+ * pool is one request.  A NULL policy, the default, has no limits; the drbg
+ * still reseeds itself after 2^32 - 1 requests.
+ *
+ * With background reseeding, which needs a drbg instantiated with
+ * ntru_crypto_drbg_instantiate_bulk, a helper thread gets the entropy input
+ * for the next reseed ahead of time, and a due reseed takes it over without
+ * calling the entropy function, so generate calls do not wait on the
+ * entropy source.  If the entropy input is not ready yet, the reseed is put
+ * off to a later request, until the drbg is twice past one of the policy's
+ * limits; then, or if the helper thread could not get it, the drbg reseeds
+ * from the entropy function directly, and returns its error if it fails.
+ * The bulk entropy function must then be safe to call from the helper
+ * thread, and concurrently with itself.  The helper thread is started with
+ * the first drbg that reseeds in the background, and stopped and joined
+ * when the last one turns background reseeding off or is uninstantiated.
+ * Background reseeding is not available in the kernel.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or is
+ *  the handle of an external drbg, or if background reseeding is requested
+ *  for a drbg without a bulk entropy function.
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the background entropy
+ *  input cannot be allocated from the heap.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if the helper thread cannot
+ *  be started.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_set_reseed_policy(
+    DRBG_HANDLE               handle,  /* in - drbg handle */
+    DRBG_RESEED_POLICY const *policy); /* in - reseed policy, or NULL for
+                                                none */
+
+
 /* ntru_crypto_drbg_reseed
  *
  * This routine reseeds an instantiated drbg.
@@ -193,6 +418,33 @@ ntru_crypto_drbg_reseed(
     DRBG_HANDLE handle);            /* in - drbg handle */
 
 
+/* ntru_crypto_drbg_reseed_ex
+ *
+ * This routine reseeds an instantiated drbg, mixing in up to
+ * DRBG_MAX_ADDITIONAL_INPUT_BYTES of additional input along with the new
+ * entropy.  The additional input need not be secret; it may be, for
+ * example, a transaction or session identifier.  A NULL additional_input
+ * with additional_input_bytes of 0 is the same as ntru_crypto_drbg_reseed.
+ * See ANS X9.82: Part 3-2007 and NIST SP 800-90A.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or is
+ *  the handle of an external drbg, or if additional_input is NULL and
+ *  additional_input_bytes is not 0.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if additional_input_bytes is
+ *  more than DRBG_MAX_ADDITIONAL_INPUT_BYTES.
+ * Returns DRBG_ERROR_BASE + DRBG_ENTROPY_FAIL if the entropy function fails.
+ * Returns NTRU_CRYPTO_HMAC errors if they occur.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_reseed_ex(
+    DRBG_HANDLE    handle,                  /* in - drbg handle */
+    uint8_t const *additional_input,        /* in - ptr to additional input */
+    uint32_t       additional_input_bytes); /* in - no. additional input
+                                                    bytes */
+
+
 /* ntru_crypto_drbg_generate
  *
  * This routine generates pseudorandom bytes using an instantiated drbg.
@@ -215,6 +467,45 @@ ntru_crypto_drbg_generate(
     uint8_t    *out);               /* out - address for generated octets */
 
 
+/* ntru_crypto_drbg_generate_ex
+ *
+ * This routine generates pseudorandom bytes using an instantiated drbg,
+ * as ntru_crypto_drbg_generate does, with two optional extensions:
+ *  - if prediction_resistance is TRUE, the drbg is reseeded with fresh
+ *    entropy before the bytes are generated, so that they cannot be
+ *    predicted even from a compromised earlier state;
+ *  - up to DRBG_MAX_ADDITIONAL_INPUT_BYTES of additional input are mixed
+ *    into the state before and after the bytes are generated, binding the
+ *    output to a per-request context without the cost of a reseed.
+ * Requests using either extension bypass the output pool, if any.
+ * External drbgs support neither.
+ * See ANS X9.82: Part 3-2007 and NIST SP 800-90A.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid, if
+ *  an argument pointer is NULL, or if prediction resistance or additional
+ *  input is requested from an external drbg.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the security strength requested
+ *  is too large, the number of bytes requested is zero or too large, or
+ *  additional_input_bytes is more than DRBG_MAX_ADDITIONAL_INPUT_BYTES.
+ * Returns DRBG_ERROR_BASE + DRBG_ENTROPY_FAIL if the entropy function fails
+ *  while reseeding.
+ * Returns NTRU_CRYPTO_HMAC errors if they occur.
+ */
+
+NTRUCALL
+ntru_crypto_drbg_generate_ex(
+    DRBG_HANDLE    handle,                 /*  in - drbg handle */
+    uint32_t       sec_strength_bits,      /*  in - requested sec strength
+                                                    in bits */
+    bool           prediction_resistance,  /*  in - reseed first if TRUE */
+    uint8_t const *additional_input,       /*  in - ptr to additional input */
+    uint32_t       additional_input_bytes, /*  in - no. additional input
+                                                    bytes */
+    uint32_t       num_bytes,              /*  in - no. octets to generate */
+    uint8_t       *out);                   /* out - address for octets */
+
+
 #if defined ( __cplusplus )
 }
 #endif /* __cplusplus */
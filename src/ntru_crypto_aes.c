@@ -0,0 +1,366 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_aes.c is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_aes.c
+ *
+ * Contents: Portable AES-256 encryption and run-time selection of the AES
+ *           implementation.
+ *
+ * The portable implementation is always built.  It looks up the S-box in
+ * a table, so its timing may depend on the key and data through the cache;
+ * it is only used on CPUs without the AES instructions.  When the library
+ * is built for x86 with NTRU_HAVE_X86_SIMD, an implementation using the AES
+ * instructions is built as well, and is selected when the library is loaded
+ * if the CPU supports it.
+ *
+ *****************************************************************************/
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_aes.h"
+#include "ntru_crypto_cpu.h"
+
+
+/* the AES S-box */
+
+static uint8_t const aes_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+    0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+    0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc,
+    0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a,
+    0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+    0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+    0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85,
+    0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+    0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17,
+    0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+    0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+    0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9,
+    0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6,
+    0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+    0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94,
+    0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68,
+    0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+
+/* multiplication by x in GF(2^8) */
+
+#define AES_XTIME(b)                                                          \
+    ((uint8_t)(((b) << 1) ^ (((b) >> 7) * 0x1b)))
+
+
+/* ntru_crypto_aes256_set_key_scalar
+ *
+ * Expands a 32-byte key with the key expansion of FIPS 197, a 4-byte word
+ * at a time.
+ */
+
+void
+ntru_crypto_aes256_set_key_scalar(
+    uint8_t const          *key,    /*  in - ptr to 32-byte key */
+    NTRU_CRYPTO_AES256_KEY *ks)     /* out - address for key schedule */
+{
+    uint8_t *w = ks->rk;
+    uint8_t  t[4];
+    uint8_t  tmp;
+    uint8_t  rcon = 0x01;
+    uint32_t i;
+
+    memcpy(w, key, AES256_KEY_LEN);
+
+    for (i = AES256_KEY_LEN; i < sizeof(ks->rk); i += 4)
+    {
+        memcpy(t, w + i - 4, 4);
+
+        if ((i % AES256_KEY_LEN) == 0)
+        {
+            /* RotWord, SubWord and Rcon */
+
+            tmp = t[0];
+            t[0] = aes_sbox[t[1]] ^ rcon;
+            t[1] = aes_sbox[t[2]];
+            t[2] = aes_sbox[t[3]];
+            t[3] = aes_sbox[tmp];
+            rcon = AES_XTIME(rcon);
+        }
+        else if ((i % AES256_KEY_LEN) == 16)
+        {
+            /* SubWord */
+
+            t[0] = aes_sbox[t[0]];
+            t[1] = aes_sbox[t[1]];
+            t[2] = aes_sbox[t[2]];
+            t[3] = aes_sbox[t[3]];
+        }
+
+        w[i]   = w[i - AES256_KEY_LEN]   ^ t[0];
+        w[i+1] = w[i - AES256_KEY_LEN+1] ^ t[1];
+        w[i+2] = w[i - AES256_KEY_LEN+2] ^ t[2];
+        w[i+3] = w[i - AES256_KEY_LEN+3] ^ t[3];
+    }
+}
+
+
+/* ntru_crypto_aes256_encrypt_scalar
+ *
+ * Encrypts one block.  The state is kept as 16 bytes in column order, so
+ * that byte 4 * c + r is row r of column c, and SubBytes is combined with
+ * ShiftRows, which moves row r left by r columns.
+ */
+
+void
+ntru_crypto_aes256_encrypt_scalar(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*  in - ptr to key schedule */
+    uint8_t const                *in,   /*  in - ptr to input block */
+    uint8_t                      *out)  /* out - address for output block */
+{
+    uint8_t const *rk = ks->rk;
+    uint8_t        s[AES_BLK_LEN];
+    uint8_t        t[AES_BLK_LEN];
+    uint8_t        a0, a1, a2, a3, x;
+    uint32_t       round;
+    uint32_t       c, r;
+
+    for (c = 0; c < AES_BLK_LEN; c++)
+    {
+        s[c] = in[c] ^ rk[c];
+    }
+
+    for (round = 1; round <= AES256_NUM_ROUNDS; round++)
+    {
+        rk += AES_BLK_LEN;
+
+        /* SubBytes and ShiftRows */
+
+        for (c = 0; c < 4; c++)
+        {
+            for (r = 0; r < 4; r++)
+            {
+                t[4*c + r] = aes_sbox[s[4*((c + r) & 3) + r]];
+            }
+        }
+
+        if (round == AES256_NUM_ROUNDS)
+        {
+            for (c = 0; c < AES_BLK_LEN; c++)
+            {
+                s[c] = t[c] ^ rk[c];
+            }
+            break;
+        }
+
+        /* MixColumns and AddRoundKey */
+
+        for (c = 0; c < AES_BLK_LEN; c += 4)
+        {
+            a0 = t[c];
+            a1 = t[c+1];
+            a2 = t[c+2];
+            a3 = t[c+3];
+            x = a0 ^ a1 ^ a2 ^ a3;
+            s[c]   = a0 ^ x ^ AES_XTIME(a0 ^ a1) ^ rk[c];
+            s[c+1] = a1 ^ x ^ AES_XTIME(a1 ^ a2) ^ rk[c+1];
+            s[c+2] = a2 ^ x ^ AES_XTIME(a2 ^ a3) ^ rk[c+2];
+            s[c+3] = a3 ^ x ^ AES_XTIME(a3 ^ a0) ^ rk[c+3];
+        }
+    }
+
+    memcpy(out, s, AES_BLK_LEN);
+}
+
+
+/* ntru_crypto_aes256_ctr_scalar
+ *
+ * Generates counter mode keystream a block at a time.
+ */
+
+void
+ntru_crypto_aes256_ctr_scalar(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*     in - ptr to key schedule */
+    uint8_t                      *ctr,  /* in/out - ptr to 16-byte counter */
+    uint32_t                      num_blocks, /* in - no. of blocks */
+    uint8_t                      *out)  /*    out - address for keystream */
+{
+    int32_t i;
+
+    while (num_blocks-- > 0)
+    {
+        for (i = AES_BLK_LEN - 1; (i >= 0) && (++ctr[i] == 0); i--)
+        {
+            ;
+        }
+
+        ntru_crypto_aes256_encrypt_scalar(ks, ctr, out);
+        out += AES_BLK_LEN;
+    }
+}
+
+
+/* implementation table, indexed by NTRU_CRYPTO_AES_IMPL_ID */
+
+static NTRU_CRYPTO_AES_IMPL const ntru_crypto_aes_impls[] = {
+    {
+        "scalar",
+        ntru_crypto_aes256_set_key_scalar,
+        ntru_crypto_aes256_encrypt_scalar,
+        ntru_crypto_aes256_ctr_scalar,
+    },
+#if defined(NTRU_HAVE_X86_SIMD)
+    {
+        "aesni",
+        ntru_crypto_aes256_set_key_aesni,
+        ntru_crypto_aes256_encrypt_aesni,
+        ntru_crypto_aes256_ctr_aesni,
+    },
+#endif
+};
+
+#define NTRU_CRYPTO_AES_NUM_BUILT                                             \
+    (sizeof(ntru_crypto_aes_impls) / sizeof(ntru_crypto_aes_impls[0]))
+
+
+/* NTRU_CPU_ flags required by each implementation, indexed by
+ * NTRU_CRYPTO_AES_IMPL_ID
+ */
+
+static uint32_t const ntru_crypto_aes_required[] = {
+    0,
+#if defined(NTRU_HAVE_X86_SIMD)
+    NTRU_CPU_AESNI,
+#endif
+};
+
+
+/* the AES implementation in use */
+
+static NTRU_CRYPTO_AES_IMPL const *ntru_crypto_aes_impl =
+    ntru_crypto_aes_impls;
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* ntru_crypto_aes_select
+ *
+ * Uses AES-NI if the CPU has it.
+ */
+
+static void ntru_crypto_aes_select(void) __attribute__((constructor));
+
+static void
+ntru_crypto_aes_select(void)
+{
+    ntru_crypto_aes_impl = ntru_crypto_aes_impls +
+        ntru_crypto_cpu_best_impl(ntru_crypto_aes_required,
+                                  NTRU_CRYPTO_AES_NUM_BUILT);
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_crypto_aes_get_impl
+ *
+ * Returns the AES implementation with the given ID, or NULL if it is not
+ * built into the library or not supported by the CPU.  Passing
+ * NTRU_CRYPTO_AES_NUM_IMPLS returns the selected implementation.
+ */
+
+NTRU_CRYPTO_AES_IMPL const *
+ntru_crypto_aes_get_impl(
+    NTRU_CRYPTO_AES_IMPL_ID id)         /*  in - implementation ID */
+{
+    if (id == NTRU_CRYPTO_AES_NUM_IMPLS)
+    {
+        return ntru_crypto_aes_impl;
+    }
+
+    if (((uint32_t)id >= NTRU_CRYPTO_AES_NUM_BUILT) ||
+        !ntru_crypto_cpu_supports(ntru_crypto_aes_required[id]))
+    {
+        return NULL;
+    }
+
+    return ntru_crypto_aes_impls + id;
+}
+
+
+/* ntru_crypto_aes256_set_key
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_aes.h.
+ */
+
+void
+ntru_crypto_aes256_set_key(
+    uint8_t const          *key,    /*  in - ptr to 32-byte key */
+    NTRU_CRYPTO_AES256_KEY *ks)     /* out - address for key schedule */
+{
+    ntru_crypto_aes_impl->set_key(key, ks);
+}
+
+
+/* ntru_crypto_aes256_encrypt
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_aes.h.
+ */
+
+void
+ntru_crypto_aes256_encrypt(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*  in - ptr to key schedule */
+    uint8_t const                *in,   /*  in - ptr to input block */
+    uint8_t                      *out)  /* out - address for output block */
+{
+    ntru_crypto_aes_impl->encrypt(ks, in, out);
+}
+
+
+/* ntru_crypto_aes256_ctr
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_aes.h.
+ */
+
+void
+ntru_crypto_aes256_ctr(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*     in - ptr to key schedule */
+    uint8_t                      *ctr,  /* in/out - ptr to 16-byte counter */
+    uint32_t                      num_blocks, /* in - no. of blocks */
+    uint8_t                      *out)  /*    out - address for keystream */
+{
+    ntru_crypto_aes_impl->ctr(ks, ctr, num_blocks, out);
+}
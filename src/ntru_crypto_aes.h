@@ -0,0 +1,169 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_aes.h is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_aes.h
+ *
+ * Contents: Definitions and declarations for the AES-256 block cipher,
+ *           used by the CTR_DRBG.
+ *
+ *****************************************************************************/
+
+#ifndef NTRU_CRYPTO_AES_H
+#define NTRU_CRYPTO_AES_H
+
+
+#include "ntru_crypto_platform.h"
+
+
+/*************************
+ * constants and structs *
+ *************************/
+
+#define AES_BLK_LEN          16     /* bytes in an AES block */
+#define AES256_KEY_LEN       32     /* bytes in an AES-256 key */
+#define AES256_NUM_ROUNDS    14
+
+
+/* AES-256 key schedule: the 15 round keys as the bytes of the expanded key
+ * of FIPS 197, which is also the layout the AES instructions use
+ */
+
+typedef struct _NTRU_CRYPTO_AES256_KEY {
+    uint8_t rk[(AES256_NUM_ROUNDS + 1) * AES_BLK_LEN];
+} NTRU_CRYPTO_AES256_KEY;
+
+
+/*************************
+ * function declarations *
+ *************************/
+
+/* ntru_crypto_aes256_set_key
+ *
+ * Expands a 32-byte AES-256 key into its key schedule.
+ */
+
+extern void
+ntru_crypto_aes256_set_key(
+    uint8_t const          *key,    /*  in - ptr to 32-byte key */
+    NTRU_CRYPTO_AES256_KEY *ks);    /* out - address for key schedule */
+
+
+/* ntru_crypto_aes256_encrypt
+ *
+ * Encrypts one 16-byte block.  in and out may be the same.
+ */
+
+extern void
+ntru_crypto_aes256_encrypt(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*  in - ptr to key schedule */
+    uint8_t const                *in,   /*  in - ptr to input block */
+    uint8_t                      *out); /* out - address for output block */
+
+
+/* ntru_crypto_aes256_ctr
+ *
+ * Generates num_blocks blocks of AES-256 counter mode keystream.  For each
+ * block, the 16-byte counter is first incremented as a big-endian integer
+ * and then encrypted, as the CTR_DRBG of NIST SP 800-90A does, so the
+ * counter is left at the value used for the last block.
+ */
+
+extern void
+ntru_crypto_aes256_ctr(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*     in - ptr to key schedule */
+    uint8_t                      *ctr,  /* in/out - ptr to 16-byte counter */
+    uint32_t                      num_blocks, /* in - no. of blocks */
+    uint8_t                      *out); /*    out - address for keystream */
+
+
+/* implementation selection */
+
+typedef enum {
+    NTRU_CRYPTO_AES_SCALAR = 0,
+    NTRU_CRYPTO_AES_AESNI,
+    NTRU_CRYPTO_AES_NUM_IMPLS,
+} NTRU_CRYPTO_AES_IMPL_ID;
+
+typedef void (*NTRU_CRYPTO_AES256_SET_KEY_FN)(
+    uint8_t const          *key,
+    NTRU_CRYPTO_AES256_KEY *ks);
+
+typedef void (*NTRU_CRYPTO_AES256_ENCRYPT_FN)(
+    NTRU_CRYPTO_AES256_KEY const *ks,
+    uint8_t const                *in,
+    uint8_t                      *out);
+
+typedef void (*NTRU_CRYPTO_AES256_CTR_FN)(
+    NTRU_CRYPTO_AES256_KEY const *ks,
+    uint8_t                      *ctr,
+    uint32_t                      num_blocks,
+    uint8_t                      *out);
+
+typedef struct {
+    char const                     *name;
+    NTRU_CRYPTO_AES256_SET_KEY_FN   set_key;
+    NTRU_CRYPTO_AES256_ENCRYPT_FN   encrypt;
+    NTRU_CRYPTO_AES256_CTR_FN       ctr;
+} NTRU_CRYPTO_AES_IMPL;
+
+
+/* ntru_crypto_aes_get_impl
+ *
+ * Returns the AES implementation with the given ID, or NULL if it is not
+ * built into the library or not supported by the CPU.  Passing
+ * NTRU_CRYPTO_AES_NUM_IMPLS returns the selected implementation.
+ */
+
+extern NTRU_CRYPTO_AES_IMPL const *
+ntru_crypto_aes_get_impl(
+    NTRU_CRYPTO_AES_IMPL_ID id);        /*  in - implementation ID */
+
+
+/* implementation variants, see ntru_crypto_aes256_set_key(),
+ * ntru_crypto_aes256_encrypt() and ntru_crypto_aes256_ctr()
+ */
+
+extern void
+ntru_crypto_aes256_set_key_scalar(uint8_t const *key,
+                                  NTRU_CRYPTO_AES256_KEY *ks);
+extern void
+ntru_crypto_aes256_encrypt_scalar(NTRU_CRYPTO_AES256_KEY const *ks,
+                                  uint8_t const *in, uint8_t *out);
+extern void
+ntru_crypto_aes256_ctr_scalar(NTRU_CRYPTO_AES256_KEY const *ks, uint8_t *ctr,
+                              uint32_t num_blocks, uint8_t *out);
+extern void
+ntru_crypto_aes256_set_key_aesni(uint8_t const *key,
+                                 NTRU_CRYPTO_AES256_KEY *ks);
+extern void
+ntru_crypto_aes256_encrypt_aesni(NTRU_CRYPTO_AES256_KEY const *ks,
+                                 uint8_t const *in, uint8_t *out);
+extern void
+ntru_crypto_aes256_ctr_aesni(NTRU_CRYPTO_AES256_KEY const *ks, uint8_t *ctr,
+                             uint32_t num_blocks, uint8_t *out);
+
+
+#endif /* NTRU_CRYPTO_AES_H */
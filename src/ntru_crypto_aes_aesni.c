@@ -0,0 +1,167 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_aes.h"
+#include <immintrin.h>
+
+/* ntru_crypto_aes256_set_key_aesni
+ *
+ * Expands a 32-byte key with AESKEYGENASSIST.  Each step derives the next
+ * round key from the two before it: even round keys use RotWord, SubWord
+ * and Rcon of the last word of the previous one, odd round keys use only
+ * SubWord.  The other three words of a round key are a running XOR, done
+ * with three 4-byte shifts.
+ */
+
+#define AES256_KEY_EVEN(k0, k1, rcon)                                         \
+  t = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k1, rcon), 0xff);           \
+  k0 = _mm_xor_si128(k0, _mm_slli_si128(k0, 4));                              \
+  k0 = _mm_xor_si128(k0, _mm_slli_si128(k0, 4));                              \
+  k0 = _mm_xor_si128(k0, _mm_slli_si128(k0, 4));                              \
+  k0 = _mm_xor_si128(k0, t)
+
+#define AES256_KEY_ODD(k0, k1)                                                \
+  t = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k0, 0), 0xaa);              \
+  k1 = _mm_xor_si128(k1, _mm_slli_si128(k1, 4));                              \
+  k1 = _mm_xor_si128(k1, _mm_slli_si128(k1, 4));                              \
+  k1 = _mm_xor_si128(k1, _mm_slli_si128(k1, 4));                              \
+  k1 = _mm_xor_si128(k1, t)
+
+void
+ntru_crypto_aes256_set_key_aesni(
+    uint8_t const          *key,    /*  in - ptr to 32-byte key */
+    NTRU_CRYPTO_AES256_KEY *ks)     /* out - address for key schedule */
+{
+  __m128i *rk = (__m128i *) ks->rk;
+  __m128i k0, k1, t;
+
+  k0 = _mm_loadu_si128((__m128i const *) key);
+  k1 = _mm_loadu_si128((__m128i const *) (key+16));
+  _mm_storeu_si128(rk, k0);
+  _mm_storeu_si128(rk+1, k1);
+
+  AES256_KEY_EVEN(k0, k1, 0x01);  _mm_storeu_si128(rk+2, k0);
+  AES256_KEY_ODD(k0, k1);         _mm_storeu_si128(rk+3, k1);
+  AES256_KEY_EVEN(k0, k1, 0x02);  _mm_storeu_si128(rk+4, k0);
+  AES256_KEY_ODD(k0, k1);         _mm_storeu_si128(rk+5, k1);
+  AES256_KEY_EVEN(k0, k1, 0x04);  _mm_storeu_si128(rk+6, k0);
+  AES256_KEY_ODD(k0, k1);         _mm_storeu_si128(rk+7, k1);
+  AES256_KEY_EVEN(k0, k1, 0x08);  _mm_storeu_si128(rk+8, k0);
+  AES256_KEY_ODD(k0, k1);         _mm_storeu_si128(rk+9, k1);
+  AES256_KEY_EVEN(k0, k1, 0x10);  _mm_storeu_si128(rk+10, k0);
+  AES256_KEY_ODD(k0, k1);         _mm_storeu_si128(rk+11, k1);
+  AES256_KEY_EVEN(k0, k1, 0x20);  _mm_storeu_si128(rk+12, k0);
+  AES256_KEY_ODD(k0, k1);         _mm_storeu_si128(rk+13, k1);
+  AES256_KEY_EVEN(k0, k1, 0x40);  _mm_storeu_si128(rk+14, k0);
+}
+
+/* ntru_crypto_aes256_encrypt_aesni
+ *
+ * Encrypts one block with AESENC and AESENCLAST.
+ */
+
+void
+ntru_crypto_aes256_encrypt_aesni(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*  in - ptr to key schedule */
+    uint8_t const                *in,   /*  in - ptr to input block */
+    uint8_t                      *out)  /* out - address for output block */
+{
+  __m128i const *rk = (__m128i const *) ks->rk;
+  __m128i b;
+  int r;
+
+  b = _mm_xor_si128(_mm_loadu_si128((__m128i const *) in),
+                    _mm_loadu_si128(rk));
+  for (r = 1; r < AES256_NUM_ROUNDS; r++)
+  {
+    b = _mm_aesenc_si128(b, _mm_loadu_si128(rk+r));
+  }
+  b = _mm_aesenclast_si128(b, _mm_loadu_si128(rk+AES256_NUM_ROUNDS));
+  _mm_storeu_si128((__m128i *) out, b);
+}
+
+/* ntru_crypto_aes256_ctr_aesni
+ *
+ * Generates counter mode keystream eight blocks at a time, so that the
+ * AESENC latency of one block is hidden behind the other seven.  The
+ * counter is kept as two 64-bit halves in registers and byte swapped into
+ * each block.
+ */
+
+#define AES_CTR_LANES 8
+
+void
+ntru_crypto_aes256_ctr_aesni(
+    NTRU_CRYPTO_AES256_KEY const *ks,   /*     in - ptr to key schedule */
+    uint8_t                      *ctr,  /* in/out - ptr to 16-byte counter */
+    uint32_t                      num_blocks, /* in - no. of blocks */
+    uint8_t                      *out)  /*    out - address for keystream */
+{
+  __m128i const *rkp = (__m128i const *) ks->rk;
+  __m128i rk[AES256_NUM_ROUNDS+1];
+  __m128i b[AES_CTR_LANES];
+  uint64_t hi, lo;
+  uint32_t n, i;
+  int r;
+
+  for (r = 0; r <= AES256_NUM_ROUNDS; r++)
+  {
+    rk[r] = _mm_loadu_si128(rkp+r);
+  }
+
+  memcpy(&hi, ctr, 8);
+  memcpy(&lo, ctr+8, 8);
+  hi = __builtin_bswap64(hi);
+  lo = __builtin_bswap64(lo);
+
+  while (num_blocks >= AES_CTR_LANES)
+  {
+    for (i = 0; i < AES_CTR_LANES; i++)
+    {
+      hi += (++lo == 0);
+      b[i] = _mm_xor_si128(_mm_set_epi64x((long long) __builtin_bswap64(lo),
+                                          (long long) __builtin_bswap64(hi)),
+                           rk[0]);
+    }
+    for (r = 1; r < AES256_NUM_ROUNDS; r++)
+    {
+      for (i = 0; i < AES_CTR_LANES; i++)
+      {
+        b[i] = _mm_aesenc_si128(b[i], rk[r]);
+      }
+    }
+    for (i = 0; i < AES_CTR_LANES; i++)
+    {
+      _mm_storeu_si128((__m128i *) out + i,
+                       _mm_aesenclast_si128(b[i], rk[AES256_NUM_ROUNDS]));
+    }
+    out += AES_CTR_LANES * AES_BLK_LEN;
+    num_blocks -= AES_CTR_LANES;
+  }
+
+  /* the last blocks */
+
+  n = num_blocks;
+  for (i = 0; i < n; i++)
+  {
+    hi += (++lo == 0);
+    b[i] = _mm_xor_si128(_mm_set_epi64x((long long) __builtin_bswap64(lo),
+                                        (long long) __builtin_bswap64(hi)),
+                         rk[0]);
+  }
+  for (r = 1; r < AES256_NUM_ROUNDS; r++)
+  {
+    for (i = 0; i < n; i++)
+    {
+      b[i] = _mm_aesenc_si128(b[i], rk[r]);
+    }
+  }
+  for (i = 0; i < n; i++)
+  {
+    _mm_storeu_si128((__m128i *) out + i,
+                     _mm_aesenclast_si128(b[i], rk[AES256_NUM_ROUNDS]));
+  }
+
+  hi = __builtin_bswap64(hi);
+  lo = __builtin_bswap64(lo);
+  memcpy(ctr, &hi, 8);
+  memcpy(ctr+8, &lo, 8);
+}
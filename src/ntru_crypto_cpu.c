@@ -0,0 +1,175 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_cpu.c is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_cpu.c
+ *
+ * Contents: Detection of the CPU features used to select vectorized
+ *           implementations at run time.
+ *
+ *****************************************************************************/
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_cpu.h"
+
+#if defined(NTRU_HAVE_X86_SIMD)
+#include <cpuid.h>
+#endif
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* set in the cached flags once the features have been detected */
+
+#define NTRU_CPU_DETECTED   0x80000000
+
+static uint32_t ntru_crypto_cpu_cached;
+
+
+/* ntru_crypto_cpu_detect
+ *
+ * Checks with CPUID (and XGETBV for AVX2 register state) which features
+ * the CPU and operating system support.
+ */
+
+static uint32_t
+ntru_crypto_cpu_detect(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0_lo, xcr0_hi;
+    bool         sse41, avx;
+    uint32_t     features = 0;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return 0;
+    }
+
+    if (ecx & bit_SSSE3)
+    {
+        features |= NTRU_CPU_SSSE3;
+    }
+
+    if (ecx & bit_AES)
+    {
+        features |= NTRU_CPU_AESNI;
+    }
+
+    sse41 = (ecx & bit_SSE4_1) != 0;
+
+    /* AVX2 needs OS support for saving the YMM registers */
+
+    avx = (ecx & bit_OSXSAVE) && (ecx & bit_AVX);
+    if (avx)
+    {
+        __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        avx = (xcr0_lo & 0x6) == 0x6;
+    }
+
+    if (__get_cpuid_max(0, NULL) < 7)
+    {
+        return features;
+    }
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (avx && (ebx & bit_AVX2) && (features & NTRU_CPU_SSSE3))
+    {
+        features |= NTRU_CPU_AVX2;
+    }
+
+    if ((ebx & bit_SHA) && sse41 && (features & NTRU_CPU_SSSE3))
+    {
+        features |= NTRU_CPU_SHA;
+    }
+
+    return features;
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_crypto_cpu_features
+ *
+ * Returns the features detected by ntru_crypto_cpu_detect, running it only
+ * on the first call.  The first call is made by the selection constructors
+ * while the library is loaded, so the cache is not written concurrently.
+ */
+
+uint32_t
+ntru_crypto_cpu_features(void)
+{
+#if defined(NTRU_HAVE_X86_SIMD)
+    uint32_t features = ntru_crypto_cpu_cached;
+
+    if (!(features & NTRU_CPU_DETECTED))
+    {
+        features = ntru_crypto_cpu_detect() | NTRU_CPU_DETECTED;
+        ntru_crypto_cpu_cached = features;
+    }
+
+    return features & ~NTRU_CPU_DETECTED;
+#else
+    return 0;
+#endif /* NTRU_HAVE_X86_SIMD */
+}
+
+
+/* ntru_crypto_cpu_supports
+ *
+ * Returns TRUE if the CPU and operating system support all of the given
+ * features.
+ */
+
+bool
+ntru_crypto_cpu_supports(
+    uint32_t required)              /*  in - NTRU_CPU_ flags required */
+{
+    return (ntru_crypto_cpu_features() & required) == required;
+}
+
+
+/* ntru_crypto_cpu_best_impl
+ *
+ * Walks the implementations down from the fastest and returns the first
+ * one whose features are supported, falling back to index 0.
+ */
+
+uint32_t
+ntru_crypto_cpu_best_impl(
+    uint32_t const *required,       /*  in - flags required by each impl */
+    uint32_t        num_impls)      /*  in - no. of implementations */
+{
+    uint32_t id;
+
+    for (id = num_impls - 1; id > 0; id--)
+    {
+        if (ntru_crypto_cpu_supports(required[id]))
+        {
+            break;
+        }
+    }
+
+    return id;
+}
@@ -0,0 +1,94 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_cpu.h is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_cpu.h
+ *
+ * Contents: Detection of the CPU features used to select vectorized
+ *           implementations at run time.
+ *
+ *****************************************************************************/
+
+#ifndef NTRU_CRYPTO_CPU_H
+#define NTRU_CRYPTO_CPU_H
+
+
+#include "ntru_crypto_platform.h"
+
+
+/* CPU feature flags */
+
+#define NTRU_CPU_SSSE3      0x00000001  /* SSSE3 */
+#define NTRU_CPU_AVX2       0x00000002  /* AVX2, with OS support for YMM
+                                           state */
+#define NTRU_CPU_SHA        0x00000004  /* SHA extensions, with SSE4.1 and
+                                           SSSE3 */
+#define NTRU_CPU_AESNI      0x00000008  /* AES instructions */
+
+
+/* ntru_crypto_cpu_features
+ *
+ * Returns the NTRU_CPU_ flags for the features that the CPU and operating
+ * system support.  Only features that the library was built to use are
+ * reported, so this returns 0 when the library is built without
+ * NTRU_HAVE_X86_SIMD.
+ *
+ * The features are detected on the first call and cached.
+ */
+
+extern uint32_t
+ntru_crypto_cpu_features(void);
+
+
+/* ntru_crypto_cpu_supports
+ *
+ * Returns TRUE if the CPU and operating system support all of the given
+ * NTRU_CPU_ flags.
+ */
+
+extern bool
+ntru_crypto_cpu_supports(
+    uint32_t required);             /*  in - NTRU_CPU_ flags required */
+
+
+/* ntru_crypto_cpu_best_impl
+ *
+ * Selects among the implementations of a module, given the NTRU_CPU_ flags
+ * that each one requires.  The implementations are ordered from the
+ * portable one at index 0, which requires no features, to the fastest.
+ *
+ * Returns the index of the last implementation that the CPU supports.
+ *
+ * Modules call this from a constructor, so that the selection is made when
+ * the library is loaded, before any other thread can call into it.
+ */
+
+extern uint32_t
+ntru_crypto_cpu_best_impl(
+    uint32_t const *required,       /*  in - flags required by each impl */
+    uint32_t        num_impls);     /*  in - no. of implementations */
+
+
+#endif /* NTRU_CRYPTO_CPU_H */
@@ -27,28 +27,44 @@
  * File:  ntru_crypto_drbg.c
  *
  * Contents: Implementation of a SHA-256 HMAC-based deterministic random byte
- *           generator (HMAC_DRBG) as defined in ANSI X9.82, Part 3 - 2007.
+ *           generator (HMAC_DRBG) as defined in ANSI X9.82, Part 3 - 2007,
+ *           and of an AES-256 block cipher-based one (CTR_DRBG) as defined
+ *           in NIST SP 800-90A.
  *
  * This implementation:
- *   - allows for MAX_INSTANTIATIONS simultaneous drbg instantiations
- *     (may be overridden on compiler command line)
+ *   - allows for DRBG_MAX_INSTANTIATIONS simultaneous drbg instantiations
+ *     by default (may be overridden on compiler command line, or at run
+ *     time with ntru_crypto_drbg_set_max_instantiations)
+ *   - keeps instantiations in a lock-free handle table, so that drbgs may be
+ *     instantiated, used and uninstantiated from several threads at once
+ *   - can keep one instantiation of each drbg type per thread, which is
+ *     uninstantiated when the thread exits
  *   - has a maximum security strength of 256 bits
- *   - automatically uses SHA-256 for all security strengths
+ *   - automatically uses SHA-256 for all security strengths of HMAC_DRBG,
+ *     and AES-256 with the derivation function for all security strengths
+ *     of CTR_DRBG
  *   - allows a personalization string of length up to
- *     HMAC_DRBG_MAX_PERS_STR_BYTES bytes
+ *     HMAC_DRBG_MAX_PERS_STR_BYTES or CTR_DRBG_MAX_PERS_STR_BYTES bytes
  *   - implments reseeding
- *   - does not implement additional input for reseeding or generation
- *   - does not implement predictive resistance
+ *   - implements additional input for reseeding and generation, of up to
+ *     DRBG_MAX_ADDITIONAL_INPUT_BYTES bytes
+ *   - implements prediction resistance on request, by reseeding before
+ *     generating
  *   - limits the number of bytes requested in one invocation of generate to
- *     MAX_BYTES_PER_REQUEST
+ *     HMAC_DRBG_MAX_BYTES_PER_REQUEST or CTR_DRBG_MAX_BYTES_PER_REQUEST
  *   - uses a callback function to allow the caller to supply the
  *     Get_entropy_input routine (entropy function)
  *   - limits the number of bytes returned from the entropy function to
- *     MAX_ENTROPY_NONCE_BYTES
+ *     DRBG_MAX_ENTROPY_NONCE_BYTES
  *   - gets the nonce bytes along with the entropy input from the entropy
  *     function
  *   - automatically reseeds an instantitation after MAX_REQUESTS calls to
  *     generate
+ *   - can also reseed an instantiation on a policy of requests, bytes and
+ *     age, optionally with the entropy input for the next reseed gathered
+ *     ahead of time on a helper thread
+ *   - can buffer the output of an instantiation, generating it a pool at a
+ *     time and serving smaller requests from the pool
  *
  *****************************************************************************/
 
@@ -56,37 +72,89 @@
 #include "ntru_crypto.h"
 #include "ntru_crypto_drbg.h"
 #include "ntru_crypto_hmac.h"
+#include "ntru_crypto_aes.h"
 
+#if defined(_MSC_VER)
+#include <windows.h>
+#elif !(defined(linux) && defined(__KERNEL__))
+#include <pthread.h>
+#include <time.h>
+#else
+#include <linux/jiffies.h>
+#endif
 
-/************************
- * HMAC_DRBG parameters *
- ************************/
+
+/*******************
+ * DRBG parameters *
+ *******************/
 
 /* Note: Combined entropy input and nonce are a total of 2 * sec_strength_bits
  * of randomness to provide quantum resistance */
-#define HMAC_DRBG_MAX_MIN_ENTROPY_NONCE_BYTES                                 \
+#define DRBG_MAX_MIN_ENTROPY_NONCE_BYTES                                      \
     (2 * DRBG_MAX_SEC_STRENGTH_BITS)/8
-#define HMAC_DRBG_MAX_ENTROPY_NONCE_BYTES                                     \
-    HMAC_DRBG_MAX_MIN_ENTROPY_NONCE_BYTES * DRBG_MAX_BYTES_PER_BYTE_OF_ENTROPY
+#define DRBG_MAX_ENTROPY_NONCE_BYTES                                          \
+    DRBG_MAX_MIN_ENTROPY_NONCE_BYTES * DRBG_MAX_BYTES_PER_BYTE_OF_ENTROPY
+
+
+/************************
+ * HMAC_DRBG parameters *
+ ************************/
+
 #define HMAC_DRBG_MAX_REQUESTS            0xffffffff
 
 
+/***********************
+ * CTR_DRBG parameters *
+ ***********************/
+
+#define CTR_DRBG_SEED_LEN                 (AES256_KEY_LEN + AES_BLK_LEN)
+#define CTR_DRBG_MAX_REQUESTS             0xffffffff
+
+/* the derivation function input: the 32-bit input and output lengths, the
+ * seed material and a 0x80 byte, padded to a whole number of blocks; the
+ * seed material is at most the entropy input and the additional input,
+ * which is no shorter than the personalization string */
+#define CTR_DRBG_DF_MAX_INPUT_BYTES                                           \
+    ((8 + DRBG_MAX_ENTROPY_NONCE_BYTES + DRBG_MAX_ADDITIONAL_INPUT_BYTES +    \
+      1 + AES_BLK_LEN - 1) / AES_BLK_LEN * AES_BLK_LEN)
+
+
 /*******************
  * DRBG structures *
  *******************/
 
+/* entropy source: exactly one of the two functions is set */
+
+typedef struct {
+    ENTROPY_FN       entropy_fn;       /* byte-at-a-time entropy function */
+    ENTROPY_BULK_FN  entropy_bulk_fn;  /* bulk entropy function */
+} DRBG_ENTROPY_SRC;
+
+
 /* SHA256_HMAC_DRBG state structure */
 
 typedef struct {
     uint32_t              sec_strength;  /* security strength in bits */
     uint32_t              requests_left; /* generation requests remaining
                                             before reseeding */
-    ENTROPY_FN            entropy_fn;    /* pointer to entropy function */
-    NTRU_CRYPTO_HMAC_CTX *hmac_ctx;      /* pointer to HMAC context */
+    DRBG_ENTROPY_SRC      entropy_src;   /* entropy source */
+    NTRU_CRYPTO_HMAC_CTX  hmac_ctx;      /* HMAC context */
     uint8_t               V[33];         /* md_len size internal state + 1 */
 } SHA256_HMAC_DRBG_STATE;
 
 
+/* AES256_CTR_DRBG state structure */
+
+typedef struct {
+    uint32_t                sec_strength;  /* security strength in bits */
+    uint32_t                requests_left; /* generation requests remaining
+                                              before reseeding */
+    DRBG_ENTROPY_SRC        entropy_src;   /* entropy source */
+    NTRU_CRYPTO_AES256_KEY  key;           /* expanded Key */
+    uint8_t                 V[AES_BLK_LEN]; /* counter */
+} AES256_CTR_DRBG_STATE;
+
+
 /* External DRBG state structure */
 
 typedef struct {
@@ -94,22 +162,309 @@ typedef struct {
 } EXTERNAL_DRBG_STATE;
 
 
-/* DRBG state structure */
+/* DRBG state structure
+ *
+ * A handle is (generation << DRBG_HANDLE_INDEX_BITS) | slot index, with a
+ * non-zero generation, so a handle published in a slot is never 0 and a
+ * stale handle for a reused slot does not match the slot's new handle.
+ * The generation never wraps: a slot whose generation has reached
+ * DRBG_GENERATION_MAX is retired instead of being reused.
+ */
 
 typedef struct {
-    uint32_t    handle;
+    uint32_t    handle;     /* published handle, 0 if not instantiated */
+    uint32_t    next;       /* free-list link: slot index + 1, 0 if last */
+    uint16_t    generation; /* generation of the current/last handle */
     DRBG_TYPE   type;
-    void       *state;
+    void       *state;      /* points into storage when instantiated */
+    uint8_t    *pool;       /* buffered output, NULL if not buffering */
+    uint32_t    pool_bytes; /* size of the pool */
+    uint32_t    pool_avail; /* no. of unused bytes at the end of the pool */
+    DRBG_RESEED_POLICY policy; /* reseed policy */
+    uint32_t    requests;   /* generate requests since the last reseed */
+    uint64_t    bytes;      /* octets generated since the last reseed */
+    uint64_t    reseed_ms;  /* time of the last reseed, in milliseconds */
+    uint32_t    bg_status;  /* DRBG_BG_* status of the background entropy */
+    uint32_t    bg_entropy_bytes; /* no. of background entropy bytes */
+    uint8_t    *bg_entropy; /* entropy input for the next reseed, prepared
+                               by the helper thread, or NULL */
+    union {
+        SHA256_HMAC_DRBG_STATE  sha256_hmac;
+        AES256_CTR_DRBG_STATE   aes256_ctr;
+        EXTERNAL_DRBG_STATE     external;
+    } storage;              /* internal state, kept in the slot so that
+                               instantiation does not allocate memory */
 } DRBG_STATE;
 
 
-/*************
- * DRBG DATA *
- *************/
+/**************************
+ * DRBG handle table data *
+ **************************/
+
+#define DRBG_HANDLE_INDEX_BITS  16
+#define DRBG_HANDLE_INDEX_MASK  ((1 << DRBG_HANDLE_INDEX_BITS) - 1)
+#define DRBG_GENERATION_MAX     0xffff
+#define DRBG_TABLE_CHUNK_BITS   6
+#define DRBG_TABLE_CHUNK_SLOTS  (1 << DRBG_TABLE_CHUNK_BITS)
+#define DRBG_TABLE_NUM_CHUNKS                                                 \
+    (1 << (DRBG_HANDLE_INDEX_BITS - DRBG_TABLE_CHUNK_BITS))
+
+/* the last index is unused so that index + 1 fits the free-list link */
+
+#define DRBG_TABLE_MAX_SLOTS    DRBG_MAX_INSTANTIATIONS_LIMIT
+
+/* drbg states are kept in chunks of DRBG_TABLE_CHUNK_SLOTS slots that are
+ * allocated on first use and never freed, so a slot pointer stays valid
+ * once obtained
+ */
+
+static DRBG_STATE *drbg_table[DRBG_TABLE_NUM_CHUNKS];
+
+/* number of slots ever handed out */
+
+static uint32_t drbg_table_used;
+
+/* head of the free-slot list: (tag << 16) | (slot index + 1); the tag is
+ * bumped on every update to guard against ABA, and has 48 bits so that it
+ * cannot wrap around while a thread is between loading the head and
+ * swapping it
+ */
+
+static uint64_t drbg_free_list;
+
+/* number of live instantiations and the limit on it */
+
+static uint32_t drbg_num_instantiations;
+static uint32_t drbg_max_instantiations = DRBG_MAX_INSTANTIATIONS;
+
+
+/*********************
+ * atomic operations *
+ *********************/
+
+#if defined(_MSC_VER)
+
+static uint32_t
+drbg_atomic_load(
+    uint32_t volatile *p)
+{
+    return (uint32_t) InterlockedCompareExchange((LONG volatile *) p, 0, 0);
+}
+
+static void
+drbg_atomic_store(
+    uint32_t volatile *p,
+    uint32_t           v)
+{
+    InterlockedExchange((LONG volatile *) p, (LONG) v);
+}
+
+static bool
+drbg_atomic_cas(
+    uint32_t volatile *p,
+    uint32_t           expected,
+    uint32_t           desired)
+{
+    return InterlockedCompareExchange((LONG volatile *) p, (LONG) desired,
+                                      (LONG) expected) == (LONG) expected;
+}
+
+static uint32_t
+drbg_atomic_fetch_add(
+    uint32_t volatile *p,
+    uint32_t           v)
+{
+    return (uint32_t) InterlockedExchangeAdd((LONG volatile *) p, (LONG) v);
+}
+
+static uint64_t
+drbg_atomic_load64(
+    uint64_t volatile *p)
+{
+    return (uint64_t) InterlockedCompareExchange64((LONGLONG volatile *) p,
+                                                   0, 0);
+}
+
+static bool
+drbg_atomic_cas64(
+    uint64_t volatile *p,
+    uint64_t           expected,
+    uint64_t           desired)
+{
+    return InterlockedCompareExchange64((LONGLONG volatile *) p,
+                                        (LONGLONG) desired,
+                                        (LONGLONG) expected) ==
+           (LONGLONG) expected;
+}
+
+static void *
+drbg_atomic_load_ptr(
+    void * volatile *p)
+{
+    return InterlockedCompareExchangePointer(p, NULL, NULL);
+}
+
+static bool
+drbg_atomic_cas_ptr(
+    void * volatile *p,
+    void            *expected,
+    void            *desired)
+{
+    return InterlockedCompareExchangePointer(p, desired, expected) ==
+           expected;
+}
+
+#else
+
+static uint32_t
+drbg_atomic_load(
+    uint32_t volatile *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void
+drbg_atomic_store(
+    uint32_t volatile *p,
+    uint32_t           v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static bool
+drbg_atomic_cas(
+    uint32_t volatile *p,
+    uint32_t           expected,
+    uint32_t           desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static uint32_t
+drbg_atomic_fetch_add(
+    uint32_t volatile *p,
+    uint32_t           v)
+{
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+
+static uint64_t
+drbg_atomic_load64(
+    uint64_t volatile *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static bool
+drbg_atomic_cas64(
+    uint64_t volatile *p,
+    uint64_t           expected,
+    uint64_t           desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static void *
+drbg_atomic_load_ptr(
+    void * volatile *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static bool
+drbg_atomic_cas_ptr(
+    void * volatile *p,
+    void            *expected,
+    void            *desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#endif
+
+
+/**********************
+ * DRBG entropy input *
+ **********************/
+
+/* drbg_get_entropy_input
+ *
+ * This routine gets the entropy input for instantiating or reseeding a drbg
+ * from its entropy source.  2 * sec_strength_bits bits of entropy are
+ * requested, which also covers the nonce when instantiating; when
+ * reseeding the factor of 2 is probably unnecessary, but ensures quantum
+ * resistance even if the internal state is leaked prior to the reseed.
+ * A bulk entropy function is called once for all of the bytes; a
+ * byte-at-a-time entropy function is called for each byte.  The entropy
+ * buffer must hold DRBG_MAX_ENTROPY_NONCE_BYTES.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ENTROPY_FAIL if the entropy function fails.
+ */
+
+static uint32_t
+drbg_get_entropy_input(
+    DRBG_ENTROPY_SRC const *src,               /*  in - entropy source */
+    uint32_t                sec_strength_bits, /*  in - sec strength in bits */
+    uint8_t                *entropy,           /* out - address for entropy
+                                                        input */
+    uint32_t               *entropy_bytes)     /* out - address for no. of
+                                                        bytes */
+{
+    ENTROPY_FN entropy_fn = src->entropy_fn;
+    uint32_t   min_bytes_of_entropy;
+    uint8_t    num_bytes_per_byte_of_entropy;
+    uint32_t   i;
+
+    min_bytes_of_entropy = (2 * sec_strength_bits) / 8;
+
+    /* a bulk source delivers full-entropy bytes in one call */
+
+    if (src->entropy_bulk_fn)
+    {
+        *entropy_bytes = min_bytes_of_entropy;
+        if (src->entropy_bulk_fn(entropy, min_bytes_of_entropy,
+                                 2 * sec_strength_bits) == 0)
+        {
+            memset(entropy, 0, min_bytes_of_entropy);
+            DRBG_RET(DRBG_ENTROPY_FAIL);
+        }
+
+        DRBG_RET(DRBG_OK);
+    }
+
+    /* calculate number of bytes needed for the entropy input and get them
+     * from the entropy source
+     */
+
+    if (entropy_fn(GET_NUM_BYTES_PER_BYTE_OF_ENTROPY,
+                   &num_bytes_per_byte_of_entropy) == 0)
+    {
+        DRBG_RET(DRBG_ENTROPY_FAIL);
+    }
+
+    if ((num_bytes_per_byte_of_entropy == 0) ||
+            (num_bytes_per_byte_of_entropy >
+             DRBG_MAX_BYTES_PER_BYTE_OF_ENTROPY))
+    {
+        DRBG_RET(DRBG_ENTROPY_FAIL);
+    }
+
+    *entropy_bytes = min_bytes_of_entropy * num_bytes_per_byte_of_entropy;
 
-/* array of drbg states */
+    for (i = 0; i < *entropy_bytes; i++)
+    {
+        if (entropy_fn(GET_BYTE_OF_ENTROPY, entropy+i) == 0)
+        {
+            DRBG_RET(DRBG_ENTROPY_FAIL);
+        }
+    }
 
-static DRBG_STATE drbg_state[DRBG_MAX_INSTANTIATIONS];
+    DRBG_RET(DRBG_OK);
+}
 
 
 /******************************
@@ -127,10 +482,10 @@ static DRBG_STATE drbg_state[DRBG_MAX_INSTANTIATIONS];
  * is the seed material.
  *
  * For reseeding, provided_data1 holds the entropy input;
- * provided_data2 is NULL (because this implementation does not support
- * additional input).
+ * provided_data2 holds the optional additional input.
  *
- * For byte generation, both provided_data1 and provided_data2 are NULL.
+ * For byte generation, provided_data1 holds the optional additional input
+ * and provided_data2 is NULL.
  *
  * Returns DRBG_OK if successful.
  * Returns HMAC errors if they occur.
@@ -150,14 +505,14 @@ sha256_hmac_drbg_update(
 
     /* new key = HMAC(K, V || 0x00 [|| provided data1 [|| provided data2]] */
 
-    if ((result = ntru_crypto_hmac_init(s->hmac_ctx)) != NTRU_CRYPTO_HMAC_OK)
+    if ((result = ntru_crypto_hmac_init(&s->hmac_ctx)) != NTRU_CRYPTO_HMAC_OK)
     {
         return result;
     }
     
     s->V[md_len] = 0x00;
     
-    if ((result = ntru_crypto_hmac_update(s->hmac_ctx, s->V, md_len + 1)) !=
+    if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, s->V, md_len + 1)) !=
             NTRU_CRYPTO_HMAC_OK)
     {
         return result;
@@ -165,7 +520,7 @@ sha256_hmac_drbg_update(
     
     if (provided_data1) 
     {
-        if ((result = ntru_crypto_hmac_update(s->hmac_ctx, provided_data1,
+        if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, provided_data1,
                   provided_data1_bytes)) != NTRU_CRYPTO_HMAC_OK)
         {
             return result;
@@ -173,7 +528,7 @@ sha256_hmac_drbg_update(
             
         if (provided_data2) 
         {
-            if ((result = ntru_crypto_hmac_update(s->hmac_ctx, provided_data2,
+            if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, provided_data2,
                   provided_data2_bytes)) != NTRU_CRYPTO_HMAC_OK)
             {
                 return result;
@@ -181,13 +536,13 @@ sha256_hmac_drbg_update(
         }
     }
     
-    if ((result = ntru_crypto_hmac_final(s->hmac_ctx, key)) !=
+    if ((result = ntru_crypto_hmac_final(&s->hmac_ctx, key)) !=
             NTRU_CRYPTO_HMAC_OK)
     {
         return result;
     }
     
-    if ((result = ntru_crypto_hmac_set_key(s->hmac_ctx, key)) !=
+    if ((result = ntru_crypto_hmac_set_key(&s->hmac_ctx, key)) !=
             NTRU_CRYPTO_HMAC_OK)
     {
         return result;
@@ -195,18 +550,18 @@ sha256_hmac_drbg_update(
     
     /* new V = HMAC(K, V) */
 
-    if ((result = ntru_crypto_hmac_init(s->hmac_ctx)) != NTRU_CRYPTO_HMAC_OK)
+    if ((result = ntru_crypto_hmac_init(&s->hmac_ctx)) != NTRU_CRYPTO_HMAC_OK)
     {
         return result;
     }
     
-    if ((result = ntru_crypto_hmac_update(s->hmac_ctx, s->V, md_len)) !=
+    if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, s->V, md_len)) !=
             NTRU_CRYPTO_HMAC_OK)
     {
         return result;
     }
     
-    if ((result = ntru_crypto_hmac_final(s->hmac_ctx, s->V)) !=
+    if ((result = ntru_crypto_hmac_final(&s->hmac_ctx, s->V)) !=
             NTRU_CRYPTO_HMAC_OK)
     {
        return result;
@@ -218,7 +573,7 @@ sha256_hmac_drbg_update(
     {
         /* new key = HMAC(K, V || 0x01 || provided data1 [|| provided data2] */
 
-        if ((result = ntru_crypto_hmac_init(s->hmac_ctx)) !=
+        if ((result = ntru_crypto_hmac_init(&s->hmac_ctx)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
@@ -226,13 +581,14 @@ sha256_hmac_drbg_update(
         
         s->V[md_len] = 0x01;
         
-        if ((result = ntru_crypto_hmac_update(s->hmac_ctx, s->V, md_len + 1)) !=
+        if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, s->V,
+                                              md_len + 1)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
         }
         
-        if ((result = ntru_crypto_hmac_update(s->hmac_ctx, provided_data1,
+        if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, provided_data1,
                 provided_data1_bytes)) != NTRU_CRYPTO_HMAC_OK)
         {
             return result;
@@ -240,20 +596,20 @@ sha256_hmac_drbg_update(
         
         if (provided_data2) 
         {
-            if ((result = ntru_crypto_hmac_update(s->hmac_ctx, provided_data2,
+            if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, provided_data2,
                   provided_data2_bytes)) != NTRU_CRYPTO_HMAC_OK)
             {
                 return result;
             }
         }
         
-        if ((result = ntru_crypto_hmac_final(s->hmac_ctx, key)) !=
+        if ((result = ntru_crypto_hmac_final(&s->hmac_ctx, key)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
         }
         
-        if ((result = ntru_crypto_hmac_set_key(s->hmac_ctx, key)) !=
+        if ((result = ntru_crypto_hmac_set_key(&s->hmac_ctx, key)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
@@ -261,19 +617,19 @@ sha256_hmac_drbg_update(
         
         /* new V = HMAC(K, V) */
 
-        if ((result = ntru_crypto_hmac_init(s->hmac_ctx)) !=
+        if ((result = ntru_crypto_hmac_init(&s->hmac_ctx)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
         }
         
-        if ((result = ntru_crypto_hmac_update(s->hmac_ctx, s->V, md_len)) !=
+        if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, s->V, md_len)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
         }
         
-        if ((result = ntru_crypto_hmac_final(s->hmac_ctx, s->V)) !=
+        if ((result = ntru_crypto_hmac_final(&s->hmac_ctx, s->V)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
@@ -287,11 +643,10 @@ sha256_hmac_drbg_update(
 
 /* sha256_hmac_drbg_instantiate
  *
- * This routine allocates and initializes a SHA-256 HMAC_DRBG internal state. 
+ * This routine initializes a SHA-256 HMAC_DRBG internal state. 
  *
  * Returns DRBG_OK if successful.
  * Returns DRBG_BAD_LENGTH if the personalization string is too long.
- * Returns DRBG_OUT_OF_MEMORY if the internal state cannot be allocated.
  * Returns errors from HASH or SHA256 if those errors occur.
  */
 
@@ -300,17 +655,13 @@ sha256_hmac_drbg_instantiate(
     uint32_t                 sec_strength_bits,  /* strength to instantiate */
     uint8_t const           *pers_str,
     uint32_t                 pers_str_bytes,
-    ENTROPY_FN               entropy_fn,
-    SHA256_HMAC_DRBG_STATE **state)
+    DRBG_ENTROPY_SRC const  *src,
+    SHA256_HMAC_DRBG_STATE  *s)
 {
-    uint8_t                 entropy_nonce[HMAC_DRBG_MAX_ENTROPY_NONCE_BYTES];
+    uint8_t                 entropy_nonce[DRBG_MAX_ENTROPY_NONCE_BYTES];
     uint32_t                entropy_nonce_bytes;
-    uint32_t                min_bytes_of_entropy;
-    uint8_t                 num_bytes_per_byte_of_entropy;
     uint8_t                 key[32];             /* array of md_len size */
-    SHA256_HMAC_DRBG_STATE *s;
     uint32_t                result;
-    uint32_t                i;
 
     /* check arguments */
 
@@ -319,48 +670,22 @@ sha256_hmac_drbg_instantiate(
         DRBG_RET(DRBG_BAD_LENGTH);
     }
     
-    /* calculate number of bytes needed for the entropy input and nonce
-     * for a SHA256_HMAC_DRBG, and get them from the entropy source
-     */
+    /* get the entropy input and nonce from the entropy source */
 
-    if (entropy_fn(GET_NUM_BYTES_PER_BYTE_OF_ENTROPY,
-                   &num_bytes_per_byte_of_entropy) == 0)
-    {
-        DRBG_RET(DRBG_ENTROPY_FAIL);
-    }
-    
-    if ((num_bytes_per_byte_of_entropy == 0) ||
-            (num_bytes_per_byte_of_entropy >
-             DRBG_MAX_BYTES_PER_BYTE_OF_ENTROPY))
-    {
-        DRBG_RET(DRBG_ENTROPY_FAIL);
-    }
-    
-    min_bytes_of_entropy = (2 * sec_strength_bits) / 8;
-    entropy_nonce_bytes = min_bytes_of_entropy * num_bytes_per_byte_of_entropy;
-    
-    for (i = 0; i < entropy_nonce_bytes; i++)
-    {    
-         if (entropy_fn(GET_BYTE_OF_ENTROPY, entropy_nonce+i) == 0)
-         {
-            DRBG_RET(DRBG_ENTROPY_FAIL);
-         }
-    }
-    
-    /* allocate SHA256_HMAC_DRBG state */
-    s = (SHA256_HMAC_DRBG_STATE*) MALLOC(sizeof(SHA256_HMAC_DRBG_STATE));
-    if (s == NULL)
+    if ((result = drbg_get_entropy_input(src, sec_strength_bits,
+                                         entropy_nonce, &entropy_nonce_bytes))
+            != DRBG_OK)
     {
-        DRBG_RET(DRBG_OUT_OF_MEMORY);
+        return result;
     }
 
-    /* allocate HMAC context */
+    /* set up HMAC context */
 
     memset(key, 0, sizeof(key));
-    if ((result = ntru_crypto_hmac_create_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256,
+    if ((result = ntru_crypto_hmac_setup_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256,
                     key, sizeof(key), &s->hmac_ctx)) != NTRU_CRYPTO_HMAC_OK)
     {
-        FREE(s);
+        memset(entropy_nonce, 0, sizeof(entropy_nonce));
         return  result;
     }
 
@@ -371,9 +696,8 @@ sha256_hmac_drbg_instantiate(
                                        entropy_nonce, entropy_nonce_bytes,
                                        pers_str, pers_str_bytes)) != DRBG_OK)
     {
-        (void) ntru_crypto_hmac_destroy_ctx(s->hmac_ctx);
+        ntru_crypto_hmac_clear_ctx(&s->hmac_ctx);
         memset(s->V, 0, sizeof(s->V));
-        FREE(s);
         memset(entropy_nonce, 0, sizeof(entropy_nonce));
         return result;
     }
@@ -384,92 +708,73 @@ sha256_hmac_drbg_instantiate(
 
     s->sec_strength = sec_strength_bits;
     s->requests_left = HMAC_DRBG_MAX_REQUESTS;
-    s->entropy_fn = entropy_fn;
-    *state = s;
+    s->entropy_src = *src;
 
     return result;
 }
 
 
-/* sha256_hmac_drbg_free
- *
- * This routine frees a SHA-256 HMAC_DRBG internal state.
+/* sha256_hmac_drbg_clear
  *
- * Returns DRBG_OK if successful.
- * Returns DRBG_BAD_PARAMETER if inappropriate NULL pointers are passed.
+ * This routine zeroes a SHA-256 HMAC_DRBG internal state.
  */
 
 static void
-sha256_hmac_drbg_free(
+sha256_hmac_drbg_clear(
     SHA256_HMAC_DRBG_STATE *s)
 {
-    if (s->hmac_ctx) 
-    {
-        (void) ntru_crypto_hmac_destroy_ctx(s->hmac_ctx);
-    }
-    
+    ntru_crypto_hmac_clear_ctx(&s->hmac_ctx);
     memset(s->V, 0, sizeof(s->V));
     s->sec_strength = 0;
     s->requests_left = 0;
-    s->entropy_fn = NULL;
-    FREE(s);
+    memset(&s->entropy_src, 0, sizeof(s->entropy_src));
 }
 
 
 /* sha256_hmac_drbg_reseed
  *
- * This function reseeds an instantiated SHA256_HMAC DRBG.
+ * This function reseeds an instantiated SHA256_HMAC DRBG, with optional
+ * additional input.  The entropy input is taken from the entropy source,
+ * unless it is given in entropy.
  *
  * Returns DRBG_OK if successful.
+ * Returns DRBG_ENTROPY_FAIL if the entropy function fails.
  * Returns HMAC errors if they occur.
  */
 
 static uint32_t
 sha256_hmac_drbg_reseed(
-    SHA256_HMAC_DRBG_STATE *s)
+    SHA256_HMAC_DRBG_STATE *s,
+    uint8_t const          *entropy,
+    uint32_t                entropy_bytes,
+    uint8_t const          *additional_input,
+    uint32_t                additional_input_bytes)
 {
-    uint8_t  entropy[HMAC_DRBG_MAX_ENTROPY_NONCE_BYTES];
-    uint32_t entropy_bytes;
-    uint32_t min_bytes_of_entropy;
-    uint8_t  num_bytes_per_byte_of_entropy;
+    uint8_t  buf[DRBG_MAX_ENTROPY_NONCE_BYTES];
     uint8_t  key[32];  /* array of md_len size for sha256_hmac_drbg_update() */
     uint32_t result;
-    uint32_t i;
 
-    /* calculate number of bytes needed for the entropy input
-     * for a SHA256_HMAC_DRBG, and get them from the entropy source
-     */
+    /* get the entropy input from the entropy source, unless given */
 
-    if (s->entropy_fn(GET_NUM_BYTES_PER_BYTE_OF_ENTROPY,
-                      &num_bytes_per_byte_of_entropy) == 0)
-    {
-        DRBG_RET(DRBG_ENTROPY_FAIL);
-    }
-    
-    if ((num_bytes_per_byte_of_entropy == 0) ||
-            (num_bytes_per_byte_of_entropy >
-             DRBG_MAX_BYTES_PER_BYTE_OF_ENTROPY))
-    {
-        DRBG_RET(DRBG_ENTROPY_FAIL);
-    }
-    
-    /* note: factor of 2 here is probably unnecessary, but ensures quantum
-     * resistance even if internal state is leaked prior to reseed */
-    min_bytes_of_entropy = (2 * s->sec_strength) / 8;
-    entropy_bytes = min_bytes_of_entropy * num_bytes_per_byte_of_entropy;
-    
-    for (i = 0; i < entropy_bytes; i++)
+    if (!entropy)
     {
-        if (s->entropy_fn(GET_BYTE_OF_ENTROPY, entropy+i) == 0)
+        if ((result = drbg_get_entropy_input(&s->entropy_src,
+                                             s->sec_strength, buf,
+                                             &entropy_bytes)) != DRBG_OK)
         {
-            DRBG_RET(DRBG_ENTROPY_FAIL);
+            return result;
         }
+
+        entropy = buf;
     }
 
     /* update internal state */
 
-    if ((result = sha256_hmac_drbg_update(s, key, sizeof(key),
-            entropy, entropy_bytes, NULL, 0)) != DRBG_OK)
+    result = sha256_hmac_drbg_update(s, key, sizeof(key),
+                                     entropy, entropy_bytes,
+                                     additional_input, additional_input_bytes);
+    memset(buf, 0, sizeof(buf));
+    if (result != DRBG_OK)
     {
         return result;
     }
@@ -483,7 +788,9 @@ sha256_hmac_drbg_reseed(
 
 /* sha256_hmac_drbg_generate
  *
- * This routine generates pseudorandom bytes from a SHA256_HMAC DRBG.
+ * This routine generates pseudorandom bytes from a SHA256_HMAC DRBG,
+ * first reseeding it if prediction resistance is requested, and mixing in
+ * the optional additional input.
  *
  * Returns DRBG_OK if successful.
  * Returns DRBG_BAD_LENGTH if too many bytes are requested or the requested
@@ -495,6 +802,9 @@ static uint32_t
 sha256_hmac_drbg_generate(
     SHA256_HMAC_DRBG_STATE *s,
     uint32_t                sec_strength_bits,
+    bool                    prediction_resistance,
+    uint8_t const          *additional_input,
+    uint32_t                additional_input_bytes,
     uint32_t                num_bytes,
     uint8_t                *out)
 {
@@ -515,11 +825,31 @@ sha256_hmac_drbg_generate(
         DRBG_RET(DRBG_BAD_LENGTH);
     }
 
-    /* check if max requests have been exceeded */
+    /* reseed if prediction resistance is requested or max requests have
+     * been exceeded; the additional input is then used by the reseed
+     */
+
+    if (prediction_resistance || (s->requests_left == 0))
+    {
+        if ((result = sha256_hmac_drbg_reseed(s, NULL, 0, additional_input,
+                                              additional_input_bytes))
+                != DRBG_OK)
+        {
+            return result;
+        }
+
+        additional_input = NULL;
+        additional_input_bytes = 0;
+    }
+
+    /* mix in the additional input */
 
-    if (s->requests_left == 0)
+    if (additional_input)
     {
-        if ((result = sha256_hmac_drbg_reseed(s)) != DRBG_OK)
+        if ((result = sha256_hmac_drbg_update(s, key, sizeof(key),
+                                              additional_input,
+                                              additional_input_bytes,
+                                              NULL, 0)) != DRBG_OK)
         {
             return result;
         }
@@ -531,19 +861,19 @@ sha256_hmac_drbg_generate(
     {
         /* generate md_len bytes = V = HMAC(K, V) */
 
-        if ((result = ntru_crypto_hmac_init(s->hmac_ctx)) !=
+        if ((result = ntru_crypto_hmac_init(&s->hmac_ctx)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
         }
             
-        if ((result = ntru_crypto_hmac_update(s->hmac_ctx, s->V,
+        if ((result = ntru_crypto_hmac_update(&s->hmac_ctx, s->V,
                         sizeof(key))) != NTRU_CRYPTO_HMAC_OK)
         {
             return result;
         }
 
-        if ((result = ntru_crypto_hmac_final(s->hmac_ctx, s->V)) !=
+        if ((result = ntru_crypto_hmac_final(&s->hmac_ctx, s->V)) !=
                 NTRU_CRYPTO_HMAC_OK)
         {
             return result;
@@ -567,7 +897,8 @@ sha256_hmac_drbg_generate(
     /* update internal state */
 
     if ((result = sha256_hmac_drbg_update(s, key, sizeof(key),
-                            NULL, 0, NULL, 0)) != DRBG_OK)
+                            additional_input, additional_input_bytes,
+                            NULL, 0)) != DRBG_OK)
     {
         return result;
     }
@@ -578,304 +909,2282 @@ sha256_hmac_drbg_generate(
 }
 
 
-/******************
- * DRBG functions *
- ******************/
+/*****************************
+ * AES256 CTR_DRBG functions *
+ *****************************/
 
-/* drbg_get_new_drbg
+/* aes256_ctr_drbg_df
  *
- * This routine finds an uninstantiated drbg state and returns a pointer to it.
+ * This routine is the block cipher derivation function (Block_Cipher_df)
+ * of the AES-256 CTR_DRBG.  It derives CTR_DRBG_SEED_LEN bytes from the
+ * concatenation of input1 and the optional input2, which need not be
+ * full-entropy.
  *
- * Returns a pointer to an uninstantiated drbg state if found.
- * Returns NULL if all drbg states are instantiated.
+ * Three BCC chains under the fixed key 00 01 ... 1f, which differ only in
+ * their first block, are run over the same input, so they are computed in
+ * one pass.  Their outputs are the key and the first block for encrypting
+ * the derived bytes.
  */
 
-static DRBG_STATE *
-drbg_get_new_drbg()
+static void
+aes256_ctr_drbg_df(
+    uint8_t const *input1,
+    uint32_t       input1_bytes,
+    uint8_t const *input2,
+    uint32_t       input2_bytes,
+    uint8_t       *out)             /* CTR_DRBG_SEED_LEN size array */
 {
-    int i;
+    NTRU_CRYPTO_AES256_KEY  ks;
+    uint8_t                 s[CTR_DRBG_DF_MAX_INPUT_BYTES];
+    uint8_t                 x[CTR_DRBG_SEED_LEN];
+    uint32_t                s_bytes;
+    uint32_t                len;
+    uint32_t                i, j, k;
+
+    /* S = L || N || input || 0x80, padded with zeros */
+
+    len = input1_bytes + input2_bytes;
+    s[0] = (uint8_t)(len >> 24);
+    s[1] = (uint8_t)(len >> 16);
+    s[2] = (uint8_t)(len >> 8);
+    s[3] = (uint8_t)len;
+    s[4] = 0;
+    s[5] = 0;
+    s[6] = 0;
+    s[7] = CTR_DRBG_SEED_LEN;
+    memcpy(s + 8, input1, input1_bytes);
+    if (input2)
+    {
+        memcpy(s + 8 + input1_bytes, input2, input2_bytes);
+    }
+    s[8 + len] = 0x80;
+    s_bytes = (8 + len + 1 + AES_BLK_LEN - 1) / AES_BLK_LEN * AES_BLK_LEN;
+    memset(s + 8 + len + 1, 0, s_bytes - (8 + len + 1));
+
+    /* BCC(K, IV_i || S) for i = 0, 1, 2, where IV_i is the 32-bit i
+     * followed by zeros; the chaining values start at E(K, IV_i)
+     */
+
+    for (i = 0; i < AES256_KEY_LEN; i++)
+    {
+        x[i] = (uint8_t)i;
+    }
+    ntru_crypto_aes256_set_key(x, &ks);
+
+    memset(x, 0, sizeof(x));
+    for (k = 0; k < CTR_DRBG_SEED_LEN / AES_BLK_LEN; k++)
+    {
+        x[k * AES_BLK_LEN + 3] = (uint8_t)k;
+        ntru_crypto_aes256_encrypt(&ks, x + k * AES_BLK_LEN,
+                                   x + k * AES_BLK_LEN);
+    }
 
-    for (i = 0; i < DRBG_MAX_INSTANTIATIONS; i++) 
+    for (i = 0; i < s_bytes; i += AES_BLK_LEN)
     {
-        if (drbg_state[i].state == NULL)
+        for (k = 0; k < CTR_DRBG_SEED_LEN; k += AES_BLK_LEN)
         {
-            return drbg_state+i;
+            for (j = 0; j < AES_BLK_LEN; j++)
+            {
+                x[k + j] ^= s[i + j];
+            }
+            ntru_crypto_aes256_encrypt(&ks, x + k, x + k);
         }
     }
-    
-    return NULL;
+
+    /* encrypt X repeatedly under the derived key for the output */
+
+    ntru_crypto_aes256_set_key(x, &ks);
+    ntru_crypto_aes256_encrypt(&ks, x + AES256_KEY_LEN, out);
+    for (k = AES_BLK_LEN; k < CTR_DRBG_SEED_LEN; k += AES_BLK_LEN)
+    {
+        ntru_crypto_aes256_encrypt(&ks, out + k - AES_BLK_LEN, out + k);
+    }
+
+    memset(&ks, 0, sizeof(ks));
+    memset(s, 0, sizeof(s));
+    memset(x, 0, sizeof(x));
 }
 
 
-/* drbg_get_drbg
- *
- * This routine finds an instantiated drbg state given its handle, and returns
- * a pointer to it.
+/* aes256_ctr_drbg_update
  *
- * Returns a pointer to the drbg state if found.
- * Returns NULL if the drbg state is not found.
+ * This routine is the update function of the AES-256 CTR_DRBG, used in
+ * instantiation, reseeding and generation.  It replaces Key and V with the
+ * next CTR_DRBG_SEED_LEN bytes of keystream XORed with the provided data,
+ * or with the keystream alone when provided_data is NULL.
  */
 
-static DRBG_STATE *
-drbg_get_drbg(
-    DRBG_HANDLE handle)             /* in/out - drbg handle */
+static void
+aes256_ctr_drbg_update(
+    AES256_CTR_DRBG_STATE *s,
+    uint8_t const         *provided_data)   /* CTR_DRBG_SEED_LEN size array */
 {
-    int i;
+    uint8_t  temp[CTR_DRBG_SEED_LEN];
+    uint32_t i;
 
-    for (i = 0; i < DRBG_MAX_INSTANTIATIONS; i++) 
+    ntru_crypto_aes256_ctr(&s->key, s->V, CTR_DRBG_SEED_LEN / AES_BLK_LEN,
+                           temp);
+
+    if (provided_data)
     {
-        if ((drbg_state[i].handle == handle) && drbg_state[i].state)
+        for (i = 0; i < CTR_DRBG_SEED_LEN; i++)
         {
-            return drbg_state+i;
+            temp[i] ^= provided_data[i];
         }
     }
-    
-    return NULL;
+
+    ntru_crypto_aes256_set_key(temp, &s->key);
+    memcpy(s->V, temp + AES256_KEY_LEN, AES_BLK_LEN);
+    memset(temp, 0, sizeof(temp));
 }
 
 
-/* drbg_get_new_handle
+/* aes256_ctr_drbg_instantiate
  *
- * This routine gets a new, unique 32-bit handle.
+ * This routine initializes an AES-256 CTR_DRBG internal state.
  *
- * Returns the new DRBG handle.
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_BAD_LENGTH if the personalization string is too long.
+ * Returns DRBG_ENTROPY_FAIL if the entropy function fails.
  */
 
-static DRBG_HANDLE
-drbg_get_new_handle(void)
+static uint32_t
+aes256_ctr_drbg_instantiate(
+    uint32_t                 sec_strength_bits,  /* strength to instantiate */
+    uint8_t const           *pers_str,
+    uint32_t                 pers_str_bytes,
+    DRBG_ENTROPY_SRC const  *src,
+    AES256_CTR_DRBG_STATE   *s)
 {
-    DRBG_HANDLE h = 0;
+    uint8_t                 entropy_nonce[DRBG_MAX_ENTROPY_NONCE_BYTES];
+    uint32_t                entropy_nonce_bytes;
+    uint8_t                 seed[CTR_DRBG_SEED_LEN];
+    uint8_t                 key[AES256_KEY_LEN];
+    uint32_t                result;
 
-    /* ensure the new handle is unique:
-     *  if it already exists, increment it
-     */
+    /* check arguments */
 
-    while (drbg_get_drbg(h) != NULL)
+    if (pers_str_bytes > CTR_DRBG_MAX_PERS_STR_BYTES)
     {
-        ++h;
+        DRBG_RET(DRBG_BAD_LENGTH);
     }
 
-    return h;
-}
+    /* get the entropy input and nonce from the entropy source */
 
+    if ((result = drbg_get_entropy_input(src, sec_strength_bits,
+                                         entropy_nonce, &entropy_nonce_bytes))
+            != DRBG_OK)
+    {
+        return result;
+    }
 
-/********************
- * Public functions *
+    /* seed material = df(entropy input || nonce || personalization string),
+     * then update from Key = 0, V = 0
+     */
+
+    aes256_ctr_drbg_df(entropy_nonce, entropy_nonce_bytes,
+                       pers_str, pers_str_bytes, seed);
+    memset(entropy_nonce, 0, sizeof(entropy_nonce));
+
+    memset(key, 0, sizeof(key));
+    memset(s->V, 0, sizeof(s->V));
+    ntru_crypto_aes256_set_key(key, &s->key);
+    aes256_ctr_drbg_update(s, seed);
+    memset(seed, 0, sizeof(seed));
+
+    /* init instantiation parameters */
+
+    s->sec_strength = sec_strength_bits;
+    s->requests_left = CTR_DRBG_MAX_REQUESTS;
+    s->entropy_src = *src;
+
+    DRBG_RET(DRBG_OK);
+}
+
+
+/* aes256_ctr_drbg_clear
+ *
+ * This routine zeroes an AES-256 CTR_DRBG internal state.
+ */
+
+static void
+aes256_ctr_drbg_clear(
+    AES256_CTR_DRBG_STATE *s)
+{
+    memset(&s->key, 0, sizeof(s->key));
+    memset(s->V, 0, sizeof(s->V));
+    s->sec_strength = 0;
+    s->requests_left = 0;
+    memset(&s->entropy_src, 0, sizeof(s->entropy_src));
+}
+
+
+/* aes256_ctr_drbg_reseed
+ *
+ * This function reseeds an instantiated AES-256 CTR_DRBG, with optional
+ * additional input.  The entropy input is taken from the entropy source,
+ * unless it is given in entropy.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ENTROPY_FAIL if the entropy function fails.
+ */
+
+static uint32_t
+aes256_ctr_drbg_reseed(
+    AES256_CTR_DRBG_STATE *s,
+    uint8_t const         *entropy,
+    uint32_t               entropy_bytes,
+    uint8_t const         *additional_input,
+    uint32_t               additional_input_bytes)
+{
+    uint8_t  buf[DRBG_MAX_ENTROPY_NONCE_BYTES];
+    uint8_t  seed[CTR_DRBG_SEED_LEN];
+    uint32_t result;
+
+    /* get the entropy input from the entropy source, unless given */
+
+    if (!entropy)
+    {
+        if ((result = drbg_get_entropy_input(&s->entropy_src,
+                                             s->sec_strength, buf,
+                                             &entropy_bytes)) != DRBG_OK)
+        {
+            return result;
+        }
+
+        entropy = buf;
+    }
+
+    /* update internal state with df(entropy input || additional input) */
+
+    aes256_ctr_drbg_df(entropy, entropy_bytes,
+                       additional_input, additional_input_bytes, seed);
+    memset(buf, 0, sizeof(buf));
+    aes256_ctr_drbg_update(s, seed);
+    memset(seed, 0, sizeof(seed));
+
+    /* reset request counter */
+
+    s->requests_left = CTR_DRBG_MAX_REQUESTS;
+    DRBG_RET(DRBG_OK);
+}
+
+
+/* aes256_ctr_drbg_generate
+ *
+ * This routine generates pseudorandom bytes from an AES-256 CTR_DRBG,
+ * first reseeding it if prediction resistance is requested, and mixing in
+ * the optional additional input.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_BAD_LENGTH if too many bytes are requested or the requested
+ *  security strength is too large.
+ * Returns DRBG_ENTROPY_FAIL if reseeding is needed and the entropy function
+ *  fails.
+ */
+
+static uint32_t
+aes256_ctr_drbg_generate(
+    AES256_CTR_DRBG_STATE *s,
+    uint32_t               sec_strength_bits,
+    bool                   prediction_resistance,
+    uint8_t const         *additional_input,
+    uint32_t               additional_input_bytes,
+    uint32_t               num_bytes,
+    uint8_t               *out)
+{
+    uint8_t  seed[CTR_DRBG_SEED_LEN];
+    uint8_t  block[AES_BLK_LEN];
+    uint32_t num_blocks;
+    uint32_t result;
+
+    /* check if number of bytes requested exceeds the maximum allowed */
+
+    if (num_bytes > CTR_DRBG_MAX_BYTES_PER_REQUEST)
+    {
+        DRBG_RET(DRBG_BAD_LENGTH);
+    }
+
+    /* check if drbg has adequate security strength */
+
+    if (sec_strength_bits > s->sec_strength)
+    {
+        DRBG_RET(DRBG_BAD_LENGTH);
+    }
+
+    /* reseed if prediction resistance is requested or max requests have
+     * been exceeded; the additional input is then used by the reseed
+     */
+
+    if (prediction_resistance || (s->requests_left == 0))
+    {
+        if ((result = aes256_ctr_drbg_reseed(s, NULL, 0, additional_input,
+                                             additional_input_bytes))
+                != DRBG_OK)
+        {
+            return result;
+        }
+
+        additional_input = NULL;
+    }
+
+    /* mix in df(additional input) */
+
+    if (additional_input)
+    {
+        aes256_ctr_drbg_df(additional_input, additional_input_bytes,
+                           NULL, 0, seed);
+        aes256_ctr_drbg_update(s, seed);
+    }
+
+    /* generate pseudorandom bytes: whole blocks of keystream straight into
+     * the output buffer, then any partial block through a copy
+     */
+
+    num_blocks = num_bytes / AES_BLK_LEN;
+    if (num_blocks > 0)
+    {
+        ntru_crypto_aes256_ctr(&s->key, s->V, num_blocks, out);
+    }
+
+    if (num_bytes % AES_BLK_LEN)
+    {
+        ntru_crypto_aes256_ctr(&s->key, s->V, 1, block);
+        memcpy(out + num_blocks * AES_BLK_LEN, block,
+               num_bytes % AES_BLK_LEN);
+        memset(block, 0, sizeof(block));
+    }
+
+    /* update internal state, with df(additional input) again if given */
+
+    aes256_ctr_drbg_update(s, additional_input ? seed : NULL);
+    memset(seed, 0, sizeof(seed));
+    s->requests_left--;
+
+    DRBG_RET(DRBG_OK);
+}
+
+
+/******************
+ * DRBG functions *
+ ******************/
+
+/* drbg_reserve
+ *
+ * This routine counts a new instantiation against the instantiation limit.
+ *
+ * Returns TRUE if the instantiation may proceed.
+ * Returns FALSE if the limit has been reached.
+ */
+
+static bool
+drbg_reserve(void)
+{
+    uint32_t n;
+
+    do
+    {
+        n = drbg_atomic_load(&drbg_num_instantiations);
+
+        if (n >= drbg_atomic_load(&drbg_max_instantiations))
+        {
+            return FALSE;
+        }
+    } while (!drbg_atomic_cas(&drbg_num_instantiations, n, n + 1));
+
+    return TRUE;
+}
+
+
+/* drbg_release
+ *
+ * This routine returns an instantiation reserved with drbg_reserve.
+ */
+
+static void
+drbg_release(void)
+{
+    drbg_atomic_fetch_add(&drbg_num_instantiations, (uint32_t)-1);
+}
+
+
+/* drbg_get_slot
+ *
+ * This routine returns a pointer to the drbg state in slot index.
+ *
+ * Returns a pointer to the drbg state.
+ * Returns NULL if the slot has never been allocated.
+ */
+
+static DRBG_STATE *
+drbg_get_slot(
+    uint32_t index)                 /* in - slot index */
+{
+    DRBG_STATE *chunk;
+
+    chunk = (DRBG_STATE *) drbg_atomic_load_ptr(
+                (void * volatile *) (drbg_table +
+                                     (index >> DRBG_TABLE_CHUNK_BITS)));
+    if (chunk == NULL)
+    {
+        return NULL;
+    }
+
+    return chunk + (index & (DRBG_TABLE_CHUNK_SLOTS - 1));
+}
+
+
+/* drbg_get_new_drbg
+ *
+ * This routine claims an unused drbg state, from the free list if possible
+ * and otherwise from the end of the table, and returns a pointer to it.
+ * The slot index is returned in index.
+ *
+ * Returns a pointer to an unused drbg state if found.
+ * Returns NULL if the table is full or a chunk cannot be allocated.
+ */
+
+static DRBG_STATE *
+drbg_get_new_drbg(
+    uint32_t *index)                /* out - address for slot index */
+{
+    DRBG_STATE *drbg;
+    DRBG_STATE *chunk;
+    uint64_t    head;
+    uint32_t    next;
+    uint32_t    i;
+
+    /* pop the free list */
+
+    for (;;)
+    {
+        head = drbg_atomic_load64(&drbg_free_list);
+
+        if ((head & DRBG_HANDLE_INDEX_MASK) == 0)
+        {
+            break;
+        }
+
+        drbg = drbg_get_slot((uint32_t)(head & DRBG_HANDLE_INDEX_MASK) - 1);
+        next = drbg_atomic_load(&drbg->next);
+
+        if (drbg_atomic_cas64(&drbg_free_list, head,
+                              (head & ~(uint64_t) DRBG_HANDLE_INDEX_MASK) +
+                              ((uint64_t) 1 << DRBG_HANDLE_INDEX_BITS) + next))
+        {
+            *index = (uint32_t)(head & DRBG_HANDLE_INDEX_MASK) - 1;
+            return drbg;
+        }
+    }
+
+    /* take a never-used slot, first making sure that its chunk has been
+     * allocated, so that the count of slots handed out only moves past
+     * slots that can be used
+     */
+
+    do
+    {
+        i = drbg_atomic_load(&drbg_table_used);
+
+        if (i >= DRBG_TABLE_MAX_SLOTS)
+        {
+            return NULL;
+        }
+
+        if (drbg_get_slot(i) == NULL)
+        {
+            chunk = (DRBG_STATE *) MALLOC(DRBG_TABLE_CHUNK_SLOTS *
+                                          sizeof(DRBG_STATE));
+            if (chunk == NULL)
+            {
+                return NULL;
+            }
+
+            memset(chunk, 0, DRBG_TABLE_CHUNK_SLOTS * sizeof(DRBG_STATE));
+
+            if (!drbg_atomic_cas_ptr((void * volatile *) (drbg_table +
+                                                 (i >> DRBG_TABLE_CHUNK_BITS)),
+                                     NULL, chunk))
+            {
+                /* another thread installed the chunk first */
+
+                FREE(chunk);
+            }
+        }
+    } while (!drbg_atomic_cas(&drbg_table_used, i, i + 1));
+
+    *index = i;
+    return drbg_get_slot(i);
+}
+
+
+/* drbg_put_drbg
+ *
+ * This routine returns the drbg state in slot index to the free list, or
+ * retires the slot if its generation is used up, so that a stale handle
+ * can never match a later handle for the slot.
+ */
+
+static void
+drbg_put_drbg(
+    DRBG_STATE *drbg,               /* in - drbg state */
+    uint32_t    index)              /* in - slot index */
+{
+    uint64_t head;
+
+    if (drbg->generation == DRBG_GENERATION_MAX)
+    {
+        return;
+    }
+
+    do
+    {
+        head = drbg_atomic_load64(&drbg_free_list);
+        drbg_atomic_store(&drbg->next,
+                          (uint32_t)(head & DRBG_HANDLE_INDEX_MASK));
+    } while (!drbg_atomic_cas64(&drbg_free_list, head,
+                                (head & ~(uint64_t) DRBG_HANDLE_INDEX_MASK) +
+                                ((uint64_t) 1 << DRBG_HANDLE_INDEX_BITS) +
+                                index + 1));
+}
+
+
+/* drbg_publish
+ *
+ * This routine fills in a claimed drbg state and makes it visible to
+ * drbg_get_drbg under a new handle.
+ *
+ * Returns the new DRBG handle.
+ */
+
+static DRBG_HANDLE
+drbg_publish(
+    DRBG_STATE *drbg,               /* in - claimed drbg state */
+    uint32_t    index,              /* in - slot index */
+    DRBG_TYPE   type,               /* in - drbg type */
+    void       *state)              /* in - drbg internal state */
+{
+    DRBG_HANDLE h;
+
+    /* the generation starts at 1, so that a published handle is never 0,
+     * and slots are retired before it would wrap
+     */
+
+    drbg->generation++;
+
+    drbg->type = type;
+    drbg->state = state;
+
+    h = ((DRBG_HANDLE) drbg->generation << DRBG_HANDLE_INDEX_BITS) | index;
+    drbg_atomic_store(&drbg->handle, h);
+
+    return h;
+}
+
+
+/* drbg_get_drbg
+ *
+ * This routine finds an instantiated drbg state given its handle, and returns
+ * a pointer to it.
+ *
+ * Returns a pointer to the drbg state if found.
+ * Returns NULL if the drbg state is not found.
+ */
+
+static DRBG_STATE *
+drbg_get_drbg(
+    DRBG_HANDLE handle)             /* in - drbg handle */
+{
+    DRBG_STATE *drbg;
+
+    if (handle == 0)
+    {
+        return NULL;
+    }
+
+    drbg = drbg_get_slot(handle & DRBG_HANDLE_INDEX_MASK);
+
+    if ((drbg == NULL) || (drbg_atomic_load(&drbg->handle) != handle))
+    {
+        return NULL;
+    }
+
+    return drbg;
+}
+
+
+/* drbg_get_sec_strength
+ *
+ * This routine returns the security strength of an instantiated HMAC_DRBG
+ * or CTR_DRBG.
+ */
+
+static uint32_t
+drbg_get_sec_strength(
+    DRBG_STATE const *drbg)         /* in - drbg state */
+{
+    switch (drbg->type)
+    {
+        case SHA256_HMAC_DRBG:
+            return ((SHA256_HMAC_DRBG_STATE *)drbg->state)->sec_strength;
+        case AES256_CTR_DRBG:
+            return ((AES256_CTR_DRBG_STATE *)drbg->state)->sec_strength;
+        default:
+            return 0;
+    }
+}
+
+
+/* drbg_clear_pool
+ *
+ * This routine zeroes and frees the output pool of a drbg, if it has one.
+ */
+
+static void
+drbg_clear_pool(
+    DRBG_STATE *drbg)               /* in - drbg state */
+{
+    if (drbg->pool)
+    {
+        memset(drbg->pool, 0, drbg->pool_bytes);
+        FREE(drbg->pool);
+        drbg->pool = NULL;
+    }
+
+    drbg->pool_bytes = 0;
+    drbg->pool_avail = 0;
+}
+
+
+/*******************
+ * reseed schedule *
+ *******************/
+
+/* status of the background entropy input of a drbg */
+
+#define DRBG_BG_IDLE        0   /* no background reseeding */
+#define DRBG_BG_REQUESTED   1   /* waiting for the helper thread */
+#define DRBG_BG_FILLING     2   /* being filled by the helper thread */
+#define DRBG_BG_READY       3   /* ready for the next reseed */
+#define DRBG_BG_FAILED      4   /* the entropy function failed */
+
+/* a reseed put off while the helper thread gets the entropy input is done
+ * directly once the drbg is this many times past its policy's limits
+ */
+
+#define DRBG_BG_HARD_LIMIT  2
+
+/* state of the helper thread, guarded by the helper thread lock: whether
+ * it is running, its generation, which is bumped to make it exit, and the
+ * no. of drbgs that reseed in the background
+ */
+
+static bool     drbg_bg_running;
+static uint32_t drbg_bg_gen;
+static uint32_t drbg_bg_users;
+
+static void drbg_bg_work(uint32_t gen);
+
+#if defined(_MSC_VER)
+
+typedef HANDLE DRBG_BG_THREAD;
+
+static SRWLOCK            drbg_bg_mutex = SRWLOCK_INIT;
+static CONDITION_VARIABLE drbg_bg_cond = CONDITION_VARIABLE_INIT;
+static DRBG_BG_THREAD     drbg_bg_handle;
+
+static uint64_t
+drbg_time_ms(void)
+{
+    return (uint64_t) GetTickCount64();
+}
+
+static void
+drbg_bg_lock(void)
+{
+    AcquireSRWLockExclusive(&drbg_bg_mutex);
+}
+
+static void
+drbg_bg_unlock(void)
+{
+    ReleaseSRWLockExclusive(&drbg_bg_mutex);
+}
+
+static void
+drbg_bg_wait(void)
+{
+    SleepConditionVariableSRW(&drbg_bg_cond, &drbg_bg_mutex, INFINITE, 0);
+}
+
+static void
+drbg_bg_wake(void)
+{
+    WakeAllConditionVariable(&drbg_bg_cond);
+}
+
+static DWORD WINAPI
+drbg_bg_thread(
+    LPVOID arg)
+{
+    drbg_bg_work((uint32_t)(uintptr_t) arg);
+    return 0;
+}
+
+static bool
+drbg_bg_start(void)
+{
+    HANDLE thread;
+
+    if (!drbg_bg_running)
+    {
+        if ((thread = CreateThread(NULL, 0, drbg_bg_thread,
+                                   (LPVOID)(uintptr_t) drbg_bg_gen, 0,
+                                   NULL)) == NULL)
+        {
+            return FALSE;
+        }
+
+        drbg_bg_handle = thread;
+        drbg_bg_running = TRUE;
+    }
+
+    return TRUE;
+}
+
+static void
+drbg_bg_join(
+    DRBG_BG_THREAD thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+#elif !(defined(linux) && defined(__KERNEL__))
+
+typedef pthread_t DRBG_BG_THREAD;
+
+static pthread_mutex_t drbg_bg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  drbg_bg_cond = PTHREAD_COND_INITIALIZER;
+static DRBG_BG_THREAD  drbg_bg_handle;
+
+static uint64_t
+drbg_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+static void
+drbg_bg_lock(void)
+{
+    pthread_mutex_lock(&drbg_bg_mutex);
+}
+
+static void
+drbg_bg_unlock(void)
+{
+    pthread_mutex_unlock(&drbg_bg_mutex);
+}
+
+static void
+drbg_bg_wait(void)
+{
+    pthread_cond_wait(&drbg_bg_cond, &drbg_bg_mutex);
+}
+
+static void
+drbg_bg_wake(void)
+{
+    pthread_cond_broadcast(&drbg_bg_cond);
+}
+
+static void *
+drbg_bg_thread(
+    void *arg)
+{
+    drbg_bg_work((uint32_t)(uintptr_t) arg);
+    return NULL;
+}
+
+static bool
+drbg_bg_start(void)
+{
+    if (!drbg_bg_running)
+    {
+        if (pthread_create(&drbg_bg_handle, NULL, drbg_bg_thread,
+                           (void *)(uintptr_t) drbg_bg_gen) != 0)
+        {
+            return FALSE;
+        }
+
+        drbg_bg_running = TRUE;
+    }
+
+    return TRUE;
+}
+
+static void
+drbg_bg_join(
+    DRBG_BG_THREAD thread)
+{
+    pthread_join(thread, NULL);
+}
+
+#else
+
+/* no helper thread in the kernel */
+
+typedef int DRBG_BG_THREAD;
+
+static DRBG_BG_THREAD drbg_bg_handle;
+
+static uint64_t
+drbg_time_ms(void)
+{
+    return (uint64_t) jiffies_to_msecs(jiffies);
+}
+
+static void
+drbg_bg_lock(void)
+{
+}
+
+static void
+drbg_bg_unlock(void)
+{
+}
+
+static void
+drbg_bg_wait(void)
+{
+}
+
+static void
+drbg_bg_wake(void)
+{
+}
+
+static bool
+drbg_bg_start(void)
+{
+    return FALSE;
+}
+
+static void
+drbg_bg_join(
+    DRBG_BG_THREAD thread)
+{
+    (void) thread;
+}
+
+#endif
+
+
+/* drbg_get_entropy_src
+ *
+ * This routine returns the entropy source of an instantiated HMAC_DRBG or
+ * CTR_DRBG.
+ */
+
+static DRBG_ENTROPY_SRC const *
+drbg_get_entropy_src(
+    DRBG_STATE const *drbg)         /* in - drbg state */
+{
+    if (drbg->type == AES256_CTR_DRBG)
+    {
+        return &((AES256_CTR_DRBG_STATE *)drbg->state)->entropy_src;
+    }
+
+    return &((SHA256_HMAC_DRBG_STATE *)drbg->state)->entropy_src;
+}
+
+
+/* drbg_bg_find
+ *
+ * This routine finds a drbg whose background entropy input has been
+ * requested.  It is called with the helper thread lock held.
+ *
+ * Returns a pointer to the drbg state if found.
+ * Returns NULL otherwise.
+ */
+
+static DRBG_STATE *
+drbg_bg_find(void)
+{
+    DRBG_STATE *drbg;
+    uint32_t    n;
+    uint32_t    i;
+
+    n = drbg_atomic_load(&drbg_table_used);
+
+    for (i = 0; (i < n) && (i < DRBG_TABLE_MAX_SLOTS); i++)
+    {
+        if (((drbg = drbg_get_slot(i)) != NULL) &&
+            (drbg_atomic_load(&drbg->bg_status) == DRBG_BG_REQUESTED))
+        {
+            return drbg;
+        }
+    }
+
+    return NULL;
+}
+
+
+/* drbg_bg_work
+ *
+ * This routine is the body of the helper thread.  It gets the entropy input
+ * for the next reseed of each drbg that requests it, without holding the
+ * lock, so that a slow entropy function does not hold up generate calls.
+ * It returns when the helper thread generation moves on from gen, which is
+ * the generation the thread was started with.
+ */
+
+static void
+drbg_bg_work(
+    uint32_t gen)                   /* in - generation of this thread */
+{
+    DRBG_STATE *drbg;
+    uint32_t    entropy_bytes = 0;
+    uint32_t    result;
+
+    drbg_bg_lock();
+
+    for (;;)
+    {
+        while (((drbg = drbg_bg_find()) == NULL) && (drbg_bg_gen == gen))
+        {
+            drbg_bg_wait();
+        }
+
+        if (drbg_bg_gen != gen)
+        {
+            break;
+        }
+
+        drbg_atomic_store(&drbg->bg_status, DRBG_BG_FILLING);
+        drbg_bg_unlock();
+
+        result = drbg_get_entropy_input(drbg_get_entropy_src(drbg),
+                                        drbg_get_sec_strength(drbg),
+                                        drbg->bg_entropy, &entropy_bytes);
+
+        drbg_bg_lock();
+        drbg->bg_entropy_bytes = entropy_bytes;
+        drbg_atomic_store(&drbg->bg_status, (result == DRBG_OK) ?
+                                            DRBG_BG_READY : DRBG_BG_FAILED);
+        drbg_bg_wake();
+    }
+
+    drbg_bg_unlock();
+}
+
+
+/* drbg_bg_request
+ *
+ * This routine asks the helper thread for the entropy input for the next
+ * reseed of a drbg.
+ */
+
+static void
+drbg_bg_request(
+    DRBG_STATE *drbg)               /* in - drbg state */
+{
+    drbg_bg_lock();
+    drbg_atomic_store(&drbg->bg_status, DRBG_BG_REQUESTED);
+    drbg_bg_wake();
+    drbg_bg_unlock();
+}
+
+
+/* drbg_bg_stop
+ *
+ * This routine turns background reseeding off for a drbg, waiting for the
+ * helper thread if it is filling the drbg's entropy input, and zeroes and
+ * frees the entropy input.  When no drbg reseeds in the background any
+ * more, the helper thread is stopped and joined; a drbg turning background
+ * reseeding on meanwhile starts a new one.
+ */
+
+static void
+drbg_bg_stop(
+    DRBG_STATE *drbg)               /* in - drbg state */
+{
+    DRBG_BG_THREAD thread;
+    bool           join = FALSE;
+
+    if (drbg->bg_entropy == NULL)
+    {
+        return;
+    }
+
+    drbg_bg_lock();
+
+    while (drbg_atomic_load(&drbg->bg_status) == DRBG_BG_FILLING)
+    {
+        drbg_bg_wait();
+    }
+
+    drbg_atomic_store(&drbg->bg_status, DRBG_BG_IDLE);
+
+    if ((--drbg_bg_users == 0) && drbg_bg_running)
+    {
+        thread = drbg_bg_handle;
+        drbg_bg_running = FALSE;
+        drbg_bg_gen++;
+        drbg_bg_wake();
+        join = TRUE;
+    }
+
+    drbg_bg_unlock();
+
+    if (join)
+    {
+        drbg_bg_join(thread);
+    }
+
+    memset(drbg->bg_entropy, 0, DRBG_MAX_ENTROPY_NONCE_BYTES);
+    FREE(drbg->bg_entropy);
+    drbg->bg_entropy = NULL;
+    drbg->bg_entropy_bytes = 0;
+}
+
+
+/* drbg_reseed
+ *
+ * This routine reseeds an instantiated HMAC_DRBG or CTR_DRBG, with the
+ * given entropy input or, if entropy is NULL, entropy input from its
+ * entropy source, and restarts its reseed schedule.  Every reseed comes
+ * through here, so this is also where buffered output, which predates the
+ * new entropy, is discarded.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_BAD_PARAMETER if the drbg is an external drbg.
+ * Returns the errors of the drbg's reseed function if they occur.
+ */
+
+static uint32_t
+drbg_reseed(
+    DRBG_STATE    *drbg,                   /* in - drbg state */
+    uint8_t const *entropy,                /* in - entropy input, or NULL */
+    uint32_t       entropy_bytes,          /* in - no. entropy input bytes */
+    uint8_t const *additional_input,       /* in - ptr to additional input,
+                                                   or NULL */
+    uint32_t       additional_input_bytes) /* in - no. additional input
+                                                   bytes */
+{
+    uint32_t result;
+
+    if (drbg->pool)
+    {
+        memset(drbg->pool, 0, drbg->pool_bytes);
+        drbg->pool_avail = 0;
+    }
+
+    switch (drbg->type)
+    {
+        case SHA256_HMAC_DRBG:
+            result = sha256_hmac_drbg_reseed(
+                                    (SHA256_HMAC_DRBG_STATE *)drbg->state,
+                                    entropy, entropy_bytes,
+                                    additional_input, additional_input_bytes);
+            break;
+        case AES256_CTR_DRBG:
+            result = aes256_ctr_drbg_reseed(
+                                    (AES256_CTR_DRBG_STATE *)drbg->state,
+                                    entropy, entropy_bytes,
+                                    additional_input, additional_input_bytes);
+            break;
+        default:
+            DRBG_RET(DRBG_BAD_PARAMETER);
+    }
+
+    if (result == DRBG_OK)
+    {
+        drbg->requests = 0;
+        drbg->bytes = 0;
+        drbg->reseed_ms = drbg_time_ms();
+    }
+
+    return result;
+}
+
+
+/* drbg_reseed_due
+ *
+ * This routine checks whether a request for num_bytes would go past one of
+ * the limits of a drbg's reseed policy, each multiplied by scale.
+ */
+
+static bool
+drbg_reseed_due(
+    DRBG_STATE const *drbg,         /* in - drbg state */
+    uint32_t          num_bytes,    /* in - no. of octets requested */
+    uint32_t          scale)        /* in - multiple of the limits */
+{
+    DRBG_RESEED_POLICY const *policy = &drbg->policy;
+
+    return ((policy->max_requests != 0) &&
+            (drbg->requests >= (uint64_t) policy->max_requests * scale)) ||
+           ((policy->max_bytes != 0) &&
+            (drbg->bytes + num_bytes > policy->max_bytes * scale)) ||
+           ((policy->max_age_secs != 0) &&
+            (drbg_time_ms() - drbg->reseed_ms >=
+             (uint64_t) policy->max_age_secs * 1000 * scale));
+}
+
+
+/* drbg_scheduled_reseed
+ *
+ * This routine reseeds a drbg whose reseed policy says that a reseed is
+ * due.  With background reseeding, the entropy input prepared by the
+ * helper thread is used, and the helper thread is asked for the next one;
+ * if it is not ready yet, the reseed is put off to a later request rather
+ * than waiting for the entropy source, unless the drbg is DRBG_BG_HARD_LIMIT
+ * times past its policy's limits, and if the helper thread failed to get
+ * it, the drbg is reseeded from its entropy source directly.
+ *
+ * Returns DRBG_OK if successful or if the reseed is put off.
+ * Returns the errors of the drbg's reseed function if they occur.
+ */
+
+static uint32_t
+drbg_scheduled_reseed(
+    DRBG_STATE *drbg,               /* in - drbg state */
+    uint32_t    num_bytes)          /* in - no. of octets requested */
+{
+    uint32_t result;
+
+    if (drbg->bg_entropy == NULL)
+    {
+        return drbg_reseed(drbg, NULL, 0, NULL, 0);
+    }
+
+    switch (drbg_atomic_load(&drbg->bg_status))
+    {
+        case DRBG_BG_READY:
+            result = drbg_reseed(drbg, drbg->bg_entropy,
+                                 drbg->bg_entropy_bytes, NULL, 0);
+            memset(drbg->bg_entropy, 0, DRBG_MAX_ENTROPY_NONCE_BYTES);
+            drbg_bg_request(drbg);
+            return result;
+
+        case DRBG_BG_FAILED:
+            if ((result = drbg_reseed(drbg, NULL, 0, NULL, 0)) == DRBG_OK)
+            {
+                drbg_bg_request(drbg);
+            }
+            return result;
+
+        default:
+            if (drbg_reseed_due(drbg, num_bytes, DRBG_BG_HARD_LIMIT))
+            {
+                return drbg_reseed(drbg, NULL, 0, NULL, 0);
+            }
+            DRBG_RET(DRBG_OK);
+    }
+}
+
+
+/* drbg_generate
+ *
+ * This routine generates pseudorandom bytes directly from a drbg of any
+ * type, first reseeding it if its reseed policy says so, and counts the
+ * request against the policy.  An external drbg takes no additional input
+ * and does not provide prediction resistance.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_BAD_PARAMETER if prediction resistance or additional input
+ *  is requested from an external drbg.
+ * Returns the errors of the drbg's reseed and generate functions if they
+ *  occur.
+ */
+
+static uint32_t
+drbg_generate(
+    DRBG_STATE    *drbg,                   /*  in - drbg state */
+    uint32_t       sec_strength_bits,      /*  in - requested sec strength */
+    bool           prediction_resistance,  /*  in - reseed first if TRUE */
+    uint8_t const *additional_input,       /*  in - ptr to additional input,
+                                                    or NULL */
+    uint32_t       additional_input_bytes, /*  in - no. additional input
+                                                    bytes */
+    uint32_t       num_bytes,              /*  in - no. octets to generate */
+    uint8_t       *out)                    /* out - address for octets */
+{
+    uint32_t result;
+
+    if (drbg->type == EXTERNAL_DRBG)
+    {
+        if (prediction_resistance || additional_input)
+        {
+            DRBG_RET(DRBG_BAD_PARAMETER);
+        }
+        return ((EXTERNAL_DRBG_STATE *)drbg->state)->randombytesfn(out,
+                                                                 num_bytes);
+    }
+
+    /* reseed first for prediction resistance, using the additional input,
+     * or if the reseed policy says so
+     */
+
+    if (prediction_resistance)
+    {
+        if ((result = drbg_reseed(drbg, NULL, 0, additional_input,
+                                  additional_input_bytes)) != DRBG_OK)
+        {
+            return result;
+        }
+
+        additional_input = NULL;
+        additional_input_bytes = 0;
+    }
+    else if (drbg_reseed_due(drbg, num_bytes, 1))
+    {
+        if ((result = drbg_scheduled_reseed(drbg, num_bytes)) != DRBG_OK)
+        {
+            return result;
+        }
+    }
+
+    switch (drbg->type)
+    {
+        case SHA256_HMAC_DRBG:
+            result = sha256_hmac_drbg_generate(
+                                    (SHA256_HMAC_DRBG_STATE *)drbg->state,
+                                     sec_strength_bits, FALSE,
+                                     additional_input, additional_input_bytes,
+                                     num_bytes, out);
+            break;
+        case AES256_CTR_DRBG:
+            result = aes256_ctr_drbg_generate(
+                                    (AES256_CTR_DRBG_STATE *)drbg->state,
+                                     sec_strength_bits, FALSE,
+                                     additional_input, additional_input_bytes,
+                                     num_bytes, out);
+            break;
+        default:
+            DRBG_RET(DRBG_BAD_PARAMETER);
+    }
+
+    if (result != DRBG_OK)
+    {
+        return result;
+    }
+
+    drbg->requests++;
+    drbg->bytes += num_bytes;
+    DRBG_RET(DRBG_OK);
+}
+
+
+/* drbg_pool_generate
+ *
+ * This routine serves a request from the output pool of a drbg, refilling
+ * the pool with one generate call whenever it runs out.  Each refill ends
+ * with the drbg's update of its internal state, so the state does not
+ * reveal pool contents, and served bytes are zeroed in the pool, so that
+ * output already handed out cannot be recovered from the drbg later.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_BAD_LENGTH if the requested security strength is too large.
+ * Returns the errors of the drbg's generate function if they occur.
+ */
+
+static uint32_t
+drbg_pool_generate(
+    DRBG_STATE *drbg,               /*  in - drbg state */
+    uint32_t    sec_strength_bits,  /*  in - requested sec strength in bits */
+    uint32_t    num_bytes,          /*  in - number of octets to generate */
+    uint8_t    *out)                /* out - address for generated octets */
+{
+    uint8_t  *p;
+    uint32_t  n;
+    uint32_t  result;
+
+    if (sec_strength_bits > drbg_get_sec_strength(drbg))
+    {
+        DRBG_RET(DRBG_BAD_LENGTH);
+    }
+
+    while (num_bytes > 0)
+    {
+        if (drbg->pool_avail == 0)
+        {
+            if ((result = drbg_generate(drbg, sec_strength_bits, FALSE,
+                                        NULL, 0, drbg->pool_bytes,
+                                        drbg->pool)) != DRBG_OK)
+            {
+                return result;
+            }
+
+            drbg->pool_avail = drbg->pool_bytes;
+        }
+
+        n = (num_bytes < drbg->pool_avail) ? num_bytes : drbg->pool_avail;
+        p = drbg->pool + drbg->pool_bytes - drbg->pool_avail;
+        memcpy(out, p, n);
+        memset(p, 0, n);
+        drbg->pool_avail -= n;
+        out += n;
+        num_bytes -= n;
+    }
+
+    DRBG_RET(DRBG_OK);
+}
+
+
+/*****************************
+ * thread-local DRBG storage *
+ *****************************/
+
+/* One thread-local slot per drbg type, indexed by DRBG_TYPE, holds the
+ * handle of the calling thread's drbg of that type, or 0.  Handles are
+ * never 0, so they are stored directly in the pointer-sized slot value,
+ * and the slot's destructor uninstantiates the drbg when the thread exits.
+ */
+
+#define DRBG_NUM_TYPES  (AES256_CTR_DRBG + 1)
+
+#if defined(_MSC_VER)
+
+/* one initializer per DRBG_TYPE */
+
+static DWORD drbg_tls_index[DRBG_NUM_TYPES] = {
+    FLS_OUT_OF_INDEXES, FLS_OUT_OF_INDEXES, FLS_OUT_OF_INDEXES
+};
+
+static bool drbg_tls_unloading;
+
+static VOID WINAPI
+drbg_tls_destructor(
+    PVOID value)
+{
+    if (value && !drbg_tls_unloading)
+    {
+        ntru_crypto_drbg_uninstantiate((DRBG_HANDLE)(uintptr_t) value);
+    }
+}
+
+static bool
+drbg_tls_init(
+    DRBG_TYPE type)
+{
+    DWORD index;
+
+    if (drbg_atomic_load((uint32_t volatile *) (drbg_tls_index + type)) !=
+            FLS_OUT_OF_INDEXES)
+    {
+        return TRUE;
+    }
+
+    if ((index = FlsAlloc(drbg_tls_destructor)) == FLS_OUT_OF_INDEXES)
+    {
+        return FALSE;
+    }
+
+    if (!drbg_atomic_cas((uint32_t volatile *) (drbg_tls_index + type),
+                         FLS_OUT_OF_INDEXES, index))
+    {
+        /* another thread allocated the index first */
+
+        FlsFree(index);
+    }
+
+    return TRUE;
+}
+
+static DRBG_HANDLE
+drbg_tls_get(
+    DRBG_TYPE type)
+{
+    return (DRBG_HANDLE)(uintptr_t) FlsGetValue(drbg_tls_index[type]);
+}
+
+static bool
+drbg_tls_set(
+    DRBG_TYPE   type,
+    DRBG_HANDLE handle)
+{
+    return FlsSetValue(drbg_tls_index[type], (PVOID)(uintptr_t) handle) != 0;
+}
+
+/* drbg_tls_release
+ *
+ * This routine frees the FLS indexes when the DLL is unloaded, so that no
+ * FLS callback can run after the library's code is gone.  The drbgs of
+ * threads that are still running are not uninstantiated, since that could
+ * wait for the helper thread while the loader lock is held.
+ */
+
+static void
+drbg_tls_release(void)
+{
+    uint32_t i;
+
+    drbg_tls_unloading = TRUE;
+
+    for (i = 0; i < DRBG_NUM_TYPES; i++)
+    {
+        if (drbg_tls_index[i] != FLS_OUT_OF_INDEXES)
+        {
+            FlsFree(drbg_tls_index[i]);
+            drbg_tls_index[i] = FLS_OUT_OF_INDEXES;
+        }
+    }
+}
+
+#if defined(NTRUCRYPTO_EXPORTS)
+
+BOOL WINAPI
+DllMain(
+    HINSTANCE instance,
+    DWORD     reason,
+    LPVOID    reserved)
+{
+    (void) instance;
+    (void) reserved;
+
+    if (reason == DLL_PROCESS_DETACH)
+    {
+        drbg_tls_release();
+    }
+
+    return TRUE;
+}
+
+#endif
+
+#elif !(defined(linux) && defined(__KERNEL__))
+
+static pthread_key_t  drbg_tls_key[DRBG_NUM_TYPES];
+static pthread_once_t drbg_tls_once = PTHREAD_ONCE_INIT;
+static bool           drbg_tls_ok;
+
+static void
+drbg_tls_destructor(
+    void *value)
+{
+    if (value)
+    {
+        ntru_crypto_drbg_uninstantiate((DRBG_HANDLE)(uintptr_t) value);
+    }
+}
+
+static void
+drbg_tls_create_keys(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < DRBG_NUM_TYPES; i++)
+    {
+        if (pthread_key_create(drbg_tls_key + i, drbg_tls_destructor) != 0)
+        {
+            while (i > 0)
+            {
+                pthread_key_delete(drbg_tls_key[--i]);
+            }
+            return;
+        }
+    }
+
+    drbg_tls_ok = TRUE;
+}
+
+/* drbg_tls_delete_keys
+ *
+ * This routine deletes the keys when the library is unloaded, so that no
+ * key destructor can run after the library's code is gone.  The drbgs of
+ * threads that are still running are not uninstantiated.
+ */
+
+#if defined(__GNUC__)
+static void drbg_tls_delete_keys(void) __attribute__((destructor));
+
+static void
+drbg_tls_delete_keys(void)
+{
+    uint32_t i;
+
+    if (drbg_tls_ok)
+    {
+        drbg_tls_ok = FALSE;
+
+        for (i = 0; i < DRBG_NUM_TYPES; i++)
+        {
+            pthread_key_delete(drbg_tls_key[i]);
+        }
+    }
+}
+#endif
+
+static bool
+drbg_tls_init(
+    DRBG_TYPE type)
+{
+    (void) type;
+    return (pthread_once(&drbg_tls_once, drbg_tls_create_keys) == 0) &&
+           drbg_tls_ok;
+}
+
+static DRBG_HANDLE
+drbg_tls_get(
+    DRBG_TYPE type)
+{
+    return (DRBG_HANDLE)(uintptr_t) pthread_getspecific(drbg_tls_key[type]);
+}
+
+static bool
+drbg_tls_set(
+    DRBG_TYPE   type,
+    DRBG_HANDLE handle)
+{
+    return pthread_setspecific(drbg_tls_key[type],
+                               (void *)(uintptr_t) handle) == 0;
+}
+
+#else
+
+/* no thread-local storage in the kernel */
+
+static bool
+drbg_tls_init(
+    DRBG_TYPE type)
+{
+    (void) type;
+    return FALSE;
+}
+
+static DRBG_HANDLE
+drbg_tls_get(
+    DRBG_TYPE type)
+{
+    (void) type;
+    return 0;
+}
+
+static bool
+drbg_tls_set(
+    DRBG_TYPE   type,
+    DRBG_HANDLE handle)
+{
+    (void) type;
+    (void) handle;
+    return FALSE;
+}
+
+#endif
+
+
+/* drbg_thread_local_get
+ *
+ * This routine looks up the calling thread's drbg of the given type.
+ *
+ * Returns DRBG_OK and the handle, or 0 if the thread has no drbg of that
+ *  type, in handle if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if thread-local storage is
+ *  not available.
+ */
+
+static uint32_t
+drbg_thread_local_get(
+    DRBG_TYPE    type,              /*  in - drbg type */
+    DRBG_HANDLE *handle)            /* out - address for drbg handle */
+{
+    DRBG_HANDLE h;
+
+    if (!drbg_tls_init(type))
+    {
+        DRBG_RET(DRBG_NOT_AVAILABLE);
+    }
+
+    /* a thread-local drbg may have been uninstantiated by hand */
+
+    if (((h = drbg_tls_get(type)) != 0) && (drbg_get_drbg(h) == NULL))
+    {
+        h = 0;
+    }
+
+    *handle = h;
+    DRBG_RET(DRBG_OK);
+}
+
+
+/* drbg_thread_local_set
+ *
+ * This routine records a new drbg as the calling thread's drbg of the given
+ * type.  If that fails, the drbg is uninstantiated.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the handle cannot be
+ *  stored.
+ */
+
+static uint32_t
+drbg_thread_local_set(
+    DRBG_TYPE   type,               /* in - drbg type */
+    DRBG_HANDLE handle)             /* in - drbg handle */
+{
+    if (!drbg_tls_set(type, handle))
+    {
+        ntru_crypto_drbg_uninstantiate(handle);
+        DRBG_RET(DRBG_OUT_OF_MEMORY);
+    }
+
+    DRBG_RET(DRBG_OK);
+}
+
+
+/********************
+ * Public functions *
  ********************/
 
-/* ntru_crypto_drbg_instantiate
+/* ntru_crypto_drbg_instantiate
+ *
+ * This routine instantiates a SHA-256 HMAC_DRBG with the requested security
+ * strength.  See ntru_crypto_drbg_instantiate_ex.
+ */
+
+uint32_t
+ntru_crypto_drbg_instantiate(
+    uint32_t       sec_strength_bits, /*  in - requested sec strength in bits */
+    uint8_t const *pers_str,          /*  in - ptr to personalization string */
+    uint32_t       pers_str_bytes,    /*  in - no. personalization str bytes */
+    ENTROPY_FN     entropy_fn,        /*  in - pointer to entropy function */
+    DRBG_HANDLE   *handle)            /* out - address for drbg handle */
+{
+    return ntru_crypto_drbg_instantiate_ex(SHA256_HMAC_DRBG,
+                                           sec_strength_bits,
+                                           pers_str, pers_str_bytes,
+                                           entropy_fn, handle);
+}
+
+
+/* drbg_instantiate
+ *
+ * This routine instantiates a drbg of the given type from an entropy
+ * source.  See ntru_crypto_drbg_instantiate_ex.
+ */
+
+static uint32_t
+drbg_instantiate(
+    DRBG_TYPE               type,              /*  in - type of drbg */
+    uint32_t                sec_strength_bits, /*  in - requested sec strength
+                                                        in bits */
+    uint8_t const          *pers_str,          /*  in - ptr to personalization
+                                                        string */
+    uint32_t                pers_str_bytes,    /*  in - no. personalization
+                                                        str bytes */
+    DRBG_ENTROPY_SRC const *src,               /*  in - entropy source */
+    DRBG_HANDLE            *handle)            /* out - address for drbg
+                                                        handle */
+{
+    DRBG_STATE             *drbg = NULL;
+    void                   *state;
+    uint32_t                index;
+    uint32_t                result;
+
+    /* check arguments */
+
+    if ((!pers_str && pers_str_bytes) ||
+        (!src->entropy_fn && !src->entropy_bulk_fn) || !handle)
+    {
+        DRBG_RET(DRBG_BAD_PARAMETER);
+    }
+
+    if ((type != SHA256_HMAC_DRBG) && (type != AES256_CTR_DRBG))
+    {
+        DRBG_RET(DRBG_BAD_PARAMETER);
+    }
+
+    if (sec_strength_bits > DRBG_MAX_SEC_STRENGTH_BITS)
+    {
+        DRBG_RET(DRBG_BAD_LENGTH);
+    }
+
+    if (pers_str && (pers_str_bytes == 0))
+    {
+        pers_str = NULL;
+    }
+
+    /* set security strength */
+
+    if (sec_strength_bits <= 112) 
+    {
+        sec_strength_bits = 112;
+    }
+    else if (sec_strength_bits <= 128)
+    {
+        sec_strength_bits = 128;
+    }
+    else if (sec_strength_bits <= 192) 
+    {
+        sec_strength_bits = 192;
+    } 
+    else 
+    {
+        sec_strength_bits = 256;
+    }
+
+    /* count the instantiation against the limit */
+
+    if (!drbg_reserve())
+    {
+        DRBG_RET(DRBG_NOT_AVAILABLE);
+    }
+    
+    /* init a byte-at-a-time entropy function */
+
+    if (src->entropy_fn && (src->entropy_fn(INIT, NULL) == 0))
+    {
+        drbg_release();
+        DRBG_RET(DRBG_ENTROPY_FAIL);
+    }
+    
+    /* get an uninstantiated drbg */
+
+    if ((drbg = drbg_get_new_drbg(&index)) == NULL)
+    {
+        drbg_release();
+        DRBG_RET(DRBG_OUT_OF_MEMORY);
+    }
+
+    /* instantiate a SHA-256 HMAC_DRBG or an AES-256 CTR_DRBG in it */
+
+    if (type == SHA256_HMAC_DRBG)
+    {
+        state = &drbg->storage.sha256_hmac;
+        result = sha256_hmac_drbg_instantiate(sec_strength_bits,
+                                              pers_str, pers_str_bytes,
+                                              src, &drbg->storage.sha256_hmac);
+    }
+    else
+    {
+        state = &drbg->storage.aes256_ctr;
+        result = aes256_ctr_drbg_instantiate(sec_strength_bits,
+                                             pers_str, pers_str_bytes,
+                                             src, &drbg->storage.aes256_ctr);
+    }
+
+    if (result != DRBG_OK)
+    {
+        drbg_put_drbg(drbg, index);
+        drbg_release();
+        return result;
+    }
+
+    /* start the reseed schedule */
+
+    drbg->requests = 0;
+    drbg->bytes = 0;
+    drbg->reseed_ms = drbg_time_ms();
+
+    /* init drbg state and return drbg handle */
+
+    *handle = drbg_publish(drbg, index, type, state);
+    DRBG_RET(DRBG_OK);
+}
+
+
+/* ntru_crypto_drbg_instantiate_ex
+ *
+ * This routine instantiates a drbg of the given type, a SHA-256 HMAC_DRBG
+ * (see ANS X9.82: Part 3-2007) or an AES-256 CTR_DRBG (see NIST SP
+ * 800-90A), with the requested security strength.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if an argument pointer is NULL
+ *  or the type is not SHA256_HMAC_DRBG or AES256_CTR_DRBG.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the security strength requested
+ *  or the personalization string is too large.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if there are no instantiation
+ *  slots available
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the internal state cannot be
+ *  allocated from the heap.
+ */
+
+uint32_t
+ntru_crypto_drbg_instantiate_ex(
+    DRBG_TYPE      type,              /*  in - type of drbg */
+    uint32_t       sec_strength_bits, /*  in - requested sec strength in bits */
+    uint8_t const *pers_str,          /*  in - ptr to personalization string */
+    uint32_t       pers_str_bytes,    /*  in - no. personalization str bytes */
+    ENTROPY_FN     entropy_fn,        /*  in - pointer to entropy function */
+    DRBG_HANDLE   *handle)            /* out - address for drbg handle */
+{
+    DRBG_ENTROPY_SRC src = {entropy_fn, NULL};
+
+    return drbg_instantiate(type, sec_strength_bits, pers_str, pers_str_bytes,
+                            &src, handle);
+}
+
+
+/* ntru_crypto_drbg_instantiate_bulk
+ *
+ * This routine instantiates a drbg of the given type with the requested
+ * security strength, as ntru_crypto_drbg_instantiate_ex does, but takes
+ * its entropy input from a bulk entropy function, which is called once
+ * for each instantiation and reseed.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns the errors of ntru_crypto_drbg_instantiate_ex if they occur.
+ */
+
+uint32_t
+ntru_crypto_drbg_instantiate_bulk(
+    DRBG_TYPE       type,              /*  in - type of drbg */
+    uint32_t        sec_strength_bits, /*  in - requested sec strength in
+                                                bits */
+    uint8_t const  *pers_str,          /*  in - ptr to personalization
+                                                string */
+    uint32_t        pers_str_bytes,    /*  in - no. personalization str
+                                                bytes */
+    ENTROPY_BULK_FN entropy_fn,        /*  in - pointer to bulk entropy
+                                                function */
+    DRBG_HANDLE    *handle)            /* out - address for drbg handle */
+{
+    DRBG_ENTROPY_SRC src = {NULL, entropy_fn};
+
+    return drbg_instantiate(type, sec_strength_bits, pers_str, pers_str_bytes,
+                            &src, handle);
+}
+
+
+/* ntru_crypto_drbg_external_instantiate
+ *
+ * This routine instruments an external DRBG so that ntru_crypto routines
+ * can call it. randombytesfn must be of type
+ * uint32_t (randombytesfn*)(unsigned char *out, unsigned long long num_bytes);
+ * and should return DRBG_OK on success.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if there are no instantiation
+ *  slots available
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the internal state cannot be
+ *  allocated from the heap.
+ */
+
+uint32_t
+ntru_crypto_drbg_external_instantiate(
+    RANDOM_BYTES_FN  randombytesfn, /*  in - pointer to random bytes function */
+    DRBG_HANDLE     *handle)        /* out - address for drbg handle */
+{
+    DRBG_STATE             *drbg = NULL;
+    uint32_t                index;
+
+    if (!randombytesfn || !handle)
+    {
+        DRBG_RET(DRBG_BAD_PARAMETER);
+    }
+
+    /* count the instantiation against the limit */
+
+    if (!drbg_reserve())
+    {
+        DRBG_RET(DRBG_NOT_AVAILABLE);
+    }
+
+    /* get an uninstantiated drbg */
+
+    if ((drbg = drbg_get_new_drbg(&index)) == NULL)
+    {
+        drbg_release();
+        DRBG_RET(DRBG_OUT_OF_MEMORY);
+    }
+
+    /* instantiate an External DRBG in it */
+
+    drbg->storage.external.randombytesfn = randombytesfn;
+
+    /* init drbg state and return drbg handle */
+
+    *handle = drbg_publish(drbg, index, EXTERNAL_DRBG,
+                           &drbg->storage.external);
+
+    DRBG_RET(DRBG_OK);
+}
+
+/* ntru_crypto_drbg_thread_local
+ *
+ * This routine returns the calling thread's SHA-256 HMAC_DRBG, first
+ * instantiating it as ntru_crypto_drbg_instantiate does if the thread does
+ * not have one.  The drbg is uninstantiated automatically when the thread
+ * exits, and counts against the instantiation limit while it exists.
  *
- * This routine instantiates a drbg with the requested security strength.
- * See ANS X9.82: Part 3-2007. This routine currently returns an instance
- * of SHA-256 HMAC_DRBG for all requested security strengths.
+ * Only the first call on each thread instantiates a drbg, so the security
+ * strength, personalization string and entropy function of later calls are
+ * ignored unless the drbg has been uninstantiated in between.
  *
  * Returns DRBG_OK if successful.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if an argument pointer is NULL.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the security strength requested
- *  or the personalization string is too large.
- * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if there are no instantiation
- *  slots available
- * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the internal state cannot be
- *  allocated from the heap.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if thread-local storage is
+ *  not available, or if there are no instantiation slots available.
+ * Returns the errors of ntru_crypto_drbg_instantiate if they occur.
  */
 
 uint32_t
-ntru_crypto_drbg_instantiate(
+ntru_crypto_drbg_thread_local(
     uint32_t       sec_strength_bits, /*  in - requested sec strength in bits */
     uint8_t const *pers_str,          /*  in - ptr to personalization string */
     uint32_t       pers_str_bytes,    /*  in - no. personalization str bytes */
     ENTROPY_FN     entropy_fn,        /*  in - pointer to entropy function */
     DRBG_HANDLE   *handle)            /* out - address for drbg handle */
 {
-    DRBG_STATE             *drbg = NULL;
-    SHA256_HMAC_DRBG_STATE *state = NULL;
-    uint32_t                result;
-
-    /* check arguments */
+    DRBG_HANDLE h;
+    uint32_t    result;
 
-    if ((!pers_str && pers_str_bytes) || !entropy_fn || !handle)
+    if (!handle)
     {
         DRBG_RET(DRBG_BAD_PARAMETER);
     }
 
-    if (sec_strength_bits > DRBG_MAX_SEC_STRENGTH_BITS)
+    if ((result = drbg_thread_local_get(SHA256_HMAC_DRBG, &h)) != DRBG_OK)
     {
-        DRBG_RET(DRBG_BAD_LENGTH);
+        return result;
     }
 
-    if (pers_str && (pers_str_bytes == 0))
+    if (h == 0)
     {
-        pers_str = NULL;
+        if ((result = ntru_crypto_drbg_instantiate(sec_strength_bits,
+                                                   pers_str, pers_str_bytes,
+                                                   entropy_fn, &h)) != DRBG_OK)
+        {
+            return result;
+        }
+
+        if ((result = drbg_thread_local_set(SHA256_HMAC_DRBG, h)) != DRBG_OK)
+        {
+            return result;
+        }
     }
 
-    /* set security strength */
+    *handle = h;
+    DRBG_RET(DRBG_OK);
+}
 
-    if (sec_strength_bits <= 112) 
+
+/* ntru_crypto_drbg_external_thread_local
+ *
+ * This routine returns the calling thread's external DRBG, first
+ * instantiating it with randombytesfn, as
+ * ntru_crypto_drbg_external_instantiate does, if the thread does not have
+ * one.  The drbg is uninstantiated automatically when the thread exits, and
+ * counts against the instantiation limit while it exists.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if thread-local storage is
+ *  not available, or if there are no instantiation slots available.
+ * Returns the errors of ntru_crypto_drbg_external_instantiate if they occur.
+ */
+
+uint32_t
+ntru_crypto_drbg_external_thread_local(
+    RANDOM_BYTES_FN  randombytesfn, /*  in - pointer to random bytes function */
+    DRBG_HANDLE     *handle)        /* out - address for drbg handle */
+{
+    DRBG_HANDLE h;
+    uint32_t    result;
+
+    if (!handle)
     {
-        sec_strength_bits = 112;
+        DRBG_RET(DRBG_BAD_PARAMETER);
     }
-    else if (sec_strength_bits <= 128)
+
+    if ((result = drbg_thread_local_get(EXTERNAL_DRBG, &h)) != DRBG_OK)
     {
-        sec_strength_bits = 128;
+        return result;
     }
-    else if (sec_strength_bits <= 192) 
-    {
-        sec_strength_bits = 192;
-    } 
-    else 
+
+    if (h == 0)
     {
-        sec_strength_bits = 256;
+        if ((result = ntru_crypto_drbg_external_instantiate(randombytesfn,
+                                                            &h)) != DRBG_OK)
+        {
+            return result;
+        }
+
+        if ((result = drbg_thread_local_set(EXTERNAL_DRBG, h)) != DRBG_OK)
+        {
+            return result;
+        }
     }
 
-    /* get an uninstantiated drbg */
+    *handle = h;
+    DRBG_RET(DRBG_OK);
+}
 
-    if ((drbg = drbg_get_new_drbg()) == NULL)
-    {
-        DRBG_RET(DRBG_NOT_AVAILABLE);
-    }
-    
-    /* init entropy function */
 
-    if (entropy_fn(INIT, NULL) == 0)
+/* ntru_crypto_drbg_uninstantiate
+ *
+ * This routine frees a drbg given its handle.  The handle must not be in
+ * use by another thread.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid.
+ */
+
+uint32_t
+ntru_crypto_drbg_uninstantiate(
+    DRBG_HANDLE handle)             /* in - drbg handle */
+{
+    DRBG_STATE *drbg = NULL;
+
+    /* find the instantiated drbg and unpublish it; if two threads race to
+     * uninstantiate the same handle, only one of them succeeds
+     */
+
+    if (((drbg = drbg_get_drbg(handle)) == NULL) ||
+        !drbg_atomic_cas(&drbg->handle, handle, 0))
     {
-        DRBG_RET(DRBG_ENTROPY_FAIL);
+        DRBG_RET(DRBG_BAD_PARAMETER);
     }
-    
-    /* instantiate a SHA-256 HMAC_DRBG */
 
-    if ((result = sha256_hmac_drbg_instantiate(sec_strength_bits,
-                                               pers_str, pers_str_bytes,
-                                               entropy_fn,
-                                               &state)) != DRBG_OK)
+    /* stop background reseeding and clear the reseed policy */
+
+    drbg_bg_stop(drbg);
+    memset(&drbg->policy, 0, sizeof(drbg->policy));
+
+    /* zero drbg state */
+
+    if (drbg->state) 
     {
-        return result;
+        switch (drbg->type)
+        {
+            case EXTERNAL_DRBG:
+                drbg->storage.external.randombytesfn = NULL;
+                break;
+            case SHA256_HMAC_DRBG:
+                sha256_hmac_drbg_clear((SHA256_HMAC_DRBG_STATE *)drbg->state);
+                break;
+            case AES256_CTR_DRBG:
+                aes256_ctr_drbg_clear((AES256_CTR_DRBG_STATE *)drbg->state);
+                break;
+        }
+        drbg->state = NULL;
     }
-    
-    /* init drbg state */
 
-    drbg->handle = drbg_get_new_handle();
-    drbg->type = SHA256_HMAC_DRBG;
-    drbg->state = state;
+    drbg_clear_pool(drbg);
 
-    /* return drbg handle */
+    /* return the slot and the instantiation */
 
-    *handle = drbg->handle;
+    drbg_put_drbg(drbg, handle & DRBG_HANDLE_INDEX_MASK);
+    drbg_release();
     DRBG_RET(DRBG_OK);
-} 
+}
 
 
-/* ntru_crypto_drbg_external_instantiate
+/* ntru_crypto_drbg_set_max_instantiations
  *
- * This routine instruments an external DRBG so that ntru_crypto routines
- * can call it. randombytesfn must be of type
- * uint32_t (randombytesfn*)(unsigned char *out, unsigned long long num_bytes);
- * and should return DRBG_OK on success.
+ * This routine sets the maximum number of simultaneous drbg instantiations,
+ * which is DRBG_MAX_INSTANTIATIONS by default.  Lowering the limit below the
+ * current number of instantiations does not affect them, but prevents new
+ * ones until enough have been uninstantiated.
  *
  * Returns DRBG_OK if successful.
- * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if there are no instantiation
- *  slots available
- * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the internal state cannot be
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if max_instantiations is zero or
+ *  greater than DRBG_MAX_INSTANTIATIONS_LIMIT.
+ */
+
+uint32_t
+ntru_crypto_drbg_set_max_instantiations(
+    uint32_t max_instantiations)    /* in - maximum no. of instantiations */
+{
+    if ((max_instantiations == 0) ||
+        (max_instantiations > DRBG_MAX_INSTANTIATIONS_LIMIT))
+    {
+        DRBG_RET(DRBG_BAD_LENGTH);
+    }
+
+    drbg_atomic_store(&drbg_max_instantiations, max_instantiations);
+    DRBG_RET(DRBG_OK);
+}
+
+
+/* ntru_crypto_drbg_set_pool
+ *
+ * This routine sets the size of the output pool of an instantiated
+ * HMAC_DRBG or CTR_DRBG.  See ntru_crypto_drbg.h.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or is
+ *  the handle of an external drbg.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if pool_bytes is more than the
+ *  drbg can generate in one request.
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the pool cannot be
  *  allocated from the heap.
  */
 
 uint32_t
-ntru_crypto_drbg_external_instantiate(
-    RANDOM_BYTES_FN  randombytesfn, /*  in - pointer to random bytes function */
-    DRBG_HANDLE     *handle)        /* out - address for drbg handle */
+ntru_crypto_drbg_set_pool(
+    DRBG_HANDLE handle,             /* in - drbg handle */
+    uint32_t    pool_bytes)         /* in - pool size, or 0 for no pool */
 {
-    DRBG_STATE             *drbg = NULL;
-    EXTERNAL_DRBG_STATE    *state = NULL;
+    DRBG_STATE *drbg = NULL;
+    uint8_t    *pool = NULL;
+    uint32_t    max_bytes;
 
-    if (!randombytesfn || !handle)
+    /* find the instantiated drbg */
+
+    if ((drbg = drbg_get_drbg(handle)) == NULL)
     {
         DRBG_RET(DRBG_BAD_PARAMETER);
     }
 
-    /* get an uninstantiated drbg */
-
-    if ((drbg = drbg_get_new_drbg()) == NULL)
+    switch (drbg->type)
     {
-        DRBG_RET(DRBG_NOT_AVAILABLE);
+        case SHA256_HMAC_DRBG:
+            max_bytes = HMAC_DRBG_MAX_BYTES_PER_REQUEST;
+            break;
+        case AES256_CTR_DRBG:
+            max_bytes = CTR_DRBG_MAX_BYTES_PER_REQUEST;
+            break;
+        default:
+            DRBG_RET(DRBG_BAD_PARAMETER);
     }
 
-    /* instantiate an External DRBG */
-
-    state = (EXTERNAL_DRBG_STATE*) MALLOC(sizeof(EXTERNAL_DRBG_STATE));
-    if (state == NULL)
+    if (pool_bytes > max_bytes)
     {
-        DRBG_RET(DRBG_OUT_OF_MEMORY);
+        DRBG_RET(DRBG_BAD_LENGTH);
     }
 
-    state->randombytesfn = randombytesfn;
-
-    /* init drbg state */
-
-    drbg->handle = drbg_get_new_handle();
-    drbg->type = EXTERNAL_DRBG;
-    drbg->state = state;
-
-    /* return drbg handle */
+    if (pool_bytes)
+    {
+        if ((pool = (uint8_t *) MALLOC(pool_bytes)) == NULL)
+        {
+            DRBG_RET(DRBG_OUT_OF_MEMORY);
+        }
+    }
 
-    *handle = drbg->handle;
+    /* replace the old pool, discarding its unused output */
 
+    drbg_clear_pool(drbg);
+    drbg->pool = pool;
+    drbg->pool_bytes = pool_bytes;
     DRBG_RET(DRBG_OK);
 }
 
-/* ntru_crypto_drbg_uninstantiate
+
+/* ntru_crypto_drbg_set_reseed_policy
  *
- * This routine frees a drbg given its handle.
+ * This routine sets the reseed policy of an instantiated HMAC_DRBG or
+ * CTR_DRBG.  See ntru_crypto_drbg.h.
  *
  * Returns DRBG_OK if successful.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or is
+ *  the handle of an external drbg, or if background reseeding is requested
+ *  for a drbg without a bulk entropy function.
+ * Returns DRBG_ERROR_BASE + DRBG_OUT_OF_MEMORY if the background entropy
+ *  input cannot be allocated from the heap.
+ * Returns DRBG_ERROR_BASE + DRBG_NOT_AVAILABLE if the helper thread cannot
+ *  be started.
  */
 
 uint32_t
-ntru_crypto_drbg_uninstantiate(
-    DRBG_HANDLE handle)             /* in - drbg handle */
+ntru_crypto_drbg_set_reseed_policy(
+    DRBG_HANDLE               handle, /* in - drbg handle */
+    DRBG_RESEED_POLICY const *policy) /* in - reseed policy, or NULL for
+                                               none */
 {
     DRBG_STATE *drbg = NULL;
+    uint8_t    *bg_entropy;
 
     /* find the instantiated drbg */
 
-    if ((drbg = drbg_get_drbg(handle)) == NULL)
+    if (((drbg = drbg_get_drbg(handle)) == NULL) ||
+        ((drbg->type != SHA256_HMAC_DRBG) && (drbg->type != AES256_CTR_DRBG)))
     {
         DRBG_RET(DRBG_BAD_PARAMETER);
     }
 
-    /* zero and free drbg state */
-
-    if (drbg->state) 
+    if (policy && policy->background)
     {
-        switch (drbg->type)
+        /* the helper thread needs a bulk entropy function, which is only
+         * called once per reseed
+         */
+
+        if (drbg_get_entropy_src(drbg)->entropy_bulk_fn == NULL)
         {
-            case EXTERNAL_DRBG:
-                FREE(drbg->state);
-                break;
-            case SHA256_HMAC_DRBG:
-                sha256_hmac_drbg_free((SHA256_HMAC_DRBG_STATE *)drbg->state);
-                break;
+            DRBG_RET(DRBG_BAD_PARAMETER);
         }
-        drbg->state = NULL;
+
+        /* turn background reseeding on, asking for the entropy input of the
+         * next reseed right away
+         */
+
+        if (drbg->bg_entropy == NULL)
+        {
+            bg_entropy = (uint8_t *) MALLOC(DRBG_MAX_ENTROPY_NONCE_BYTES);
+            if (bg_entropy == NULL)
+            {
+                DRBG_RET(DRBG_OUT_OF_MEMORY);
+            }
+
+            drbg_bg_lock();
+            if (!drbg_bg_start())
+            {
+                drbg_bg_unlock();
+                FREE(bg_entropy);
+                DRBG_RET(DRBG_NOT_AVAILABLE);
+            }
+
+            drbg_bg_users++;
+            drbg->bg_entropy = bg_entropy;
+            drbg_atomic_store(&drbg->bg_status, DRBG_BG_REQUESTED);
+            drbg_bg_wake();
+            drbg_bg_unlock();
+        }
+    }
+    else
+    {
+        drbg_bg_stop(drbg);
+    }
+
+    if (policy)
+    {
+        drbg->policy = *policy;
+    }
+    else
+    {
+        memset(&drbg->policy, 0, sizeof(drbg->policy));
     }
 
-    drbg->handle = 0;
     DRBG_RET(DRBG_OK);
 }
 
 
 /* ntru_crypto_drbg_reseed
  *
- * This routine reseeds an instantiated drbg.
- * See ANS X9.82: Part 3-2007.
+ * This routine reseeds an instantiated drbg.  See
+ * ntru_crypto_drbg_reseed_ex.
+ */
+
+uint32_t
+ntru_crypto_drbg_reseed(
+    DRBG_HANDLE handle)             /* in - drbg handle */
+{
+    return ntru_crypto_drbg_reseed_ex(handle, NULL, 0);
+}
+
+
+/* ntru_crypto_drbg_reseed_ex
+ *
+ * This routine reseeds an instantiated drbg, with optional additional
+ * input.  See ANS X9.82: Part 3-2007 and NIST SP 800-90A.
  *
  * Returns DRBG_OK if successful.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or if
+ *  additional_input is NULL and additional_input_bytes is not 0.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the additional input is too
+ *  long.
  * Returns HMAC errors if they occur.
  */
 
 uint32_t
-ntru_crypto_drbg_reseed(
-    DRBG_HANDLE handle)             /* in - drbg handle */
+ntru_crypto_drbg_reseed_ex(
+    DRBG_HANDLE    handle,                 /* in - drbg handle */
+    uint8_t const *additional_input,       /* in - ptr to additional input */
+    uint32_t       additional_input_bytes) /* in - no. additional input bytes */
 {
     DRBG_STATE *drbg = NULL;
 
@@ -886,29 +3195,36 @@ ntru_crypto_drbg_reseed(
         DRBG_RET(DRBG_BAD_PARAMETER);
     }
 
-    if (drbg->type == EXTERNAL_DRBG)
+    /* check arguments */
+
+    if (!additional_input && additional_input_bytes)
     {
         DRBG_RET(DRBG_BAD_PARAMETER);
     }
 
-    /* reseed the SHA-256 HMAC_DRBG */
+    if (additional_input_bytes > DRBG_MAX_ADDITIONAL_INPUT_BYTES)
+    {
+        DRBG_RET(DRBG_BAD_LENGTH);
+    }
+
+    if (additional_input_bytes == 0)
+    {
+        additional_input = NULL;
+    }
+
+    /* reseed the SHA-256 HMAC_DRBG or AES-256 CTR_DRBG, discarding any
+     * buffered output
+     */
 
-    return sha256_hmac_drbg_reseed((SHA256_HMAC_DRBG_STATE *)drbg->state);
+    return drbg_reseed(drbg, NULL, 0, additional_input,
+                       additional_input_bytes);
 }
 
 
 /* ntru_crypto_drbg_generate
  *
  * This routine generates pseudorandom bytes using an instantiated drbg.
- * If the maximum number of requests has been reached, reseeding will occur.
- * See ANS X9.82: Part 3-2007.
- *
- * Returns DRBG_OK if successful.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid or if
- *  an argument pointer is NULL.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the security strength requested
- *  is too large or the number of bytes requested is zero or too large.
- * Returns HMAC errors if they occur.
+ * See ntru_crypto_drbg_generate_ex.
  */
 
 uint32_t
@@ -917,6 +3233,41 @@ ntru_crypto_drbg_generate(
     uint32_t    sec_strength_bits,  /*  in - requested sec strength in bits */
     uint32_t    num_bytes,          /*  in - number of octets to generate */
     uint8_t    *out)                /* out - address for generated octets */
+{
+    return ntru_crypto_drbg_generate_ex(handle, sec_strength_bits, FALSE,
+                                        NULL, 0, num_bytes, out);
+}
+
+
+/* ntru_crypto_drbg_generate_ex
+ *
+ * This routine generates pseudorandom bytes using an instantiated drbg,
+ * with optional prediction resistance and additional input.
+ * If the maximum number of requests has been reached, reseeding will occur.
+ * See ANS X9.82: Part 3-2007 and NIST SP 800-90A.
+ *
+ * Returns DRBG_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if handle is not valid, if
+ *  an argument pointer is NULL, or if prediction resistance or additional
+ *  input is requested from an external drbg.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_LENGTH if the security strength requested
+ *  is too large, the number of bytes requested is zero or too large, or the
+ *  additional input is too long.
+ * Returns DRBG_ERROR_BASE + DRBG_ENTROPY_FAIL if the entropy function fails
+ *  while reseeding.
+ * Returns HMAC errors if they occur.
+ */
+
+uint32_t
+ntru_crypto_drbg_generate_ex(
+    DRBG_HANDLE    handle,                 /*  in - drbg handle */
+    uint32_t       sec_strength_bits,      /*  in - requested sec strength */
+    bool           prediction_resistance,  /*  in - reseed first if TRUE */
+    uint8_t const *additional_input,       /*  in - ptr to additional input */
+    uint32_t       additional_input_bytes, /*  in - no. additional input
+                                                    bytes */
+    uint32_t       num_bytes,              /*  in - no. octets to generate */
+    uint8_t       *out)                    /* out - address for octets */
 {
     DRBG_STATE *drbg = NULL;
 
@@ -929,29 +3280,33 @@ ntru_crypto_drbg_generate(
     
     /* check arguments */
 
-    if (!out)
+    if (!out || (!additional_input && additional_input_bytes))
     {
         DRBG_RET(DRBG_BAD_PARAMETER);
     }
     
-    if (num_bytes == 0)
+    if ((num_bytes == 0) ||
+        (additional_input_bytes > DRBG_MAX_ADDITIONAL_INPUT_BYTES))
     {
          DRBG_RET(DRBG_BAD_LENGTH);
     }
+
+    if (additional_input_bytes == 0)
+    {
+        additional_input = NULL;
+    }
     
-    /* generate pseudorandom output from the SHA256_HMAC_DRBG */
+    /* generate pseudorandom output from the drbg, through its pool for
+     * plain requests that fit in the pool
+     */
 
-    switch (drbg->type)
+    if (drbg->pool && (num_bytes <= drbg->pool_bytes) &&
+        !prediction_resistance && !additional_input)
     {
-        case EXTERNAL_DRBG:
-            return ((EXTERNAL_DRBG_STATE *)drbg->state)->randombytesfn(out,
-                                                                     num_bytes);
-        case SHA256_HMAC_DRBG:
-            return sha256_hmac_drbg_generate(
-                                    (SHA256_HMAC_DRBG_STATE *)drbg->state,
-                                     sec_strength_bits, num_bytes, out);
-        default:
-            DRBG_RET(DRBG_BAD_PARAMETER);
+        return drbg_pool_generate(drbg, sec_strength_bits, num_bytes, out);
     }
-}
 
+    return drbg_generate(drbg, sec_strength_bits, prediction_resistance,
+                         additional_input, additional_input_bytes,
+                         num_bytes, out);
+}
@@ -333,3 +333,148 @@ ntru_crypto_hash_digest(
     return alg_params->digest(data, data_len, md);
 }
 
+
+
+/* ntru_crypto_hash_digest_ct
+ *
+ * This routine computes the same message digest as ntru_crypto_hash_digest()
+ * for data_len bytes of input, in a time that depends only on max_len.
+ * It is used when the input length is secret.
+ *
+ * Every block that a max_len-byte input would need is built from the input
+ * with the padding and length inserted under masks, and is hashed.  The
+ * chaining state after the block that really ends the input is kept,
+ * again under a mask, and output as the digest.
+ *
+ * The input buffer must hold max_len readable bytes; those beyond data_len
+ * do not affect the result.
+ *
+ * Returns NTRU_CRYPTO_HASH_OK on success.
+ * Returns NTRU_CRYPTO_HASH_BAD_PARAMETER if inappropriate NULL pointers are
+ * passed, or if data_len > max_len.
+ * Returns NTRU_CRYPTO_HASH_BAD_ALG if the specified algorithm is not supported.
+ */
+
+uint32_t
+ntru_crypto_hash_digest_ct(
+   NTRU_CRYPTO_HASH_ALGID  algid,    /*  in - the hash algorithm to use */
+   uint8_t const          *data,     /*  in - pointer to input data */
+   uint32_t                data_len, /*  in - number of bytes of input data */
+   uint32_t                max_len,  /*  in - maximum value of data_len */
+   uint8_t                *md)       /* out - address for message digest */
+{
+    NTRU_CRYPTO_HASH_ALG_PARAMS const *alg_params = get_alg_params(algid);
+    NTRU_CRYPTO_HASH_CTX               c;
+    uint32_t const                    *state;
+    uint32_t                           out[8];
+    uint8_t                            blk[64];
+    uint32_t                           num_words;
+    uint32_t                           num_blks;
+    uint32_t                           last_blk;
+    uint32_t                           pos;
+    uint32_t                           mask;
+    uint32_t                           blk_mask;
+    uint32_t                           i;
+    uint32_t                           j;
+    uint32_t                           retcode;
+
+    if (!alg_params)
+    {
+        HASH_RET(NTRU_CRYPTO_HASH_BAD_ALG);
+    }
+
+    if ((max_len && !data) || !md || (data_len > max_len) ||
+        (max_len > 0x1fffffff))
+    {
+        HASH_RET(NTRU_CRYPTO_HASH_BAD_PARAMETER);
+    }
+
+    if (algid == NTRU_CRYPTO_HASH_ALGID_SHA1)
+    {
+        state = c.alg_ctx.sha1.state;
+    }
+    else
+    {
+        state = c.alg_ctx.sha256.state;
+    }
+
+    /* the padding takes a 0x80 byte and an 8-byte bit count */
+
+    num_words = alg_params->digest_length >> 2;
+    num_blks = (max_len + 8) / 64 + 1;
+    last_blk = (data_len + 8) / 64;
+
+    if ((retcode = alg_params->init(&c.alg_ctx)) != NTRU_CRYPTO_HASH_OK)
+    {
+        return retcode;
+    }
+
+    memset(out, 0, sizeof(out));
+
+    for (i = 0; i < num_blks; i++)
+    {
+        /* blk_mask is all ones if this block ends the input */
+
+        blk_mask = ((i ^ last_blk) - 1) & ~(i ^ last_blk);
+        blk_mask = 0 - (blk_mask >> 31);
+
+        for (j = 0; j < 64; j++)
+        {
+            pos = (i << 6) + j;
+            blk[j] = 0;
+
+            if (pos < max_len)
+            {
+                /* input byte if pos < data_len */
+
+                mask = 0 - ((pos - data_len) >> 31);
+                blk[j] = (uint8_t)(data[pos] & mask);
+            }
+
+            /* 0x80 if pos == data_len */
+
+            mask = ((pos ^ data_len) - 1) & ~(pos ^ data_len);
+            blk[j] |= (uint8_t)(0x80 & (0 - (mask >> 31)));
+
+            /* bit count in the last 8 bytes of the final block */
+
+            if (j >= 60)
+            {
+                blk[j] |= (uint8_t)((data_len << 3) >> ((63 - j) << 3)) &
+                          (uint8_t)blk_mask;
+            }
+            else if (j >= 56)
+            {
+                blk[j] |= (uint8_t)((data_len >> 29) >> ((59 - j) << 3)) &
+                          (uint8_t)blk_mask;
+            }
+        }
+
+        /* a whole block is hashed as soon as it is added */
+
+        if ((retcode = alg_params->update(&c.alg_ctx, blk, 64)) !=
+                NTRU_CRYPTO_HASH_OK)
+        {
+            return retcode;
+        }
+
+        for (j = 0; j < num_words; j++)
+        {
+            out[j] |= state[j] & blk_mask;
+        }
+    }
+
+    for (j = 0; j < num_words; j++)
+    {
+        md[(j << 2)]     = (uint8_t)(out[j] >> 24);
+        md[(j << 2) + 1] = (uint8_t)(out[j] >> 16);
+        md[(j << 2) + 2] = (uint8_t)(out[j] >> 8);
+        md[(j << 2) + 3] = (uint8_t)(out[j]);
+    }
+
+    memset(&c, 0, sizeof(c));
+    memset(blk, 0, sizeof(blk));
+    memset(out, 0, sizeof(out));
+
+    HASH_RET(NTRU_CRYPTO_HASH_OK);
+}
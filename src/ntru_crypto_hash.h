@@ -212,4 +212,25 @@ ntru_crypto_hash_digest(
    uint8_t                *md);      /* out - address for message digest */
 
 
+/* ntru_crypto_hash_digest_ct
+ *
+ * This routine computes the same message digest as ntru_crypto_hash_digest()
+ * in a time that depends only on max_len, not on data_len.  The input buffer
+ * must hold max_len readable bytes.
+ *
+ * Returns NTRU_CRYPTO_HASH_OK on success.
+ * Returns NTRU_CRYPTO_HASH_BAD_PARAMETER if inappropriate NULL pointers are
+ * passed, or if data_len > max_len.
+ * Returns NTRU_CRYPTO_HASH_BAD_ALG if the specified algorithm is not supported.
+ */
+
+extern uint32_t
+ntru_crypto_hash_digest_ct(
+   NTRU_CRYPTO_HASH_ALGID  algid,    /*  in - the hash algorithm to use */
+   uint8_t const          *data,     /*  in - pointer to input data */
+   uint32_t                data_len, /*  in - number of bytes of input data */
+   uint32_t                max_len,  /*  in - maximum value of data_len */
+   uint8_t                *md);      /* out - address for message digest */
+
+
 #endif /* NTRU_CRYPTO_HASH_H */
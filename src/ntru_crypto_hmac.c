@@ -34,38 +34,89 @@
 #include "ntru_crypto_hmac.h"
 
 
-/* HMAC context */
+/* largest input block length of the supported hash algorithms */
 
-struct _NTRU_CRYPTO_HMAC_CTX {
-    NTRU_CRYPTO_HASH_CTX  hash_ctx;
-    uint8_t              *k0;
-    uint16_t              blk_len;
-    uint16_t              md_len;
-};
+#define HMAC_MAX_BLK_LEN    64
 
 
-/* ntru_crypto_hmac_create_ctx
+/* ntru_crypto_hmac_set_pads
  *
- * This routine creates an HMAC context, setting the hash algorithm and
- * the key to be used.
+ * This routine hashes the K0 ^ ipad and K0 ^ opad blocks for a key of at
+ * most blk_len bytes and saves the resulting hash states in the HMAC
+ * context, so that each HMAC computed with the key starts from them
+ * instead of hashing the pads again.
+ *
+ * Returns NTRU_CRYPTO_HMAC_OK on success.
+ * Returns NTRU_CRYPTO_HASH_FAIL with corrupted context.
+ */
+
+static uint32_t
+ntru_crypto_hmac_set_pads(
+    NTRU_CRYPTO_HMAC_CTX *c,        /* in/out - pointer to HMAC context */
+    uint8_t const        *key,      /*     in - pointer to the HMAC key */
+    uint32_t              key_len)  /*     in - no. of bytes in the key */
+{
+    uint8_t     pad[HMAC_MAX_BLK_LEN];
+    uint32_t    result;
+    uint32_t    i;
+
+    /* H(K0 ^ ipad) */
+
+    memset(pad, 0x36, c->blk_len);
+    for (i = 0; i < key_len; i++)
+    {
+        pad[i] ^= key[i];                           /* K0 ^ ipad */
+    }
+
+    c->ipad_ctx = c->hash_ctx;
+    if ((result = ntru_crypto_hash_init(&c->ipad_ctx))                    ||
+        (result = ntru_crypto_hash_update(&c->ipad_ctx, pad, c->blk_len)))
+    {
+        memset(pad, 0, sizeof(pad));
+        return result;
+    }
+
+    /* H(K0 ^ opad) */
+
+    for (i = 0; i < c->blk_len; i++)
+    {
+        pad[i] ^= (0x36^0x5c);                      /* K0 ^ opad */
+    }
+
+    c->opad_ctx = c->hash_ctx;
+    if ((result = ntru_crypto_hash_init(&c->opad_ctx))                    ||
+        (result = ntru_crypto_hash_update(&c->opad_ctx, pad, c->blk_len)))
+    {
+        memset(pad, 0, sizeof(pad));
+        return result;
+    }
+
+    memset(pad, 0, sizeof(pad));
+    return NTRU_CRYPTO_HMAC_OK;
+}
+
+
+/* ntru_crypto_hmac_setup_ctx
+ *
+ * This routine sets up an HMAC context provided by the caller, setting the
+ * hash algorithm and the key to be used.  The context must be cleared with
+ * ntru_crypto_hmac_clear_ctx when it is no longer needed.
  *
  * Returns NTRU_CRYPTO_HMAC_OK if successful.
  * Returns NTRU_CRYPTO_HMAC_BAD_ALG if the specified algorithm is not supported.
  * Returns NTRU_CRYPTO_HMAC_BAD_PARAMETER if inappropriate NULL pointers are
  * passed.
- * Returns NTRU_CRYPTO_HMAC_OUT_OF_MEMORY if memory cannot be allocated.
  */
 
 uint32_t
-ntru_crypto_hmac_create_ctx(
+ntru_crypto_hmac_setup_ctx(
     NTRU_CRYPTO_HASH_ALGID   algid,   /*  in - the hash algorithm to be used */
     uint8_t const           *key,     /*  in - pointer to the HMAC key */
     uint32_t                 key_len, /*  in - number of bytes in HMAC key */
-    NTRU_CRYPTO_HMAC_CTX   **c)       /* out - address for pointer to HMAC
-                                               context */
+    NTRU_CRYPTO_HMAC_CTX    *c)       /* out - address for HMAC context */
 {
-    NTRU_CRYPTO_HMAC_CTX *ctx = NULL;
-    uint32_t              result;
+    uint8_t     k0[HMAC_MAX_BLK_LEN];
+    uint32_t    result;
 
     /* check parameters */
 
@@ -73,60 +124,115 @@ ntru_crypto_hmac_create_ctx(
     {
         HMAC_RET(NTRU_CRYPTO_HMAC_BAD_PARAMETER);
     }
-    
-    *c = NULL;
 
-    /* allocate memory for an HMAC context */
-    if (NULL == (ctx = (NTRU_CRYPTO_HMAC_CTX*) MALLOC(sizeof(NTRU_CRYPTO_HMAC_CTX))))
-    {
-        HMAC_RET(NTRU_CRYPTO_HMAC_OUT_OF_MEMORY);
-    }
+    memset(c, 0, sizeof(NTRU_CRYPTO_HMAC_CTX));
 
     /* set the algorithm */
 
-    if ((result = ntru_crypto_hash_set_alg(algid, &ctx->hash_ctx))) 
+    if ((result = ntru_crypto_hash_set_alg(algid, &c->hash_ctx)))
     {
-        FREE(ctx);
         HMAC_RET(NTRU_CRYPTO_HMAC_BAD_ALG);
     }
 
     /* set block length and digest length */
 
-    if ((result = ntru_crypto_hash_block_length(&ctx->hash_ctx,
-                                                &ctx->blk_len))  ||
-        (result = ntru_crypto_hash_digest_length(&ctx->hash_ctx,
-                                                 &ctx->md_len)))
+    if ((result = ntru_crypto_hash_block_length(&c->hash_ctx,
+                                                &c->blk_len))  ||
+        (result = ntru_crypto_hash_digest_length(&c->hash_ctx,
+                                                 &c->md_len)))
     {
-        FREE(ctx);
         return result;
     }
 
-    /* allocate memory for K0 */
-    if ((ctx->k0 = (uint8_t*) MALLOC(ctx->blk_len)) == NULL) 
+    /* hash the pads for K0, which is the key, or its digest if the key is
+     * too large
+     */
+
+    if (key_len > c->blk_len)
     {
-        FREE(ctx);
-        HMAC_RET(NTRU_CRYPTO_HMAC_OUT_OF_MEMORY);
+        if (!(result = ntru_crypto_hash_digest(algid, key, key_len, k0)))
+        {
+            result = ntru_crypto_hmac_set_pads(c, k0, c->md_len);
+        }
+
+        memset(k0, 0, sizeof(k0));
+    }
+    else
+    {
+        result = ntru_crypto_hmac_set_pads(c, key, key_len);
+    }
+
+    if (result)
+    {
+        memset(c, 0, sizeof(NTRU_CRYPTO_HMAC_CTX));
+        return result;
     }
 
-    /* calculate K0 and store in HMAC context */
+    HMAC_RET(NTRU_CRYPTO_HMAC_OK);
+}
 
-    memset(ctx->k0, 0, ctx->blk_len);
 
-    /* check if key is too large */
+/* ntru_crypto_hmac_clear_ctx
+ *
+ * Clears the key material and hash states from an HMAC context set up with
+ * ntru_crypto_hmac_setup_ctx.
+ */
 
-    if (key_len > ctx->blk_len) 
+void
+ntru_crypto_hmac_clear_ctx(
+    NTRU_CRYPTO_HMAC_CTX *c)        /* in/out - pointer to HMAC context */
+{
+    if (c)
     {
-        if ((result = ntru_crypto_hash_digest(algid, key, key_len, ctx->k0))) 
-        {
-            memset(ctx->k0, 0, ctx->blk_len);
-            FREE(ctx->k0);
-            FREE(ctx);
-            return result;
-        }
-    } 
-    else 
+        memset(c, 0, sizeof(NTRU_CRYPTO_HMAC_CTX));
+    }
+}
+
+
+/* ntru_crypto_hmac_create_ctx
+ *
+ * This routine creates an HMAC context, setting the hash algorithm and
+ * the key to be used.
+ *
+ * Returns NTRU_CRYPTO_HMAC_OK if successful.
+ * Returns NTRU_CRYPTO_HMAC_BAD_ALG if the specified algorithm is not supported.
+ * Returns NTRU_CRYPTO_HMAC_BAD_PARAMETER if inappropriate NULL pointers are
+ * passed.
+ * Returns NTRU_CRYPTO_HMAC_OUT_OF_MEMORY if memory cannot be allocated.
+ */
+
+uint32_t
+ntru_crypto_hmac_create_ctx(
+    NTRU_CRYPTO_HASH_ALGID   algid,   /*  in - the hash algorithm to be used */
+    uint8_t const           *key,     /*  in - pointer to the HMAC key */
+    uint32_t                 key_len, /*  in - number of bytes in HMAC key */
+    NTRU_CRYPTO_HMAC_CTX   **c)       /* out - address for pointer to HMAC
+                                               context */
+{
+    NTRU_CRYPTO_HMAC_CTX *ctx = NULL;
+    uint32_t              result;
+
+    /* check parameters */
+
+    if (!c || !key)
     {
-        memcpy(ctx->k0, key, key_len);
+        HMAC_RET(NTRU_CRYPTO_HMAC_BAD_PARAMETER);
+    }
+    
+    *c = NULL;
+
+    /* allocate memory for an HMAC context */
+    if (NULL == (ctx = (NTRU_CRYPTO_HMAC_CTX*) MALLOC(sizeof(NTRU_CRYPTO_HMAC_CTX))))
+    {
+        HMAC_RET(NTRU_CRYPTO_HMAC_OUT_OF_MEMORY);
+    }
+
+    /* set the algorithm and key */
+
+    if ((result = ntru_crypto_hmac_setup_ctx(algid, key, key_len, ctx)))
+    {
+        FREE(ctx);
+        return result;
     }
 
     /* return pointer to HMAC context */
@@ -149,15 +255,14 @@ uint32_t
 ntru_crypto_hmac_destroy_ctx(
     NTRU_CRYPTO_HMAC_CTX *c)        /* in/out - pointer to HMAC context */
 {
-    if (!c || !c->k0)
+    if (!c)
     {
         HMAC_RET(NTRU_CRYPTO_HMAC_BAD_PARAMETER);
     }
     
-    /* clear key and release memory */
+    /* clear hash states and release memory */
 
-    memset(c->k0, 0, c->blk_len);
-    FREE(c->k0);
+    ntru_crypto_hmac_clear_ctx(c);
     FREE(c);
     
     HMAC_RET(NTRU_CRYPTO_HMAC_OK);
@@ -194,7 +299,8 @@ ntru_crypto_hmac_get_md_len(
 
 /* ntru_crypto_hmac_set_key
  *
- * This routine sets a digest-length key into the HMAC context.
+ * This routine sets a digest-length key into the HMAC context, and hashes
+ * the pads for it.
  *
  * Returns NTRU_CRYPTO_HMAC_OK on success.
  * Returns NTRU_CRYPTO_HMAC_BAD_PARAMETER if inappropriate NULL pointers are
@@ -213,10 +319,9 @@ ntru_crypto_hmac_set_key(
         HMAC_RET(NTRU_CRYPTO_HMAC_BAD_PARAMETER);
     }
     
-    /* copy key */
+    /* hash the pads for the new key */
 
-    memcpy(c->k0, key, c->md_len);
-    HMAC_RET(NTRU_CRYPTO_HMAC_OK);
+    return ntru_crypto_hmac_set_pads(c, key, c->md_len);
 }
 
 
@@ -234,9 +339,6 @@ uint32_t
 ntru_crypto_hmac_init(
     NTRU_CRYPTO_HMAC_CTX *c)        /* in/out - pointer to HMAC context */
 {
-    uint32_t    result;
-    int         i;
-
     /* check parameters */
 
     if (!c)
@@ -244,19 +346,9 @@ ntru_crypto_hmac_init(
         HMAC_RET(NTRU_CRYPTO_HMAC_BAD_PARAMETER);
     }
     
-    /* init hash context and compute H(K0 ^ ipad) */
+    /* start from the saved H(K0 ^ ipad) state */
 
-    for (i = 0; i < c->blk_len; i++)
-    {
-        c->k0[i] ^= 0x36;                           /* K0 ^ ipad */
-    }
-        
-    if ((result = ntru_crypto_hash_init(&c->hash_ctx))                   ||
-        (result = ntru_crypto_hash_update(&c->hash_ctx, c->k0, c->blk_len)))
-    {
-        return result;
-    }
-    
+    c->hash_ctx = c->ipad_ctx;
     HMAC_RET(NTRU_CRYPTO_HMAC_OK);
 }
 
@@ -314,7 +406,6 @@ ntru_crypto_hmac_final(
     uint8_t              *md)       /*   out - address for message digest */
 {
     uint32_t    result = NTRU_CRYPTO_HMAC_OK;
-    int         i;
 
     /* check parameters */
 
@@ -323,30 +414,21 @@ ntru_crypto_hmac_final(
         HMAC_RET(NTRU_CRYPTO_HMAC_BAD_PARAMETER);
     }
     
-    /* form K0 ^ opad
-     * complete md = H((K0 ^ ipad) || data)
-     * compute  md = H((K0 ^ opad) || md)
-     * re-form K0
+    /* complete md = H((K0 ^ ipad) || data)
+     * compute  md = H((K0 ^ opad) || md), from the saved H(K0 ^ opad) state
      */
 
-    for (i = 0; i < c->blk_len; i++)
+    if ((result = ntru_crypto_hash_final(&c->hash_ctx, md)))
     {
-        c->k0[i] ^= (0x36^0x5c);
+        return result;
     }
-        
-    if ((result = ntru_crypto_hash_final(&c->hash_ctx, md))                  ||
-        (result = ntru_crypto_hash_init(&c->hash_ctx))                       ||
-        (result = ntru_crypto_hash_update(&c->hash_ctx, c->k0, c->blk_len))  ||
-        (result = ntru_crypto_hash_update(&c->hash_ctx, md, c->md_len))      ||
+
+    c->hash_ctx = c->opad_ctx;
+    if ((result = ntru_crypto_hash_update(&c->hash_ctx, md, c->md_len))      ||
         (result = ntru_crypto_hash_final(&c->hash_ctx, md))) 
     {
     }
     
-    for (i = 0; i < c->blk_len; i++)
-    {
-        c->k0[i] ^= 0x5c;
-    }
-    
     return result;
 }
 
@@ -55,16 +55,58 @@
  * structure definitions *
  *************************/
 
-/* HMAC context structure */
+/* HMAC context structure
+ *
+ * The context has a fixed size and holds no pointers, so it can be embedded
+ * in other structures or live on the stack; see ntru_crypto_hmac_setup_ctx.
+ * Its fields are private to ntru_crypto_hmac.c.
+ */
 
-struct _NTRU_CRYPTO_HMAC_CTX;            /* opaque forward reference */
-typedef struct _NTRU_CRYPTO_HMAC_CTX NTRU_CRYPTO_HMAC_CTX;
+typedef struct _NTRU_CRYPTO_HMAC_CTX {
+    NTRU_CRYPTO_HASH_CTX  hash_ctx;     /* hash state of the current HMAC */
+    NTRU_CRYPTO_HASH_CTX  ipad_ctx;     /* hash state after K0 ^ ipad */
+    NTRU_CRYPTO_HASH_CTX  opad_ctx;     /* hash state after K0 ^ opad */
+    uint16_t              blk_len;
+    uint16_t              md_len;
+} NTRU_CRYPTO_HMAC_CTX;
 
 
 /*************************
  * function declarations *
  *************************/
 
+/* ntru_crypto_hmac_setup_ctx
+ *
+ * This routine sets up an HMAC context provided by the caller, setting the
+ * hash algorithm and the key to be used.  Unlike ntru_crypto_hmac_create_ctx
+ * it does not allocate memory.  The context must be cleared with
+ * ntru_crypto_hmac_clear_ctx when it is no longer needed.
+ *
+ * Returns NTRU_CRYPTO_HMAC_OK if successful.
+ * Returns NTRU_CRYPTO_HMAC_BAD_ALG if the specified algorithm is not supported.
+ * Returns NTRU_CRYPTO_HMAC_BAD_PARAMETER if inappropriate NULL pointers are
+ * passed.
+ */
+
+extern uint32_t
+ntru_crypto_hmac_setup_ctx(
+    NTRU_CRYPTO_HASH_ALGID   algid,   /*  in - the hash algorithm to be used */
+    uint8_t const           *key,     /*  in - pointer to the HMAC key */
+    uint32_t                 key_len, /*  in - number of bytes in HMAC key */
+    NTRU_CRYPTO_HMAC_CTX    *c);      /* out - address for HMAC context */
+
+
+/* ntru_crypto_hmac_clear_ctx
+ *
+ * Clears the key material and hash states from an HMAC context set up with
+ * ntru_crypto_hmac_setup_ctx.
+ */
+
+extern void
+ntru_crypto_hmac_clear_ctx(
+    NTRU_CRYPTO_HMAC_CTX *c);       /* in/out - pointer to HMAC context */
+
+
 /* ntru_crypto_hmac_create_ctx
  *
  * This routine creates an HMAC context, setting the hash algorithm and
@@ -34,6 +34,7 @@
 
 #include "ntru_crypto.h"
 #include "ntru_crypto_ntru_convert.h"
+#include "ntru_crypto_cpu.h"
 
 
 /* 3-bit to 2-trit conversion tables: 2 represents -1 */
@@ -42,7 +43,7 @@ static uint8_t const bits_2_trit1[] = {0, 0, 0, 1, 1, 1, 2, 2};
 static uint8_t const bits_2_trit2[] = {0, 1, 2, 0, 1, 2, 0, 1};
 
 
-/* ntru_bits_2_trits
+/* ntru_bits_2_trits_scalar
  *
  * Each 3 bits in an array of octets is converted to 2 trits in an array
  * of trits.
@@ -51,7 +52,7 @@ static uint8_t const bits_2_trit2[] = {0, 1, 2, 0, 1, 2, 0, 1};
  */
 
 void
-ntru_bits_2_trits(
+ntru_bits_2_trits_scalar(
     uint8_t const *octets,          /*  in - pointer to array of octets */
     uint16_t       num_trits,       /*  in - number of trits to produce */
     uint8_t       *trits)           /* out - address for array of trits */
@@ -138,23 +139,47 @@ ntru_bits_2_trits(
 }
 
 
-/* ntru_trits_2_bits
+/* ntru_trits_2_bits3
+ *
+ * Converts 2 trits to 3 bits.  The trit pair (2, 2) has no 3-bit value;
+ * it is converted to 7 and flagged by setting bit 0 of *invalid.  Neither
+ * case branches, so the time taken does not depend on the trits.
+ */
+
+static uint32_t
+ntru_trits_2_bits3(
+    uint32_t  trit0,                /*  in - first trit */
+    uint32_t  trit1,                /*  in - second trit */
+    uint32_t *invalid)              /* in/out - invalid-pair flag */
+{
+    uint32_t bits3 = trit0 * 3 + trit1;
+    uint32_t over = bits3 >> 3;     /* 1 only for (2, 2) */
+
+    *invalid |= over;
+
+    return (bits3 | (0 - over)) & 7;
+}
+
+
+/* ntru_trits_2_bits_scalar
  *
  * Each 2 trits in an array of trits is converted to 3 bits, and the bits
  * are packed in an array of octets.  A multiple of 3 octets is output.
  * Any bits in the final octets not derived from trits are zero.
  *
+ * The time taken depends only on num_trits.
+ *
  * Returns TRUE if all trits were valid.
  * Returns FALSE if invalid trits were found.
  */
 
 bool
-ntru_trits_2_bits(
+ntru_trits_2_bits_scalar(
     uint8_t const *trits,           /*  in - pointer to array of trits */
     uint32_t       num_trits,       /*  in - number of trits to convert */
     uint8_t       *octets)          /* out - address for array of octets */
 {
-    bool     all_trits_valid = TRUE;
+    uint32_t invalid = 0;
     uint32_t bits24;
     uint32_t bits3;
     uint32_t shift;
@@ -164,86 +189,15 @@ ntru_trits_2_bits(
 
         /* convert each 2 trits to 3 bits and pack */
 
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 = (bits3 << 21);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= (bits3 << 18);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= (bits3 << 15);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7)
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= (bits3 << 12);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= (bits3 <<  9);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= (bits3 <<  6);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= (bits3 <<  3);
-        bits3  = *trits++ * 3;
-        bits3 += *trits++;
-        
-        if (bits3 > 7) 
-        {
-            bits3 = 7;
-            all_trits_valid = FALSE;
-        }
-        
-        bits24 |= bits3;
+        bits24  = ntru_trits_2_bits3(trits[0], trits[1], &invalid) << 21;
+        bits24 |= ntru_trits_2_bits3(trits[2], trits[3], &invalid) << 18;
+        bits24 |= ntru_trits_2_bits3(trits[4], trits[5], &invalid) << 15;
+        bits24 |= ntru_trits_2_bits3(trits[6], trits[7], &invalid) << 12;
+        bits24 |= ntru_trits_2_bits3(trits[8], trits[9], &invalid) <<  9;
+        bits24 |= ntru_trits_2_bits3(trits[10], trits[11], &invalid) << 6;
+        bits24 |= ntru_trits_2_bits3(trits[12], trits[13], &invalid) << 3;
+        bits24 |= ntru_trits_2_bits3(trits[14], trits[15], &invalid);
+        trits += 16;
         num_trits -= 16;
 
         /* output three octets */
@@ -261,20 +215,19 @@ ntru_trits_2_bits(
 
         /* convert each 2 trits to 3 bits and pack */
 
-        bits3 = *trits++ * 3;
-        
-        if (--num_trits) 
+        if (num_trits >= 2)
         {
-            bits3 += *trits++;
-            --num_trits;
+            bits3 = ntru_trits_2_bits3(trits[0], trits[1], &invalid);
+            trits += 2;
+            num_trits -= 2;
         }
-        
-        if (bits3 > 7) 
+        else
         {
-            bits3 = 7;
-            all_trits_valid = FALSE;
+            bits3 = ntru_trits_2_bits3(trits[0], 0, &invalid);
+            trits += 1;
+            num_trits -= 1;
         }
-        
+
         bits24 |= (bits3 << shift);
         shift -= 3;
     }
@@ -285,7 +238,7 @@ ntru_trits_2_bits(
     *octets++ = (uint8_t)((bits24 >>  8) & 0xff);
     *octets++ = (uint8_t)(bits24 & 0xff);
 
-    return all_trits_valid;
+    return invalid == 0;
 }
 
 
@@ -511,7 +464,7 @@ ntru_indices_2_packed_trits(
 }
 
 
-/* ntru_elements_2_octets
+/* ntru_elements_2_octets_scalar
  *
  * Packs an array of n-bit elements into an array of
  * ((in_len * n_bits) + 7) / 8 octets.
@@ -519,7 +472,7 @@ ntru_indices_2_packed_trits(
  */
 
 void
-ntru_elements_2_octets(
+ntru_elements_2_octets_scalar(
     uint16_t        in_len,         /*  in - no. of elements to be packed */
     uint16_t const *in,             /*  in - ptr to elements to be packed */
     uint8_t         n_bits,         /*  in - no. of bits in input element */
@@ -570,7 +523,7 @@ ntru_elements_2_octets(
 }
 
 
-/* ntru_octets_2_elements
+/* ntru_octets_2_elements_scalar
  *
  * Unpacks an octet string into an array of ((in_len * 8) / n_bits)
  * n-bit elements.  Any extra bits are discarded.
@@ -578,7 +531,7 @@ ntru_elements_2_octets(
  */
 
 void
-ntru_octets_2_elements(
+ntru_octets_2_elements_scalar(
     uint16_t        in_len,         /*  in - no. of octets to be unpacked */
     uint8_t const  *in,             /*  in - ptr to octets to be unpacked */
     uint8_t         n_bits,         /*  in - no. of bits in output element */
@@ -627,3 +580,159 @@ ntru_octets_2_elements(
 }
 
 
+/* implementation table, indexed by NTRU_CONVERT_IMPL_ID */
+
+static NTRU_CONVERT_IMPL const ntru_convert_impls[] = {
+    {
+        "scalar",
+        ntru_elements_2_octets_scalar,
+        ntru_octets_2_elements_scalar,
+        ntru_bits_2_trits_scalar,
+        ntru_trits_2_bits_scalar,
+    },
+#if defined(NTRU_HAVE_X86_SIMD)
+    {
+        "ssse3",
+        ntru_elements_2_octets_ssse3,
+        ntru_octets_2_elements_ssse3,
+        ntru_bits_2_trits_ssse3,
+        ntru_trits_2_bits_ssse3,
+    },
+    {
+        "avx2",
+        ntru_elements_2_octets_avx2,
+        ntru_octets_2_elements_avx2,
+        ntru_bits_2_trits_avx2,
+        ntru_trits_2_bits_avx2,
+    },
+#endif
+};
+
+#define NTRU_CONVERT_NUM_BUILT                                                \
+    (sizeof(ntru_convert_impls) / sizeof(ntru_convert_impls[0]))
+
+
+/* NTRU_CPU_ flags required by each implementation, indexed by
+ * NTRU_CONVERT_IMPL_ID
+ */
+
+static uint32_t const ntru_convert_required[] = {
+    0,
+#if defined(NTRU_HAVE_X86_SIMD)
+    NTRU_CPU_SSSE3,
+    NTRU_CPU_AVX2,
+#endif
+};
+
+
+/* the packing and trit conversion routines in use */
+
+static NTRU_CONVERT_IMPL const *ntru_convert_impl = ntru_convert_impls;
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* ntru_convert_select
+ *
+ * Picks the widest conversion routines that the CPU supports.
+ */
+
+static void ntru_convert_select(void) __attribute__((constructor));
+
+static void
+ntru_convert_select(void)
+{
+    ntru_convert_impl = ntru_convert_impls +
+        ntru_crypto_cpu_best_impl(ntru_convert_required,
+                                  NTRU_CONVERT_NUM_BUILT);
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_convert_get_impl
+ *
+ * Returns the conversion implementation with the given ID, or NULL if it is
+ * not built into the library or not supported by the CPU.  Passing
+ * NTRU_CONVERT_NUM_IMPLS returns the selected implementation.
+ */
+
+NTRU_CONVERT_IMPL const *
+ntru_convert_get_impl(
+    NTRU_CONVERT_IMPL_ID id)        /*  in - implementation ID */
+{
+    if (id == NTRU_CONVERT_NUM_IMPLS)
+    {
+        return ntru_convert_impl;
+    }
+
+    if (((uint32_t)id >= NTRU_CONVERT_NUM_BUILT) ||
+        !ntru_crypto_cpu_supports(ntru_convert_required[id]))
+    {
+        return NULL;
+    }
+
+    return ntru_convert_impls + id;
+}
+
+
+/* ntru_elements_2_octets
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_convert.h.
+ */
+
+void
+ntru_elements_2_octets(
+    uint16_t        in_len,         /*  in - no. of elements to be packed */
+    uint16_t const *in,             /*  in - ptr to elements to be packed */
+    uint8_t         n_bits,         /*  in - no. of bits in input element */
+    uint8_t        *out)            /* out - addr for output octets */
+{
+    ntru_convert_impl->elements_2_octets(in_len, in, n_bits, out);
+}
+
+
+/* ntru_octets_2_elements
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_convert.h.
+ */
+
+void
+ntru_octets_2_elements(
+    uint16_t        in_len,         /*  in - no. of octets to be unpacked */
+    uint8_t const  *in,             /*  in - ptr to octets to be unpacked */
+    uint8_t         n_bits,         /*  in - no. of bits in output element */
+    uint16_t       *out)            /* out - addr for output elements */
+{
+    ntru_convert_impl->octets_2_elements(in_len, in, n_bits, out);
+}
+
+
+/* ntru_bits_2_trits
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_convert.h.
+ */
+
+void
+ntru_bits_2_trits(
+    uint8_t const *octets,          /*  in - pointer to array of octets */
+    uint16_t       num_trits,       /*  in - number of trits to produce */
+    uint8_t       *trits)           /* out - address for array of trits */
+{
+    ntru_convert_impl->bits_2_trits(octets, num_trits, trits);
+}
+
+
+/* ntru_trits_2_bits
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_convert.h.
+ */
+
+bool
+ntru_trits_2_bits(
+    uint8_t const *trits,           /*  in - pointer to array of trits */
+    uint32_t       num_trits,       /*  in - number of trits to convert */
+    uint8_t       *octets)          /* out - address for array of octets */
+{
+    return ntru_convert_impl->trits_2_bits(trits, num_trits, octets);
+}
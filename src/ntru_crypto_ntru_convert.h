@@ -58,6 +58,8 @@ ntru_bits_2_trits(
  * are packed in an array of octets.  A multiple of 3 octets is output.
  * Any bits in the final octets not derived from trits are zero.
  *
+ * The time taken depends only on num_trits.
+ *
  * Returns TRUE if all trits were valid.
  * Returns FALSE if invalid trits were found.
  */
@@ -178,6 +180,114 @@ ntru_octets_2_elements(
     uint16_t       *out);           /* out - addr for output elements */
 
 
+/* conversion implementations
+ *
+ * ntru_elements_2_octets, ntru_octets_2_elements, ntru_bits_2_trits and
+ * ntru_trits_2_bits dispatch through the implementation selected for the
+ * CPU when the library is loaded.  The vectorized implementations handle
+ * 11-bit elements, as used for q = 2048, in blocks of 8 elements
+ * (11 octets), and convert between bits and trits in groups of 3 octets
+ * (16 trits).  They use the scalar code for other element sizes and for
+ * the remainder.
+ */
+
+typedef enum {
+    NTRU_CONVERT_SCALAR = 0,
+    NTRU_CONVERT_SSSE3,
+    NTRU_CONVERT_AVX2,
+    NTRU_CONVERT_NUM_IMPLS,
+} NTRU_CONVERT_IMPL_ID;
+
+typedef void (*NTRU_ELEMENTS_2_OCTETS_FN)(
+    uint16_t        in_len,
+    uint16_t const *in,
+    uint8_t         n_bits,
+    uint8_t        *out);
+
+typedef void (*NTRU_OCTETS_2_ELEMENTS_FN)(
+    uint16_t        in_len,
+    uint8_t const  *in,
+    uint8_t         n_bits,
+    uint16_t       *out);
+
+typedef void (*NTRU_BITS_2_TRITS_FN)(
+    uint8_t const *octets,
+    uint16_t       num_trits,
+    uint8_t       *trits);
+
+typedef bool (*NTRU_TRITS_2_BITS_FN)(
+    uint8_t const *trits,
+    uint32_t       num_trits,
+    uint8_t       *octets);
+
+typedef struct {
+    char const                 *name;
+    NTRU_ELEMENTS_2_OCTETS_FN   elements_2_octets;
+    NTRU_OCTETS_2_ELEMENTS_FN   octets_2_elements;
+    NTRU_BITS_2_TRITS_FN        bits_2_trits;
+    NTRU_TRITS_2_BITS_FN        trits_2_bits;
+} NTRU_CONVERT_IMPL;
+
+
+/* ntru_convert_get_impl
+ *
+ * Returns the conversion implementation with the given ID, or NULL if it is
+ * not built into the library or not supported by the CPU.  Passing
+ * NTRU_CONVERT_NUM_IMPLS returns the selected implementation.
+ */
+
+extern NTRU_CONVERT_IMPL const *
+ntru_convert_get_impl(
+    NTRU_CONVERT_IMPL_ID id);       /*  in - implementation ID */
+
+
+/* implementation variants, see ntru_elements_2_octets,
+ * ntru_octets_2_elements, ntru_bits_2_trits and ntru_trits_2_bits
+ */
+
+extern void
+ntru_elements_2_octets_scalar(uint16_t in_len, uint16_t const *in,
+                              uint8_t n_bits, uint8_t *out);
+extern void
+ntru_octets_2_elements_scalar(uint16_t in_len, uint8_t const *in,
+                              uint8_t n_bits, uint16_t *out);
+extern void
+ntru_bits_2_trits_scalar(uint8_t const *octets, uint16_t num_trits,
+                         uint8_t *trits);
+extern bool
+ntru_trits_2_bits_scalar(uint8_t const *trits, uint32_t num_trits,
+                         uint8_t *octets);
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+extern void
+ntru_elements_2_octets_ssse3(uint16_t in_len, uint16_t const *in,
+                             uint8_t n_bits, uint8_t *out);
+extern void
+ntru_octets_2_elements_ssse3(uint16_t in_len, uint8_t const *in,
+                             uint8_t n_bits, uint16_t *out);
+extern void
+ntru_bits_2_trits_ssse3(uint8_t const *octets, uint16_t num_trits,
+                        uint8_t *trits);
+extern bool
+ntru_trits_2_bits_ssse3(uint8_t const *trits, uint32_t num_trits,
+                        uint8_t *octets);
+extern void
+ntru_elements_2_octets_avx2(uint16_t in_len, uint16_t const *in,
+                            uint8_t n_bits, uint8_t *out);
+extern void
+ntru_octets_2_elements_avx2(uint16_t in_len, uint8_t const *in,
+                            uint8_t n_bits, uint16_t *out);
+extern void
+ntru_bits_2_trits_avx2(uint8_t const *octets, uint16_t num_trits,
+                       uint8_t *trits);
+extern bool
+ntru_trits_2_bits_avx2(uint8_t const *trits, uint32_t num_trits,
+                       uint8_t *octets);
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
 #endif /* NTRU_CRYPTO_NTRU_CONVERT_H */
 
 
@@ -0,0 +1,282 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_convert.h"
+#include <string.h>
+#include <immintrin.h>
+
+/* ntru_pack11_avx2
+ *
+ * Packs eight 11-bit elements into the first 11 octets of each 128-bit
+ * lane, as ntru_pack11_ssse3 in ntru_crypto_ntru_convert_simd.c.
+ */
+
+static __m256i
+ntru_pack11_avx2(
+    __m256i x)
+{
+  __m256i v;
+
+  v = _mm256_madd_epi16(x, _mm256_set1_epi32((1 << 16) | (1 << 11)));
+  v = _mm256_or_si256(_mm256_srli_epi64(_mm256_slli_epi64(v, 32), 10),
+                      _mm256_srli_epi64(v, 32));
+
+  return _mm256_or_si256(
+      _mm256_shuffle_epi8(_mm256_slli_epi64(v, 4),
+          _mm256_setr_epi8(5, 4, 3, 2, 1, 0, -1, -1,
+                           -1, -1, -1, -1, -1, -1, -1, -1,
+                           5, 4, 3, 2, 1, 0, -1, -1,
+                           -1, -1, -1, -1, -1, -1, -1, -1)),
+      _mm256_shuffle_epi8(v,
+          _mm256_setr_epi8(-1, -1, -1, -1, -1, 13, 12, 11,
+                           10, 9, 8, -1, -1, -1, -1, -1,
+                           -1, -1, -1, -1, -1, 13, 12, 11,
+                           10, 9, 8, -1, -1, -1, -1, -1)));
+}
+
+/* ntru_unpack11_avx2
+ *
+ * Unpacks the first 11 octets of each 128-bit lane into eight 11-bit
+ * elements, as ntru_unpack11_ssse3 in ntru_crypto_ntru_convert_simd.c.
+ */
+
+static __m256i
+ntru_unpack11_avx2(
+    __m256i b)
+{
+  __m256i w, x;
+
+  w = _mm256_shuffle_epi8(b,
+          _mm256_setr_epi8(1, 0, 2, 1, 3, 2, 5, 4, 6, 5, 7, 6, 9, 8, 10, 9,
+                           1, 0, 2, 1, 3, 2, 5, 4, 6, 5, 7, 6, 9, 8, 10, 9));
+  w = _mm256_mullo_epi16(w,
+          _mm256_setr_epi16(1 << 0, 1 << 3, 1 << 6, 1 << 1,
+                            1 << 4, 1 << 7, 1 << 2, 1 << 5,
+                            1 << 0, 1 << 3, 1 << 6, 1 << 1,
+                            1 << 4, 1 << 7, 1 << 2, 1 << 5));
+  w = _mm256_srli_epi16(w, 5);
+
+  x = _mm256_shuffle_epi8(b,
+          _mm256_setr_epi8(-1, -1, -1, -1, 4, -1, -1, -1,
+                           -1, -1, 8, -1, -1, -1, -1, -1,
+                           -1, -1, -1, -1, 4, -1, -1, -1,
+                           -1, -1, 8, -1, -1, -1, -1, -1));
+  x = _mm256_mulhi_epu16(x,
+          _mm256_setr_epi16(0, 0, 1 << 9, 0, 0, 1 << 10, 0, 0,
+                            0, 0, 1 << 9, 0, 0, 1 << 10, 0, 0));
+
+  return _mm256_or_si256(w, x);
+}
+
+/* ntru_elements_2_octets_avx2
+ *
+ * Packs an array of n-bit elements as ntru_elements_2_octets_scalar.
+ * 11-bit elements are packed 16 at a time into two blocks of 11 octets,
+ * each written with a 16-octet store, and the rest are left to the SSSE3
+ * implementation.
+ */
+
+void
+ntru_elements_2_octets_avx2(
+    uint16_t        in_len,         /*  in - no. of elements to be packed */
+    uint16_t const *in,             /*  in - ptr to elements to be packed */
+    uint8_t         n_bits,         /*  in - no. of bits in input element */
+    uint8_t        *out)            /* out - addr for output octets */
+{
+  uint32_t i = 0;
+  __m256i  v;
+
+  if (n_bits == 11)
+  {
+    for (; i + 24 <= in_len; i += 16)
+    {
+      v = ntru_pack11_avx2(_mm256_loadu_si256((__m256i const *) (in + i)));
+      _mm_storeu_si128((__m128i *) out, _mm256_castsi256_si128(v));
+      _mm_storeu_si128((__m128i *) (out + 11), _mm256_extracti128_si256(v, 1));
+      out += 22;
+    }
+  }
+
+  ntru_elements_2_octets_ssse3((uint16_t) (in_len - i), in + i, n_bits, out);
+}
+
+/* ntru_octets_2_elements_avx2
+ *
+ * Unpacks an octet string as ntru_octets_2_elements_scalar.  11-bit
+ * elements are unpacked from two blocks of 11 octets at a time, and the
+ * rest are left to the SSSE3 implementation.
+ */
+
+void
+ntru_octets_2_elements_avx2(
+    uint16_t        in_len,         /*  in - no. of octets to be unpacked */
+    uint8_t const  *in,             /*  in - ptr to octets to be unpacked */
+    uint8_t         n_bits,         /*  in - no. of bits in output element */
+    uint16_t       *out)            /* out - addr for output elements */
+{
+  uint32_t i = 0;
+  __m256i  b;
+
+  if (n_bits == 11)
+  {
+    for (; i + 27 <= in_len; i += 22)
+    {
+      b = _mm256_inserti128_si256(
+              _mm256_castsi128_si256(
+                  _mm_loadu_si128((__m128i const *) (in + i))),
+              _mm_loadu_si128((__m128i const *) (in + i + 11)), 1);
+      _mm256_storeu_si256((__m256i *) out, ntru_unpack11_avx2(b));
+      out += 16;
+    }
+  }
+
+  ntru_octets_2_elements_ssse3((uint16_t) (in_len - i), in + i, n_bits, out);
+}
+
+/* ntru_bits24_2_trits_avx2
+ *
+ * Converts the 24 bits in the first 3 octets of each 128-bit lane to 16
+ * trits, as ntru_bits24_2_trits_ssse3 in ntru_crypto_ntru_convert_simd.c.
+ */
+
+static __m256i
+ntru_bits24_2_trits_avx2(
+    __m256i b)
+{
+  __m256i v;
+
+  v = _mm256_shuffle_epi8(b,
+          _mm256_setr_epi8(1, 0, 1, 0, 1, 0, 2, 1, 2, 1, 2, 1, -1, 2, -1, 2,
+                           1, 0, 1, 0, 1, 0, 2, 1, 2, 1, 2, 1, -1, 2, -1, 2));
+  v = _mm256_mullo_epi16(v,
+          _mm256_setr_epi16(1 << 0, 1 << 3, 1 << 6, 1 << 1,
+                            1 << 4, 1 << 7, 1 << 2, 1 << 5,
+                            1 << 0, 1 << 3, 1 << 6, 1 << 1,
+                            1 << 4, 1 << 7, 1 << 2, 1 << 5));
+  v = _mm256_srli_epi16(v, 13);
+  v = _mm256_add_epi16(_mm256_mullo_epi16(v, _mm256_set1_epi16(0x0101)),
+                       _mm256_set1_epi16(0x0800));
+
+  return _mm256_shuffle_epi8(
+      _mm256_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 0, 1, 2, 0, 1, 2, 0, 1,
+                       0, 0, 0, 1, 1, 1, 2, 2, 0, 1, 2, 0, 1, 2, 0, 1), v);
+}
+
+/* ntru_trits_2_bits24_avx2
+ *
+ * Converts the 16 trits in each 128-bit lane to 24 bits in the first
+ * 3 octets of the lane, as ntru_trits_2_bits24_ssse3 in
+ * ntru_crypto_ntru_convert_simd.c.
+ */
+
+static __m256i
+ntru_trits_2_bits24_avx2(
+    __m256i  t,
+    __m256i *invalid)
+{
+  __m256i v;
+
+  v = _mm256_maddubs_epi16(t, _mm256_set1_epi16(0x0103));
+  *invalid = _mm256_or_si256(*invalid,
+                             _mm256_cmpgt_epi16(v, _mm256_set1_epi16(7)));
+  v = _mm256_min_epi16(v, _mm256_set1_epi16(7));
+
+  v = _mm256_madd_epi16(v, _mm256_set1_epi32((1 << 16) | (1 << 3)));
+  v = _mm256_or_si256(_mm256_srli_epi64(_mm256_slli_epi64(v, 32), 26),
+                      _mm256_srli_epi64(v, 32));
+
+  return _mm256_or_si256(
+      _mm256_shuffle_epi8(_mm256_slli_epi64(v, 4),
+          _mm256_setr_epi8(1, 0, -1, -1, -1, -1, -1, -1,
+                           -1, -1, -1, -1, -1, -1, -1, -1,
+                           1, 0, -1, -1, -1, -1, -1, -1,
+                           -1, -1, -1, -1, -1, -1, -1, -1)),
+      _mm256_shuffle_epi8(v,
+          _mm256_setr_epi8(-1, 9, 8, -1, -1, -1, -1, -1,
+                           -1, -1, -1, -1, -1, -1, -1, -1,
+                           -1, 9, 8, -1, -1, -1, -1, -1,
+                           -1, -1, -1, -1, -1, -1, -1, -1)));
+}
+
+/* ntru_bits_2_trits_avx2
+ *
+ * Converts octets to trits as ntru_bits_2_trits_scalar.  Ten groups of
+ * 3 octets are read with two 16-octet loads, one per lane, and are only
+ * converted while at least eleven groups remain; the rest are left to the
+ * SSSE3 implementation.  All the octets of a step are read before its
+ * trits are written, so the octet array may overlap the end of the trit
+ * array.
+ */
+
+void
+ntru_bits_2_trits_avx2(
+    uint8_t const *octets,          /*  in - pointer to array of octets */
+    uint16_t       num_trits,       /*  in - number of trits to produce */
+    uint8_t       *trits)           /* out - address for array of trits */
+{
+  __m256i b, t;
+
+  while (num_trits >= 11 * 16)
+  {
+    b = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(
+                _mm_loadu_si128((__m128i const *) octets)),
+            _mm_loadu_si128((__m128i const *) (octets + 15)), 1);
+
+#define NTRU_BITS_2_TRITS_STEP(j)                                             \
+    t = ntru_bits24_2_trits_avx2(_mm256_srli_si256(b, 3 * (j)));              \
+    _mm_storeu_si128((__m128i *) (trits + 16 * (j)),                          \
+                     _mm256_castsi256_si128(t));                              \
+    _mm_storeu_si128((__m128i *) (trits + 80 + 16 * (j)),                     \
+                     _mm256_extracti128_si256(t, 1))
+
+    NTRU_BITS_2_TRITS_STEP(0);
+    NTRU_BITS_2_TRITS_STEP(1);
+    NTRU_BITS_2_TRITS_STEP(2);
+    NTRU_BITS_2_TRITS_STEP(3);
+    NTRU_BITS_2_TRITS_STEP(4);
+
+#undef NTRU_BITS_2_TRITS_STEP
+
+    octets += 30;
+    trits += 160;
+    num_trits -= 160;
+  }
+
+  ntru_bits_2_trits_ssse3(octets, num_trits, trits);
+}
+
+/* ntru_trits_2_bits_avx2
+ *
+ * Converts trits to octets as ntru_trits_2_bits_scalar, for trits in
+ * {0, 1, 2}.  Two groups of 16 trits, one per lane, are converted while
+ * another group follows, and the rest are left to the SSSE3
+ * implementation.
+ */
+
+bool
+ntru_trits_2_bits_avx2(
+    uint8_t const *trits,           /*  in - pointer to array of trits */
+    uint32_t       num_trits,       /*  in - number of trits to convert */
+    uint8_t       *octets)          /* out - address for array of octets */
+{
+  __m256i  invalid = _mm256_setzero_si256();
+  __m256i  r;
+  uint32_t bits24;
+  bool     valid;
+
+  while (num_trits >= 3 * 16)
+  {
+    r = ntru_trits_2_bits24_avx2(
+            _mm256_loadu_si256((__m256i const *) trits), &invalid);
+    bits24 = (uint32_t) _mm_cvtsi128_si32(_mm256_castsi256_si128(r));
+    memcpy(octets, &bits24, 4);
+    bits24 = (uint32_t) _mm_cvtsi128_si32(_mm256_extracti128_si256(r, 1));
+    memcpy(octets + 3, &bits24, 4);
+    trits += 32;
+    octets += 6;
+    num_trits -= 32;
+  }
+
+  valid = ntru_trits_2_bits_ssse3(trits, num_trits, octets);
+
+  return valid & (_mm256_movemask_epi8(invalid) == 0);
+}
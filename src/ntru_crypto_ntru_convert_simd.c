@@ -0,0 +1,258 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_convert.h"
+#include <string.h>
+#include <immintrin.h>
+
+/* ntru_pack11_ssse3
+ *
+ * Packs eight 11-bit elements into the first 11 octets of the result,
+ * most significant bit first.  The remaining octets are zero.
+ *
+ * Adjacent elements are joined into 22-bit words with a multiply-add, and
+ * adjacent words into 44-bit words with shifts.  The second 44-bit word is
+ * byte-reversed into octets 5 - 10, and the first, shifted up by 4 bits to
+ * end on an octet boundary, into octets 0 - 5.
+ */
+
+static __m128i
+ntru_pack11_ssse3(
+    __m128i x)
+{
+  __m128i v;
+
+  v = _mm_madd_epi16(x, _mm_set1_epi32((1 << 16) | (1 << 11)));
+  v = _mm_or_si128(_mm_srli_epi64(_mm_slli_epi64(v, 32), 10),
+                   _mm_srli_epi64(v, 32));
+
+  return _mm_or_si128(
+      _mm_shuffle_epi8(_mm_slli_epi64(v, 4),
+                       _mm_setr_epi8(5, 4, 3, 2, 1, 0, -1, -1,
+                                     -1, -1, -1, -1, -1, -1, -1, -1)),
+      _mm_shuffle_epi8(v,
+                       _mm_setr_epi8(-1, -1, -1, -1, -1, 13, 12, 11,
+                                     10, 9, 8, -1, -1, -1, -1, -1)));
+}
+
+/* ntru_unpack11_ssse3
+ *
+ * Unpacks the first 11 octets of b into eight 11-bit elements.
+ *
+ * Element j starts at bit r = 11j mod 8 of octet k = 11j / 8.  The two
+ * octets from k are gathered into a 16-bit lane, shifted up by r with a
+ * multiply and down by 5, which leaves the element when r <= 5.  Elements
+ * 2 and 5 (r = 6, 7) take their last bits from octet k + 2.
+ */
+
+static __m128i
+ntru_unpack11_ssse3(
+    __m128i b)
+{
+  __m128i w, x;
+
+  w = _mm_shuffle_epi8(b, _mm_setr_epi8(1, 0, 2, 1, 3, 2, 5, 4,
+                                        6, 5, 7, 6, 9, 8, 10, 9));
+  w = _mm_mullo_epi16(w, _mm_setr_epi16(1 << 0, 1 << 3, 1 << 6, 1 << 1,
+                                        1 << 4, 1 << 7, 1 << 2, 1 << 5));
+  w = _mm_srli_epi16(w, 5);
+
+  x = _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, 4, -1, -1, -1,
+                                        -1, -1, 8, -1, -1, -1, -1, -1));
+  x = _mm_mulhi_epu16(x, _mm_setr_epi16(0, 0, 1 << 9, 0, 0, 1 << 10, 0, 0));
+
+  return _mm_or_si128(w, x);
+}
+
+/* ntru_elements_2_octets_ssse3
+ *
+ * Packs an array of n-bit elements as ntru_elements_2_octets_scalar.
+ * 11-bit elements are packed 8 at a time; each block is written with a
+ * 16-octet store, so the loop stops while at least one more block of
+ * output follows.
+ */
+
+void
+ntru_elements_2_octets_ssse3(
+    uint16_t        in_len,         /*  in - no. of elements to be packed */
+    uint16_t const *in,             /*  in - ptr to elements to be packed */
+    uint8_t         n_bits,         /*  in - no. of bits in input element */
+    uint8_t        *out)            /* out - addr for output octets */
+{
+  uint32_t i = 0;
+
+  if (n_bits == 11)
+  {
+    for (; i + 16 <= in_len; i += 8)
+    {
+      _mm_storeu_si128((__m128i *) out,
+          ntru_pack11_ssse3(_mm_loadu_si128((__m128i const *) (in + i))));
+      out += 11;
+    }
+  }
+
+  ntru_elements_2_octets_scalar((uint16_t) (in_len - i), in + i, n_bits, out);
+}
+
+/* ntru_octets_2_elements_ssse3
+ *
+ * Unpacks an octet string as ntru_octets_2_elements_scalar.  11-bit
+ * elements are unpacked from 11 octets at a time, each read with a
+ * 16-octet load.
+ */
+
+void
+ntru_octets_2_elements_ssse3(
+    uint16_t        in_len,         /*  in - no. of octets to be unpacked */
+    uint8_t const  *in,             /*  in - ptr to octets to be unpacked */
+    uint8_t         n_bits,         /*  in - no. of bits in output element */
+    uint16_t       *out)            /* out - addr for output elements */
+{
+  uint32_t i = 0;
+
+  if (n_bits == 11)
+  {
+    for (; i + 16 <= in_len; i += 11)
+    {
+      _mm_storeu_si128((__m128i *) out,
+          ntru_unpack11_ssse3(_mm_loadu_si128((__m128i const *) (in + i))));
+      out += 8;
+    }
+  }
+
+  ntru_octets_2_elements_scalar((uint16_t) (in_len - i), in + i, n_bits, out);
+}
+
+/* ntru_bits24_2_trits_ssse3
+ *
+ * Converts the 24 bits in the first 3 octets of b to 16 trits, as the
+ * scalar ntru_bits_2_trits does.
+ *
+ * Each 3-bit field i starts at bit r = 3i mod 8 of octet k = 3i / 8.  The
+ * octets from k are gathered into a 16-bit lane, shifted up by r with a
+ * multiply and down by 13.  The field is then copied into both octets of
+ * its lane, offset by 8 in the upper one, and the two trits are looked up
+ * in a register with a byte shuffle.
+ */
+
+static __m128i
+ntru_bits24_2_trits_ssse3(
+    __m128i b)
+{
+  __m128i v;
+
+  v = _mm_shuffle_epi8(b, _mm_setr_epi8(1, 0, 1, 0, 1, 0, 2, 1,
+                                        2, 1, 2, 1, -1, 2, -1, 2));
+  v = _mm_mullo_epi16(v, _mm_setr_epi16(1 << 0, 1 << 3, 1 << 6, 1 << 1,
+                                        1 << 4, 1 << 7, 1 << 2, 1 << 5));
+  v = _mm_srli_epi16(v, 13);
+  v = _mm_add_epi16(_mm_mullo_epi16(v, _mm_set1_epi16(0x0101)),
+                    _mm_set1_epi16(0x0800));
+
+  return _mm_shuffle_epi8(_mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2,
+                                        0, 1, 2, 0, 1, 2, 0, 1), v);
+}
+
+/* ntru_trits_2_bits24_ssse3
+ *
+ * Converts 16 trits to 24 bits in the first 3 octets of the result, as
+ * the scalar ntru_trits_2_bits does, and sets the lanes of *invalid for
+ * the trit pairs (2, 2), which are converted to 7.
+ *
+ * Each trit pair is combined into a 16-bit lane with a multiply-add, the
+ * lanes are joined into two 12-bit words as in ntru_pack11_ssse3, and the
+ * words are placed in the octets with byte shuffles.
+ */
+
+static __m128i
+ntru_trits_2_bits24_ssse3(
+    __m128i  t,
+    __m128i *invalid)
+{
+  __m128i v;
+
+  v = _mm_maddubs_epi16(t, _mm_set1_epi16(0x0103));
+  *invalid = _mm_or_si128(*invalid, _mm_cmpgt_epi16(v, _mm_set1_epi16(7)));
+  v = _mm_min_epi16(v, _mm_set1_epi16(7));
+
+  v = _mm_madd_epi16(v, _mm_set1_epi32((1 << 16) | (1 << 3)));
+  v = _mm_or_si128(_mm_srli_epi64(_mm_slli_epi64(v, 32), 26),
+                   _mm_srli_epi64(v, 32));
+
+  return _mm_or_si128(
+      _mm_shuffle_epi8(_mm_slli_epi64(v, 4),
+                       _mm_setr_epi8(1, 0, -1, -1, -1, -1, -1, -1,
+                                     -1, -1, -1, -1, -1, -1, -1, -1)),
+      _mm_shuffle_epi8(v,
+                       _mm_setr_epi8(-1, 9, 8, -1, -1, -1, -1, -1,
+                                     -1, -1, -1, -1, -1, -1, -1, -1)));
+}
+
+/* ntru_bits_2_trits_ssse3
+ *
+ * Converts octets to trits as ntru_bits_2_trits_scalar.  Five groups of
+ * 3 octets are read with one 16-octet load, and are only converted while
+ * at least six groups remain, so that the load stays within the octets the
+ * scalar code would read.  As in the scalar code, all the octets of a step
+ * are read before its trits are written, so the octet array may overlap
+ * the end of the trit array.
+ */
+
+void
+ntru_bits_2_trits_ssse3(
+    uint8_t const *octets,          /*  in - pointer to array of octets */
+    uint16_t       num_trits,       /*  in - number of trits to produce */
+    uint8_t       *trits)           /* out - address for array of trits */
+{
+  __m128i b;
+
+  while (num_trits >= 6 * 16)
+  {
+    b = _mm_loadu_si128((__m128i const *) octets);
+    _mm_storeu_si128((__m128i *) trits, ntru_bits24_2_trits_ssse3(b));
+    _mm_storeu_si128((__m128i *) (trits + 16),
+                     ntru_bits24_2_trits_ssse3(_mm_srli_si128(b, 3)));
+    _mm_storeu_si128((__m128i *) (trits + 32),
+                     ntru_bits24_2_trits_ssse3(_mm_srli_si128(b, 6)));
+    _mm_storeu_si128((__m128i *) (trits + 48),
+                     ntru_bits24_2_trits_ssse3(_mm_srli_si128(b, 9)));
+    _mm_storeu_si128((__m128i *) (trits + 64),
+                     ntru_bits24_2_trits_ssse3(_mm_srli_si128(b, 12)));
+    octets += 15;
+    trits += 80;
+    num_trits -= 80;
+  }
+
+  ntru_bits_2_trits_scalar(octets, num_trits, trits);
+}
+
+/* ntru_trits_2_bits_ssse3
+ *
+ * Converts trits to octets as ntru_trits_2_bits_scalar, for trits in
+ * {0, 1, 2}.  Each group of 16 trits is written as 4 octets, so groups are
+ * only converted while another group follows.  The invalid pairs are
+ * accumulated without branching.
+ */
+
+bool
+ntru_trits_2_bits_ssse3(
+    uint8_t const *trits,           /*  in - pointer to array of trits */
+    uint32_t       num_trits,       /*  in - number of trits to convert */
+    uint8_t       *octets)          /* out - address for array of octets */
+{
+  __m128i  invalid = _mm_setzero_si128();
+  uint32_t bits24;
+  bool     valid;
+
+  while (num_trits >= 2 * 16)
+  {
+    bits24 = (uint32_t) _mm_cvtsi128_si32(ntru_trits_2_bits24_ssse3(
+                 _mm_loadu_si128((__m128i const *) trits), &invalid));
+    memcpy(octets, &bits24, 4);
+    trits += 16;
+    octets += 3;
+    num_trits -= 16;
+  }
+
+  valid = ntru_trits_2_bits_scalar(trits, num_trits, octets);
+
+  return valid & (_mm_movemask_epi8(invalid) == 0);
+}
@@ -40,139 +40,254 @@
 #include "ntru_crypto_drbg.h"
 
 
-/* ntru_crypto_ntru_encrypt
- *
- * Implements NTRU encryption (SVES) for the parameter set specified in
- * the public key blob.
- *
- * Before invoking this function, a DRBG must be instantiated using
- * ntru_crypto_drbg_instantiate() to obtain a DRBG handle, and in that
- * instantiation the requested security strength must be at least as large
- * as the security strength of the NTRU parameter set being used.
- * Failure to instantiate the DRBG with the proper security strength will
- * result in this function returning DRBG_ERROR_BASE + DRBG_BAD_LENGTH.
- *
- * The required minimum size of the output ciphertext buffer (ct) may be
- * queried by invoking this function with ct = NULL.  In this case, no
- * encryption is performed, NTRU_OK is returned, and the required minimum
- * size for ct is returned in ct_len.
+/* public-key context */
+
+struct _NTRU_ENCRYPT_PUBKEY_CTX {
+    NTRU_ENCRYPT_PARAM_SET *params;       /* parameter set of the key */
+    uint16_t                pad_deg;      /* padded degree of h */
+    uint16_t               *h;            /* unpacked public key, padded to
+                                             pad_deg coefficients */
+    uint8_t                *pubkey_trunc; /* first sec_strength_len octets of
+                                             the packed public key */
+};
+
+
+/* private-key context */
+
+struct _NTRU_ENCRYPT_PRIVKEY_CTX {
+    NTRU_ENCRYPT_PARAM_SET *params;       /* parameter set of the key */
+    uint16_t                pad_deg;      /* padded degree of h */
+    uint16_t               *h;            /* unpacked public key, padded to
+                                             pad_deg coefficients */
+    uint16_t               *F;            /* indices of the private key F */
+    uint8_t                *pubkey_trunc; /* first sec_strength_len octets of
+                                             the packed public key */
+    size_t                  buf_len;      /* no. of octets allocated for h, F
+                                             and pubkey_trunc */
+};
+
+
+/* ntru_scratch_get
  *
- * When ct != NULL, at invocation *ct_len must be the size of the ct buffer.
- * Upon return it is the actual size of the ciphertext.
+ * Provides the scratch buffer for an operation needing scratch_buf_len
+ * octets.  If the caller supplied a workspace (scratch != NULL), it is
+ * checked for alignment and size and used; otherwise the buffer is
+ * allocated from the heap.
  *
  * Returns NTRU_OK if successful.
- * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
- * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
- *  (other than ct) is NULL.
- * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if a length argument
- *  (pubkey_blob_len or pt_len) is zero, or if pt_len exceeds the
- *  maximum plaintext length for the parameter set.
- * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
- *  invalid (unknown format, corrupt, bad length).
- * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the ciphertext buffer
- *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  aligned to NTRU_SCRATCH_ALIGNMENT octets.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
  * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
  *  allocated from the heap.
  */
 
-uint32_t
-ntru_crypto_ntru_encrypt(
-    DRBG_HANDLE     drbg_handle,     /*     in - handle of DRBG */
-    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
-                                                 blob */
-    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
-    uint16_t        pt_len,          /*     in - no. of octets in plaintext */
-    uint8_t const  *pt,              /*     in - pointer to plaintext */
-    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
-                                                 no. of octets in ciphertext */
-    uint8_t        *ct)              /*    out - address for ciphertext */
+static uint32_t
+ntru_scratch_get(
+    void       *scratch,         /*  in - caller's workspace, or NULL */
+    uint32_t    scratch_len,     /*  in - no. of octets in workspace */
+    size_t      scratch_buf_len, /*  in - no. of octets needed */
+    uint16_t  **scratch_buf)     /* out - address for pointer to scratch
+                                          buffer */
 {
-    NTRU_ENCRYPT_PARAM_SET *params = NULL;
-    uint8_t const          *pubkey_packed = NULL;
-    uint8_t                 pubkey_pack_type = 0x00;
-    uint16_t                packed_ct_len;
-    size_t                  scratch_buf_len;
-    uint32_t                dr;
-    uint32_t                dr1 = 0;
-    uint32_t                dr2 = 0;
-    uint32_t                dr3 = 0;
-    uint16_t                num_scratch_polys;
-    uint16_t                pad_deg;
-    uint16_t                ring_mult_tmp_len;
-    uint16_t               *scratch_buf = NULL;
-    uint16_t               *ringel_buf = NULL;
-    uint16_t               *r_buf = NULL;
-    uint8_t                *b_buf = NULL;
-    uint8_t                *tmp_buf = NULL;
-    bool                    msg_rep_good = FALSE;
-    NTRU_CRYPTO_HASH_ALGID  hash_algid;
-    uint8_t                 md_len;
-    uint16_t                mod_q_mask;
-    uint32_t                result = NTRU_OK;
+    if (scratch)
+    {
+        if (((size_t)scratch & (NTRU_SCRATCH_ALIGNMENT - 1)) != 0)
+        {
+            NTRU_RET(NTRU_BAD_PARAMETER);
+        }
 
-    /* check for bad parameters */
+        if (scratch_len < scratch_buf_len)
+        {
+            NTRU_RET(NTRU_BUFFER_TOO_SMALL);
+        }
 
-    if (!pubkey_blob || !ct_len)
+        *scratch_buf = (uint16_t *)scratch;
+    }
+    else
     {
-        NTRU_RET(NTRU_BAD_PARAMETER);
+        *scratch_buf = MALLOC(scratch_buf_len);
+        if (!*scratch_buf)
+        {
+            NTRU_RET(NTRU_OUT_OF_MEMORY);
+        }
     }
 
-    if (pubkey_blob_len == 0)
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_scratch_put
+ *
+ * Clears a scratch buffer obtained with ntru_scratch_get(), and frees it
+ * if it was allocated from the heap.
+ */
+
+static void
+ntru_scratch_put(
+    void       *scratch,         /* in - caller's workspace, or NULL */
+    uint16_t   *scratch_buf,     /* in - pointer to scratch buffer */
+    size_t      scratch_buf_len) /* in - no. of octets used */
+{
+    memset(scratch_buf, 0, scratch_buf_len);
+
+    if (!scratch)
     {
-        NTRU_RET(NTRU_BAD_LENGTH);
+        FREE(scratch_buf);
     }
 
-    /* get a pointer to the parameter-set parameters, the packing type for
-     * the public key, and a pointer to the packed public key
-     */
+    return;
+}
 
-    if (!ntru_crypto_ntru_encrypt_key_parse(TRUE /* pubkey */, pubkey_blob_len,
-                                            pubkey_blob, &pubkey_pack_type,
-                                            NULL, &params, &pubkey_packed,
-                                            NULL))
+
+/* ntru_encrypt_scratch_len
+ *
+ * Returns the number of octets of scratch space needed by ntru_encrypt_core()
+ * for the parameter set.  The space for the unpacked public key, which is
+ * supplied separately to ntru_encrypt_core(), is not included.
+ *
+ * If pad_deg is not NULL, the padded degree of ring elements used by the
+ * ring multiplication is returned in it.
+ */
+
+static size_t
+ntru_encrypt_scratch_len(
+    NTRU_ENCRYPT_PARAM_SET const *params,  /*  in - parameter set */
+    uint16_t                     *pad_deg) /* out - padded ring degree */
+{
+    uint32_t dr;
+    uint16_t num_scratch_polys;
+    uint16_t ring_pad_deg;
+
+    ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys,
+                                  &ring_pad_deg);
+
+    if (params->is_product_form)
     {
-        NTRU_RET(NTRU_BAD_PUBLIC_KEY);
+        dr = (params->dF_r & 0xff) + ((params->dF_r >> 8) & 0xff) +
+             ((params->dF_r >> 16) & 0xff);
+        num_scratch_polys += 1; /* mult_product_indices needs space for a
+                                   mult_indices and one intermediate result */
     }
-
-    if(params->q_bits <= 8
-            || params->q_bits >= 16
-            || pubkey_pack_type != NTRU_ENCRYPT_KEY_PACKED_COEFFICIENTS)
+    else
     {
-        NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
+        dr = params->dF_r;
     }
 
-    /* return the ciphertext size if requested */
-
-    packed_ct_len = (params->N * params->q_bits + 7) >> 3;
-    
-    if (!ct)
+    if (pad_deg)
     {
-        *ct_len = packed_ct_len;
-        NTRU_RET(NTRU_OK);
+        *pad_deg = ring_pad_deg;
     }
 
-    /* check the ciphertext buffer size */
+    return ((size_t)(num_scratch_polys * ring_pad_deg) << 1) +
+                                            /* X-byte temp buf for ring mult and
+                                                other intermediate results */
+           (ring_pad_deg << 1) +            /* 2N-byte buffer for ring elements
+                                                and overflow from temp buffer */
+           (dr << 2) +                      /* buffer for r indices */
+           params->b_len +                  /* buffer for b */
+           params->sec_strength_len;        /* buffer for a KEM secret */
+}
 
-    if (*ct_len < packed_ct_len)
-    {
-        NTRU_RET(NTRU_BUFFER_TOO_SMALL);
-    }
 
-    /* check that a plaintext was provided */
+/* ntru_kem_derive_key
+ *
+ * Derives a KEM shared key of NTRU_KEM_SHARED_KEY_LEN octets as the SHA-256
+ * digest of the secret followed by the packed ciphertext, binding the key
+ * to the ciphertext as well as the secret.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns the errors of the hash functions if they occur.
+ */
 
-    if (!pt)
+static uint32_t
+ntru_kem_derive_key(
+    uint8_t const *secret,          /*  in - pointer to KEM secret */
+    uint16_t       secret_len,      /*  in - no. of octets in secret */
+    uint8_t const *ct,              /*  in - pointer to ciphertext */
+    uint16_t       ct_len,          /*  in - no. of octets in ciphertext */
+    uint8_t       *key)             /* out - address for shared key */
+{
+    NTRU_CRYPTO_HASH_CTX ctx;
+    uint32_t             result;
+
+    if ((result = ntru_crypto_hash_set_alg(NTRU_CRYPTO_HASH_ALGID_SHA256,
+                                           &ctx))                         ||
+        (result = ntru_crypto_hash_init(&ctx))                            ||
+        (result = ntru_crypto_hash_update(&ctx, secret, secret_len))      ||
+        (result = ntru_crypto_hash_update(&ctx, ct, ct_len))              ||
+        (result = ntru_crypto_hash_final(&ctx, key)))
     {
-        NTRU_RET(NTRU_BAD_PARAMETER);
+        memset(&ctx, 0, sizeof(ctx));
+        return result;
     }
 
-    /* check the plaintext length */
+    memset(&ctx, 0, sizeof(ctx));
+    NTRU_RET(NTRU_OK);
+}
 
-    if (pt_len > params->m_len_max)
-    {
-        NTRU_RET(NTRU_BAD_LENGTH);
-    }
 
-    /* allocate memory for all operations */
+/* ntru_encrypt_core
+ *
+ * Performs NTRU encryption (SVES) of a single plaintext with a public key
+ * that has already been parsed and unpacked.
+ *
+ * The arguments are assumed to have been checked by the caller: pt_len
+ * does not exceed the maximum plaintext length for the parameter set and
+ * the ct buffer is large enough for a packed ciphertext.
+ *
+ * The scratch buffer must be at least ntru_encrypt_scratch_len() octets,
+ * and h must hold the padded ring element produced by unpacking the public
+ * key.  Neither h nor pubkey_trunc is modified.
+ *
+ * If pt is NULL, the plaintext is a KEM secret of pt_len octets, at most
+ * sec_strength_len, which is generated from the DRBG in the same request
+ * as b, and the shared key derived from it and the ciphertext by
+ * ntru_kem_derive_key() is returned in kem_key.  Otherwise kem_key is not
+ * used.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the parameter set
+ *  uses an unknown hash algorithm.
+ */
+
+static uint32_t
+ntru_encrypt_core(
+    DRBG_HANDLE                   drbg_handle, /*  in - handle of DRBG */
+    NTRU_ENCRYPT_PARAM_SET const *params,      /*  in - parameter set */
+    uint16_t const               *h,           /*  in - unpacked public key */
+    uint8_t const                *pubkey_trunc,/*  in - first sec_strength_len
+                                                        octets of the packed
+                                                        public key */
+    uint16_t                      pt_len,      /*  in - no. of octets in
+                                                        plaintext */
+    uint8_t const                *pt,          /*  in - pointer to plaintext,
+                                                        or NULL */
+    uint16_t                     *scratch_buf, /*  in - scratch buffer */
+    uint8_t                      *ct,          /* out - address for
+                                                        ciphertext */
+    uint8_t                      *kem_key)     /* out - address for KEM
+                                                        shared key */
+{
+    uint32_t                dr;
+    uint32_t                dr1 = 0;
+    uint32_t                dr2 = 0;
+    uint32_t                dr3 = 0;
+    uint16_t                num_scratch_polys;
+    uint16_t                pad_deg;
+    uint16_t               *ringel_buf = NULL;
+    uint16_t               *r_buf = NULL;
+    uint8_t                *b_buf = NULL;
+    uint8_t                *tmp_buf = NULL;
+    uint16_t                b_m_len;
+    bool                    msg_rep_good = FALSE;
+    NTRU_CRYPTO_HASH_ALGID  hash_algid;
+    uint8_t                 md_len;
+    uint32_t                result = NTRU_OK;
+
+    /* set up the scratch buffer */
 
     ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys, &pad_deg);
 
@@ -181,30 +296,14 @@ ntru_crypto_ntru_encrypt(
         dr2 = (params->dF_r >>  8) & 0xff;
         dr3 = (params->dF_r >> 16) & 0xff;
         dr = dr1 + dr2 + dr3;
-        num_scratch_polys += 1; /* mult_product_indices needs space for a
-                                   mult_indices and one intermediate result */
+        num_scratch_polys += 1;
     }
     else
     {
         dr = params->dF_r;
     }
-    ring_mult_tmp_len = num_scratch_polys * pad_deg;
-
-    scratch_buf_len = (ring_mult_tmp_len << 1) +
-                                            /* X-byte temp buf for ring mult and
-                                                other intermediate results */
-                      (pad_deg << 1) +      /* 2N-byte buffer for ring elements
-                                                and overflow from temp buffer */
-                      (dr << 2) +           /* buffer for r indices */
-                      params->b_len;
-                                            /* buffer for b */
-    scratch_buf = MALLOC(scratch_buf_len);
-    if (!scratch_buf)
-    {
-        NTRU_RET(NTRU_OUT_OF_MEMORY);
-    }
 
-    ringel_buf = scratch_buf + ring_mult_tmp_len;
+    ringel_buf = scratch_buf + num_scratch_polys * pad_deg;
     r_buf = ringel_buf + pad_deg;
     b_buf = (uint8_t *)(r_buf + (dr << 1));
     tmp_buf = (uint8_t *)scratch_buf;
@@ -223,23 +322,30 @@ ntru_crypto_ntru_encrypt(
     }
     else
     {
-        FREE(scratch_buf);
         NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
     }
 
-    /* set constants */
+    /* a KEM secret follows b in b_buf, so that both come from one DRBG
+     * request and the secret is copied straight into sData and M
+     */
 
-    mod_q_mask = params->q - 1;
+    b_m_len = params->b_len;
+
+    if (!pt)
+    {
+        pt = b_buf + params->b_len;
+        b_m_len += pt_len;
+    }
 
     /* loop until a message representative with proper weight is achieved */
 
     do {
         uint8_t *ptr = tmp_buf;
 
-        /* get b */
+        /* get b, and the KEM secret if there is one */
         result = ntru_crypto_drbg_generate(drbg_handle,
                                            params->sec_strength_len << 3,
-                                           params->b_len, b_buf);
+                                           b_m_len, b_buf);
 
         if (result == NTRU_OK)
         {
@@ -251,7 +357,7 @@ ntru_crypto_ntru_encrypt(
             ptr += pt_len;
             memcpy(ptr, b_buf, params->b_len);
             ptr += params->b_len;
-            memcpy(ptr, pubkey_packed, params->sec_strength_len);
+            memcpy(ptr, pubkey_trunc, params->sec_strength_len);
             ptr += params->sec_strength_len;
 
 
@@ -269,25 +375,18 @@ ntru_crypto_ntru_encrypt(
 
         if (result == NTRU_OK)
         {
-            uint16_t pubkey_packed_len;
-
-            /* unpack the public key */
-            pubkey_packed_len = (params->N * params->q_bits + 7) >> 3;
-            ntru_octets_2_elements(pubkey_packed_len, pubkey_packed,
-                                   params->q_bits, ringel_buf);
-
             /* form R = h * r */
 
             if (params->is_product_form)
             {
-                ntru_ring_mult_product_indices(ringel_buf, (uint16_t)dr1,
+                ntru_ring_mult_product_indices(h, (uint16_t)dr1,
                                                (uint16_t)dr2, (uint16_t)dr3,
                                                r_buf, params->N, params->q,
                                                scratch_buf, ringel_buf);
             }
             else
             {
-                ntru_ring_mult_indices(ringel_buf, (uint16_t)dr, (uint16_t)dr,
+                ntru_ring_mult_indices(h, (uint16_t)dr, (uint16_t)dr,
                                        r_buf, params->N, params->q,
                                        scratch_buf, ringel_buf);
             }
@@ -310,7 +409,6 @@ ntru_crypto_ntru_encrypt(
             uint8_t  *M_buf = Mtrin_buf + params->N -
                               (params->b_len + params->m_len_len +
                                params->m_len_max + 2);
-            uint16_t  i;
 
             /* form the padded message M */
 
@@ -334,117 +432,948 @@ ntru_crypto_ntru_encrypt(
 
             ntru_bits_2_trits(M_buf, params->N, Mtrin_buf);
 
-            /* form the msg representative m' by adding Mtrin to mask, mod p */
-
-            for (i = 0; i < params->N; i++)
-            {
-                tmp_buf[i] = tmp_buf[i] + Mtrin_buf[i];
-
-                if (tmp_buf[i] >= 3)
-                {
-                    tmp_buf[i] -= 3;
-                }
-            }
-
-            /* check that message representative meets minimum weight
-             * requirements
+            /* form the msg representative m' by adding Mtrin to mask,
+             * mod p, and in the same pass check that it meets minimum
+             * weight requirements and form ciphertext e by adding m' to
+             * R mod q.  If m' is rejected, R is formed again.
              */
-            msg_rep_good = ntru_poly_check_min_weight(params->N, tmp_buf,
-                                                   params->min_msg_rep_wt);
+
+            msg_rep_good = ntru_poly_add_msg_rep(params->N, tmp_buf,
+                                                 Mtrin_buf,
+                                                 params->min_msg_rep_wt,
+                                                 params->q, ringel_buf);
         }
     } while ((result == NTRU_OK) && !msg_rep_good);
 
     if (result == NTRU_OK)
     {
-        uint16_t i;
-
-        /* form ciphertext e by adding m' to R mod q */
-
-        for (i = 0; i < params->N; i++)
-        {
-            if (tmp_buf[i] == 1)
-            {
-                ringel_buf[i] = (ringel_buf[i] + 1) & mod_q_mask;
-            }
-            else if (tmp_buf[i] == 2)
-            {
-                ringel_buf[i] = (ringel_buf[i] - 1) & mod_q_mask;
-            }
-            else
-            {
-                ;
-            }
-        }
-
         /* pack ciphertext */
 
         ntru_elements_2_octets(params->N, ringel_buf, params->q_bits, ct);
-        *ct_len = packed_ct_len;
-    }
 
-    /* cleanup */
+        /* derive the KEM shared key from the secret and ciphertext */
 
-    memset(scratch_buf, 0, scratch_buf_len);
-    FREE(scratch_buf);
+        if (b_m_len != params->b_len)
+        {
+            result = ntru_kem_derive_key(pt, pt_len, ct,
+                                         (params->N * params->q_bits + 7) >> 3,
+                                         kem_key);
+        }
+    }
 
     return result;
 }
 
 
-/* ntru_crypto_ntru_decrypt
+/* ntru_crypto_ntru_encrypt
  *
- * Implements NTRU decryption (SVES) for the parameter set specified in
- * the private key blob.
+ * Implements NTRU encryption (SVES) for the parameter set specified in
+ * the public key blob.
  *
- * The maximum size of the output plaintext may be queried by invoking
- * this function with pt = NULL.  In this case, no decryption is performed,
- * NTRU_OK is returned, and the maximum size the plaintext could be is
- * returned in pt_len.
- * Note that until the decryption is performed successfully, the actual size
- * of the resulting plaintext cannot be known.
+ * Before invoking this function, a DRBG must be instantiated using
+ * ntru_crypto_drbg_instantiate() to obtain a DRBG handle, and in that
+ * instantiation the requested security strength must be at least as large
+ * as the security strength of the NTRU parameter set being used.
+ * Failure to instantiate the DRBG with the proper security strength will
+ * result in this function returning DRBG_ERROR_BASE + DRBG_BAD_LENGTH.
  *
- * When pt != NULL, at invocation *pt_len must be the size of the pt buffer.
- * Upon return it is the actual size of the plaintext.
+ * The required minimum size of the output ciphertext buffer (ct) may be
+ * queried by invoking this function with ct = NULL.  In this case, no
+ * encryption is performed, NTRU_OK is returned, and the required minimum
+ * size for ct is returned in ct_len.
+ *
+ * When ct != NULL, at invocation *ct_len must be the size of the ct buffer.
+ * Upon return it is the actual size of the ciphertext.
  *
  * Returns NTRU_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
  * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
- *  (other than pt) is NULL.
+ *  (other than ct) is NULL.
  * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if a length argument
- *  (privkey_blob) is zero, or if ct_len is invalid for the parameter set.
- * Returns NTRU_ERROR_BASE + NTRU_BAD_PRIVATE_KEY if the private-key blob is
+ *  (pubkey_blob_len or pt_len) is zero, or if pt_len exceeds the
+ *  maximum plaintext length for the parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
  *  invalid (unknown format, corrupt, bad length).
- * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the plaintext buffer
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the ciphertext buffer
  *  is too small.
  * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
  *  allocated from the heap.
- * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs.
  */
 
 uint32_t
-ntru_crypto_ntru_decrypt(
-    uint16_t       privkey_blob_len, /*     in - no. of octets in private key
+ntru_crypto_ntru_encrypt(
+    DRBG_HANDLE     drbg_handle,     /*     in - handle of DRBG */
+    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
                                                  blob */
-    uint8_t const *privkey_blob,     /*     in - pointer to private key */
-    uint16_t       ct_len,           /*     in - no. of octets in ciphertext */
-    uint8_t const *ct,               /*     in - pointer to ciphertext */
-    uint16_t      *pt_len,           /* in/out - no. of octets in pt, addr for
-                                                 no. of octets in plaintext */
-    uint8_t       *pt)               /*    out - address for plaintext */
+    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t        pt_len,          /*     in - no. of octets in plaintext */
+    uint8_t const  *pt,              /*     in - pointer to plaintext */
+    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
+                                                 no. of octets in ciphertext */
+    uint8_t        *ct)              /*    out - address for ciphertext */
+{
+    return ntru_crypto_ntru_encrypt_ex(drbg_handle, pubkey_blob_len,
+                                       pubkey_blob, pt_len, pt, ct_len, ct,
+                                       NULL, 0);
+}
+
+
+/* ntru_crypto_ntru_encrypt_scratch_size
+ *
+ * Returns in scratch_len the number of octets of workspace needed by
+ * ntru_crypto_ntru_encrypt_ex() for the parameter set.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if scratch_len is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_INVALID_PARAMETER_SET if the parameter-set
+ *  ID is invalid.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_scratch_size(
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id, /*  in - parameter set ID */
+    uint32_t                  *scratch_len)  /* out - address for no. of
+                                                      octets of workspace */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint16_t                pad_deg;
+
+    if ((params = ntru_encrypt_get_params_with_id(param_set_id)) == NULL)
+    {
+        NTRU_RET(NTRU_INVALID_PARAMETER_SET);
+    }
+
+    if (!scratch_len)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    *scratch_len = (uint32_t)ntru_encrypt_scratch_len(params, &pad_deg);
+    *scratch_len += pad_deg << 1;           /* buffer for unpacked h */
+
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_encrypt_parse_pubkey
+ *
+ * Parses a public-key blob, returning the parameter set and a pointer to
+ * the packed public key, and checks that its parameter set and packing
+ * are supported.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the public key
+ *  uses a parameter set or packing that is not supported.
+ */
+
+static uint32_t
+ntru_encrypt_parse_pubkey(
+    uint16_t                 pubkey_blob_len, /*  in - no. of octets in public
+                                                       key blob */
+    uint8_t const           *pubkey_blob,     /*  in - pointer to public key */
+    NTRU_ENCRYPT_PARAM_SET **params,          /* out - address for pointer to
+                                                       parameter set */
+    uint8_t const          **pubkey_packed)   /* out - address for pointer to
+                                                       packed public key */
+{
+    uint8_t pubkey_pack_type = 0x00;
+
+    if (pubkey_blob_len == 0)
+    {
+        NTRU_RET(NTRU_BAD_LENGTH);
+    }
+
+    /* get a pointer to the parameter-set parameters, the packing type for
+     * the public key, and a pointer to the packed public key
+     */
+
+    if (!ntru_crypto_ntru_encrypt_key_parse(TRUE /* pubkey */, pubkey_blob_len,
+                                            pubkey_blob, &pubkey_pack_type,
+                                            NULL, params, pubkey_packed,
+                                            NULL))
+    {
+        NTRU_RET(NTRU_BAD_PUBLIC_KEY);
+    }
+
+    if((*params)->q_bits <= 8
+            || (*params)->q_bits >= 16
+            || pubkey_pack_type != NTRU_ENCRYPT_KEY_PACKED_COEFFICIENTS)
+    {
+        NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
+    }
+
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_encrypt_blob
+ *
+ * Implements ntru_crypto_ntru_encrypt_ex() and ntru_crypto_kem_encaps().
+ * If kem_key is not NULL, pt and pt_len are ignored and a KEM secret is
+ * encrypted instead; see ntru_encrypt_core().
+ */
+
+static uint32_t
+ntru_encrypt_blob(
+    DRBG_HANDLE     drbg_handle,     /*     in - handle of DRBG */
+    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
+                                                 blob */
+    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t        pt_len,          /*     in - no. of octets in plaintext */
+    uint8_t const  *pt,              /*     in - pointer to plaintext */
+    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
+                                                 no. of octets in ciphertext */
+    uint8_t        *ct,              /*    out - address for ciphertext */
+    uint8_t        *kem_key,         /*    out - address for KEM shared key,
+                                                 or NULL */
+    void           *scratch,         /*     in - workspace, or NULL */
+    uint32_t        scratch_len)     /*     in - no. of octets in workspace */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint8_t const          *pubkey_packed = NULL;
+    uint16_t                packed_ct_len;
+    size_t                  scratch_buf_len;
+    uint16_t                pad_deg;
+    uint16_t               *scratch_buf = NULL;
+    uint16_t               *h_buf = NULL;
+    uint32_t                result = NTRU_OK;
+
+    /* check for bad parameters */
+
+    if (!pubkey_blob || !ct_len)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    /* parse and check the public-key blob */
+
+    result = ntru_encrypt_parse_pubkey(pubkey_blob_len, pubkey_blob, &params,
+                                       &pubkey_packed);
+    if (result != NTRU_OK)
+    {
+        return result;
+    }
+
+    /* return the ciphertext size if requested */
+
+    packed_ct_len = (params->N * params->q_bits + 7) >> 3;
+    
+    if (!ct)
+    {
+        *ct_len = packed_ct_len;
+        NTRU_RET(NTRU_OK);
+    }
+
+    /* check the ciphertext buffer size */
+
+    if (*ct_len < packed_ct_len)
+    {
+        NTRU_RET(NTRU_BUFFER_TOO_SMALL);
+    }
+
+    /* check that a plaintext was provided, or set the length of the KEM
+     * secret that is generated in its place
+     */
+
+    if (kem_key)
+    {
+        pt_len = params->sec_strength_len;
+        pt = NULL;
+    }
+    else if (!pt)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    /* check the plaintext length */
+
+    if (pt_len > params->m_len_max)
+    {
+        NTRU_RET(NTRU_BAD_LENGTH);
+    }
+
+    /* get memory for all operations */
+
+    scratch_buf_len = ntru_encrypt_scratch_len(params, &pad_deg);
+    scratch_buf_len += pad_deg << 1;        /* buffer for unpacked h */
+
+    result = ntru_scratch_get(scratch, scratch_len, scratch_buf_len,
+                              &scratch_buf);
+    if (result != NTRU_OK)
+    {
+        return result;
+    }
+
+    h_buf = scratch_buf;
+
+    /* unpack the public key, which has the same packed length as a
+     * ciphertext
+     */
+
+    ntru_octets_2_elements(packed_ct_len, pubkey_packed, params->q_bits,
+                           h_buf);
+    memset(h_buf + params->N, 0, (pad_deg - params->N) << 1);
+
+    /* encrypt */
+
+    result = ntru_encrypt_core(drbg_handle, params, h_buf, pubkey_packed,
+                               pt_len, pt, scratch_buf + pad_deg, ct,
+                               kem_key);
+
+    if (result == NTRU_OK)
+    {
+        *ct_len = packed_ct_len;
+    }
+
+    /* cleanup */
+
+    ntru_scratch_put(scratch, scratch_buf, scratch_buf_len);
+
+    return result;
+}
+
+
+/* ntru_crypto_ntru_encrypt_ex
+ *
+ * Implements NTRU encryption (SVES) as ntru_crypto_ntru_encrypt(), using
+ * a workspace provided by the caller instead of memory allocated from the
+ * heap.
+ *
+ * The workspace must be aligned to NTRU_SCRATCH_ALIGNMENT octets and be
+ * at least the size returned by ntru_crypto_ntru_encrypt_scratch_size()
+ * for the parameter set.  It is cleared before returning.  If scratch is
+ * NULL, memory is allocated from the heap as in ntru_crypto_ntru_encrypt().
+ *
+ * Returns the same values as ntru_crypto_ntru_encrypt(), and:
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  suitably aligned.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_ex(
+    DRBG_HANDLE     drbg_handle,     /*     in - handle of DRBG */
+    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
+                                                 blob */
+    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t        pt_len,          /*     in - no. of octets in plaintext */
+    uint8_t const  *pt,              /*     in - pointer to plaintext */
+    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
+                                                 no. of octets in ciphertext */
+    uint8_t        *ct,              /*    out - address for ciphertext */
+    void           *scratch,         /*     in - workspace, or NULL */
+    uint32_t        scratch_len)     /*     in - no. of octets in workspace */
+{
+    return ntru_encrypt_blob(drbg_handle, pubkey_blob_len, pubkey_blob,
+                             pt_len, pt, ct_len, ct, NULL, scratch,
+                             scratch_len);
+}
+
+
+/* ntru_crypto_ntru_encrypt_batch
+ *
+ * Implements NTRU encryption (SVES) of several plaintexts under a single
+ * public key.  The public-key blob is parsed and unpacked once, and a
+ * single scratch buffer is used for all of the encryptions.
+ *
+ * The DRBG requirements are the same as for ntru_crypto_ntru_encrypt().
+ *
+ * The required minimum size of each ciphertext buffer may be queried by
+ * invoking this function with cts = NULL.  In this case, no encryption is
+ * performed, NTRU_OK is returned, and the required minimum size for a
+ * ciphertext is returned in each of the num_msgs elements of ct_lens.
+ *
+ * When cts != NULL, at invocation ct_lens[i] must be the size of the
+ * cts[i] buffer.  Upon return, for each message that was encrypted,
+ * ct_lens[i] is the actual size of the ciphertext.  The status of each
+ * encryption is returned in results[i], using the return codes of
+ * ntru_crypto_ntru_encrypt(); a failure for one message does not stop
+ * the remaining messages from being encrypted.
+ *
+ * Returns NTRU_OK if every message was encrypted successfully.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if one or more messages could not be
+ *  encrypted; results identifies which.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than cts) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len or num_msgs
+ *  is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_batch(
+    DRBG_HANDLE            drbg_handle,     /*     in - handle of DRBG */
+    uint16_t               pubkey_blob_len, /*     in - no. of octets in public
+                                                        key blob */
+    uint8_t const         *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t               num_msgs,        /*     in - no. of plaintexts */
+    uint16_t const        *pt_lens,         /*     in - no. of octets in each
+                                                        plaintext */
+    uint8_t const * const *pts,             /*     in - pointers to
+                                                        plaintexts */
+    uint16_t              *ct_lens,         /* in/out - no. of octets in each
+                                                        ct buffer, addr for
+                                                        no. of octets in each
+                                                        ciphertext */
+    uint8_t * const       *cts,             /*    out - addresses for
+                                                        ciphertexts */
+    uint32_t              *results)         /*    out - status of each
+                                                        encryption */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint8_t const          *pubkey_packed = NULL;
+    uint16_t                packed_ct_len;
+    size_t                  scratch_buf_len;
+    uint16_t                pad_deg;
+    uint16_t               *scratch_buf = NULL;
+    uint16_t               *h_buf = NULL;
+    uint16_t                i;
+    uint32_t                result = NTRU_OK;
+
+    /* check for bad parameters */
+
+    if (!pubkey_blob || !ct_lens)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    if (num_msgs == 0)
+    {
+        NTRU_RET(NTRU_BAD_LENGTH);
+    }
+
+    /* parse and check the public-key blob */
+
+    result = ntru_encrypt_parse_pubkey(pubkey_blob_len, pubkey_blob, &params,
+                                       &pubkey_packed);
+    if (result != NTRU_OK)
+    {
+        return result;
+    }
+
+    /* return the ciphertext sizes if requested */
+
+    packed_ct_len = (params->N * params->q_bits + 7) >> 3;
+
+    if (!cts)
+    {
+        for (i = 0; i < num_msgs; i++)
+        {
+            ct_lens[i] = packed_ct_len;
+        }
+        NTRU_RET(NTRU_OK);
+    }
+
+    if (!pt_lens || !pts || !results)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    /* allocate memory for all operations */
+
+    scratch_buf_len = ntru_encrypt_scratch_len(params, &pad_deg);
+    scratch_buf_len += pad_deg << 1;        /* buffer for unpacked h */
+
+    result = ntru_scratch_get(NULL, 0, scratch_buf_len, &scratch_buf);
+    if (result != NTRU_OK)
+    {
+        return result;
+    }
+
+    h_buf = scratch_buf;
+
+    /* unpack the public key once for all messages; it has the same packed
+     * length as a ciphertext
+     */
+
+    ntru_octets_2_elements(packed_ct_len, pubkey_packed, params->q_bits,
+                           h_buf);
+    memset(h_buf + params->N, 0, (pad_deg - params->N) << 1);
+
+    /* encrypt each message, recording its status */
+
+    for (i = 0; i < num_msgs; i++)
+    {
+        if (!cts[i] || !pts[i])
+        {
+            results[i] = NTRU_RESULT(NTRU_BAD_PARAMETER);
+        }
+        else if (ct_lens[i] < packed_ct_len)
+        {
+            results[i] = NTRU_RESULT(NTRU_BUFFER_TOO_SMALL);
+        }
+        else if (pt_lens[i] > params->m_len_max)
+        {
+            results[i] = NTRU_RESULT(NTRU_BAD_LENGTH);
+        }
+        else
+        {
+            results[i] = ntru_encrypt_core(drbg_handle, params, h_buf,
+                                           pubkey_packed, pt_lens[i], pts[i],
+                                           scratch_buf + pad_deg, cts[i],
+                                           NULL);
+            if (results[i] == NTRU_OK)
+            {
+                ct_lens[i] = packed_ct_len;
+            }
+        }
+
+        if (results[i] != NTRU_OK)
+        {
+            result = NTRU_RESULT(NTRU_FAIL);
+        }
+    }
+
+    /* cleanup */
+
+    ntru_scratch_put(NULL, scratch_buf, scratch_buf_len);
+
+    return result;
+}
+
+
+/* ntru_crypto_ntru_encrypt_create_pubkey_ctx
+ *
+ * Creates a public-key context from a public-key blob.  The context holds
+ * the parameter set, the unpacked public key, and the truncated public key
+ * used in forming sData, so that ntru_crypto_ntru_encrypt_with_ctx() does
+ * not need to parse and unpack the blob for each encryption.
+ *
+ * The context does not reference the public-key blob after it is created.
+ * It must be released with ntru_crypto_ntru_encrypt_destroy_pubkey_ctx().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the public key
+ *  uses a parameter set or packing that is not supported.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_create_pubkey_ctx(
+    uint16_t                  pubkey_blob_len, /*  in - no. of octets in public
+                                                        key blob */
+    uint8_t const            *pubkey_blob,     /*  in - pointer to public key */
+    NTRU_ENCRYPT_PUBKEY_CTX **ctx)             /* out - address for pointer to
+                                                        public-key context */
+{
+    NTRU_ENCRYPT_PUBKEY_CTX *c = NULL;
+    NTRU_ENCRYPT_PARAM_SET  *params = NULL;
+    uint8_t const           *pubkey_packed = NULL;
+    uint16_t                 pubkey_packed_len;
+    uint16_t                 num_scratch_polys;
+    uint16_t                 pad_deg;
+    uint32_t                 result;
+
+    /* check for bad parameters */
+
+    if (!pubkey_blob || !ctx)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    *ctx = NULL;
+
+    /* parse and check the public-key blob */
+
+    result = ntru_encrypt_parse_pubkey(pubkey_blob_len, pubkey_blob, &params,
+                                       &pubkey_packed);
+    if (result != NTRU_OK)
+    {
+        return result;
+    }
+
+    /* allocate memory for the context, and for h followed by the
+     * truncated public key
+     */
+
+    ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys, &pad_deg);
+
+    if ((c = (NTRU_ENCRYPT_PUBKEY_CTX *)
+                MALLOC(sizeof(NTRU_ENCRYPT_PUBKEY_CTX))) == NULL)
+    {
+        NTRU_RET(NTRU_OUT_OF_MEMORY);
+    }
+
+    if ((c->h = (uint16_t *)MALLOC((pad_deg << 1) +
+                                   params->sec_strength_len)) == NULL)
+    {
+        FREE(c);
+        NTRU_RET(NTRU_OUT_OF_MEMORY);
+    }
+
+    c->params = params;
+    c->pad_deg = pad_deg;
+    c->pubkey_trunc = (uint8_t *)(c->h + pad_deg);
+
+    /* unpack the public key */
+
+    pubkey_packed_len = (params->N * params->q_bits + 7) >> 3;
+    ntru_octets_2_elements(pubkey_packed_len, pubkey_packed, params->q_bits,
+                           c->h);
+    memset(c->h + params->N, 0, (pad_deg - params->N) << 1);
+    memcpy(c->pubkey_trunc, pubkey_packed, params->sec_strength_len);
+
+    *ctx = c;
+
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_crypto_ntru_encrypt_destroy_pubkey_ctx
+ *
+ * Destroys a public-key context created by
+ * ntru_crypto_ntru_encrypt_create_pubkey_ctx().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if ctx is NULL.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_destroy_pubkey_ctx(
+    NTRU_ENCRYPT_PUBKEY_CTX *ctx)   /* in - pointer to public-key context */
+{
+    if (!ctx)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    FREE(ctx->h);
+    FREE(ctx);
+
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_crypto_ntru_encrypt_with_ctx
+ *
+ * Implements NTRU encryption (SVES) with a public-key context created by
+ * ntru_crypto_ntru_encrypt_create_pubkey_ctx().  Apart from taking the
+ * public key as a context, this behaves as ntru_crypto_ntru_encrypt().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than ct) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pt_len exceeds the
+ *  maximum plaintext length for the parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the ciphertext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_with_ctx(
+    DRBG_HANDLE                    drbg_handle, /*     in - handle of DRBG */
+    NTRU_ENCRYPT_PUBKEY_CTX const *ctx,         /*     in - pointer to
+                                                            public-key
+                                                            context */
+    uint16_t                       pt_len,      /*     in - no. of octets in
+                                                            plaintext */
+    uint8_t const                 *pt,          /*     in - pointer to
+                                                            plaintext */
+    uint16_t                      *ct_len,      /* in/out - no. of octets in
+                                                            ct, addr for no.
+                                                            of octets in
+                                                            ciphertext */
+    uint8_t                       *ct)          /*    out - address for
+                                                            ciphertext */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint16_t                packed_ct_len;
+    size_t                  scratch_buf_len;
+    uint16_t               *scratch_buf = NULL;
+    uint32_t                result = NTRU_OK;
+
+    /* check for bad parameters */
+
+    if (!ctx || !ct_len)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    params = ctx->params;
+
+    /* return the ciphertext size if requested */
+
+    packed_ct_len = (params->N * params->q_bits + 7) >> 3;
+
+    if (!ct)
+    {
+        *ct_len = packed_ct_len;
+        NTRU_RET(NTRU_OK);
+    }
+
+    /* check the ciphertext buffer size */
+
+    if (*ct_len < packed_ct_len)
+    {
+        NTRU_RET(NTRU_BUFFER_TOO_SMALL);
+    }
+
+    /* check that a plaintext was provided */
+
+    if (!pt)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    /* check the plaintext length */
+
+    if (pt_len > params->m_len_max)
+    {
+        NTRU_RET(NTRU_BAD_LENGTH);
+    }
+
+    /* allocate memory for all operations */
+
+    scratch_buf_len = ntru_encrypt_scratch_len(params, NULL);
+
+    result = ntru_scratch_get(NULL, 0, scratch_buf_len, &scratch_buf);
+    if (result != NTRU_OK)
+    {
+        return result;
+    }
+
+    /* encrypt */
+
+    result = ntru_encrypt_core(drbg_handle, params, ctx->h, ctx->pubkey_trunc,
+                               pt_len, pt, scratch_buf, ct, NULL);
+
+    if (result == NTRU_OK)
+    {
+        *ct_len = packed_ct_len;
+    }
+
+    /* cleanup */
+
+    ntru_scratch_put(NULL, scratch_buf, scratch_buf_len);
+
+    return result;
+}
+
+
+/* ntru_decrypt_scratch_len
+ *
+ * Returns the number of octets of scratch space needed by ntru_decrypt_core()
+ * for the parameter set.  The space for the unpacked private and public
+ * keys, which are supplied separately to ntru_decrypt_core(), is not
+ * included.
+ *
+ * If pad_deg is not NULL, the padded degree of ring elements used by the
+ * ring multiplication is returned in it.
+ */
+
+static size_t
+ntru_decrypt_scratch_len(
+    NTRU_ENCRYPT_PARAM_SET const *params,  /*  in - parameter set */
+    uint16_t                     *pad_deg) /* out - padded ring degree */
+{
+    uint32_t dF_r;
+    uint16_t num_scratch_polys;
+    uint16_t ring_pad_deg;
+
+    ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys,
+                                  &ring_pad_deg);
+
+    if (params->is_product_form)
+    {
+        dF_r = (params->dF_r & 0xff) + ((params->dF_r >> 8) & 0xff) +
+               ((params->dF_r >> 16) & 0xff);
+        num_scratch_polys += 1; /* mult_product_indices needs space for a
+                                   mult_indices and one intermediate result */
+    }
+    else
+    {
+        dF_r = params->dF_r;
+    }
+
+    if (pad_deg)
+    {
+        *pad_deg = ring_pad_deg;
+    }
+
+    return ((size_t)(num_scratch_polys * ring_pad_deg) << 1) +
+                                            /* X-byte temp buf for ring mult and
+                                                other intermediate results */
+           (ring_pad_deg << 2) +            /* 2 2N-byte bufs for ring elements
+                                                and overflow from temp buffer */
+           (dF_r << 2) +                    /* buffer for r indices */
+           params->m_len_max;               /* buffer for plaintext */
+}
+
+
+/* ntru_decrypt_num_F_indices
+ *
+ * Returns the total number of indices in the private key F for the
+ * parameter set (for all three polynomials in product form).
+ */
+
+static uint32_t
+ntru_decrypt_num_F_indices(
+    NTRU_ENCRYPT_PARAM_SET const *params)  /*  in - parameter set */
+{
+    uint32_t dF_r;
+
+    if (params->is_product_form)
+    {
+        dF_r = (params->dF_r & 0xff) + ((params->dF_r >> 8) & 0xff) +
+               ((params->dF_r >> 16) & 0xff);
+    }
+    else
+    {
+        dF_r = params->dF_r;
+    }
+
+    return dF_r << 1;
+}
+
+
+/* ntru_decrypt_unpack_F
+ *
+ * Unpacks the private key F from a private-key blob into a list of
+ * indices, as used by ntru_ring_mult_indices() and
+ * ntru_ring_mult_product_indices().
+ */
+
+static void
+ntru_decrypt_unpack_F(
+    NTRU_ENCRYPT_PARAM_SET const *params,            /*  in - parameter set */
+    uint8_t                       privkey_pack_type, /*  in - packing type of
+                                                              private key */
+    uint8_t const                *privkey_packed,    /*  in - packed private
+                                                              key */
+    uint16_t                     *F)                 /* out - address for F
+                                                              indices */
+{
+    uint32_t num_indices = ntru_decrypt_num_F_indices(params);
+
+    if (privkey_pack_type == NTRU_ENCRYPT_KEY_PACKED_TRITS)
+    {
+        ntru_packed_trits_2_indices(privkey_packed, params->N, F,
+                                    F + (num_indices >> 1));
+
+    }
+    else if (privkey_pack_type == NTRU_ENCRYPT_KEY_PACKED_INDICES)
+    {
+        ntru_octets_2_elements(
+                ((uint16_t)num_indices * params->N_bits + 7) >> 3,
+                privkey_packed, params->N_bits, F);
+    }
+    else
+    {
+        /* Unreachable due to supported parameter set check by caller */
+    }
+
+    return;
+}
+
+
+/* ntru_decrypt_shift_tail
+ *
+ * Shifts buf left by shift octets, filling the vacated octets at the end
+ * with zeros, in a time that depends only on len.  The shift is applied as
+ * a sequence of power-of-two shifts, each selected under a mask.
+ */
+
+static void
+ntru_decrypt_shift_tail(
+    uint8_t  *buf,              /* in/out - buffer to shift */
+    uint16_t  len,              /*     in - no. of octets in buf */
+    uint16_t  shift)            /*     in - no. of octets to shift by,
+                                            at most len */
+{
+    uint32_t s;
+    uint16_t i;
+    uint8_t  mask;
+
+    for (s = 1; s <= len; s <<= 1)
+    {
+        mask = (uint8_t)(0 - ((shift & s) != 0));
+
+        for (i = 0; i + s < len; i++)
+        {
+            buf[i] ^= (buf[i] ^ buf[i + s]) & mask;
+        }
+
+        for (; i < len; i++)
+        {
+            buf[i] &= ~mask;
+        }
+    }
+
+    return;
+}
+
+
+/* ntru_decrypt_core
+ *
+ * Performs NTRU decryption (SVES) of a single ciphertext with a private key
+ * that has already been parsed and unpacked.
+ *
+ * The arguments are assumed to have been checked by the caller: ct points
+ * to a ciphertext of the correct length for the parameter set, and pt is
+ * not NULL.
+ *
+ * The scratch buffer must be at least ntru_decrypt_scratch_len() octets.
+ * F holds the private-key indices, h holds the padded ring element produced
+ * by unpacking the public key; neither is modified.
+ *
+ * The checks on a candidate plaintext are accumulated without branching on
+ * secret data, and decryption of any valid or invalid ciphertext performs
+ * the same memory accesses and hash compressions, with two exceptions: the
+ * number of rejected candidates in MGF-TP-1 and IGF-2, which is a function
+ * of public-looking hash output, and the multiplications by the sparse
+ * polynomials F and cr, whose memory addresses depend on their indices.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the parameter set
+ *  uses an unknown hash algorithm.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the plaintext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs.
+ */
+
+static uint32_t
+ntru_decrypt_core(
+    NTRU_ENCRYPT_PARAM_SET const *params,      /*     in - parameter set */
+    uint16_t const               *F,           /*     in - private-key
+                                                           indices */
+    uint16_t const               *h,           /*     in - unpacked public
+                                                           key */
+    uint8_t const                *pubkey_trunc,/*     in - first
+                                                           sec_strength_len
+                                                           octets of the
+                                                           packed public key */
+    uint8_t const                *ct,          /*     in - pointer to
+                                                           ciphertext */
+    uint16_t                     *pt_len,      /* in/out - no. of octets in
+                                                           pt, addr for no. of
+                                                           octets in
+                                                           plaintext */
+    uint8_t                      *pt,          /*    out - address for
+                                                           plaintext */
+    uint16_t                     *scratch_buf) /*     in - scratch buffer */
 {
-    NTRU_ENCRYPT_PARAM_SET *params = NULL;
-    uint8_t const          *privkey_packed = NULL;
-    uint8_t const          *pubkey_packed = NULL;
-    uint8_t                 privkey_pack_type = 0x00;
-    uint8_t                 pubkey_pack_type = 0x00;
-    size_t                  scratch_buf_len;
     uint32_t                dF_r;
     uint32_t                dF_r1 = 0;
     uint32_t                dF_r2 = 0;
     uint32_t                dF_r3 = 0;
     uint16_t                num_scratch_polys;
     uint16_t                pad_deg;
-    uint16_t                ring_mult_tmp_len;
-    uint16_t               *scratch_buf = NULL;
     uint16_t               *ringel_buf1 = NULL;
     uint16_t               *ringel_buf2 = NULL;
     uint16_t               *i_buf = NULL;
@@ -455,40 +1384,424 @@ ntru_crypto_ntru_decrypt(
     uint8_t                *ptr = NULL;
     NTRU_CRYPTO_HASH_ALGID  hash_algid;
     uint8_t                 md_len;
-    uint16_t                mod_q_mask;
-    uint16_t                q_mod_p;
+    uint8_t                *shift_buf = NULL;
     uint16_t                cm_len = 0;
-    uint16_t                num_zeros;
+    uint16_t                tail_len;
     uint16_t                i;
-    bool                    decryption_ok = TRUE;
+    uint32_t                t;
+    uint32_t                fail = 0;
+    uint32_t                ok_mask;
     uint32_t                result = NTRU_OK;
 
-    /* check for bad parameters */
+    /* set up the scratch buffer */
 
-    if (!privkey_blob || !pt_len)
+    ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys, &pad_deg);
+
+    if (params->is_product_form)
     {
-        NTRU_RET(NTRU_BAD_PARAMETER);
+        dF_r1 =  params->dF_r & 0xff;
+        dF_r2 = (params->dF_r >>  8) & 0xff;
+        dF_r3 = (params->dF_r >> 16) & 0xff;
+        dF_r = dF_r1 + dF_r2 + dF_r3;
+        num_scratch_polys += 1;
+    }
+    else
+    {
+        dF_r = params->dF_r;
     }
 
-    if (privkey_blob_len == 0)
+    ringel_buf1 = scratch_buf + num_scratch_polys * pad_deg;
+    ringel_buf2 = ringel_buf1 + pad_deg;
+    i_buf = ringel_buf2 + pad_deg;
+    m_buf = (uint8_t *)(i_buf + (dF_r << 1));
+    tmp_buf = (uint8_t *)scratch_buf;
+    Mtrin_buf = (uint8_t *)ringel_buf1;
+    M_buf = Mtrin_buf + params->N;
+
+    /* set hash algorithm and seed length based on security strength */
+
+    if (params->hash_algid == NTRU_CRYPTO_HASH_ALGID_SHA1)
     {
-        NTRU_RET(NTRU_BAD_LENGTH);
+        hash_algid = NTRU_CRYPTO_HASH_ALGID_SHA1;
+        md_len = SHA_1_MD_LEN;
+    }
+    else if (params->hash_algid == NTRU_CRYPTO_HASH_ALGID_SHA256)
+    {
+        hash_algid = NTRU_CRYPTO_HASH_ALGID_SHA256;
+        md_len = SHA_256_MD_LEN;
+    }
+    else
+    {
+        NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
     }
 
-    /* get a pointer to the parameter-set parameters, the packing types for
-     * the public and private keys, and pointers to the packed public and
-     * private keys
+    /* unpack the ciphertext */
+
+    ntru_octets_2_elements((params->N * params->q_bits + 7) >> 3, ct,
+                           params->q_bits, ringel_buf2);
+
+    /* form cm':
+     *  F * e
+     *  A = e * (1 + pF) mod q = e + pFe mod q
+     *  a = A in the range [-q/2, q/2)
+     *  cm' = a mod p
+     *
+     * first compute F*e w/o reduction mod q and store in ringel_buf1
+     */
+    if (params->is_product_form)
+    {
+        ntru_ring_mult_product_indices(ringel_buf2, (uint16_t)dF_r1,
+                                       (uint16_t)dF_r2, (uint16_t)dF_r3,
+                                       F, params->N, params->q,
+                                       scratch_buf, ringel_buf1);
+    }
+    else
+    {
+        ntru_ring_mult_indices(ringel_buf2, (uint16_t)dF_r, (uint16_t)dF_r,
+                               F, params->N, params->q,
+                               scratch_buf, ringel_buf1);
+    }
+
+    /* then let ringel_buf1 = e + 3*ringel_buf1 (mod q) = e + pFe mod q
+     * lift ringel_buf1 elements to integers in the range [-q/2, q/2)
+     * let Mtrin_buf = ringel_buf1 (mod 3) = cm'
+     * check that the candidate message representative meets minimum weight
+     * requirements
+     * form cR = e - cm' mod q, where cm' = 1 subtracts 1 and cm' = 2 (-1)
+     * adds 1
+     *
+     * all in one pass over ringel_buf2 (e, then cR) and ringel_buf1
      */
 
-    if (!ntru_crypto_ntru_encrypt_key_parse(FALSE /* privkey */,
-                                            privkey_blob_len,
-                                            privkey_blob, &pubkey_pack_type,
-                                            &privkey_pack_type, &params,
-                                            &pubkey_packed, &privkey_packed))
+    fail |= !ntru_poly_recover_msg_rep(params->N, ringel_buf1,
+                                       params->min_msg_rep_wt, params->q,
+                                       ringel_buf2, Mtrin_buf);
+
+    /* form cR mod 4 */
+
+    ntru_coeffs_mod4_2_octets(params->N, ringel_buf2, tmp_buf);
+
+    /* form mask */
+
+    result = ntru_mgftp1(hash_algid, md_len,
+                         params->min_MGF_hash_calls,
+                         (params->N + 3) / 4, tmp_buf,
+                         tmp_buf + params->N, params->N, tmp_buf);
+
+    if (result == NTRU_OK)
+    {
+        /* form cMtrin by subtracting mask from cm', mod p */
+
+        ntru_poly_unmask_msg_rep(params->N, tmp_buf, Mtrin_buf);
+
+        /* convert cMtrin to cM (Mtrin to Mbin) */
+
+        fail |= !ntru_trits_2_bits(Mtrin_buf, params->N, M_buf);
+
+        /* validate the padded message cM and copy cm to m_buf
+         *
+         * cm_len is clamped to m_len_max under a mask, and all m_len_max + 1
+         * octets that may follow the message are checked, so that the
+         * octets read do not depend on cm_len
+         */
+
+        ptr = M_buf + params->b_len;
+
+        if (params->m_len_len == 2)
+        {
+            cm_len = (uint16_t)(*ptr++) << 8;
+        }
+
+        cm_len |= (uint16_t)(*ptr++);
+
+        t = ((uint32_t)params->m_len_max - cm_len) >> 31;
+        fail |= t;
+        cm_len ^= (cm_len ^ params->m_len_max) & (uint16_t)(0 - t);
+
+        memcpy(m_buf, ptr, params->m_len_max);
+
+        t = 0;
+        for (i = 0; i <= params->m_len_max; i++)
+        {
+            t |= ptr[i] & (0 - (((uint32_t)cm_len - 1 - i) >> 31));
+        }
+        fail |= (t + 0xff) >> 8;
+
+        /* form sData (OID || m || b || hTrunc) and hash it in a time that
+         * depends only on m_len_max; the sData octets after the message
+         * are placed with ntru_decrypt_shift_tail()
+         */
+
+        tail_len = params->b_len + params->sec_strength_len;
+        ptr = tmp_buf;
+        memcpy(ptr, params->OID, 3);
+        ptr += 3;
+
+        for (i = 0; i < params->m_len_max; i++)
+        {
+            ptr[i] = m_buf[i] & (uint8_t)(0 - ((i - (uint32_t)cm_len) >> 31));
+        }
+
+        memset(ptr + params->m_len_max, 0, tail_len);
+
+        shift_buf = ptr + params->m_len_max + tail_len;
+        memset(shift_buf, 0, params->m_len_max);
+        memcpy(shift_buf + params->m_len_max, M_buf, params->b_len);
+        memcpy(shift_buf + params->m_len_max + params->b_len, pubkey_trunc,
+               params->sec_strength_len);
+        ntru_decrypt_shift_tail(shift_buf, params->m_len_max + tail_len,
+                                params->m_len_max - cm_len);
+
+        for (i = 0; i < params->m_len_max + tail_len; i++)
+        {
+            ptr[i] |= shift_buf[i];
+        }
+
+        result = ntru_crypto_hash_digest_ct(hash_algid, tmp_buf,
+                                            3 + cm_len + tail_len,
+                                            3 + params->m_len_max + tail_len,
+                                            tmp_buf);
+    }
+
+    if (result == NTRU_OK)
+    {
+        /* generate cr, continuing from the digest of sData in tmp_buf */
+
+        memset(tmp_buf + md_len, 0, 4);
+        result = ntru_gen_poly(hash_algid, md_len,
+                               params->min_IGF_hash_calls,
+                               0, NULL, tmp_buf,
+                               params->N, params->c_bits,
+                               params->no_bias_limit,
+                               params->is_product_form,
+                               params->dF_r << 1, i_buf);
+    }
+
+    if (result == NTRU_OK)
+    {
+        /* form cR' = h * cr */
+
+        if (params->is_product_form)
+        {
+            ntru_ring_mult_product_indices(h, (uint16_t)dF_r1,
+                                           (uint16_t)dF_r2, (uint16_t)dF_r3,
+                                           i_buf, params->N, params->q,
+                                           scratch_buf, ringel_buf1);
+        }
+        else
+        {
+            ntru_ring_mult_indices(h, (uint16_t)dF_r, (uint16_t)dF_r,
+                                   i_buf, params->N, params->q,
+                                   scratch_buf, ringel_buf1);
+        }
+
+        /* compare cR' to cR */
+
+        t = 0;
+        for (i = 0; i < params->N; i++)
+        {
+            t |= ringel_buf1[i] ^ ringel_buf2[i];
+        }
+        fail |= (t + 0xffff) >> 16;
+
+        /* output plaintext and plaintext length; the copy is made under a
+         * mask, whether decryption succeeded or not, so that it takes the
+         * same time for any ciphertext
+         */
+
+        t = (((uint32_t)*pt_len - cm_len) >> 31) | fail;
+        ok_mask = t - 1;
+
+        for (i = 0; (i < params->m_len_max) && (i < *pt_len); i++)
+        {
+            t = ok_mask & (0 - ((i - (uint32_t)cm_len) >> 31));
+            pt[i] = (uint8_t)((m_buf[i] & t) | (pt[i] & ~t));
+        }
+
+        if (!fail)
+        {
+            if (*pt_len < cm_len)
+            {
+                NTRU_RET(NTRU_BUFFER_TOO_SMALL);
+            }
+
+            *pt_len = cm_len;
+        }
+    }
+
+    if (fail)
+    {
+        NTRU_RET(NTRU_FAIL);
+    }
+
+    return result;
+}
+
+
+/* ntru_crypto_ntru_decrypt
+ *
+ * Implements NTRU decryption (SVES) for the parameter set specified in
+ * the private key blob.
+ *
+ * The maximum size of the output plaintext may be queried by invoking
+ * this function with pt = NULL.  In this case, no decryption is performed,
+ * NTRU_OK is returned, and the maximum size the plaintext could be is
+ * returned in pt_len.
+ * Note that until the decryption is performed successfully, the actual size
+ * of the resulting plaintext cannot be known.
+ *
+ * When pt != NULL, at invocation *pt_len must be the size of the pt buffer.
+ * Upon return it is the actual size of the plaintext.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than pt) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if a length argument
+ *  (privkey_blob) is zero, or if ct_len is invalid for the parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PRIVATE_KEY if the private-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the plaintext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs.
+ */
+
+uint32_t
+ntru_crypto_ntru_decrypt(
+    uint16_t       privkey_blob_len, /*     in - no. of octets in private key
+                                                 blob */
+    uint8_t const *privkey_blob,     /*     in - pointer to private key */
+    uint16_t       ct_len,           /*     in - no. of octets in ciphertext */
+    uint8_t const *ct,               /*     in - pointer to ciphertext */
+    uint16_t      *pt_len,           /* in/out - no. of octets in pt, addr for
+                                                 no. of octets in plaintext */
+    uint8_t       *pt)               /*    out - address for plaintext */
+{
+    return ntru_crypto_ntru_decrypt_ex(privkey_blob_len, privkey_blob,
+                                       ct_len, ct, pt_len, pt, NULL, 0);
+}
+
+
+/* ntru_decrypt_ex_scratch_len
+ *
+ * Returns the number of octets of workspace needed by
+ * ntru_crypto_ntru_decrypt_ex() for the parameter set.  The workspace holds
+ * the unpacked public key, the scratch buffer for ntru_decrypt_core(), and
+ * the private-key indices, in that order.
+ *
+ * The padded degree of ring elements and the no. of octets used by
+ * ntru_decrypt_core(), rounded up to a whole number of coefficients, are
+ * returned in pad_deg and core_scratch_len.
+ */
+
+static size_t
+ntru_decrypt_ex_scratch_len(
+    NTRU_ENCRYPT_PARAM_SET const *params,           /*  in - parameter set */
+    uint16_t                     *pad_deg,          /* out - padded ring
+                                                             degree */
+    size_t                       *core_scratch_len) /* out - no. of octets
+                                                             of core
+                                                             scratch */
+{
+    *core_scratch_len = (ntru_decrypt_scratch_len(params, pad_deg) + 1) & ~1;
+
+    return (*pad_deg << 1) +                /* buffer for unpacked h */
+           *core_scratch_len +              /* scratch for decryption */
+           (ntru_decrypt_num_F_indices(params) << 1);
+                                            /* buffer for F indices */
+}
+
+
+/* ntru_crypto_ntru_decrypt_scratch_size
+ *
+ * Returns in scratch_len the number of octets of workspace needed by
+ * ntru_crypto_ntru_decrypt_ex() for the parameter set.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if scratch_len is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_INVALID_PARAMETER_SET if the parameter-set
+ *  ID is invalid.
+ */
+
+uint32_t
+ntru_crypto_ntru_decrypt_scratch_size(
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id, /*  in - parameter set ID */
+    uint32_t                  *scratch_len)  /* out - address for no. of
+                                                      octets of workspace */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint16_t                pad_deg;
+    size_t                  core_scratch_len;
+
+    if ((params = ntru_encrypt_get_params_with_id(param_set_id)) == NULL)
+    {
+        NTRU_RET(NTRU_INVALID_PARAMETER_SET);
+    }
+
+    if (!scratch_len)
     {
-        NTRU_RET(NTRU_BAD_PRIVATE_KEY);
+        NTRU_RET(NTRU_BAD_PARAMETER);
     }
 
+    *scratch_len = (uint32_t)ntru_decrypt_ex_scratch_len(params, &pad_deg,
+                                                         &core_scratch_len);
+
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_decrypt_parsed
+ *
+ * Implements ntru_crypto_ntru_decrypt_ex() for a private-key blob that has
+ * already been parsed by ntru_crypto_ntru_encrypt_key_parse(), given the
+ * parameter set, packing types and packed keys that it returned.
+ *
+ * Returns the same values as ntru_crypto_ntru_decrypt_ex(), other than
+ * those for a bad private-key blob.
+ */
+
+static uint32_t
+ntru_decrypt_parsed(
+    NTRU_ENCRYPT_PARAM_SET const *params,            /*     in - parameter
+                                                                 set */
+    uint8_t                       pubkey_pack_type,  /*     in - packing type
+                                                                 of public
+                                                                 key */
+    uint8_t                       privkey_pack_type, /*     in - packing type
+                                                                 of private
+                                                                 key */
+    uint8_t const                *pubkey_packed,     /*     in - packed
+                                                                 public key */
+    uint8_t const                *privkey_packed,    /*     in - packed
+                                                                 private
+                                                                 key */
+    uint16_t                      ct_len,            /*     in - no. of octets
+                                                                 in
+                                                                 ciphertext */
+    uint8_t const                *ct,                /*     in - pointer to
+                                                                 ciphertext */
+    uint16_t                     *pt_len,            /* in/out - no. of octets
+                                                                 in pt, addr
+                                                                 for no. of
+                                                                 octets in
+                                                                 plaintext */
+    uint8_t                      *pt,                /*    out - address for
+                                                                 plaintext */
+    void                         *scratch,           /*     in - workspace,
+                                                                 or NULL */
+    uint32_t                      scratch_len)       /*     in - no. of octets
+                                                                 in
+                                                                 workspace */
+{
+    size_t                  scratch_buf_len;
+    size_t                  core_scratch_len;
+    uint16_t                pad_deg;
+    uint16_t               *scratch_buf = NULL;
+    uint16_t               *h_buf = NULL;
+    uint16_t               *F_buf = NULL;
+    uint32_t                result = NTRU_OK;
+
     if(params->q_bits <= 8
             || params->q_bits >= 16
             || params->N_bits <= 8
@@ -527,307 +1840,356 @@ ntru_crypto_ntru_decrypt(
         NTRU_RET(NTRU_BAD_LENGTH);
     }
 
-    /* allocate memory for all operations */
+    /* get memory for all operations */
 
-    ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys, &pad_deg);
+    scratch_buf_len = ntru_decrypt_ex_scratch_len(params, &pad_deg,
+                                                  &core_scratch_len);
 
-    if (params->is_product_form)
-    {
-        dF_r1 =  params->dF_r & 0xff;
-        dF_r2 = (params->dF_r >>  8) & 0xff;
-        dF_r3 = (params->dF_r >> 16) & 0xff;
-        dF_r = dF_r1 + dF_r2 + dF_r3;
-        num_scratch_polys += 1; /* mult_product_indices needs space for a
-                                   mult_indices and one intermediate result */
-    }
-    else
+    result = ntru_scratch_get(scratch, scratch_len, scratch_buf_len,
+                              &scratch_buf);
+    if (result != NTRU_OK)
     {
-        dF_r = params->dF_r;
+        return result;
     }
-    ring_mult_tmp_len = num_scratch_polys * pad_deg;
 
-    scratch_buf_len = (ring_mult_tmp_len << 1) +
-                                            /* X-byte temp buf for ring mult and
-                                                other intermediate results */
-                      (pad_deg << 2) +      /* 2 2N-byte bufs for ring elements
-                                                and overflow from temp buffer */
-                      (dF_r << 2) +         /* buffer for F, r indices */
-                      params->m_len_max;    /* buffer for plaintext */
+    h_buf = scratch_buf;
+    F_buf = scratch_buf + pad_deg + (core_scratch_len >> 1);
 
-    scratch_buf = MALLOC(scratch_buf_len);
-    if (!scratch_buf)
-    {
-        NTRU_RET(NTRU_OUT_OF_MEMORY);
-    }
+    /* unpack the private key */
 
-    ringel_buf1 = scratch_buf + ring_mult_tmp_len;
-    ringel_buf2 = ringel_buf1 + pad_deg;
-    i_buf = ringel_buf2 + pad_deg;
-    m_buf = (uint8_t *)(i_buf + (dF_r << 1));
-    tmp_buf = (uint8_t *)scratch_buf;
-    Mtrin_buf = (uint8_t *)ringel_buf1;
-    M_buf = Mtrin_buf + params->N;
+    ntru_decrypt_unpack_F(params, privkey_pack_type, privkey_packed, F_buf);
 
-    /* set hash algorithm and seed length based on security strength */
+    /* unpack the public key, which has the same packed length as a
+     * ciphertext
+     */
 
-    if (params->hash_algid == NTRU_CRYPTO_HASH_ALGID_SHA1)
+    ntru_octets_2_elements(ct_len, pubkey_packed, params->q_bits, h_buf);
+    memset(h_buf + params->N, 0, (pad_deg - params->N) << 1);
+
+    /* decrypt */
+
+    result = ntru_decrypt_core(params, F_buf, h_buf, pubkey_packed, ct,
+                               pt_len, pt, scratch_buf + pad_deg);
+
+    /* cleanup */
+
+    ntru_scratch_put(scratch, scratch_buf, scratch_buf_len);
+
+    return result;
+}
+
+
+/* ntru_crypto_ntru_decrypt_ex
+ *
+ * Implements NTRU decryption (SVES) as ntru_crypto_ntru_decrypt(), using
+ * a workspace provided by the caller instead of memory allocated from the
+ * heap.
+ *
+ * The workspace must be aligned to NTRU_SCRATCH_ALIGNMENT octets and be
+ * at least the size returned by ntru_crypto_ntru_decrypt_scratch_size()
+ * for the parameter set.  It is cleared before returning.  If scratch is
+ * NULL, memory is allocated from the heap as in ntru_crypto_ntru_decrypt().
+ *
+ * Returns the same values as ntru_crypto_ntru_decrypt(), and:
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  suitably aligned.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
+ */
+
+uint32_t
+ntru_crypto_ntru_decrypt_ex(
+    uint16_t       privkey_blob_len, /*     in - no. of octets in private key
+                                                 blob */
+    uint8_t const *privkey_blob,     /*     in - pointer to private key */
+    uint16_t       ct_len,           /*     in - no. of octets in ciphertext */
+    uint8_t const *ct,               /*     in - pointer to ciphertext */
+    uint16_t      *pt_len,           /* in/out - no. of octets in pt, addr for
+                                                 no. of octets in plaintext */
+    uint8_t       *pt,               /*    out - address for plaintext */
+    void          *scratch,          /*     in - workspace, or NULL */
+    uint32_t       scratch_len)      /*     in - no. of octets in workspace */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint8_t const          *privkey_packed = NULL;
+    uint8_t const          *pubkey_packed = NULL;
+    uint8_t                 privkey_pack_type = 0x00;
+    uint8_t                 pubkey_pack_type = 0x00;
+
+    /* check for bad parameters */
+
+    if (!privkey_blob || !pt_len)
     {
-        hash_algid = NTRU_CRYPTO_HASH_ALGID_SHA1;
-        md_len = SHA_1_MD_LEN;
+        NTRU_RET(NTRU_BAD_PARAMETER);
     }
-    else if (params->hash_algid == NTRU_CRYPTO_HASH_ALGID_SHA256)
+
+    if (privkey_blob_len == 0)
     {
-        hash_algid = NTRU_CRYPTO_HASH_ALGID_SHA256;
-        md_len = SHA_256_MD_LEN;
+        NTRU_RET(NTRU_BAD_LENGTH);
     }
-    else
+
+    /* get a pointer to the parameter-set parameters, the packing types for
+     * the public and private keys, and pointers to the packed public and
+     * private keys
+     */
+
+    if (!ntru_crypto_ntru_encrypt_key_parse(FALSE /* privkey */,
+                                            privkey_blob_len,
+                                            privkey_blob, &pubkey_pack_type,
+                                            &privkey_pack_type, &params,
+                                            &pubkey_packed, &privkey_packed))
     {
-        FREE(scratch_buf);
-        NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
+        NTRU_RET(NTRU_BAD_PRIVATE_KEY);
     }
 
-    /* set constants */
-
-    mod_q_mask = params->q - 1;
-    q_mod_p = params->q % 3;
+    return ntru_decrypt_parsed(params, pubkey_pack_type, privkey_pack_type,
+                               pubkey_packed, privkey_packed, ct_len, ct,
+                               pt_len, pt, scratch, scratch_len);
+}
 
-    /* unpack the ciphertext */
 
-    ntru_octets_2_elements(ct_len, ct, params->q_bits, ringel_buf2);
+/* ntru_crypto_ntru_encrypt_create_privkey_ctx
+ *
+ * Creates a private-key context from a private-key blob.  The context holds
+ * the parameter set, the indices of the private key F, the unpacked public
+ * key, and the truncated public key used in forming sData, so that
+ * ntru_crypto_ntru_decrypt_with_ctx() does not need to parse and unpack
+ * the blob for each decryption.
+ *
+ * The context does not reference the private-key blob after it is created.
+ * It must be released with ntru_crypto_ntru_encrypt_destroy_privkey_ctx(),
+ * which clears the key material it holds.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if privkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PRIVATE_KEY if the private-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_UNSUPPORTED_PARAM_SET if the private key
+ *  uses a parameter set or packing that is not supported.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
 
-    /* unpack the private key */
+uint32_t
+ntru_crypto_ntru_encrypt_create_privkey_ctx(
+    uint16_t                   privkey_blob_len, /*  in - no. of octets in
+                                                          private key blob */
+    uint8_t const             *privkey_blob,     /*  in - pointer to private
+                                                          key */
+    NTRU_ENCRYPT_PRIVKEY_CTX **ctx)              /* out - address for pointer
+                                                          to private-key
+                                                          context */
+{
+    NTRU_ENCRYPT_PRIVKEY_CTX *c = NULL;
+    NTRU_ENCRYPT_PARAM_SET   *params = NULL;
+    uint8_t const            *privkey_packed = NULL;
+    uint8_t const            *pubkey_packed = NULL;
+    uint8_t                   privkey_pack_type = 0x00;
+    uint8_t                   pubkey_pack_type = 0x00;
+    uint16_t                  pubkey_packed_len;
+    uint16_t                  num_scratch_polys;
+    uint16_t                  pad_deg;
+    uint32_t                  num_F_indices;
 
-    if (privkey_pack_type == NTRU_ENCRYPT_KEY_PACKED_TRITS)
-    {
-        ntru_packed_trits_2_indices(privkey_packed, params->N, i_buf,
-                                    i_buf + dF_r);
+    /* check for bad parameters */
 
-    }
-    else if (privkey_pack_type == NTRU_ENCRYPT_KEY_PACKED_INDICES)
+    if (!privkey_blob || !ctx)
     {
-        ntru_octets_2_elements(
-                (((uint16_t)dF_r << 1) * params->N_bits + 7) >> 3,
-                privkey_packed, params->N_bits, i_buf);
+        NTRU_RET(NTRU_BAD_PARAMETER);
     }
-    else
+
+    *ctx = NULL;
+
+    if (privkey_blob_len == 0)
     {
-        /* Unreachable due to supported parameter set check above */
+        NTRU_RET(NTRU_BAD_LENGTH);
     }
 
-    /* form cm':
-     *  F * e
-     *  A = e * (1 + pF) mod q = e + pFe mod q
-     *  a = A in the range [-q/2, q/2)
-     *  cm' = a mod p
-     *
-     * first compute F*e w/o reduction mod q and store in ringel_buf1
+    /* get a pointer to the parameter-set parameters, the packing types for
+     * the public and private keys, and pointers to the packed public and
+     * private keys
      */
-    if (params->is_product_form)
+
+    if (!ntru_crypto_ntru_encrypt_key_parse(FALSE /* privkey */,
+                                            privkey_blob_len,
+                                            privkey_blob, &pubkey_pack_type,
+                                            &privkey_pack_type, &params,
+                                            &pubkey_packed, &privkey_packed))
     {
-        ntru_ring_mult_product_indices(ringel_buf2, (uint16_t)dF_r1,
-                                       (uint16_t)dF_r2, (uint16_t)dF_r3,
-                                       i_buf, params->N, params->q,
-                                       scratch_buf, ringel_buf1);
+        NTRU_RET(NTRU_BAD_PRIVATE_KEY);
     }
-    else
+
+    if(params->q_bits <= 8
+            || params->q_bits >= 16
+            || params->N_bits <= 8
+            || params->N_bits >= 16
+            || pubkey_pack_type != NTRU_ENCRYPT_KEY_PACKED_COEFFICIENTS
+            || (privkey_pack_type != NTRU_ENCRYPT_KEY_PACKED_TRITS
+                && privkey_pack_type != NTRU_ENCRYPT_KEY_PACKED_INDICES))
     {
-        ntru_ring_mult_indices(ringel_buf2, (uint16_t)dF_r, (uint16_t)dF_r,
-                               i_buf, params->N, params->q,
-                               scratch_buf, ringel_buf1);
+        NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
     }
 
-    /* then let ringel_buf1 = e + 3*ringel_buf1 (mod q) = e + pFe mod q
-     * lift ringel_buf1 elements to integers in the range [-q/2, q/2)
-     * let Mtrin_buf = ringel_buf1 (mod 3) = cm'
+    /* allocate memory for the context, and for h followed by F and the
+     * truncated public key
      */
-    for (i = 0; i < params->N; i++)
-    {
-        ringel_buf1[i] = (ringel_buf2[i] + 3 * ringel_buf1[i]) & mod_q_mask;
-
-        if (ringel_buf1[i] >= (params->q >> 1))
-        {
-            ringel_buf1[i] = ringel_buf1[i] - q_mod_p;
-        }
 
-        Mtrin_buf[i] = (uint8_t)(ringel_buf1[i] % 3);
-    }
+    ntru_ring_mult_indices_memreq(params->N, &num_scratch_polys, &pad_deg);
+    num_F_indices = ntru_decrypt_num_F_indices(params);
 
-    /* check that the candidate message representative meets minimum weight
-     * requirements
-     */
-    if (!ntru_poly_check_min_weight(params->N,
-                                    Mtrin_buf, params->min_msg_rep_wt))
+    if ((c = (NTRU_ENCRYPT_PRIVKEY_CTX *)
+                MALLOC(sizeof(NTRU_ENCRYPT_PRIVKEY_CTX))) == NULL)
     {
-        decryption_ok = FALSE;
+        NTRU_RET(NTRU_OUT_OF_MEMORY);
     }
 
+    c->buf_len = (pad_deg << 1) + (num_F_indices << 1) +
+                 params->sec_strength_len;
 
-    /* form cR = e - cm' mod q */
-
-    for (i = 0; i < params->N; i++)
+    if ((c->h = (uint16_t *)MALLOC(c->buf_len)) == NULL)
     {
-        if (Mtrin_buf[i] == 1)
-        {
-            ringel_buf2[i] = (ringel_buf2[i]-1) & mod_q_mask;
-        }
-        else if (Mtrin_buf[i] == 2)
-        {
-            ringel_buf2[i] = (ringel_buf2[i]+1) & mod_q_mask;
-        }
-        else
-        {
-            ;
-        }
+        FREE(c);
+        NTRU_RET(NTRU_OUT_OF_MEMORY);
     }
 
-    /* form cR mod 4 */
-
-    ntru_coeffs_mod4_2_octets(params->N, ringel_buf2, tmp_buf);
+    c->params = params;
+    c->pad_deg = pad_deg;
+    c->F = c->h + pad_deg;
+    c->pubkey_trunc = (uint8_t *)(c->F + num_F_indices);
 
-    /* form mask */
+    /* unpack the private key */
 
-    result = ntru_mgftp1(hash_algid, md_len,
-                         params->min_MGF_hash_calls,
-                         (params->N + 3) / 4, tmp_buf,
-                         tmp_buf + params->N, params->N, tmp_buf);
+    ntru_decrypt_unpack_F(params, privkey_pack_type, privkey_packed, c->F);
 
-    if (result == NTRU_OK)
-    {
-        /* form cMtrin by subtracting mask from cm', mod p */
+    /* unpack the public key */
 
-        for (i = 0; i < params->N; i++)
-        {
-            Mtrin_buf[i] = Mtrin_buf[i] - tmp_buf[i];
+    pubkey_packed_len = (params->N * params->q_bits + 7) >> 3;
+    ntru_octets_2_elements(pubkey_packed_len, pubkey_packed, params->q_bits,
+                           c->h);
+    memset(c->h + params->N, 0, (pad_deg - params->N) << 1);
+    memcpy(c->pubkey_trunc, pubkey_packed, params->sec_strength_len);
 
-            if (Mtrin_buf[i] >= 3)
-            {
-                Mtrin_buf[i] += 3;
-            }
-        }
+    *ctx = c;
 
-        /* convert cMtrin to cM (Mtrin to Mbin) */
+    NTRU_RET(NTRU_OK);
+}
 
-        if (!ntru_trits_2_bits(Mtrin_buf, params->N, M_buf))
-        {
-            decryption_ok = FALSE;
-        }
 
-        /* validate the padded message cM and copy cm to m_buf */
+/* ntru_crypto_ntru_encrypt_destroy_privkey_ctx
+ *
+ * Clears and destroys a private-key context created by
+ * ntru_crypto_ntru_encrypt_create_privkey_ctx().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if ctx is NULL.
+ */
 
-        ptr = M_buf + params->b_len;
+uint32_t
+ntru_crypto_ntru_encrypt_destroy_privkey_ctx(
+    NTRU_ENCRYPT_PRIVKEY_CTX *ctx)  /* in - pointer to private-key context */
+{
+    if (!ctx)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
 
-        if (params->m_len_len == 2)
-        {
-            cm_len = (uint16_t)(*ptr++) << 8;
-        }
+    memset(ctx->h, 0, ctx->buf_len);
+    FREE(ctx->h);
+    FREE(ctx);
 
-        cm_len |= (uint16_t)(*ptr++);
+    NTRU_RET(NTRU_OK);
+}
 
-        if (cm_len > params->m_len_max)
-        {
-            cm_len = params->m_len_max;
-            decryption_ok = FALSE;
-        }
 
-        memcpy(m_buf, ptr, cm_len);
-        ptr += cm_len;
-        num_zeros = params->m_len_max - cm_len + 1;
+/* ntru_crypto_ntru_decrypt_with_ctx
+ *
+ * Implements NTRU decryption (SVES) with a private-key context created by
+ * ntru_crypto_ntru_encrypt_create_privkey_ctx().  Apart from taking the
+ * private key as a context, this behaves as ntru_crypto_ntru_decrypt().
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than pt) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if ct_len is invalid for the
+ *  parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the plaintext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs.
+ */
 
-        for (i = 0; i < num_zeros; i++)
-        {
-            if (ptr[i] != 0)
-            {
-                decryption_ok = FALSE;
-            }
-        }
+uint32_t
+ntru_crypto_ntru_decrypt_with_ctx(
+    NTRU_ENCRYPT_PRIVKEY_CTX const *ctx,    /*     in - pointer to private-key
+                                                        context */
+    uint16_t                        ct_len, /*     in - no. of octets in
+                                                        ciphertext */
+    uint8_t const                  *ct,     /*     in - pointer to
+                                                        ciphertext */
+    uint16_t                       *pt_len, /* in/out - no. of octets in pt,
+                                                        addr for no. of octets
+                                                        in plaintext */
+    uint8_t                        *pt)     /*    out - address for
+                                                        plaintext */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    size_t                  scratch_buf_len;
+    uint16_t               *scratch_buf = NULL;
+    uint32_t                result = NTRU_OK;
 
-        /* form sData (OID || m || b || hTrunc) */
+    /* check for bad parameters */
 
-        ptr = tmp_buf;
-        memcpy(ptr, params->OID, 3);
-        ptr += 3;
-        memcpy(ptr, m_buf, cm_len);
-        ptr += cm_len;
-        memcpy(ptr, M_buf, params->b_len);
-        ptr += params->b_len;
-        memcpy(ptr, pubkey_packed, params->sec_strength_len);
-        ptr += params->sec_strength_len;
+    if (!ctx || !pt_len)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
 
-        /* generate cr */
+    params = ctx->params;
 
-        result = ntru_gen_poly(hash_algid, md_len,
-                               params->min_IGF_hash_calls,
-                               (uint16_t)(ptr - tmp_buf),
-                               tmp_buf, tmp_buf,
-                               params->N, params->c_bits,
-                               params->no_bias_limit,
-                               params->is_product_form,
-                               params->dF_r << 1, i_buf);
-    }
+    /* return the max plaintext size if requested */
 
-    if (result == NTRU_OK)
+    if (!pt)
     {
-        /* unpack the public key */
-
-        {
-            uint16_t pubkey_packed_len;
-            pubkey_packed_len = (params->N * params->q_bits + 7) >> 3;
-            ntru_octets_2_elements(pubkey_packed_len, pubkey_packed,
-                                   params->q_bits, ringel_buf1);
-        }
+        *pt_len = params->m_len_max;
+        NTRU_RET(NTRU_OK);
+    }
 
-        /* form cR' = h * cr */
+    /* check that a ciphertext was provided */
 
-        if (params->is_product_form)
-        {
-            ntru_ring_mult_product_indices(ringel_buf1, (uint16_t)dF_r1,
-                                           (uint16_t)dF_r2, (uint16_t)dF_r3,
-                                           i_buf, params->N, params->q,
-                                           scratch_buf, ringel_buf1);
-        }
-        else
-        {
-            ntru_ring_mult_indices(ringel_buf1, (uint16_t)dF_r, (uint16_t)dF_r,
-                                   i_buf, params->N, params->q,
-                                   scratch_buf, ringel_buf1);
-        }
+    if (!ct)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
 
-        /* compare cR' to cR */
+    /* check the ciphertext length */
 
-        for (i = 0; i < params->N; i++)
-        {
-            if (ringel_buf1[i] != ringel_buf2[i])
-            {
-                decryption_ok = FALSE;
-            }
-        }
+    if (ct_len != (params->N * params->q_bits + 7) >> 3)
+    {
+        NTRU_RET(NTRU_BAD_LENGTH);
+    }
 
-        /* output plaintext and plaintext length */
+    /* allocate memory for all operations */
 
-        if (decryption_ok)
-        {
-            if (*pt_len < cm_len)
-            {
-                memset(scratch_buf, 0, scratch_buf_len);
-                FREE(scratch_buf);
-                NTRU_RET(NTRU_BUFFER_TOO_SMALL);
-            }
+    scratch_buf_len = ntru_decrypt_scratch_len(params, NULL);
 
-            memcpy(pt, m_buf, cm_len);
-            *pt_len = cm_len;
-        }
+    result = ntru_scratch_get(NULL, 0, scratch_buf_len, &scratch_buf);
+    if (result != NTRU_OK)
+    {
+        return result;
     }
 
+    /* decrypt */
+
+    result = ntru_decrypt_core(params, ctx->F, ctx->h, ctx->pubkey_trunc, ct,
+                               pt_len, pt, scratch_buf);
+
     /* cleanup */
 
-    memset(scratch_buf, 0, scratch_buf_len);
-    FREE(scratch_buf);
-    
-    if (!decryption_ok)
-    {
-        NTRU_RET(NTRU_FAIL);
-    }
-    
+    ntru_scratch_put(NULL, scratch_buf, scratch_buf_len);
+
     return result;
 }
 
@@ -893,6 +2255,129 @@ ntru_crypto_ntru_encrypt_keygen(
                                                              in privkey_blob */
     uint8_t                   *privkey_blob)     /*    out - address for
                                                              private key blob */
+{
+    return ntru_crypto_ntru_encrypt_keygen_ex(drbg_handle, param_set_id,
+                                              pubkey_blob_len, pubkey_blob,
+                                              privkey_blob_len, privkey_blob,
+                                              NULL, 0);
+}
+
+
+/* ntru_keygen_scratch_len
+ *
+ * Returns the number of octets of scratch space needed for key generation
+ * with the parameter set.  We need:
+ *  - 2 polynomials for results: ringel_buf1 and ringel_buf2.
+ *  - scratch space for ntru_ring_mult_coefficients (which is
+ *    implementation dependent) plus one additional polynomial
+ *    of the same size for ntru_ring_lift_inv_pow2_x.
+ *  - 2*dF coefficients for F
+ * For product form keys we can overlap ringel_buf1 and the scratch space
+ * since mult. by f uses F_buf, so only room for ringel_buf2 is added.
+ */
+
+static size_t
+ntru_keygen_scratch_len(
+    NTRU_ENCRYPT_PARAM_SET const *params)  /*  in - parameter set */
+{
+    uint32_t dF;
+    uint16_t pad_deg;
+    uint16_t total_polys;
+
+    ntru_ring_mult_coefficients_memreq(params->N, &total_polys, &pad_deg);
+    total_polys += 1; /* ntru_ring_lift_... */
+
+    if (params->is_product_form)
+    {
+        dF = (params->dF_r & 0xff) + ((params->dF_r >> 8) & 0xff) +
+             ((params->dF_r >> 16) & 0xff);
+        total_polys += 1; /* ringel_buf2 */
+    }
+    else
+    {
+        dF = params->dF_r;
+        total_polys += 2; /* ringel_buf{1,2} */
+    }
+
+    return (total_polys * pad_deg * sizeof(uint16_t)) +
+           (2 * dF * sizeof(uint16_t));
+}
+
+
+/* ntru_crypto_ntru_encrypt_keygen_scratch_size
+ *
+ * Returns in scratch_len the number of octets of workspace needed by
+ * ntru_crypto_ntru_encrypt_keygen_ex() for the parameter set.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if scratch_len is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_INVALID_PARAMETER_SET if the parameter-set
+ *  ID is invalid.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_keygen_scratch_size(
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id, /*  in - parameter set ID */
+    uint32_t                  *scratch_len)  /* out - address for no. of
+                                                      octets of workspace */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+
+    if ((params = ntru_encrypt_get_params_with_id(param_set_id)) == NULL)
+    {
+        NTRU_RET(NTRU_INVALID_PARAMETER_SET);
+    }
+
+    if (!scratch_len)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    *scratch_len = (uint32_t)ntru_keygen_scratch_len(params);
+
+    NTRU_RET(NTRU_OK);
+}
+
+
+/* ntru_crypto_ntru_encrypt_keygen_ex
+ *
+ * Implements key generation for NTRUEncrypt as
+ * ntru_crypto_ntru_encrypt_keygen(), using a workspace provided by the
+ * caller instead of memory allocated from the heap.
+ *
+ * The workspace must be aligned to NTRU_SCRATCH_ALIGNMENT octets and be
+ * at least the size returned by ntru_crypto_ntru_encrypt_keygen_scratch_size()
+ * for the parameter set.  It is cleared before returning.  If scratch is
+ * NULL, memory is allocated from the heap as in
+ * ntru_crypto_ntru_encrypt_keygen().
+ *
+ * Returns the same values as ntru_crypto_ntru_encrypt_keygen(), and:
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if the workspace is not
+ *  suitably aligned.
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the workspace is
+ *  too small.
+ */
+
+uint32_t
+ntru_crypto_ntru_encrypt_keygen_ex(
+    DRBG_HANDLE                drbg_handle,      /*     in - handle of DRBG */
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id,     /*     in - parameter set ID */
+    uint16_t                  *pubkey_blob_len,  /* in/out - no. of octets in
+                                                             pubkey_blob, addr
+                                                             for no. of octets
+                                                             in pubkey_blob */
+    uint8_t                   *pubkey_blob,      /*    out - address for
+                                                             public key blob */
+    uint16_t                  *privkey_blob_len, /* in/out - no. of octets in
+                                                             privkey_blob, addr
+                                                             for no. of octets
+                                                             in privkey_blob */
+    uint8_t                   *privkey_blob,     /*    out - address for
+                                                             private key blob */
+    void                      *scratch,          /*     in - workspace, or
+                                                             NULL */
+    uint32_t                   scratch_len)      /*     in - no. of octets in
+                                                             workspace */
 {
     NTRU_ENCRYPT_PARAM_SET *params = NULL;
     uint16_t                public_key_blob_len;
@@ -905,7 +2390,6 @@ ntru_crypto_ntru_encrypt_keygen(
     uint32_t                dF2 = 0;
     uint32_t                dF3 = 0;
     uint16_t                pad_deg;
-    uint16_t                total_polys;
     uint16_t                num_scratch_polys;
     uint16_t               *scratch_buf = NULL;
     uint16_t               *ringel_buf1 = NULL;
@@ -964,17 +2448,11 @@ ntru_crypto_ntru_encrypt_keygen(
         NTRU_RET(NTRU_BUFFER_TOO_SMALL);
     }
 
-    /* Allocate memory for all operations. We need:
-     *  - 2 polynomials for results: ringel_buf1 and ringel_buf2.
-     *  - scratch space for ntru_ring_mult_coefficients (which is
-     *    implementation dependent) plus one additional polynomial
-     *    of the same size for ntru_ring_lift_inv_pow2_x.
-     *  - 2*dF coefficients for F
-     */
+    /* Get memory for all operations; see ntru_keygen_scratch_len() */
+
     ntru_ring_mult_coefficients_memreq(params->N, &num_scratch_polys, &pad_deg);
     num_scratch_polys += 1; /* ntru_ring_lift_... */
 
-    total_polys = num_scratch_polys;
     if (params->is_product_form)
     {
         dF1 =  params->dF_r & 0xff;
@@ -985,20 +2463,19 @@ ntru_crypto_ntru_encrypt_keygen(
          * and the scratch space since mult. by f uses F_buf.
          * so only add room for ringel_buf2 */
         num_scratch_polys -= 1;
-        total_polys += 1;
     }
     else
     {
         dF = params->dF_r;
-        total_polys += 2; /* ringel_buf{1,2} */
     }
 
-    scratch_buf_len = total_polys * pad_deg * sizeof(uint16_t);
-    scratch_buf_len += 2 * dF * sizeof(uint16_t);
-    scratch_buf = MALLOC(scratch_buf_len);
-    if (!scratch_buf)
+    scratch_buf_len = ntru_keygen_scratch_len(params);
+
+    result = ntru_scratch_get(scratch, scratch_len, scratch_buf_len,
+                              &scratch_buf);
+    if (result != NTRU_OK)
     {
-        NTRU_RET(NTRU_OUT_OF_MEMORY);
+        return result;
     }
     memset(scratch_buf, 0, scratch_buf_len);
 
@@ -1021,7 +2498,7 @@ ntru_crypto_ntru_encrypt_keygen(
     }
     else
     {
-        FREE(scratch_buf);
+        ntru_scratch_put(scratch, scratch_buf, scratch_buf_len);
         NTRU_RET(NTRU_UNSUPPORTED_PARAM_SET);
     }
 
@@ -1205,8 +2682,182 @@ ntru_crypto_ntru_encrypt_keygen(
 
     /* cleanup */
 
-    memset(scratch_buf, 0, scratch_buf_len);
-    FREE(scratch_buf);
+    ntru_scratch_put(scratch, scratch_buf, scratch_buf_len);
+
+    return result;
+}
+
+
+/* ntru_crypto_kem_keygen
+ *
+ * Generates a key pair for the NTRU key-encapsulation mechanism (KEM).
+ * The key blobs are the same as those of ntru_crypto_ntru_encrypt_keygen(),
+ * which this function calls, and the same requirements and return values
+ * apply.
+ */
+
+uint32_t
+ntru_crypto_kem_keygen(
+    DRBG_HANDLE                drbg_handle,      /*     in - handle of DRBG */
+    NTRU_ENCRYPT_PARAM_SET_ID  param_set_id,     /*     in - parameter set ID */
+    uint16_t                  *pubkey_blob_len,  /* in/out - no. of octets in
+                                                             pubkey_blob, addr
+                                                             for no. of octets
+                                                             in pubkey_blob */
+    uint8_t                   *pubkey_blob,      /*    out - address for
+                                                             public key blob */
+    uint16_t                  *privkey_blob_len, /* in/out - no. of octets in
+                                                             privkey_blob, addr
+                                                             for no. of octets
+                                                             in privkey_blob */
+    uint8_t                   *privkey_blob)     /*    out - address for
+                                                             private key blob */
+{
+    return ntru_crypto_ntru_encrypt_keygen(drbg_handle, param_set_id,
+                                           pubkey_blob_len, pubkey_blob,
+                                           privkey_blob_len, privkey_blob);
+}
+
+
+/* ntru_crypto_kem_encaps
+ *
+ * Encapsulates a shared key under a public key.  A secret of
+ * sec_strength_len octets is generated from the DRBG, in the same request
+ * as the random string b used by SVES, and encrypted as the plaintext;
+ * the shared key is the SHA-256 digest of the secret followed by the
+ * ciphertext, so that it is bound to the ciphertext.
+ *
+ * The DRBG requirements are the same as for ntru_crypto_ntru_encrypt().
+ *
+ * The required minimum size of the output ciphertext buffer (ct) may be
+ * queried by invoking this function with ct = NULL.  In this case, no
+ * encapsulation is performed, NTRU_OK is returned, and the required
+ * minimum size for ct is returned in ct_len.
+ *
+ * When ct != NULL, at invocation *ct_len must be the size of the ct buffer.
+ * Upon return it is the actual size of the ciphertext, and shared_key holds
+ * the NTRU_KEM_SHARED_KEY_LEN-octet shared key.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns DRBG_ERROR_BASE + DRBG_BAD_PARAMETER if the DRBG handle is invalid.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  (other than ct) is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if pubkey_blob_len is zero.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PUBLIC_KEY if the public-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_BUFFER_TOO_SMALL if the ciphertext buffer
+ *  is too small.
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ */
+
+uint32_t
+ntru_crypto_kem_encaps(
+    DRBG_HANDLE     drbg_handle,     /*     in - handle of DRBG */
+    uint16_t        pubkey_blob_len, /*     in - no. of octets in public key
+                                                 blob */
+    uint8_t const  *pubkey_blob,     /*     in - pointer to public key */
+    uint16_t       *ct_len,          /* in/out - no. of octets in ct, addr for
+                                                 no. of octets in ciphertext */
+    uint8_t        *ct,              /*    out - address for ciphertext */
+    uint8_t        *shared_key)      /*    out - address for shared key */
+{
+    if (ct && !shared_key)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    return ntru_encrypt_blob(drbg_handle, pubkey_blob_len, pubkey_blob,
+                             0, NULL, ct_len, ct,
+                             ct ? shared_key : NULL, NULL, 0);
+}
+
+
+/* ntru_crypto_kem_decaps
+ *
+ * Decapsulates the shared key from a ciphertext produced by
+ * ntru_crypto_kem_encaps(), using the private key.  The ciphertext is
+ * decrypted as by ntru_crypto_ntru_decrypt(), and the recovered plaintext
+ * must be a secret of sec_strength_len octets; the shared key is the
+ * SHA-256 digest of the secret followed by the ciphertext, returned in the
+ * NTRU_KEM_SHARED_KEY_LEN octets at shared_key.
+ *
+ * Returns NTRU_OK if successful.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PARAMETER if an argument pointer
+ *  is NULL.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_LENGTH if privkey_blob_len is zero,
+ *  or if ct_len is invalid for the parameter set.
+ * Returns NTRU_ERROR_BASE + NTRU_BAD_PRIVATE_KEY if the private-key blob is
+ *  invalid (unknown format, corrupt, bad length).
+ * Returns NTRU_ERROR_BASE + NTRU_NO_MEMORY if memory needed cannot be
+ *  allocated from the heap.
+ * Returns NTRU_ERROR_BASE + NTRU_FAIL if a decryption error occurs, or if
+ *  the plaintext is not a KEM secret.
+ */
+
+uint32_t
+ntru_crypto_kem_decaps(
+    uint16_t       privkey_blob_len, /*  in - no. of octets in private key
+                                              blob */
+    uint8_t const *privkey_blob,     /*  in - pointer to private key */
+    uint16_t       ct_len,           /*  in - no. of octets in ciphertext */
+    uint8_t const *ct,               /*  in - pointer to ciphertext */
+    uint8_t       *shared_key)       /* out - address for shared key */
+{
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    uint8_t const          *pubkey_packed = NULL;
+    uint8_t const          *privkey_packed = NULL;
+    uint8_t                 pubkey_pack_type = 0x00;
+    uint8_t                 privkey_pack_type = 0x00;
+    uint8_t                 secret[NTRU_KEM_SHARED_KEY_LEN];
+    uint16_t                secret_len;
+    uint32_t                result = NTRU_OK;
+
+    /* check for bad parameters */
+
+    if (!privkey_blob || !ct || !shared_key)
+    {
+        NTRU_RET(NTRU_BAD_PARAMETER);
+    }
+
+    if (privkey_blob_len == 0)
+    {
+        NTRU_RET(NTRU_BAD_LENGTH);
+    }
+
+    /* parse the key once, for the length of the secret and to decrypt */
+
+    if (!ntru_crypto_ntru_encrypt_key_parse(FALSE /* privkey */,
+                                            privkey_blob_len,
+                                            privkey_blob, &pubkey_pack_type,
+                                            &privkey_pack_type, &params,
+                                            &pubkey_packed, &privkey_packed))
+    {
+        NTRU_RET(NTRU_BAD_PRIVATE_KEY);
+    }
+
+    /* decrypt the secret; a plaintext of any other length is a failure */
+
+    secret_len = params->sec_strength_len;
+    result = ntru_decrypt_parsed(params, pubkey_pack_type, privkey_pack_type,
+                                 pubkey_packed, privkey_packed, ct_len, ct,
+                                 &secret_len, secret, NULL, 0);
+
+    if ((result == NTRU_RESULT(NTRU_BUFFER_TOO_SMALL)) ||
+        ((result == NTRU_OK) && (secret_len != params->sec_strength_len)))
+    {
+        result = NTRU_RESULT(NTRU_FAIL);
+    }
+
+    /* derive the shared key from the secret and ciphertext */
+
+    if (result == NTRU_OK)
+    {
+        result = ntru_kem_derive_key(secret, secret_len, ct, ct_len,
+                                     shared_key);
+    }
+
+    memset(secret, 0, sizeof(secret));
 
     return result;
 }
@@ -33,6 +33,7 @@
 #include "ntru_crypto.h"
 #include "ntru_crypto_ntru_mgf1.h"
 #include "ntru_crypto_ntru_convert.h"
+#include "ntru_crypto_sha2.h"
 
 
 /* ntru_mgf1
@@ -43,6 +44,9 @@
  *
  * The state (string and counter) is initialized when a seed is present.
  *
+ * With SHA-256, all num_calls digests are computed by a single call to
+ * ntru_crypto_sha256_ctr(), which hashes several counter values at once.
+ *
  * Returns NTRU_OK if successful.
  * Returns NTRU_CRYPTO_HASH_ errors if they occur.
  *
@@ -59,6 +63,7 @@ ntru_mgf1(
     uint8_t                *out)        /*    out - address for output */
 {
     uint8_t  *ctr = state + md_len;
+    uint32_t  count;
     uint32_t  retcode;
 
     /* if seed present, init state */
@@ -74,7 +79,23 @@ ntru_mgf1(
         memset(ctr, 0, 4);
     }
 
-    /* generate output */
+    /* generate output; SHA-256 digests of state || counter are computed
+     * together, several at a time
+     */
+
+    if (algid == NTRU_CRYPTO_HASH_ALGID_SHA256)
+    {
+        count = ((uint32_t)ctr[0] << 24) | ((uint32_t)ctr[1] << 16) |
+                ((uint32_t)ctr[2] <<  8) |  (uint32_t)ctr[3];
+        ntru_crypto_sha256_ctr(state, count, num_calls, out);
+        count += num_calls;
+        ctr[0] = (uint8_t)(count >> 24);
+        ctr[1] = (uint8_t)(count >> 16);
+        ctr[2] = (uint8_t)(count >>  8);
+        ctr[3] = (uint8_t)count;
+
+        NTRU_RET(NTRU_OK);
+    }
 
     while (num_calls-- > 0)
     {
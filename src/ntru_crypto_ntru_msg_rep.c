@@ -0,0 +1,297 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_ntru_msg_rep.c is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_ntru_msg_rep.c
+ *
+ * Contents: Forming and recovering the message representative, and
+ *           run-time selection of their implementation.
+ *
+ * The scalar implementation is always built.  When the library is built
+ * for x86 with NTRU_HAVE_X86_SIMD, the SSSE3 and AVX2 implementations are
+ * built as well, and the best one the CPU supports is selected when the
+ * library is loaded.
+ *
+ *****************************************************************************/
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_poly.h"
+#include "ntru_crypto_cpu.h"
+
+
+/* ntru_poly_add_msg_rep_scalar
+ *
+ * Forms m' = mask + Mtrin (mod 3), counts its weights and adds it to R,
+ * one element at a time; see ntru_poly_add_msg_rep.  The reduction mod 3
+ * and the addition use masks rather than branches.
+ */
+
+bool
+ntru_poly_add_msg_rep_scalar(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t const  *trits,          /*  in - pointer to message trits Mtrin */
+    uint16_t        min_wt,         /*  in - minimum weight of m' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels)        /* in/out - pointer to ring element R */
+{
+    uint32_t mod_q_mask = q - 1;
+    uint32_t wt1 = 0;
+    uint32_t wt2 = 0;
+    uint32_t m;
+    uint16_t i;
+
+    for (i = 0; i < num_els; i++)
+    {
+        /* m is at most 4, and (m + 1) >> 2 is 1 only if m >= 3 */
+
+        m = (uint32_t)mask[i] + trits[i];
+        m -= 3 & (0 - ((m + 1) >> 2));
+
+        wt1 += m & 1;
+        wt2 += m >> 1;
+
+        ringels[i] = (uint16_t)((ringels[i] + (m & 1) - (m >> 1)) &
+                                mod_q_mask);
+    }
+
+    return ntru_poly_check_weights(num_els, wt1, wt2, min_wt);
+}
+
+
+/* ntru_poly_recover_msg_rep_scalar
+ *
+ * Recovers cm', counts its weights and forms cR, one element at a time;
+ * see ntru_poly_recover_msg_rep.
+ *
+ * The lift subtracts q mod 3 under a mask, and the reduction mod 3 uses a
+ * reciprocal (t/3 = (t * 43691) >> 17 for t < 2^16), so neither depends
+ * on the coefficients through a branch or a division.
+ */
+
+bool
+ntru_poly_recover_msg_rep_scalar(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint16_t const *Fe,             /*  in - pointer to F * e */
+    uint16_t        min_wt,         /*  in - minimum weight of cm' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels,        /* in/out - pointer to e, then cR */
+    uint8_t        *trits)          /* out - address for cm' */
+{
+    uint32_t mod_q_mask = q - 1;
+    uint32_t half_q = q >> 1;
+    uint32_t q_mod_p = q % 3;
+    uint32_t wt1 = 0;
+    uint32_t wt2 = 0;
+    uint32_t t;
+    uint32_t m;
+    uint16_t i;
+
+    for (i = 0; i < num_els; i++)
+    {
+        t = (ringels[i] + 3 * (uint32_t)Fe[i]) & mod_q_mask;
+        t -= q_mod_p & (0 - ((half_q - 1 - t) >> 31));
+        m = t - 3 * ((t * 43691) >> 17);
+
+        wt1 += m & 1;
+        wt2 += m >> 1;
+
+        trits[i] = (uint8_t)m;
+        ringels[i] = (uint16_t)((ringels[i] + (m >> 1) - (m & 1)) &
+                                mod_q_mask);
+    }
+
+    return ntru_poly_check_weights(num_els, wt1, wt2, min_wt);
+}
+
+
+/* ntru_poly_unmask_msg_rep_scalar
+ *
+ * Forms cMtrin = cm' - mask (mod 3) one element at a time, adding 3 under
+ * a mask when the difference is negative.
+ */
+
+void
+ntru_poly_unmask_msg_rep_scalar(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t        *trits)          /* in/out - pointer to cm', then cMtrin */
+{
+    uint32_t t;
+    uint16_t i;
+
+    for (i = 0; i < num_els; i++)
+    {
+        t = (uint32_t)trits[i] - mask[i];
+        trits[i] = (uint8_t)(t + (3 & (0 - (t >> 31))));
+    }
+}
+
+
+/* implementation table, indexed by NTRU_MSG_REP_IMPL_ID */
+
+static NTRU_MSG_REP_IMPL const ntru_msg_rep_impls[] = {
+    {
+        "scalar",
+        ntru_poly_add_msg_rep_scalar,
+        ntru_poly_recover_msg_rep_scalar,
+        ntru_poly_unmask_msg_rep_scalar,
+    },
+#if defined(NTRU_HAVE_X86_SIMD)
+    {
+        "ssse3",
+        ntru_poly_add_msg_rep_ssse3,
+        ntru_poly_recover_msg_rep_ssse3,
+        ntru_poly_unmask_msg_rep_ssse3,
+    },
+    {
+        "avx2",
+        ntru_poly_add_msg_rep_avx2,
+        ntru_poly_recover_msg_rep_avx2,
+        ntru_poly_unmask_msg_rep_avx2,
+    },
+#endif
+};
+
+#define NTRU_MSG_REP_NUM_BUILT                                                \
+    (sizeof(ntru_msg_rep_impls) / sizeof(ntru_msg_rep_impls[0]))
+
+
+/* NTRU_CPU_ flags required by each implementation, indexed by
+ * NTRU_MSG_REP_IMPL_ID
+ */
+
+static uint32_t const ntru_msg_rep_required[] = {
+    0,
+#if defined(NTRU_HAVE_X86_SIMD)
+    NTRU_CPU_SSSE3,
+    NTRU_CPU_AVX2,
+#endif
+};
+
+
+/* the message representative routines in use */
+
+static NTRU_MSG_REP_IMPL const *ntru_msg_rep_impl = ntru_msg_rep_impls;
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* ntru_msg_rep_select
+ *
+ * Picks the widest message representative routines that the CPU supports.
+ */
+
+static void ntru_msg_rep_select(void) __attribute__((constructor));
+
+static void
+ntru_msg_rep_select(void)
+{
+    ntru_msg_rep_impl = ntru_msg_rep_impls +
+        ntru_crypto_cpu_best_impl(ntru_msg_rep_required,
+                                  NTRU_MSG_REP_NUM_BUILT);
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_msg_rep_get_impl
+ *
+ * Returns the message representative implementation with the given ID, or
+ * NULL if it is not built into the library or not supported by the CPU.
+ * Passing NTRU_MSG_REP_NUM_IMPLS returns the selected implementation.
+ */
+
+NTRU_MSG_REP_IMPL const *
+ntru_msg_rep_get_impl(
+    NTRU_MSG_REP_IMPL_ID id)        /*  in - implementation ID */
+{
+    if (id == NTRU_MSG_REP_NUM_IMPLS)
+    {
+        return ntru_msg_rep_impl;
+    }
+
+    if (((uint32_t)id >= NTRU_MSG_REP_NUM_BUILT) ||
+        !ntru_crypto_cpu_supports(ntru_msg_rep_required[id]))
+    {
+        return NULL;
+    }
+
+    return ntru_msg_rep_impls + id;
+}
+
+
+/* ntru_poly_add_msg_rep
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+bool
+ntru_poly_add_msg_rep(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t const  *trits,          /*  in - pointer to message trits Mtrin */
+    uint16_t        min_wt,         /*  in - minimum weight of m' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels)        /* in/out - pointer to ring element R */
+{
+    return ntru_msg_rep_impl->add_msg_rep(num_els, mask, trits, min_wt, q,
+                                          ringels);
+}
+
+
+/* ntru_poly_recover_msg_rep
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+bool
+ntru_poly_recover_msg_rep(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint16_t const *Fe,             /*  in - pointer to F * e */
+    uint16_t        min_wt,         /*  in - minimum weight of cm' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels,        /* in/out - pointer to e, then cR */
+    uint8_t        *trits)          /* out - address for cm' */
+{
+    return ntru_msg_rep_impl->recover_msg_rep(num_els, Fe, min_wt, q,
+                                              ringels, trits);
+}
+
+
+/* ntru_poly_unmask_msg_rep
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+void
+ntru_poly_unmask_msg_rep(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t        *trits)          /* in/out - pointer to cm', then cMtrin */
+{
+    ntru_msg_rep_impl->unmask_msg_rep(num_els, mask, trits);
+}
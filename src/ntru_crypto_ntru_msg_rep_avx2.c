@@ -0,0 +1,221 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_poly.h"
+#include <immintrin.h>
+
+/* ntru_poly_add_msg_rep_avx2
+ *
+ * Forms m' = mask + Mtrin (mod 3), counts its weights and adds it to R,
+ * 32 elements at a time, as ntru_poly_add_msg_rep_ssse3 in
+ * ntru_crypto_ntru_msg_rep_simd.c.  The remainder is done one element
+ * at a time, adding to the same weight counts.
+ */
+
+bool
+ntru_poly_add_msg_rep_avx2(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t const  *trits,          /*  in - pointer to message trits Mtrin */
+    uint16_t        min_wt,         /*  in - minimum weight of m' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels)        /* in/out - pointer to ring element R */
+{
+  __m256i const zero = _mm256_setzero_si256();
+  __m256i const one8 = _mm256_set1_epi8(1);
+  __m256i const one16 = _mm256_set1_epi16(1);
+  __m256i const qmask = _mm256_set1_epi16((short) (q - 1));
+  __m256i acc1 = zero;
+  __m256i acc12 = zero;
+  __m256i m, w, r;
+  __m128i s1, s12;
+  uint32_t mod_q_mask = q - 1;
+  uint32_t wt1, wt12;
+  uint32_t t;
+  uint16_t i;
+
+  for (i = 0; i + 32 <= num_els; i += 32)
+  {
+    m = _mm256_add_epi8(_mm256_loadu_si256((__m256i const *) (mask + i)),
+                        _mm256_loadu_si256((__m256i const *) (trits + i)));
+    m = _mm256_sub_epi8(m, _mm256_and_si256(
+                               _mm256_cmpgt_epi8(m, _mm256_set1_epi8(2)),
+                               _mm256_set1_epi8(3)));
+
+    acc1 = _mm256_add_epi64(acc1,
+                            _mm256_sad_epu8(_mm256_and_si256(m, one8), zero));
+    acc12 = _mm256_add_epi64(acc12, _mm256_sad_epu8(m, zero));
+
+    w = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(m));
+    r = _mm256_loadu_si256((__m256i const *) (ringels + i));
+    r = _mm256_add_epi16(r, _mm256_sub_epi16(_mm256_and_si256(w, one16),
+                                             _mm256_srli_epi16(w, 1)));
+    _mm256_storeu_si256((__m256i *) (ringels + i),
+                        _mm256_and_si256(r, qmask));
+
+    w = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(m, 1));
+    r = _mm256_loadu_si256((__m256i const *) (ringels + i + 16));
+    r = _mm256_add_epi16(r, _mm256_sub_epi16(_mm256_and_si256(w, one16),
+                                             _mm256_srli_epi16(w, 1)));
+    _mm256_storeu_si256((__m256i *) (ringels + i + 16),
+                        _mm256_and_si256(r, qmask));
+  }
+
+  s1 = _mm_add_epi64(_mm256_castsi256_si128(acc1),
+                     _mm256_extracti128_si256(acc1, 1));
+  s12 = _mm_add_epi64(_mm256_castsi256_si128(acc12),
+                      _mm256_extracti128_si256(acc12, 1));
+  wt1 = (uint32_t) (_mm_cvtsi128_si32(s1) +
+                    _mm_cvtsi128_si32(_mm_srli_si128(s1, 8)));
+  wt12 = (uint32_t) (_mm_cvtsi128_si32(s12) +
+                     _mm_cvtsi128_si32(_mm_srli_si128(s12, 8)));
+
+  for (; i < num_els; i++)
+  {
+    t = (uint32_t) mask[i] + trits[i];
+    t -= 3 & (0 - ((t + 1) >> 2));
+
+    wt1 += t & 1;
+    wt12 += t;
+
+    ringels[i] = (uint16_t) ((ringels[i] + (t & 1) - (t >> 1)) & mod_q_mask);
+  }
+
+  return ntru_poly_check_weights(num_els, wt1, (wt12 - wt1) >> 1, min_wt);
+}
+
+/* ntru_recover_msg_rep16_avx2
+ *
+ * Recovers 16 elements of cm' as 16-bit lanes, and replaces the 16
+ * elements of e with cR, as ntru_recover_msg_rep8_ssse3 in
+ * ntru_crypto_ntru_msg_rep_simd.c.
+ */
+
+static __m256i
+ntru_recover_msg_rep16_avx2(
+    uint16_t const *Fe,
+    uint16_t       *ringels,
+    __m256i         qmask,
+    __m256i         half_q_m1,
+    __m256i         q_mod_p)
+{
+  __m256i e, f, t, m;
+
+  e = _mm256_loadu_si256((__m256i const *) ringels);
+  f = _mm256_loadu_si256((__m256i const *) Fe);
+
+  t = _mm256_and_si256(
+          _mm256_add_epi16(e, _mm256_add_epi16(f, _mm256_add_epi16(f, f))),
+          qmask);
+  t = _mm256_sub_epi16(t, _mm256_and_si256(_mm256_cmpgt_epi16(t, half_q_m1),
+                                           q_mod_p));
+  m = _mm256_srli_epi16(
+          _mm256_mulhi_epu16(t, _mm256_set1_epi16((short) 43691)), 1);
+  m = _mm256_sub_epi16(t, _mm256_mullo_epi16(m, _mm256_set1_epi16(3)));
+
+  e = _mm256_add_epi16(e, _mm256_sub_epi16(
+                              _mm256_srli_epi16(m, 1),
+                              _mm256_and_si256(m, _mm256_set1_epi16(1))));
+  _mm256_storeu_si256((__m256i *) ringels, _mm256_and_si256(e, qmask));
+
+  return m;
+}
+
+/* ntru_poly_recover_msg_rep_avx2
+ *
+ * Recovers cm', counts its weights and forms cR, 32 elements at a time, as
+ * ntru_poly_recover_msg_rep_ssse3 in ntru_crypto_ntru_msg_rep_simd.c.  The
+ * narrowing to octets works within 128-bit lanes, so its result is put
+ * back in order with a permute.  As there, cm' may be written over the
+ * start of F * e.  The remainder is done one element at a time.
+ */
+
+bool
+ntru_poly_recover_msg_rep_avx2(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint16_t const *Fe,             /*  in - pointer to F * e */
+    uint16_t        min_wt,         /*  in - minimum weight of cm' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels,        /* in/out - pointer to e, then cR */
+    uint8_t        *trits)          /* out - address for cm' */
+{
+  __m256i const zero = _mm256_setzero_si256();
+  __m256i const qmask = _mm256_set1_epi16((short) (q - 1));
+  __m256i const half_q_m1 = _mm256_set1_epi16((short) ((q >> 1) - 1));
+  __m256i const q_mod_p = _mm256_set1_epi16((short) (q % 3));
+  __m256i acc1 = zero;
+  __m256i acc12 = zero;
+  __m256i m;
+  __m128i s1, s12;
+  uint32_t mod_q_mask = q - 1;
+  uint32_t half_q = q >> 1;
+  uint32_t wt1, wt12;
+  uint32_t t;
+  uint16_t i;
+
+  for (i = 0; i + 32 <= num_els; i += 32)
+  {
+    m = _mm256_packus_epi16(
+            ntru_recover_msg_rep16_avx2(Fe + i, ringels + i, qmask,
+                                        half_q_m1, q_mod_p),
+            ntru_recover_msg_rep16_avx2(Fe + i + 16, ringels + i + 16, qmask,
+                                        half_q_m1, q_mod_p));
+    m = _mm256_permute4x64_epi64(m, 0xd8);
+    _mm256_storeu_si256((__m256i *) (trits + i), m);
+
+    acc1 = _mm256_add_epi64(acc1, _mm256_sad_epu8(
+                                      _mm256_and_si256(m,
+                                          _mm256_set1_epi8(1)), zero));
+    acc12 = _mm256_add_epi64(acc12, _mm256_sad_epu8(m, zero));
+  }
+
+  s1 = _mm_add_epi64(_mm256_castsi256_si128(acc1),
+                     _mm256_extracti128_si256(acc1, 1));
+  s12 = _mm_add_epi64(_mm256_castsi256_si128(acc12),
+                      _mm256_extracti128_si256(acc12, 1));
+  wt1 = (uint32_t) (_mm_cvtsi128_si32(s1) +
+                    _mm_cvtsi128_si32(_mm_srli_si128(s1, 8)));
+  wt12 = (uint32_t) (_mm_cvtsi128_si32(s12) +
+                     _mm_cvtsi128_si32(_mm_srli_si128(s12, 8)));
+
+  for (; i < num_els; i++)
+  {
+    t = (ringels[i] + 3 * (uint32_t) Fe[i]) & mod_q_mask;
+    t -= (q % 3) & (0 - ((half_q - 1 - t) >> 31));
+    t -= 3 * ((t * 43691) >> 17);
+
+    wt1 += t & 1;
+    wt12 += t;
+
+    trits[i] = (uint8_t) t;
+    ringels[i] = (uint16_t) ((ringels[i] + (t >> 1) - (t & 1)) & mod_q_mask);
+  }
+
+  return ntru_poly_check_weights(num_els, wt1, (wt12 - wt1) >> 1, min_wt);
+}
+
+/* ntru_poly_unmask_msg_rep_avx2
+ *
+ * Forms cMtrin = cm' - mask (mod 3) in place, 32 elements at a time, as
+ * ntru_poly_unmask_msg_rep_ssse3 in ntru_crypto_ntru_msg_rep_simd.c.
+ */
+
+void
+ntru_poly_unmask_msg_rep_avx2(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t        *trits)          /* in/out - pointer to cm', then cMtrin */
+{
+  __m256i d;
+  uint16_t i;
+
+  for (i = 0; i + 32 <= num_els; i += 32)
+  {
+    d = _mm256_sub_epi8(_mm256_loadu_si256((__m256i const *) (trits + i)),
+                        _mm256_loadu_si256((__m256i const *) (mask + i)));
+    d = _mm256_add_epi8(d, _mm256_and_si256(
+                               _mm256_cmpgt_epi8(_mm256_setzero_si256(), d),
+                               _mm256_set1_epi8(3)));
+    _mm256_storeu_si256((__m256i *) (trits + i), d);
+  }
+
+  ntru_poly_unmask_msg_rep_ssse3(num_els - i, mask + i, trits + i);
+}
@@ -0,0 +1,207 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_poly.h"
+#include <immintrin.h>
+
+/* ntru_poly_add_msg_rep_ssse3
+ *
+ * Forms m' = mask + Mtrin (mod 3), counts its weights and adds it to R,
+ * 16 elements at a time; see ntru_poly_add_msg_rep.
+ *
+ * The trits are added and reduced as octets.  The +1 and -1 weights are
+ * summed with SAD against zero, m' & 1 giving the +1 count and m' the +1
+ * count plus twice the -1 count.  m' is then widened to 16 bits and
+ * (m' & 1) - (m' >> 1) is added to R.  The remainder is done one element
+ * at a time, adding to the same weight counts.
+ */
+
+bool
+ntru_poly_add_msg_rep_ssse3(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t const  *trits,          /*  in - pointer to message trits Mtrin */
+    uint16_t        min_wt,         /*  in - minimum weight of m' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels)        /* in/out - pointer to ring element R */
+{
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const one8 = _mm_set1_epi8(1);
+  __m128i const one16 = _mm_set1_epi16(1);
+  __m128i const qmask = _mm_set1_epi16((short) (q - 1));
+  __m128i acc1 = zero;
+  __m128i acc12 = zero;
+  __m128i m, w, r;
+  uint32_t mod_q_mask = q - 1;
+  uint32_t wt1, wt12;
+  uint32_t t;
+  uint16_t i;
+
+  for (i = 0; i + 16 <= num_els; i += 16)
+  {
+    m = _mm_add_epi8(_mm_loadu_si128((__m128i const *) (mask + i)),
+                     _mm_loadu_si128((__m128i const *) (trits + i)));
+    m = _mm_sub_epi8(m, _mm_and_si128(_mm_cmpgt_epi8(m, _mm_set1_epi8(2)),
+                                      _mm_set1_epi8(3)));
+
+    acc1 = _mm_add_epi64(acc1, _mm_sad_epu8(_mm_and_si128(m, one8), zero));
+    acc12 = _mm_add_epi64(acc12, _mm_sad_epu8(m, zero));
+
+    w = _mm_unpacklo_epi8(m, zero);
+    r = _mm_loadu_si128((__m128i const *) (ringels + i));
+    r = _mm_add_epi16(r, _mm_sub_epi16(_mm_and_si128(w, one16),
+                                       _mm_srli_epi16(w, 1)));
+    _mm_storeu_si128((__m128i *) (ringels + i), _mm_and_si128(r, qmask));
+
+    w = _mm_unpackhi_epi8(m, zero);
+    r = _mm_loadu_si128((__m128i const *) (ringels + i + 8));
+    r = _mm_add_epi16(r, _mm_sub_epi16(_mm_and_si128(w, one16),
+                                       _mm_srli_epi16(w, 1)));
+    _mm_storeu_si128((__m128i *) (ringels + i + 8), _mm_and_si128(r, qmask));
+  }
+
+  wt1 = (uint32_t) (_mm_cvtsi128_si32(acc1) +
+                    _mm_cvtsi128_si32(_mm_srli_si128(acc1, 8)));
+  wt12 = (uint32_t) (_mm_cvtsi128_si32(acc12) +
+                     _mm_cvtsi128_si32(_mm_srli_si128(acc12, 8)));
+
+  for (; i < num_els; i++)
+  {
+    t = (uint32_t) mask[i] + trits[i];
+    t -= 3 & (0 - ((t + 1) >> 2));
+
+    wt1 += t & 1;
+    wt12 += t;
+
+    ringels[i] = (uint16_t) ((ringels[i] + (t & 1) - (t >> 1)) & mod_q_mask);
+  }
+
+  return ntru_poly_check_weights(num_els, wt1, (wt12 - wt1) >> 1, min_wt);
+}
+
+/* ntru_recover_msg_rep8_ssse3
+ *
+ * Recovers 8 elements of cm' as 16-bit lanes, and replaces the 8 elements
+ * of e with cR; see ntru_poly_recover_msg_rep.
+ *
+ * The lift subtracts q mod 3 where a compare sets the lane, and t mod 3 is
+ * t - 3 * (t / 3) with t / 3 = (t * 43691) >> 17, taking the high half of
+ * the product.
+ */
+
+static __m128i
+ntru_recover_msg_rep8_ssse3(
+    uint16_t const *Fe,
+    uint16_t       *ringels,
+    __m128i         qmask,
+    __m128i         half_q_m1,
+    __m128i         q_mod_p)
+{
+  __m128i e, f, t, m;
+
+  e = _mm_loadu_si128((__m128i const *) ringels);
+  f = _mm_loadu_si128((__m128i const *) Fe);
+
+  t = _mm_and_si128(_mm_add_epi16(e, _mm_add_epi16(f, _mm_add_epi16(f, f))),
+                    qmask);
+  t = _mm_sub_epi16(t, _mm_and_si128(_mm_cmpgt_epi16(t, half_q_m1), q_mod_p));
+  m = _mm_srli_epi16(_mm_mulhi_epu16(t, _mm_set1_epi16((short) 43691)), 1);
+  m = _mm_sub_epi16(t, _mm_mullo_epi16(m, _mm_set1_epi16(3)));
+
+  e = _mm_add_epi16(e, _mm_sub_epi16(_mm_srli_epi16(m, 1),
+                                     _mm_and_si128(m, _mm_set1_epi16(1))));
+  _mm_storeu_si128((__m128i *) ringels, _mm_and_si128(e, qmask));
+
+  return m;
+}
+
+/* ntru_poly_recover_msg_rep_ssse3
+ *
+ * Recovers cm', counts its weights and forms cR, 16 elements at a time;
+ * see ntru_poly_recover_msg_rep.  cm' is narrowed to octets to be stored
+ * and its weights summed as in ntru_poly_add_msg_rep_ssse3.  All of F * e
+ * for a step is loaded before cm' is stored, so cm' may be written over
+ * the start of F * e.  The remainder is done one element at a time.
+ */
+
+bool
+ntru_poly_recover_msg_rep_ssse3(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint16_t const *Fe,             /*  in - pointer to F * e */
+    uint16_t        min_wt,         /*  in - minimum weight of cm' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels,        /* in/out - pointer to e, then cR */
+    uint8_t        *trits)          /* out - address for cm' */
+{
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const qmask = _mm_set1_epi16((short) (q - 1));
+  __m128i const half_q_m1 = _mm_set1_epi16((short) ((q >> 1) - 1));
+  __m128i const q_mod_p = _mm_set1_epi16((short) (q % 3));
+  __m128i acc1 = zero;
+  __m128i acc12 = zero;
+  __m128i m;
+  uint32_t mod_q_mask = q - 1;
+  uint32_t half_q = q >> 1;
+  uint32_t wt1, wt12;
+  uint32_t t;
+  uint16_t i;
+
+  for (i = 0; i + 16 <= num_els; i += 16)
+  {
+    m = _mm_packus_epi16(
+            ntru_recover_msg_rep8_ssse3(Fe + i, ringels + i, qmask,
+                                        half_q_m1, q_mod_p),
+            ntru_recover_msg_rep8_ssse3(Fe + i + 8, ringels + i + 8, qmask,
+                                        half_q_m1, q_mod_p));
+    _mm_storeu_si128((__m128i *) (trits + i), m);
+
+    acc1 = _mm_add_epi64(acc1, _mm_sad_epu8(_mm_and_si128(m,
+                                                _mm_set1_epi8(1)), zero));
+    acc12 = _mm_add_epi64(acc12, _mm_sad_epu8(m, zero));
+  }
+
+  wt1 = (uint32_t) (_mm_cvtsi128_si32(acc1) +
+                    _mm_cvtsi128_si32(_mm_srli_si128(acc1, 8)));
+  wt12 = (uint32_t) (_mm_cvtsi128_si32(acc12) +
+                     _mm_cvtsi128_si32(_mm_srli_si128(acc12, 8)));
+
+  for (; i < num_els; i++)
+  {
+    t = (ringels[i] + 3 * (uint32_t) Fe[i]) & mod_q_mask;
+    t -= (q % 3) & (0 - ((half_q - 1 - t) >> 31));
+    t -= 3 * ((t * 43691) >> 17);
+
+    wt1 += t & 1;
+    wt12 += t;
+
+    trits[i] = (uint8_t) t;
+    ringels[i] = (uint16_t) ((ringels[i] + (t >> 1) - (t & 1)) & mod_q_mask);
+  }
+
+  return ntru_poly_check_weights(num_els, wt1, (wt12 - wt1) >> 1, min_wt);
+}
+
+/* ntru_poly_unmask_msg_rep_ssse3
+ *
+ * Forms cMtrin = cm' - mask (mod 3) in place, 16 elements at a time,
+ * adding 3 to the octets a compare finds negative.
+ */
+
+void
+ntru_poly_unmask_msg_rep_ssse3(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t        *trits)          /* in/out - pointer to cm', then cMtrin */
+{
+  __m128i d;
+  uint16_t i;
+
+  for (i = 0; i + 16 <= num_els; i += 16)
+  {
+    d = _mm_sub_epi8(_mm_loadu_si128((__m128i const *) (trits + i)),
+                     _mm_loadu_si128((__m128i const *) (mask + i)));
+    d = _mm_add_epi8(d, _mm_and_si128(_mm_cmpgt_epi8(_mm_setzero_si128(), d),
+                                      _mm_set1_epi8(3)));
+    _mm_storeu_si128((__m128i *) (trits + i), d);
+  }
+
+  ntru_poly_unmask_msg_rep_scalar(num_els - i, mask + i, trits + i);
+}
@@ -0,0 +1,244 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_ntru_mult.c is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_ntru_mult.c
+ *
+ * Contents: Run-time selection of the ring multiplication implementation.
+ *
+ * The scalar implementation is always built.  When the library is built
+ * for x86 with NTRU_HAVE_X86_SIMD, the SSSE3 and AVX2 implementations are
+ * built as well, and the best one the CPU supports is selected when the
+ * library is loaded.
+ *
+ *****************************************************************************/
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_poly.h"
+#include "ntru_crypto_cpu.h"
+
+
+/* implementation table, indexed by NTRU_RING_MULT_IMPL_ID */
+
+static NTRU_RING_MULT_IMPL const ntru_ring_mult_impls[] = {
+    {
+        "scalar",
+        ntru_ring_mult_indices_scalar,
+        ntru_ring_mult_indices_memreq_scalar,
+        ntru_ring_mult_product_indices_scalar,
+        ntru_ring_mult_coefficients_karat,
+        ntru_ring_mult_coefficients_memreq_karat,
+    },
+#if defined(NTRU_HAVE_X86_SIMD)
+    {
+        "ssse3",
+        ntru_ring_mult_indices_ssse3,
+        ntru_ring_mult_indices_memreq_ssse3,
+        ntru_ring_mult_product_indices_ssse3,
+        ntru_ring_mult_coefficients_ssse3,
+        ntru_ring_mult_coefficients_memreq_ssse3,
+    },
+    {
+        "avx2",
+        ntru_ring_mult_indices_avx2,
+        ntru_ring_mult_indices_memreq_avx2,
+        ntru_ring_mult_product_indices_avx2,
+        ntru_ring_mult_coefficients_avx2,
+        ntru_ring_mult_coefficients_memreq_avx2,
+    },
+#endif
+};
+
+#define NTRU_RING_MULT_NUM_BUILT                                              \
+    (sizeof(ntru_ring_mult_impls) / sizeof(ntru_ring_mult_impls[0]))
+
+
+/* NTRU_CPU_ flags required by each implementation, indexed by
+ * NTRU_RING_MULT_IMPL_ID
+ */
+
+static uint32_t const ntru_ring_mult_required[] = {
+    0,
+#if defined(NTRU_HAVE_X86_SIMD)
+    NTRU_CPU_SSSE3,
+    NTRU_CPU_AVX2,
+#endif
+};
+
+
+/* the implementation used for multiplication, set by ntru_ring_mult_select */
+
+static NTRU_RING_MULT_IMPL const *ntru_ring_mult_impl = ntru_ring_mult_impls;
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* ntru_ring_mult_select
+ *
+ * Picks the fastest multiplication that the CPU supports.
+ */
+
+static void ntru_ring_mult_select(void) __attribute__((constructor));
+
+static void
+ntru_ring_mult_select(void)
+{
+    ntru_ring_mult_impl = ntru_ring_mult_impls +
+        ntru_crypto_cpu_best_impl(ntru_ring_mult_required,
+                                  NTRU_RING_MULT_NUM_BUILT);
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_ring_mult_get_impl
+ *
+ * Returns the ring multiplication implementation with the given ID, or
+ * NULL if it is not built into the library or not supported by the CPU.
+ * Passing NTRU_RING_MULT_NUM_IMPLS returns the selected implementation.
+ */
+
+NTRU_RING_MULT_IMPL const *
+ntru_ring_mult_get_impl(
+    NTRU_RING_MULT_IMPL_ID id)      /*  in - implementation ID */
+{
+    if (id == NTRU_RING_MULT_NUM_IMPLS)
+    {
+        return ntru_ring_mult_impl;
+    }
+
+    if (((uint32_t)id >= NTRU_RING_MULT_NUM_BUILT) ||
+        !ntru_crypto_cpu_supports(ntru_ring_mult_required[id]))
+    {
+        return NULL;
+    }
+
+    return ntru_ring_mult_impls + id;
+}
+
+
+/* ntru_ring_mult_indices
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+void
+ntru_ring_mult_indices(
+    uint16_t const *a,          /*  in - pointer to ring element a */
+    uint16_t const  bi_P1_len,  /*  in - no. of +1 coefficients in b */
+    uint16_t const  bi_M1_len,  /*  in - no. of -1 coefficients in b */
+    uint16_t const *bi,         /*  in - pointer to the list of nonzero
+                                         indices of ring element b,
+                                         containing indices for the +1
+                                         coefficients followed by the
+                                         indices for -1 coefficients */
+    uint16_t const  N,          /*  in - no. of coefficients in a, b, c */
+    uint16_t const  q,          /*  in - large modulus */
+    uint16_t       *t,          /*  in - temp buffer. Size is impl dependent.
+                                         see ntru_ring_mult_indices_memreq */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+    ntru_ring_mult_impl->mult_indices(a, bi_P1_len, bi_M1_len, bi, N, q, t, c);
+}
+
+
+/* ntru_ring_mult_indices_memreq
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+void
+ntru_ring_mult_indices_memreq(
+    uint16_t  N,
+    uint16_t *num_scratch_polys,
+    uint16_t *pad_deg)
+{
+    ntru_ring_mult_impl->mult_indices_memreq(N, num_scratch_polys, pad_deg);
+}
+
+
+/* ntru_ring_mult_product_indices
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+void
+ntru_ring_mult_product_indices(
+    uint16_t const *a,          /*  in - pointer to ring element a */
+    uint16_t const  b1i_len,    /*  in - no. of +1 or -1 coefficients in b1 */
+    uint16_t const  b2i_len,    /*  in - no. of +1 or -1 coefficients in b2 */
+    uint16_t const  b3i_len,    /*  in - no. of +1 or -1 coefficients in b3 */
+    uint16_t const *bi,         /*  in - pointer to the list of nonzero
+                                         indices of polynomials b1, b2, b3,
+                                         containing indices for the +1
+                                         coefficients followed by the
+                                         indices for -1 coefficients for
+                                         each polynomial */
+    uint16_t const  N,          /*  in - no. of coefficients in a, b, c */
+    uint16_t const  q,          /*  in - large modulus */
+    uint16_t       *t,          /*  in - temp buffer of one more poly than
+                                         ntru_ring_mult_indices_memreq
+                                         gives */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+    ntru_ring_mult_impl->mult_product_indices(a, b1i_len, b2i_len, b3i_len,
+                                              bi, N, q, t, c);
+}
+
+
+/* ntru_ring_mult_coefficients
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+void
+ntru_ring_mult_coefficients(
+    uint16_t const *a,          /*  in - pointer to polynomial a */
+    uint16_t const *b,          /*  in - pointer to polynomial b */
+    uint16_t        N,          /*  in - degree of (x^N - 1) */
+    uint16_t        q,          /*  in - large modulus */
+    uint16_t       *tmp,        /*  in - temp buffer. Size is impl dependent.
+                                       see ntru_ring_mult_coefficients_memreq */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+    ntru_ring_mult_impl->mult_coefficients(a, b, N, q, tmp, c);
+}
+
+
+/* ntru_ring_mult_coefficients_memreq
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_ntru_poly.h.
+ */
+
+void
+ntru_ring_mult_coefficients_memreq(
+    uint16_t  N,
+    uint16_t *num_scratch_polys,
+    uint16_t *pad_deg)
+{
+    ntru_ring_mult_impl->mult_coefficients_memreq(N, num_scratch_polys,
+                                                  pad_deg);
+}
@@ -0,0 +1,528 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_poly.h"
+#include <immintrin.h>
+
+/* Recursion plan for a given N.
+ *
+ * The inputs are padded to L = (toom ? 4 : 1) * 2^levels * base coefficients.
+ * A Toom-Cook-4 step splits them into four parts, each multiplied with
+ * "levels" Karatsuba steps down to a base case of "base" coefficients, which
+ * is a multiple of 16 and done by grade school multiplication.  Toom-Cook-4
+ * loses 3 bits to its interpolation, so for q > 2^13 the same L is split with
+ * two further Karatsuba steps instead.
+ */
+
+typedef struct {
+  uint16_t L;
+  uint16_t toom;
+  uint16_t levels;
+  uint16_t base;
+} AVX2_MULT_PLAN;
+
+#define AVX2_MULT_MAX_BASE    128
+#define AVX2_MULT_MAX_LEVELS  4
+#define AVX2_MULT_TOOM_MAX_Q  (1 << 13)
+
+
+/* Estimated cost, in vector operations, of a product of two polynomials of
+ * n coefficients with the given number of Karatsuba steps. */
+
+static uint32_t
+karatsuba_cost(
+    uint32_t n,
+    uint32_t levels)
+{
+  if(levels == 0)
+  {
+    /* (n/32) blocks of 64 outputs, each n+63 multiply-adds of 4 vectors */
+    return (n * (n + 63) * 3) / 32 + n/4;
+  }
+
+  return 3 * karatsuba_cost(n >> 1, levels - 1) + n;
+}
+
+static void
+avx2_mult_plan(
+    uint16_t        N,
+    AVX2_MULT_PLAN *plan)
+{
+  uint32_t toom;
+  uint32_t levels;
+  uint32_t base;
+  uint32_t L;
+  uint32_t cost;
+  uint32_t best = 0xffffffff;
+
+  plan->L = (N + 15) & 0xfff0;
+  plan->toom = 0;
+  plan->levels = 0;
+  plan->base = plan->L;
+
+  for(toom=0; toom<=1; toom++)
+  {
+    for(levels=0; levels<=AVX2_MULT_MAX_LEVELS; levels++)
+    {
+      /* smallest base of 16m coefficients that covers N */
+      L = (toom ? 4 : 1) << levels;
+      base = ((N + 16*L - 1) / (16*L)) * 16;
+      if(base > AVX2_MULT_MAX_BASE)
+      {
+        continue;
+      }
+      L *= base;
+
+      cost = karatsuba_cost(base << levels, levels);
+      if(toom)
+      {
+        /* evaluation and interpolation */
+        cost = 7 * cost + L/2;
+      }
+
+      if(cost < best)
+      {
+        best = cost;
+        plan->L = (uint16_t)L;
+        plan->toom = (uint16_t)toom;
+        plan->levels = (uint16_t)levels;
+        plan->base = (uint16_t)base;
+      }
+    }
+  }
+}
+
+/* Scratch needed by karatsuba() below */
+
+static uint32_t
+karatsuba_scratch(
+    uint32_t n,
+    uint32_t levels)
+{
+  if(levels == 0)
+  {
+    return 3*n;
+  }
+
+  return 2*n + karatsuba_scratch(n >> 1, levels - 1);
+}
+
+/* Scratch needed by ntru_ring_mult_coefficients_avx2, in coefficients */
+
+static uint32_t
+avx2_mult_scratch(
+    AVX2_MULT_PLAN const *plan)
+{
+  uint32_t karat;
+  uint32_t toom = 0;
+
+  /* product, padded a and b, Karatsuba */
+  karat = 4*plan->L + karatsuba_scratch(plan->L, plan->levels + 2*plan->toom);
+
+  if(plan->toom)
+  {
+    /* product, 14 evaluations, 7 products, Karatsuba */
+    toom = 2*plan->L + 14*(plan->L/4) + 7*(plan->L/2) +
+           karatsuba_scratch(plan->L/4, plan->levels);
+  }
+
+  return (karat > toom) ? karat : toom;
+}
+
+
+/* grade_school_mul
+ *
+ * res[0..2n) = a * b in Z[x] for a, b of n coefficients, n a multiple of 16.
+ *
+ * Each block of 64 (or a final 32) coefficients of res is accumulated in
+ * registers from broadcast coefficients of a times unaligned loads of b.
+ * b is copied into the middle of 3n coefficients of zeroed scratch so that
+ * loads reaching past either end of b read zeros.
+ */
+
+static void
+grade_school_mul(
+    uint16_t        *res,   /* out - a * b in Z[x], must be length 2n */
+    uint16_t const  *a,     /*  in - polynomial */
+    uint16_t const  *b,     /*  in - polynomial */
+    uint16_t const   n,     /*  in - number of coefficients in a and b */
+    uint16_t        *tmp)   /*  in - 3n coefficients of scratch space */
+{
+  uint16_t i;
+  uint16_t lo;
+  uint16_t hi;
+  uint16_t o;
+  uint16_t const *bz;
+
+  __m256i ai;
+  __m256i x0;
+  __m256i x1;
+  __m256i x2;
+  __m256i x3;
+  __m256i const zero = _mm256_setzero_si256();
+
+  for(i=0; i<n; i+=16)
+  {
+    _mm256_storeu_si256((__m256i *) (tmp+i), zero);
+    _mm256_storeu_si256((__m256i *) (tmp+n+i),
+                        _mm256_loadu_si256((__m256i *) (b+i)));
+    _mm256_storeu_si256((__m256i *) (tmp+2*n+i), zero);
+  }
+  bz = tmp+n;
+
+  /* res[o+j] = sum of a[i]*b[o+j-i] */
+
+  for(o=0; o+64<=2*n; o+=64)
+  {
+    lo = (o+1 > n) ? o+1-n : 0;
+    hi = (o+64 < n) ? o+64 : n;
+    x0 = zero;
+    x1 = zero;
+    x2 = zero;
+    x3 = zero;
+    for(i=lo; i<hi; i++)
+    {
+      ai = _mm256_set1_epi16(a[i]);
+      x0 = _mm256_add_epi16(x0, _mm256_mullo_epi16(ai,
+              _mm256_loadu_si256((__m256i *) (bz+o-i))));
+      x1 = _mm256_add_epi16(x1, _mm256_mullo_epi16(ai,
+              _mm256_loadu_si256((__m256i *) (bz+o-i+16))));
+      x2 = _mm256_add_epi16(x2, _mm256_mullo_epi16(ai,
+              _mm256_loadu_si256((__m256i *) (bz+o-i+32))));
+      x3 = _mm256_add_epi16(x3, _mm256_mullo_epi16(ai,
+              _mm256_loadu_si256((__m256i *) (bz+o-i+48))));
+    }
+    _mm256_storeu_si256((__m256i *) (res+o), x0);
+    _mm256_storeu_si256((__m256i *) (res+o+16), x1);
+    _mm256_storeu_si256((__m256i *) (res+o+32), x2);
+    _mm256_storeu_si256((__m256i *) (res+o+48), x3);
+  }
+
+  if(o < 2*n)
+  {
+    lo = (o+1 > n) ? o+1-n : 0;
+    hi = (o+32 < n) ? o+32 : n;
+    x0 = zero;
+    x1 = zero;
+    for(i=lo; i<hi; i++)
+    {
+      ai = _mm256_set1_epi16(a[i]);
+      x0 = _mm256_add_epi16(x0, _mm256_mullo_epi16(ai,
+              _mm256_loadu_si256((__m256i *) (bz+o-i))));
+      x1 = _mm256_add_epi16(x1, _mm256_mullo_epi16(ai,
+              _mm256_loadu_si256((__m256i *) (bz+o-i+16))));
+    }
+    _mm256_storeu_si256((__m256i *) (res+o), x0);
+    _mm256_storeu_si256((__m256i *) (res+o+16), x1);
+  }
+
+  return;
+}
+
+/* karatsuba
+ *
+ * res[0..2n) = a * b in Z[x], using "levels" Karatsuba steps above
+ * grade_school_mul.  n / 2^levels must be a multiple of 16.
+ */
+
+static void
+karatsuba(
+    uint16_t        *res,    /* out - a * b in Z[x], must be length 2n */
+    uint16_t const  *a,      /*  in - polynomial */
+    uint16_t const  *b,      /*  in - polynomial */
+    uint16_t const   n,      /*  in - number of coefficients in a and b */
+    uint16_t const   levels, /*  in - number of Karatsuba steps */
+    uint16_t        *tmp)    /*  in - karatsuba_scratch(n, levels)
+                                      coefficients of scratch space */
+{
+  uint16_t i;
+  uint16_t const p = n>>1;
+
+  uint16_t *sa = tmp;
+  uint16_t *sb = tmp+p;
+  uint16_t *mid = tmp+n;
+
+  __m256i x0;
+  __m256i x1;
+
+  if(levels == 0)
+  {
+    grade_school_mul(res, a, b, n, tmp);
+    return;
+  }
+
+  /* low and high halves */
+
+  karatsuba(res, a, b, p, levels-1, tmp);
+  karatsuba(res+n, a+p, b+p, p, levels-1, tmp);
+
+  /* (a0 + a1) * (b0 + b1) - a0*b0 - a1*b1 */
+
+  for(i=0; i<p; i+=16)
+  {
+    x0 = _mm256_add_epi16(_mm256_loadu_si256((__m256i *) (a+i)),
+                          _mm256_loadu_si256((__m256i *) (a+p+i)));
+    x1 = _mm256_add_epi16(_mm256_loadu_si256((__m256i *) (b+i)),
+                          _mm256_loadu_si256((__m256i *) (b+p+i)));
+    _mm256_storeu_si256((__m256i *) (sa+i), x0);
+    _mm256_storeu_si256((__m256i *) (sb+i), x1);
+  }
+
+  karatsuba(mid, sa, sb, p, levels-1, tmp+2*n);
+
+  for(i=0; i<n; i+=16)
+  {
+    x0 = _mm256_loadu_si256((__m256i *) (mid+i));
+    x0 = _mm256_sub_epi16(x0, _mm256_loadu_si256((__m256i *) (res+i)));
+    x0 = _mm256_sub_epi16(x0, _mm256_loadu_si256((__m256i *) (res+n+i)));
+    _mm256_storeu_si256((__m256i *) (mid+i), x0);
+  }
+
+  /* res[p..3p) overlaps the halves read above, so add it in afterwards */
+
+  for(i=0; i<n; i+=16)
+  {
+    x0 = _mm256_loadu_si256((__m256i *) (mid+i));
+    x1 = _mm256_loadu_si256((__m256i *) (res+p+i));
+    _mm256_storeu_si256((__m256i *) (res+p+i), _mm256_add_epi16(x0, x1));
+  }
+
+  return;
+}
+
+/* toom_cook_4
+ *
+ * res[0..8m) = a * b in Z[x] mod 2^13 for a, b of 4m coefficients.
+ *
+ * a and b are split into four parts of m coefficients and evaluated at
+ * 0, 1, -1, 2, -2, 1/2, -1/2 (the last two scaled by 8) and infinity.
+ * The seven products are found with karatsuba and interpolated with
+ * shifts and multiplication by the inverses of 3, 9 and 15 mod 2^16.
+ */
+
+static void
+toom_cook_4(
+    uint16_t        *res,    /* out - a * b in Z[x], must be length 8m */
+    uint16_t const  *a,      /*  in - polynomial */
+    uint16_t const  *b,      /*  in - polynomial */
+    uint16_t const   m,      /*  in - a quarter of the length of a and b */
+    uint16_t const   levels, /*  in - Karatsuba steps for each product */
+    uint16_t        *tmp)    /*  in - 28m + karatsuba_scratch(m, levels)
+                                      coefficients of scratch space */
+{
+  uint16_t i;
+  uint16_t j;
+  uint16_t const *src;
+  uint16_t *dst;
+  uint16_t *ev = tmp;
+  uint16_t *w = tmp + 14*m;
+
+  __m256i r0;
+  __m256i r1;
+  __m256i r2;
+  __m256i r3;
+  __m256i r4;
+  __m256i r5;
+  __m256i r6;
+  __m256i r7;
+
+  /* evaluations of a in ev[0..7m), of b in ev[7m..14m) */
+
+  for(j=0; j<2; j++)
+  {
+    src = j ? b : a;
+    dst = ev + 7*m*j;
+    for(i=0; i<m; i+=16)
+    {
+      r0 = _mm256_loadu_si256((__m256i *) (src+i));
+      r1 = _mm256_loadu_si256((__m256i *) (src+m+i));
+      r2 = _mm256_loadu_si256((__m256i *) (src+2*m+i));
+      r3 = _mm256_loadu_si256((__m256i *) (src+3*m+i));
+
+      /* infinity, 0 */
+      _mm256_storeu_si256((__m256i *) (dst+i), r3);
+      _mm256_storeu_si256((__m256i *) (dst+6*m+i), r0);
+
+      /* 1, -1 */
+      r4 = _mm256_add_epi16(r0, r2);
+      r5 = _mm256_add_epi16(r1, r3);
+      _mm256_storeu_si256((__m256i *) (dst+2*m+i), _mm256_add_epi16(r4, r5));
+      _mm256_storeu_si256((__m256i *) (dst+3*m+i), _mm256_sub_epi16(r4, r5));
+
+      /* 8 * (1/2), 8 * (-1/2) */
+      r4 = _mm256_slli_epi16(_mm256_add_epi16(_mm256_slli_epi16(r0, 2), r2), 1);
+      r5 = _mm256_add_epi16(_mm256_slli_epi16(r1, 2), r3);
+      _mm256_storeu_si256((__m256i *) (dst+4*m+i), _mm256_add_epi16(r4, r5));
+      _mm256_storeu_si256((__m256i *) (dst+5*m+i), _mm256_sub_epi16(r4, r5));
+
+      /* 2 */
+      r4 = _mm256_add_epi16(_mm256_slli_epi16(r3, 3),
+                            _mm256_slli_epi16(r2, 2));
+      r4 = _mm256_add_epi16(r4, _mm256_slli_epi16(r1, 1));
+      _mm256_storeu_si256((__m256i *) (dst+m+i), _mm256_add_epi16(r4, r0));
+    }
+  }
+
+  for(j=0; j<7; j++)
+  {
+    karatsuba(w + 2*m*j, ev + m*j, ev + 7*m + m*j, m, levels, tmp + 28*m);
+  }
+
+  /* interpolation */
+
+  memset(res, 0, 8*m*sizeof(uint16_t));
+  for(i=0; i<2*m; i+=16)
+  {
+    r0 = _mm256_loadu_si256((__m256i *) (w+i));
+    r1 = _mm256_loadu_si256((__m256i *) (w+2*m+i));
+    r2 = _mm256_loadu_si256((__m256i *) (w+4*m+i));
+    r3 = _mm256_loadu_si256((__m256i *) (w+6*m+i));
+    r4 = _mm256_loadu_si256((__m256i *) (w+8*m+i));
+    r5 = _mm256_loadu_si256((__m256i *) (w+10*m+i));
+    r6 = _mm256_loadu_si256((__m256i *) (w+12*m+i));
+
+    r1 = _mm256_add_epi16(r1, r4);
+    r5 = _mm256_sub_epi16(r5, r4);
+    r3 = _mm256_srli_epi16(_mm256_sub_epi16(r3, r2), 1);
+    r4 = _mm256_sub_epi16(r4, r0);
+    r4 = _mm256_sub_epi16(r4, _mm256_slli_epi16(r6, 6));
+    r4 = _mm256_add_epi16(_mm256_slli_epi16(r4, 1), r5);
+    r2 = _mm256_add_epi16(r2, r3);
+    r1 = _mm256_sub_epi16(r1, _mm256_slli_epi16(r2, 6));
+    r1 = _mm256_sub_epi16(r1, r2);
+    r2 = _mm256_sub_epi16(r2, r6);
+    r2 = _mm256_sub_epi16(r2, r0);
+    r1 = _mm256_add_epi16(r1, _mm256_mullo_epi16(r2, _mm256_set1_epi16(45)));
+    r7 = _mm256_sub_epi16(r4, _mm256_slli_epi16(r2, 3));
+    r4 = _mm256_srli_epi16(
+            _mm256_mullo_epi16(r7, _mm256_set1_epi16((short)43691)), 3);
+    r5 = _mm256_add_epi16(r5, r1);
+    r7 = _mm256_add_epi16(r1, _mm256_slli_epi16(r3, 4));
+    r1 = _mm256_srli_epi16(
+            _mm256_mullo_epi16(r7, _mm256_set1_epi16((short)36409)), 1);
+    r3 = _mm256_sub_epi16(_mm256_setzero_si256(), _mm256_add_epi16(r3, r1));
+    r7 = _mm256_sub_epi16(_mm256_mullo_epi16(r1, _mm256_set1_epi16(30)), r5);
+    r5 = _mm256_srli_epi16(
+            _mm256_mullo_epi16(r7, _mm256_set1_epi16((short)61167)), 2);
+    r2 = _mm256_sub_epi16(r2, r4);
+    r1 = _mm256_sub_epi16(r1, r5);
+
+    dst = res+i;
+    r7 = _mm256_add_epi16(r6, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+    dst += m;
+    r7 = _mm256_add_epi16(r5, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+    dst += m;
+    r7 = _mm256_add_epi16(r4, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+    dst += m;
+    r7 = _mm256_add_epi16(r3, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+    dst += m;
+    r7 = _mm256_add_epi16(r2, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+    dst += m;
+    r7 = _mm256_add_epi16(r1, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+    dst += m;
+    r7 = _mm256_add_epi16(r0, _mm256_loadu_si256((__m256i *) dst));
+    _mm256_storeu_si256((__m256i *) dst, r7);
+  }
+
+  return;
+}
+
+
+void
+ntru_ring_mult_coefficients_memreq_avx2(
+    uint16_t N,
+    uint16_t *tmp_polys,
+    uint16_t *poly_coeffs)
+{
+  AVX2_MULT_PLAN plan;
+
+  avx2_mult_plan(N, &plan);
+
+  if(tmp_polys)
+  {
+    *tmp_polys = (uint16_t)((avx2_mult_scratch(&plan) + plan.L - 1) / plan.L);
+  }
+
+  if(poly_coeffs)
+  {
+    *poly_coeffs = plan.L;
+  }
+}
+
+/* ntru_ring_mult_coefficients_avx2
+ *
+ * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
+ * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
+ * This is a convolution operation.
+ *
+ * This assumes q is 2^r where 8 < r < 16, so that overflow of the sum
+ * beyond 16 bits does not matter.  q = 0 is taken as 2^16.
+ *
+ * This version uses 256-bit AVX2 vectors.  The product in Z[x] is found by
+ * Toom-Cook-4 (for q <= 2^13) and Karatsuba steps over a grade school base
+ * case, following the plan chosen for N by avx2_mult_plan.  Only the first
+ * N coefficients of "a" and "b" are read.
+ */
+
+void
+ntru_ring_mult_coefficients_avx2(
+    uint16_t const *a,          /*  in - pointer to polynomial a */
+    uint16_t const *b,          /*  in - pointer to polynomial b */
+    uint16_t        N,          /*  in - degree of (x^N - 1) */
+    uint16_t        q,          /*  in - large modulus */
+    uint16_t       *tmp,        /*  in - temp buffer, see
+                                   ntru_ring_mult_coefficients_memreq_avx2 */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+  uint16_t i;
+  uint16_t const q_mask = q-1;
+  uint16_t *ap;
+  uint16_t *bp;
+
+  AVX2_MULT_PLAN plan;
+
+  avx2_mult_plan(N, &plan);
+
+  /* The product goes at the start of tmp, so that c may be tmp.
+   * Zero-padded copies of a and b follow it; a Toom-Cook step
+   * only needs them until its evaluations are done. */
+
+  if(plan.toom && q_mask < AVX2_MULT_TOOM_MAX_Q)
+  {
+    ap = tmp + 2*plan.L + 14*(plan.L/4);
+  }
+  else
+  {
+    ap = tmp + 2*plan.L;
+  }
+  bp = ap + plan.L;
+
+  memcpy(ap, a, N*sizeof(uint16_t));
+  memset(ap+N, 0, (plan.L-N)*sizeof(uint16_t));
+  memcpy(bp, b, N*sizeof(uint16_t));
+  memset(bp+N, 0, (plan.L-N)*sizeof(uint16_t));
+
+  if(plan.toom && q_mask < AVX2_MULT_TOOM_MAX_Q)
+  {
+    toom_cook_4(tmp, ap, bp, plan.L/4, plan.levels, tmp + 2*plan.L);
+  }
+  else
+  {
+    karatsuba(tmp, ap, bp, plan.L, plan.levels + 2*plan.toom, bp + plan.L);
+  }
+
+  for(i=0; i<N; i++)
+  {
+    c[i] = (tmp[i] + tmp[i+N]) & q_mask;
+  }
+  for(; i<plan.L; i++)
+  {
+    c[i] = 0;
+  }
+
+  return;
+}
@@ -100,7 +100,7 @@ karatsuba(
 
 
 void
-ntru_ring_mult_coefficients_memreq(
+ntru_ring_mult_coefficients_memreq_karat(
     uint16_t N,
     uint16_t *tmp_polys,
     uint16_t *poly_coeffs)
@@ -116,7 +116,7 @@ ntru_ring_mult_coefficients_memreq(
     }
 }
 
-/* ntru_ring_mult_coefficients
+/* ntru_ring_mult_coefficients_karat
  *
  * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
  * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
@@ -127,7 +127,7 @@ ntru_ring_mult_coefficients_memreq(
  */
 
 void
-ntru_ring_mult_coefficients(
+ntru_ring_mult_coefficients_karat(
     uint16_t const *a,          /*  in - pointer to polynomial a */
     uint16_t const *b,          /*  in - pointer to polynomial b */
     uint16_t        N,          /*  in - degree of (x^N - 1) */
@@ -88,7 +88,7 @@ grade_school_mul(
 /* To multiply polynomials mod x^N - 1 this mult_coefficients implementation
  * needs scratch space of size num_polys * num_coeffs * sizeof(uint16_t) */
 void
-ntru_ring_mult_coefficients_memreq(
+ntru_ring_mult_coefficients_memreq_ssse3(
     uint16_t N,
     uint16_t *num_polys,
     uint16_t *num_coeffs)
@@ -104,7 +104,7 @@ ntru_ring_mult_coefficients_memreq(
     }
 }
 
-/* ntru_ring_mult_coefficients
+/* ntru_ring_mult_coefficients_ssse3
  *
  * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
  * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
@@ -117,7 +117,7 @@ ntru_ring_mult_coefficients_memreq(
  */
 
 void
-ntru_ring_mult_coefficients(
+ntru_ring_mult_coefficients_ssse3(
     uint16_t const *a,          /*  in - pointer to polynomial a */
     uint16_t const *b,          /*  in - pointer to polynomial b */
     uint16_t        N,          /*  in - degree of (x^N - 1) */
@@ -3,7 +3,7 @@
 
 
 void
-ntru_ring_mult_indices_memreq(
+ntru_ring_mult_indices_memreq_scalar(
     uint16_t N,
     uint16_t *tmp_polys,
     uint16_t *poly_coeffs)
@@ -19,7 +19,7 @@ ntru_ring_mult_indices_memreq(
     }
 }
 
-/* ntru_ring_mult_indices
+/* ntru_ring_mult_indices_scalar
  *
  * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
  * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
@@ -39,7 +39,7 @@ ntru_ring_mult_indices_memreq(
  */
 
 void
-ntru_ring_mult_indices(
+ntru_ring_mult_indices_scalar(
     uint16_t const *a,          /*  in - pointer to ring element a */
     uint16_t const  bi_P1_len,  /*  in - no. of +1 coefficients in b */
     uint16_t const  bi_M1_len,  /*  in - no. of -1 coefficients in b */
@@ -0,0 +1,352 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_ntru_poly.h"
+#include <immintrin.h>
+
+#define PAD(N) ((N + 0x0007) & 0xfff8)
+
+/* ntru_ring_extend_avx2
+ *
+ * Sets t[i] = a[i mod N] for i in [0, N+PAD(N)).  "a" may be "t".
+ */
+static void
+ntru_ring_extend_avx2(
+    uint16_t       *t,
+    uint16_t const *a,
+    uint16_t        N)
+{
+  if(a != t)
+  {
+    memcpy(t, a, N*sizeof(uint16_t));
+  }
+  if(PAD(N) <= N)
+  {
+    memcpy(t+N, t, PAD(N)*sizeof(uint16_t));
+  }
+  else
+  {
+    memcpy(t+N, t, N*sizeof(uint16_t));
+    memcpy(t+2*N, t, (PAD(N)-N)*sizeof(uint16_t));
+  }
+}
+
+/* ntru_sum_indices32_avx2
+ *
+ * Adds to x[0] and x[1] the 32 coefficients at Tp - k for the first P1_len
+ * indices k in bi, and subtracts those for the following M1_len indices.
+ */
+static void
+ntru_sum_indices32_avx2(
+    __m256i        *x,
+    uint16_t const *Tp,
+    uint16_t const *bi,
+    uint16_t        P1_len,
+    uint16_t        M1_len)
+{
+  uint16_t i;
+  __m256i x0 = x[0];
+  __m256i x1 = x[1];
+
+  for(i=0; i<P1_len; i++)
+  {
+    x0 = _mm256_add_epi16(x0, _mm256_loadu_si256((__m256i *) (Tp-bi[i])));
+    x1 = _mm256_add_epi16(x1, _mm256_loadu_si256((__m256i *) (Tp-bi[i]+16)));
+  }
+  for(; i<P1_len+M1_len; i++)
+  {
+    x0 = _mm256_sub_epi16(x0, _mm256_loadu_si256((__m256i *) (Tp-bi[i])));
+    x1 = _mm256_sub_epi16(x1, _mm256_loadu_si256((__m256i *) (Tp-bi[i]+16)));
+  }
+
+  x[0] = x0;
+  x[1] = x1;
+}
+
+/* ntru_sum_indices16_avx2
+ *
+ * Returns x plus the 16 coefficients at Tp - k for the first P1_len indices
+ * k in bi, less those for the following M1_len indices.
+ */
+static __m256i
+ntru_sum_indices16_avx2(
+    __m256i         x,
+    uint16_t const *Tp,
+    uint16_t const *bi,
+    uint16_t        P1_len,
+    uint16_t        M1_len)
+{
+  uint16_t i;
+
+  for(i=0; i<P1_len; i++)
+  {
+    x = _mm256_add_epi16(x, _mm256_loadu_si256((__m256i *) (Tp-bi[i])));
+  }
+  for(; i<P1_len+M1_len; i++)
+  {
+    x = _mm256_sub_epi16(x, _mm256_loadu_si256((__m256i *) (Tp-bi[i])));
+  }
+
+  return x;
+}
+
+/* ntru_sum_indices8_avx2
+ *
+ * Returns x plus the 8 coefficients at Tp - k for the first P1_len indices
+ * k in bi, less those for the following M1_len indices.
+ */
+static __m128i
+ntru_sum_indices8_avx2(
+    __m128i         x,
+    uint16_t const *Tp,
+    uint16_t const *bi,
+    uint16_t        P1_len,
+    uint16_t        M1_len)
+{
+  uint16_t i;
+
+  for(i=0; i<P1_len; i++)
+  {
+    x = _mm_add_epi16(x, _mm_loadu_si128((__m128i *) (Tp-bi[i])));
+  }
+  for(; i<P1_len+M1_len; i++)
+  {
+    x = _mm_sub_epi16(x, _mm_loadu_si128((__m128i *) (Tp-bi[i])));
+  }
+
+  return x;
+}
+
+void
+ntru_ring_mult_indices_memreq_avx2(
+    uint16_t N,
+    uint16_t *tmp_polys,
+    uint16_t *poly_coeffs)
+{
+    if(tmp_polys)
+    {
+        *tmp_polys= 2;
+    }
+
+    if(poly_coeffs)
+    {
+        *poly_coeffs = PAD(N);
+    }
+}
+
+/* ntru_ring_mult_indices_avx2
+ *
+ * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
+ * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
+ * This is a convolution operation.
+ *
+ * Ring element "b" is a sparse trinary polynomial with coefficients -1, 0,
+ * and 1.  It is specified by a list, bi, of its nonzero indices containing
+ * indices for the bi_P1_len +1 coefficients followed by the indices for the
+ * bi_M1_len -1 coefficients.
+ * The indices are in the range [0,N).
+ *
+ * The result array "c" may share the same memory space as input array "a",
+ * input array "b", or temp array "t".
+ *
+ * This assumes q is 2^r where 8 < r < 16, so that overflow of the sum
+ * beyond 16 bits does not matter.
+ *
+ * This version uses 256-bit AVX2 vectors.  The temp buffer holds a copy of
+ * "a" extended cyclically to N + PAD(N) coefficients, so that coefficients
+ * c[j..j+15] are sums of unaligned loads at t + N + j - k for the nonzero
+ * indices k of b, accumulated in registers.  Those loads never reach below
+ * t + j + 1, so each finished block of c is stored back into t over the
+ * part of the copy that is no longer needed.
+ */
+void
+ntru_ring_mult_indices_avx2(
+    uint16_t const *a,          /*  in - pointer to ring element a */
+    uint16_t const  bi_P1_len,  /*  in - no. of +1 coefficients in b */
+    uint16_t const  bi_M1_len,  /*  in - no. of -1 coefficients in b */
+    uint16_t const *bi,         /*  in - pointer to the list of nonzero
+                                         indices of ring element b,
+                                         containing indices for the +1
+                                         coefficients followed by the
+                                         indices for -1 coefficients */
+    uint16_t const  N,          /*  in - no. of coefficients in a, b, c */
+    uint16_t const  q,          /*  in - large modulus */
+    uint16_t       *t,          /*  in - temp buffer of N elements */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+  uint16_t j;
+  uint16_t const mod_q_mask = q-1;
+
+  __m256i mask;
+  __m256i x[2];
+  __m256i x0;
+  __m128i y0;
+
+  /* t[i] = a[i mod N] for i in [0, N+PAD(N)) */
+
+  ntru_ring_extend_avx2(t, a, N);
+
+  /* c[j] = sum of a[j-k mod N] for b[k] = +1, less those for b[k] = -1 */
+
+  mask = _mm256_set1_epi16(mod_q_mask);
+  for(j=0; j+32<=PAD(N); j+=32)
+  {
+    x[0] = x[1] = _mm256_setzero_si256();
+    ntru_sum_indices32_avx2(x, t+N+j, bi, bi_P1_len, bi_M1_len);
+    _mm256_storeu_si256((__m256i *) (t+j), _mm256_and_si256(x[0], mask));
+    _mm256_storeu_si256((__m256i *) (t+j+16), _mm256_and_si256(x[1], mask));
+  }
+
+  if(j+16 <= PAD(N))
+  {
+    x0 = ntru_sum_indices16_avx2(_mm256_setzero_si256(), t+N+j, bi,
+                                 bi_P1_len, bi_M1_len);
+    _mm256_storeu_si256((__m256i *) (t+j), _mm256_and_si256(x0, mask));
+    j += 16;
+  }
+
+  if(j < PAD(N))
+  {
+    y0 = ntru_sum_indices8_avx2(_mm_setzero_si128(), t+N+j, bi,
+                                bi_P1_len, bi_M1_len);
+    _mm_storeu_si128((__m128i *) (t+j),
+                     _mm_and_si128(y0, _mm256_castsi256_si128(mask)));
+  }
+
+  memmove(c, t, N*sizeof(uint16_t));
+  for(j=N; j<PAD(N); j++)
+  {
+    c[j] = 0;
+  }
+
+  return;
+}
+
+/* ntru_ring_mult_product_indices_avx2
+ *
+ * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
+ * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1), where
+ * "b" is in the product form b1 * b2 + b3; see
+ * ntru_ring_mult_product_indices.
+ *
+ * The result array "c" may share the same memory space as input array "a",
+ * or input array "b".
+ *
+ * This assumes q is 2^r where 8 < r < 16, so that overflow of the sum
+ * beyond 16 bits does not matter.
+ *
+ * This works as ntru_ring_mult_product_indices_ssse3 in
+ * ntru_crypto_ntru_mult_indices_simd.c, summing blocks of 32 coefficients
+ * and then one of 16 and one of 8 as needed to reach PAD(N).  Both sums
+ * of a block in the first pass are taken before either is stored, as the
+ * store of a * b1 overwrites the copy of "a" just above the block.
+ */
+void
+ntru_ring_mult_product_indices_avx2(
+    uint16_t const *a,          /*  in - pointer to ring element a */
+    uint16_t const  b1i_len,    /*  in - no. of +1 or -1 coefficients in b1 */
+    uint16_t const  b2i_len,    /*  in - no. of +1 or -1 coefficients in b2 */
+    uint16_t const  b3i_len,    /*  in - no. of +1 or -1 coefficients in b3 */
+    uint16_t const *bi,         /*  in - pointer to the list of nonzero
+                                         indices of polynomials b1, b2, b3,
+                                         containing indices for the +1
+                                         coefficients followed by the
+                                         indices for -1 coefficients for
+                                         each polynomial */
+    uint16_t const  N,          /*  in - no. of coefficients in a, b, c */
+    uint16_t const  q,          /*  in - large modulus */
+    uint16_t       *t,          /*  in - temp buffer of 3 * PAD(N) elements */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+  uint16_t j;
+  uint16_t const mod_q_mask = q-1;
+  uint16_t const *b1i = bi;
+  uint16_t const *b2i = b1i+2*b1i_len;
+  uint16_t const *b3i = b2i+2*b2i_len;
+  uint16_t *t3 = t+2*PAD(N);
+  uint16_t const *Tp;
+
+  __m256i mask;
+  __m256i x[2];
+  __m256i y[2];
+  __m256i x0;
+  __m128i y0;
+  __m128i y1;
+
+  /* t[i] = a[i mod N] for i in [0, N+PAD(N)) */
+
+  ntru_ring_extend_avx2(t, a, N);
+
+  /* t[j] = (a * b1)[j] and t3[j] = (a * b3)[j], not reduced */
+
+  for(j=0; j+32<=PAD(N); j+=32)
+  {
+    Tp = t+N+j;
+    x[0] = x[1] = y[0] = y[1] = _mm256_setzero_si256();
+    ntru_sum_indices32_avx2(x, Tp, b1i, b1i_len, b1i_len);
+    ntru_sum_indices32_avx2(y, Tp, b3i, b3i_len, b3i_len);
+    _mm256_storeu_si256((__m256i *) (t+j), x[0]);
+    _mm256_storeu_si256((__m256i *) (t+j+16), x[1]);
+    _mm256_storeu_si256((__m256i *) (t3+j), y[0]);
+    _mm256_storeu_si256((__m256i *) (t3+j+16), y[1]);
+  }
+
+  if(j+16 <= PAD(N))
+  {
+    Tp = t+N+j;
+    x0 = ntru_sum_indices16_avx2(_mm256_setzero_si256(), Tp, b1i,
+                                 b1i_len, b1i_len);
+    x[0] = ntru_sum_indices16_avx2(_mm256_setzero_si256(), Tp, b3i,
+                                   b3i_len, b3i_len);
+    _mm256_storeu_si256((__m256i *) (t+j), x0);
+    _mm256_storeu_si256((__m256i *) (t3+j), x[0]);
+    j += 16;
+  }
+
+  if(j < PAD(N))
+  {
+    Tp = t+N+j;
+    y0 = ntru_sum_indices8_avx2(_mm_setzero_si128(), Tp, b1i,
+                                b1i_len, b1i_len);
+    y1 = ntru_sum_indices8_avx2(_mm_setzero_si128(), Tp, b3i,
+                                b3i_len, b3i_len);
+    _mm_storeu_si128((__m128i *) (t+j), y0);
+    _mm_storeu_si128((__m128i *) (t3+j), y1);
+  }
+
+  /* t[i] = (a * b1)[i mod N], then t[j] = (a * b1 * b2 + a * b3)[j] mod q */
+
+  ntru_ring_extend_avx2(t, t, N);
+
+  mask = _mm256_set1_epi16(mod_q_mask);
+  for(j=0; j+32<=PAD(N); j+=32)
+  {
+    x[0] = _mm256_loadu_si256((__m256i *) (t3+j));
+    x[1] = _mm256_loadu_si256((__m256i *) (t3+j+16));
+    ntru_sum_indices32_avx2(x, t+N+j, b2i, b2i_len, b2i_len);
+    _mm256_storeu_si256((__m256i *) (t+j), _mm256_and_si256(x[0], mask));
+    _mm256_storeu_si256((__m256i *) (t+j+16), _mm256_and_si256(x[1], mask));
+  }
+
+  if(j+16 <= PAD(N))
+  {
+    x0 = ntru_sum_indices16_avx2(_mm256_loadu_si256((__m256i *) (t3+j)),
+                                 t+N+j, b2i, b2i_len, b2i_len);
+    _mm256_storeu_si256((__m256i *) (t+j), _mm256_and_si256(x0, mask));
+    j += 16;
+  }
+
+  if(j < PAD(N))
+  {
+    y0 = ntru_sum_indices8_avx2(_mm_loadu_si128((__m128i *) (t3+j)),
+                                t+N+j, b2i, b2i_len, b2i_len);
+    _mm_storeu_si128((__m128i *) (t+j),
+                     _mm_and_si128(y0, _mm256_castsi256_si128(mask)));
+  }
+
+  memmove(c, t, N*sizeof(uint16_t));
+  for(j=N; j<PAD(N); j++)
+  {
+    c[j] = 0;
+  }
+
+  return;
+}
@@ -4,8 +4,33 @@
 
 #define PAD(N) ((N + 0x0007) & 0xfff8)
 
+/* ntru_ring_extend_ssse3
+ *
+ * Sets t[i] = a[i mod N] for i in [0, N+PAD(N)).  "a" may be "t".
+ */
+static void
+ntru_ring_extend_ssse3(
+    uint16_t       *t,
+    uint16_t const *a,
+    uint16_t        N)
+{
+  if(a != t)
+  {
+    memcpy(t, a, N*sizeof(uint16_t));
+  }
+  if(PAD(N) <= N)
+  {
+    memcpy(t+N, t, PAD(N)*sizeof(uint16_t));
+  }
+  else
+  {
+    memcpy(t+N, t, N*sizeof(uint16_t));
+    memcpy(t+2*N, t, (PAD(N)-N)*sizeof(uint16_t));
+  }
+}
+
 void
-ntru_ring_mult_indices_memreq(
+ntru_ring_mult_indices_memreq_ssse3(
     uint16_t N,
     uint16_t *tmp_polys,
     uint16_t *poly_coeffs)
@@ -21,7 +46,7 @@ ntru_ring_mult_indices_memreq(
     }
 }
 
-/* ntru_ring_mult_indices
+/* ntru_ring_mult_indices_ssse3
  *
  * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
  * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
@@ -40,7 +65,7 @@ ntru_ring_mult_indices_memreq(
  * beyond 16 bits does not matter.
  */
 void
-ntru_ring_mult_indices(
+ntru_ring_mult_indices_ssse3(
     uint16_t const *a,          /*  in - pointer to ring element a */
     uint16_t const  bi_P1_len,  /*  in - no. of +1 coefficients in b */
     uint16_t const  bi_M1_len,  /*  in - no. of -1 coefficients in b */
@@ -158,3 +183,118 @@ ntru_ring_mult_indices(
 
   return;
 }
+
+/* ntru_sum_indices8_ssse3
+ *
+ * Returns x plus the 8 coefficients at Tp - k for the first P1_len indices
+ * k in bi, less those for the following M1_len indices.
+ */
+static __m128i
+ntru_sum_indices8_ssse3(
+    __m128i         x,
+    uint16_t const *Tp,
+    uint16_t const *bi,
+    uint16_t        P1_len,
+    uint16_t        M1_len)
+{
+  uint16_t i;
+
+  for(i=0; i<P1_len; i++)
+  {
+    x = _mm_add_epi16(x, _mm_loadu_si128((__m128i *) (Tp-bi[i])));
+  }
+  for(; i<P1_len+M1_len; i++)
+  {
+    x = _mm_sub_epi16(x, _mm_loadu_si128((__m128i *) (Tp-bi[i])));
+  }
+
+  return x;
+}
+
+/* ntru_ring_mult_product_indices_ssse3
+ *
+ * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
+ * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1), where
+ * "b" is in the product form b1 * b2 + b3; see
+ * ntru_ring_mult_product_indices.
+ *
+ * The result array "c" may share the same memory space as input array "a",
+ * or input array "b".
+ *
+ * This assumes q is 2^r where 8 < r < 16, so that overflow of the sum
+ * beyond 16 bits does not matter.
+ *
+ * As in ntru_ring_mult_indices_avx2, "a" is extended cyclically to
+ * N + PAD(N) coefficients in the temp buffer, and each block of 8
+ * coefficients of a product is summed in a register from unaligned loads.
+ * a * b1 and a * b3 are summed in one pass over the copy of "a", a * b1
+ * replacing it and a * b3 going to the third scratch polynomial.  a * b1 is
+ * then extended in place, and a second pass adds (a * b1) * b2 to a * b3.
+ * Nothing is cleared, and the sums are only reduced mod q at the end.
+ */
+void
+ntru_ring_mult_product_indices_ssse3(
+    uint16_t const *a,          /*  in - pointer to ring element a */
+    uint16_t const  b1i_len,    /*  in - no. of +1 or -1 coefficients in b1 */
+    uint16_t const  b2i_len,    /*  in - no. of +1 or -1 coefficients in b2 */
+    uint16_t const  b3i_len,    /*  in - no. of +1 or -1 coefficients in b3 */
+    uint16_t const *bi,         /*  in - pointer to the list of nonzero
+                                         indices of polynomials b1, b2, b3,
+                                         containing indices for the +1
+                                         coefficients followed by the
+                                         indices for -1 coefficients for
+                                         each polynomial */
+    uint16_t const  N,          /*  in - no. of coefficients in a, b, c */
+    uint16_t const  q,          /*  in - large modulus */
+    uint16_t       *t,          /*  in - temp buffer of 3 * PAD(N) elements */
+    uint16_t       *c)          /* out - address for polynomial c */
+{
+  uint16_t j;
+  uint16_t const mod_q_mask = q-1;
+  uint16_t const *b1i = bi;
+  uint16_t const *b2i = b1i+2*b1i_len;
+  uint16_t const *b3i = b2i+2*b2i_len;
+  uint16_t *t3 = t+2*PAD(N);
+  uint16_t const *Tp;
+
+  __m128i mask;
+  __m128i x0;
+  __m128i x1;
+
+  /* t[i] = a[i mod N] for i in [0, N+PAD(N)) */
+
+  ntru_ring_extend_ssse3(t, a, N);
+
+  /* t[j] = (a * b1)[j] and t3[j] = (a * b3)[j], not reduced */
+
+  for(j=0; j<PAD(N); j+=8)
+  {
+    Tp = t+N+j;
+    x0 = ntru_sum_indices8_ssse3(_mm_setzero_si128(), Tp, b1i,
+                                 b1i_len, b1i_len);
+    x1 = ntru_sum_indices8_ssse3(_mm_setzero_si128(), Tp, b3i,
+                                 b3i_len, b3i_len);
+    _mm_storeu_si128((__m128i *) (t+j), x0);
+    _mm_storeu_si128((__m128i *) (t3+j), x1);
+  }
+
+  /* t[i] = (a * b1)[i mod N], then t[j] = (a * b1 * b2 + a * b3)[j] mod q */
+
+  ntru_ring_extend_ssse3(t, t, N);
+
+  mask = _mm_set1_epi16(mod_q_mask);
+  for(j=0; j<PAD(N); j+=8)
+  {
+    x0 = ntru_sum_indices8_ssse3(_mm_loadu_si128((__m128i *) (t3+j)),
+                                 t+N+j, b2i, b2i_len, b2i_len);
+    _mm_storeu_si128((__m128i *) (t+j), _mm_and_si128(x0, mask));
+  }
+
+  memmove(c, t, N*sizeof(uint16_t));
+  for(j=N; j<PAD(N); j++)
+  {
+    c[j] = 0;
+  }
+
+  return;
+}
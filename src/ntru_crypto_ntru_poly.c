@@ -53,6 +53,13 @@
  * coefficients combined) for a single polynomial, beginning with the
  * low-order byte for the first polynomial.  The high-order byte is unused.
  *
+ * If seed is NULL, buf must already hold the MGF-1 state, i.e. the digest
+ * of the seed followed by a 4-octet zero counter.  This lets the caller hash
+ * a seed of secret length with ntru_crypto_hash_digest_ct().
+ *
+ * The time taken for a candidate index does not depend on its value.  Only
+ * the number of candidates rejected, for being too large or repeated, varies.
+ *
  * Returns NTRU_OK if successful.
  * Returns HASH_BAD_ALG if the algorithm is not supported.
  *
@@ -85,6 +92,8 @@ ntru_gen_poly(
     uint16_t  num_indices;
     uint16_t  octets_available;
     uint16_t  index_cnt = 0;
+    uint16_t  used_len = ((N + 63) >> 6) << 3;
+    uint32_t  N_recip = 0xffffffff / N + 1;
     uint8_t   left = 0;
     uint8_t   num_left = 0;
     uint32_t  retcode;
@@ -122,10 +131,10 @@ ntru_gen_poly(
         num_indices = (uint16_t)indices_counts;
     }
 
-    /* init used-index array */
+    /* init used-index bitmap, which is accessed as 64-bit words */
 
     used = mgf_out + octets_available;
-    memset(used, 0, N);
+    memset(used, 0, used_len);
 
     /* generate indices (IGF-2) for all polynomials */
 
@@ -137,6 +146,11 @@ ntru_gen_poly(
         while (index_cnt < num_indices)
         {
             uint16_t index;
+            uint16_t j;
+            uint64_t bit;
+            uint64_t word;
+            uint64_t mask;
+            uint64_t dup;
             uint8_t  num_needed;
 
             /* form next index to convert to an index */
@@ -196,16 +210,29 @@ ntru_gen_poly(
                 }
             } while (index >= limit);
 
-            /* form index and check if unique */
+            /* form index and check if unique, without a division or a
+             * memory access that depends on the index: reduce with a
+             * reciprocal (exact for index, N < 2^16), test and set its
+             * bit while sweeping every word of the bitmap, and only count
+             * the index if it is new
+             */
 
-            index %= N;
-            
-            if (!used[index])
+            index -= N * (uint16_t)(((uint64_t)index * N_recip) >> 32);
+
+            bit = (uint64_t)1 << (index & 63);
+            dup = 0;
+            for (j = 0; j < used_len; j += 8)
             {
-                used[index] = 1;
-                indices[index_cnt] = index;
-                ++index_cnt;
+                mask = 0 - (uint64_t)((((uint32_t)(j ^ ((index >> 6) << 3))) -
+                                       1) >> 31);
+                memcpy(&word, used + j, 8);
+                dup |= word & bit & mask;
+                word |= bit & mask;
+                memcpy(used + j, &word, 8);
             }
+
+            indices[index_cnt] = index;
+            index_cnt += (uint16_t)(1 - ((dup | (0 - dup)) >> 63));
         }
         --num_polys;
 
@@ -213,7 +240,7 @@ ntru_gen_poly(
 
         if (num_polys > 0)
         {
-            memset(used, 0, N);
+            memset(used, 0, used_len);
             num_indices = num_indices +
                           (uint16_t)(indices_counts & 0xff);
             indices_counts >>= 8;
@@ -228,6 +255,9 @@ ntru_gen_poly(
  *
  * Checks that the number of 0, +1, and -1 trinary ring elements meet or exceed
  * a minimum weight.
+ *
+ * The weights are counted without branches or indexing by the elements, so
+ * the time taken depends only on num_els.
  */
 
 bool
@@ -236,26 +266,48 @@ ntru_poly_check_min_weight(
     uint8_t  *ringels,              /*  in - pointer to trinary ring elements */
     uint16_t  min_wt)               /*  in - minimum weight */
 {
-    uint16_t wt[3];
+    uint32_t wt1 = 0;
+    uint32_t wt2 = 0;
     uint16_t i;
 
-    wt[0] = wt[1] = wt[2] = 0;
-    
     for (i = 0; i < num_els; i++)
     {
-       ++wt[ringels[i]];
+        wt1 += ringels[i] & 1;
+        wt2 += ringels[i] >> 1;
     }
-    
-    if ((wt[0] < min_wt) || (wt[1] < min_wt) || (wt[2] < min_wt))
-    {
-        return FALSE;
-    }
-    
-    return TRUE;
+
+    return ntru_poly_check_weights(num_els, wt1, wt2, min_wt);
 }
 
 
-/* ntru_ring_mult_product_indices
+/* ntru_poly_check_weights
+ *
+ * Checks that the numbers of 0, +1, and -1 trinary ring elements, given by
+ * the number of elements and the numbers of +1 and -1 elements, meet or
+ * exceed a minimum weight, without branches.
+ */
+
+bool
+ntru_poly_check_weights(
+    uint16_t  num_els,              /*  in - degree of polynomial */
+    uint32_t  wt1,                  /*  in - no. of +1 elements */
+    uint32_t  wt2,                  /*  in - no. of -1 elements */
+    uint16_t  min_wt)               /*  in - minimum weight */
+{
+    uint32_t wt0;
+    uint32_t low;
+
+    wt0 = num_els - wt1 - wt2;
+
+    /* the top bit of each difference is set if that weight is too low */
+
+    low = (wt0 - min_wt) | (wt1 - min_wt) | (wt2 - min_wt);
+
+    return (low >> 31) == 0;
+}
+
+
+/* ntru_ring_mult_product_indices_scalar
  *
  * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
  * to produce ring element (polynomial) "c" in (Z/qZ)[X]/(X^N - 1).
@@ -273,10 +325,13 @@ ntru_poly_check_min_weight(
  *
  * This assumes q is 2^r where 8 < r < 16, so that overflow of the sum
  * beyond 16 bits does not matter.
+ *
+ * This version performs three scalar ntru_ring_mult_indices
+ * multiplications and adds two of the results.
  */
 
 void
-ntru_ring_mult_product_indices(
+ntru_ring_mult_product_indices_scalar(
     uint16_t const *a,          /*  in - pointer to ring element a */
     uint16_t const  b1i_len,    /*  in - no. of +1 or -1 coefficients in b1 */
     uint16_t const  b2i_len,    /*  in - no. of +1 or -1 coefficients in b2 */
@@ -298,23 +353,24 @@ ntru_ring_mult_product_indices(
     uint16_t  mod_q_mask;
     uint16_t  i;
 
-    ntru_ring_mult_indices_memreq(N, &scratch_polys, &poly_coeffs);
+    ntru_ring_mult_indices_memreq_scalar(N, &scratch_polys, &poly_coeffs);
     t2 = t + scratch_polys*poly_coeffs;
     mod_q_mask = q - 1;
 
     /* t2 = a * b1 */
 
-    ntru_ring_mult_indices(a, b1i_len, b1i_len, bi, N, q, t, t2);
+    ntru_ring_mult_indices_scalar(a, b1i_len, b1i_len, bi, N, q, t, t2);
 
     /* t2 = (a * b1) * b2 */
 
-    ntru_ring_mult_indices(t2, b2i_len, b2i_len, bi + (b1i_len << 1), N, q,
-                           t, t2);
+    ntru_ring_mult_indices_scalar(t2, b2i_len, b2i_len, bi + (b1i_len << 1),
+                                  N, q, t, t2);
 
     /* t = a * b3 */
 
-    ntru_ring_mult_indices(a, b3i_len, b3i_len,
-                           bi + ((b1i_len + b2i_len) << 1), N, q, t, t);
+    ntru_ring_mult_indices_scalar(a, b3i_len, b3i_len,
+                                  bi + ((b1i_len + b2i_len) << 1), N, q,
+                                  t, t);
 
     /* c = (a * b1 * b2) + (a * b3) */
 
@@ -58,6 +58,9 @@
  * coefficients combined) for a single polynomial, beginning with the
  * low-order byte for the first polynomial.  The high-order byte is unused.
  *
+ * If seed is NULL, buf must already hold the MGF-1 state, i.e. the digest
+ * of the seed followed by a 4-octet zero counter.
+ *
  * Returns NTRU_OK if successful.
  * Returns HASH_BAD_ALG if the algorithm is not supported.
  *
@@ -97,6 +100,83 @@ ntru_poly_check_min_weight(
     uint16_t  min_wt);              /*  in - minimum weight */
 
 
+/* ntru_poly_check_weights
+ *
+ * Checks that the numbers of 0, +1, and -1 trinary ring elements, given by
+ * the number of elements and the numbers of +1 and -1 elements, meet or
+ * exceed a minimum weight.
+ */
+
+extern bool
+ntru_poly_check_weights(
+    uint16_t  num_els,              /*  in - degree of polynomial */
+    uint32_t  wt1,                  /*  in - no. of +1 elements */
+    uint32_t  wt2,                  /*  in - no. of -1 elements */
+    uint16_t  min_wt);              /*  in - minimum weight */
+
+
+/* ntru_poly_add_msg_rep
+ *
+ * Forms the message representative m' = mask + Mtrin (mod 3), and adds it
+ * to ring element R mod q, where m' = 1 adds 1 and m' = 2 (-1) subtracts 1.
+ * The weights of m' are counted in the same pass; m' itself is not stored.
+ * R is updated whether or not m' meets the minimum weight.
+ *
+ * This assumes q is a power of 2.  The time taken depends only on num_els.
+ *
+ * Returns TRUE if m' meets the minimum weight.
+ * Returns FALSE otherwise.
+ */
+
+extern bool
+ntru_poly_add_msg_rep(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t const  *trits,          /*  in - pointer to message trits Mtrin */
+    uint16_t        min_wt,         /*  in - minimum weight of m' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels);       /* in/out - pointer to ring element R */
+
+
+/* ntru_poly_recover_msg_rep
+ *
+ * Recovers the candidate message representative cm' from ciphertext e and
+ * F * e, as a = e + 3 * F * e mod q lifted to [-q/2, q/2), reduced mod 3.
+ * In the same pass the weights of cm' are counted and e is replaced by
+ * cR = e - cm' mod q, where cm' = 1 subtracts 1 and cm' = 2 (-1) adds 1.
+ * F * e need not be reduced mod q, and cm' may be written over the start
+ * of it.
+ *
+ * This assumes q is a power of 2 no greater than 2^15.  The time taken
+ * depends only on num_els.
+ *
+ * Returns TRUE if cm' meets the minimum weight.
+ * Returns FALSE otherwise.
+ */
+
+extern bool
+ntru_poly_recover_msg_rep(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint16_t const *Fe,             /*  in - pointer to F * e */
+    uint16_t        min_wt,         /*  in - minimum weight of cm' */
+    uint16_t        q,              /*  in - large modulus */
+    uint16_t       *ringels,        /* in/out - pointer to e, then cR */
+    uint8_t        *trits);         /* out - address for cm' */
+
+
+/* ntru_poly_unmask_msg_rep
+ *
+ * Forms cMtrin = cm' - mask (mod 3) in place.  The time taken depends only
+ * on num_els.
+ */
+
+extern void
+ntru_poly_unmask_msg_rep(
+    uint16_t        num_els,        /*  in - degree of polynomials */
+    uint8_t const  *mask,           /*  in - pointer to mask trits */
+    uint8_t        *trits);         /* in/out - pointer to cm', then cMtrin */
+
+
 /* ntru_ring_mult_indices
  *
  * Multiplies ring element (polynomial) "a" by ring element (polynomial) "b"
@@ -167,8 +247,9 @@ ntru_ring_mult_product_indices(
                                          each polynomial */
     uint16_t const  N,          /*  in - no. of coefficients in a, b, c */
     uint16_t const  q,          /*  in - large modulus */
-    uint16_t       *t,          /*  in - temp buffer. Size is impl dependent.
-                                         see ntru_ring_mult_indices_memreq */
+    uint16_t       *t,          /*  in - temp buffer of one more poly than
+                                         ntru_ring_mult_indices_memreq
+                                         gives */
     uint16_t       *c);         /* out - address for polynomial c */
 
 
@@ -291,4 +372,263 @@ ntru_ring_mult_indices_memreq(
     uint16_t *num_scratch_polys,
     uint16_t *pad_deg);
 
+
+/* ring multiplication implementations
+ *
+ * ntru_ring_mult_indices, ntru_ring_mult_coefficients and their _memreq
+ * functions dispatch through the implementation selected for the CPU when
+ * the library is loaded.  The memory requirements of the two multiplications
+ * must be taken from the same implementation as the multiplications
+ * themselves, so the four functions are selected together.  The product
+ * form multiplication, ntru_ring_mult_product_indices, is selected with
+ * them, and uses one more scratch polynomial than ntru_ring_mult_indices.
+ */
+
+typedef enum {
+    NTRU_RING_MULT_SCALAR = 0,
+    NTRU_RING_MULT_SSSE3,
+    NTRU_RING_MULT_AVX2,
+    NTRU_RING_MULT_NUM_IMPLS,
+} NTRU_RING_MULT_IMPL_ID;
+
+typedef void (*NTRU_RING_MULT_MEMREQ_FN)(
+    uint16_t  N,
+    uint16_t *num_scratch_polys,
+    uint16_t *pad_deg);
+
+typedef void (*NTRU_RING_MULT_INDICES_FN)(
+    uint16_t const *a,
+    uint16_t const  bi_P1_len,
+    uint16_t const  bi_M1_len,
+    uint16_t const *bi,
+    uint16_t const  N,
+    uint16_t const  q,
+    uint16_t       *t,
+    uint16_t       *c);
+
+typedef void (*NTRU_RING_MULT_PRODUCT_INDICES_FN)(
+    uint16_t const *a,
+    uint16_t const  b1i_len,
+    uint16_t const  b2i_len,
+    uint16_t const  b3i_len,
+    uint16_t const *bi,
+    uint16_t const  N,
+    uint16_t const  q,
+    uint16_t       *t,
+    uint16_t       *c);
+
+typedef void (*NTRU_RING_MULT_COEFFICIENTS_FN)(
+    uint16_t const *a,
+    uint16_t const *b,
+    uint16_t        N,
+    uint16_t        q,
+    uint16_t       *tmp,
+    uint16_t       *c);
+
+typedef struct {
+    char const                     *name;
+    NTRU_RING_MULT_INDICES_FN       mult_indices;
+    NTRU_RING_MULT_MEMREQ_FN        mult_indices_memreq;
+    NTRU_RING_MULT_PRODUCT_INDICES_FN
+                                    mult_product_indices;
+    NTRU_RING_MULT_COEFFICIENTS_FN  mult_coefficients;
+    NTRU_RING_MULT_MEMREQ_FN        mult_coefficients_memreq;
+} NTRU_RING_MULT_IMPL;
+
+
+/* ntru_ring_mult_get_impl
+ *
+ * Returns the ring multiplication implementation with the given ID, or
+ * NULL if it is not built into the library or not supported by the CPU.
+ * Passing NTRU_RING_MULT_NUM_IMPLS returns the selected implementation.
+ */
+
+extern NTRU_RING_MULT_IMPL const *
+ntru_ring_mult_get_impl(
+    NTRU_RING_MULT_IMPL_ID id);     /*  in - implementation ID */
+
+
+/* implementation variants, see ntru_ring_mult_indices,
+ * ntru_ring_mult_product_indices and ntru_ring_mult_coefficients
+ */
+
+extern void
+ntru_ring_mult_indices_scalar(uint16_t const *a, uint16_t const bi_P1_len,
+                              uint16_t const bi_M1_len, uint16_t const *bi,
+                              uint16_t const N, uint16_t const q,
+                              uint16_t *t, uint16_t *c);
+extern void
+ntru_ring_mult_indices_memreq_scalar(uint16_t N, uint16_t *num_scratch_polys,
+                                     uint16_t *pad_deg);
+extern void
+ntru_ring_mult_product_indices_scalar(uint16_t const *a,
+                                      uint16_t const b1i_len,
+                                      uint16_t const b2i_len,
+                                      uint16_t const b3i_len,
+                                      uint16_t const *bi, uint16_t const N,
+                                      uint16_t const q, uint16_t *t,
+                                      uint16_t *c);
+extern void
+ntru_ring_mult_coefficients_karat(uint16_t const *a, uint16_t const *b,
+                                  uint16_t N, uint16_t q, uint16_t *tmp,
+                                  uint16_t *c);
+extern void
+ntru_ring_mult_coefficients_memreq_karat(uint16_t N,
+                                         uint16_t *num_scratch_polys,
+                                         uint16_t *pad_deg);
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+extern void
+ntru_ring_mult_indices_ssse3(uint16_t const *a, uint16_t const bi_P1_len,
+                             uint16_t const bi_M1_len, uint16_t const *bi,
+                             uint16_t const N, uint16_t const q,
+                             uint16_t *t, uint16_t *c);
+extern void
+ntru_ring_mult_indices_memreq_ssse3(uint16_t N, uint16_t *num_scratch_polys,
+                                    uint16_t *pad_deg);
+extern void
+ntru_ring_mult_product_indices_ssse3(uint16_t const *a,
+                                     uint16_t const b1i_len,
+                                     uint16_t const b2i_len,
+                                     uint16_t const b3i_len,
+                                     uint16_t const *bi, uint16_t const N,
+                                     uint16_t const q, uint16_t *t,
+                                     uint16_t *c);
+extern void
+ntru_ring_mult_coefficients_ssse3(uint16_t const *a, uint16_t const *b,
+                                  uint16_t N, uint16_t q, uint16_t *tmp,
+                                  uint16_t *c);
+extern void
+ntru_ring_mult_coefficients_memreq_ssse3(uint16_t N,
+                                         uint16_t *num_scratch_polys,
+                                         uint16_t *pad_deg);
+extern void
+ntru_ring_mult_indices_avx2(uint16_t const *a, uint16_t const bi_P1_len,
+                            uint16_t const bi_M1_len, uint16_t const *bi,
+                            uint16_t const N, uint16_t const q,
+                            uint16_t *t, uint16_t *c);
+extern void
+ntru_ring_mult_indices_memreq_avx2(uint16_t N, uint16_t *num_scratch_polys,
+                                   uint16_t *pad_deg);
+extern void
+ntru_ring_mult_product_indices_avx2(uint16_t const *a,
+                                    uint16_t const b1i_len,
+                                    uint16_t const b2i_len,
+                                    uint16_t const b3i_len,
+                                    uint16_t const *bi, uint16_t const N,
+                                    uint16_t const q, uint16_t *t,
+                                    uint16_t *c);
+extern void
+ntru_ring_mult_coefficients_avx2(uint16_t const *a, uint16_t const *b,
+                                 uint16_t N, uint16_t q, uint16_t *tmp,
+                                 uint16_t *c);
+extern void
+ntru_ring_mult_coefficients_memreq_avx2(uint16_t N,
+                                        uint16_t *num_scratch_polys,
+                                        uint16_t *pad_deg);
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* message representative implementations
+ *
+ * ntru_poly_add_msg_rep, ntru_poly_recover_msg_rep and
+ * ntru_poly_unmask_msg_rep dispatch through the implementation selected for
+ * the CPU when the library is loaded.  The vectorized implementations
+ * handle 16 or 32 elements per step and the scalar code the remainder.
+ */
+
+typedef enum {
+    NTRU_MSG_REP_SCALAR = 0,
+    NTRU_MSG_REP_SSSE3,
+    NTRU_MSG_REP_AVX2,
+    NTRU_MSG_REP_NUM_IMPLS,
+} NTRU_MSG_REP_IMPL_ID;
+
+typedef bool (*NTRU_ADD_MSG_REP_FN)(
+    uint16_t        num_els,
+    uint8_t const  *mask,
+    uint8_t const  *trits,
+    uint16_t        min_wt,
+    uint16_t        q,
+    uint16_t       *ringels);
+
+typedef bool (*NTRU_RECOVER_MSG_REP_FN)(
+    uint16_t        num_els,
+    uint16_t const *Fe,
+    uint16_t        min_wt,
+    uint16_t        q,
+    uint16_t       *ringels,
+    uint8_t        *trits);
+
+typedef void (*NTRU_UNMASK_MSG_REP_FN)(
+    uint16_t        num_els,
+    uint8_t const  *mask,
+    uint8_t        *trits);
+
+typedef struct {
+    char const                 *name;
+    NTRU_ADD_MSG_REP_FN         add_msg_rep;
+    NTRU_RECOVER_MSG_REP_FN     recover_msg_rep;
+    NTRU_UNMASK_MSG_REP_FN      unmask_msg_rep;
+} NTRU_MSG_REP_IMPL;
+
+
+/* ntru_msg_rep_get_impl
+ *
+ * Returns the message representative implementation with the given ID, or
+ * NULL if it is not built into the library or not supported by the CPU.
+ * Passing NTRU_MSG_REP_NUM_IMPLS returns the selected implementation.
+ */
+
+extern NTRU_MSG_REP_IMPL const *
+ntru_msg_rep_get_impl(
+    NTRU_MSG_REP_IMPL_ID id);       /*  in - implementation ID */
+
+
+/* implementation variants, see ntru_poly_add_msg_rep,
+ * ntru_poly_recover_msg_rep and ntru_poly_unmask_msg_rep
+ */
+
+extern bool
+ntru_poly_add_msg_rep_scalar(uint16_t num_els, uint8_t const *mask,
+                             uint8_t const *trits, uint16_t min_wt,
+                             uint16_t q, uint16_t *ringels);
+extern bool
+ntru_poly_recover_msg_rep_scalar(uint16_t num_els, uint16_t const *Fe,
+                                 uint16_t min_wt, uint16_t q,
+                                 uint16_t *ringels, uint8_t *trits);
+extern void
+ntru_poly_unmask_msg_rep_scalar(uint16_t num_els, uint8_t const *mask,
+                                uint8_t *trits);
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+extern bool
+ntru_poly_add_msg_rep_ssse3(uint16_t num_els, uint8_t const *mask,
+                            uint8_t const *trits, uint16_t min_wt,
+                            uint16_t q, uint16_t *ringels);
+extern bool
+ntru_poly_recover_msg_rep_ssse3(uint16_t num_els, uint16_t const *Fe,
+                                uint16_t min_wt, uint16_t q,
+                                uint16_t *ringels, uint8_t *trits);
+extern void
+ntru_poly_unmask_msg_rep_ssse3(uint16_t num_els, uint8_t const *mask,
+                               uint8_t *trits);
+extern bool
+ntru_poly_add_msg_rep_avx2(uint16_t num_els, uint8_t const *mask,
+                           uint8_t const *trits, uint16_t min_wt,
+                           uint16_t q, uint16_t *ringels);
+extern bool
+ntru_poly_recover_msg_rep_avx2(uint16_t num_els, uint16_t const *Fe,
+                               uint16_t min_wt, uint16_t q,
+                               uint16_t *ringels, uint8_t *trits);
+extern void
+ntru_poly_unmask_msg_rep_avx2(uint16_t num_els, uint8_t const *mask,
+                              uint8_t *trits);
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
 #endif /* NTRU_CRYPTO_NTRU_POLY_H */
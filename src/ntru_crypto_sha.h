@@ -34,6 +34,7 @@
 #define NTRU_CRYPTO_SHA_H
 
 
+#include "ntru_crypto_platform.h"
 #include "ntru_crypto_error.h"
 #include "ntru_crypto_hash_basics.h"
 
@@ -60,5 +61,74 @@
 #define SHA_FINISH          HASH_FINISH
 
 
+/******************************
+ * block compression routines *
+ ******************************/
+
+/* ntru_crypto_sha1_blk()
+ * ntru_crypto_sha256_blk()
+ *
+ * Update the SHA-1 (five-word) or SHA-256 (eight-word) chaining state by
+ * compressing a 512-bit block of data given as sixteen 32-bit words.
+ * These dispatch to the implementation selected for the CPU when the
+ * library is loaded.
+ */
+
+extern void
+ntru_crypto_sha1_blk(
+    uint32_t const *data,       /*     in - ptr to 16 32-bit word input block */
+    uint32_t       *state);     /* in/out - ptr to 5 32-bit word chaining state */
+
+extern void
+ntru_crypto_sha256_blk(
+    uint32_t const *data,     /*     in - ptr to 16 32-bit word input block */
+    uint32_t       *state);   /* in/out - ptr to 8 32-bit word chaining state */
+
+
+/* implementations of the block compression routines */
+
+typedef enum {
+    NTRU_CRYPTO_SHA_BLK_SCALAR = 0,
+    NTRU_CRYPTO_SHA_BLK_SHANI,
+    NTRU_CRYPTO_SHA_BLK_NUM_IMPLS,
+} NTRU_CRYPTO_SHA_BLK_IMPL_ID;
+
+typedef void (*NTRU_CRYPTO_SHA_BLK_FN)(
+    uint32_t const *data,
+    uint32_t       *state);
+
+typedef struct {
+    char const             *name;
+    NTRU_CRYPTO_SHA_BLK_FN  sha1_blk;
+    NTRU_CRYPTO_SHA_BLK_FN  sha256_blk;
+} NTRU_CRYPTO_SHA_BLK_IMPL;
+
+
+/* ntru_crypto_sha_blk_get_impl()
+ *
+ * Returns the block compression implementation with the given ID, or NULL
+ * if it is not built into the library or not supported by the CPU.
+ * Passing NTRU_CRYPTO_SHA_BLK_NUM_IMPLS returns the selected implementation.
+ */
+
+extern NTRU_CRYPTO_SHA_BLK_IMPL const *
+ntru_crypto_sha_blk_get_impl(
+    NTRU_CRYPTO_SHA_BLK_IMPL_ID id);    /*  in - implementation ID */
+
+
+/* implementation variants, see ntru_crypto_sha1_blk() and
+ * ntru_crypto_sha256_blk()
+ */
+
+extern void
+ntru_crypto_sha1_blk_scalar(uint32_t const *data, uint32_t *state);
+extern void
+ntru_crypto_sha256_blk_scalar(uint32_t const *data, uint32_t *state);
+extern void
+ntru_crypto_sha1_blk_shani(uint32_t const *data, uint32_t *state);
+extern void
+ntru_crypto_sha256_blk_shani(uint32_t const *data, uint32_t *state);
+
+
 #endif /* NTRU_CRYPTO_SHA_H */
 
@@ -53,7 +53,7 @@
 #define H4_INIT 0xc3d2e1f0UL
 
 
-/* sha1_blk()
+/* ntru_crypto_sha1_blk_scalar()
  *
  * This routine updates the current hash output (chaining state)
  * by performing SHA-1 on a 512-bit block of data represented as sixteen
@@ -68,8 +68,8 @@
 #define RL(a, n)    ( ((a) << (n)) | ((a) >> (32 - (n))) )
 
 
-static void
-sha1_blk(
+void
+ntru_crypto_sha1_blk_scalar(
     uint32_t const *data,       /*     in - ptr to 16 32-bit word input block */
     uint32_t       *state)      /* in/out - ptr to 5 32-bit word chaining state */
 {
@@ -396,14 +396,14 @@ ntru_crypto_sha1(
             
             ntru_crypto_msbyte_2_uint32(in_blk, (uint8_t const *) c->unhashed,
                                         16);
-            sha1_blk((uint32_t const *) in_blk, c->state);
+            ntru_crypto_sha1_blk((uint32_t const *) in_blk, c->state);
 
             /* process any remaining full blocks */
 
             for (blks = in_len >> 6; blks--; in += 64)
             {
                 ntru_crypto_msbyte_2_uint32(in_blk, in, 16);
-                sha1_blk((uint32_t const *) in_blk, c->state);
+                ntru_crypto_sha1_blk((uint32_t const *) in_blk, c->state);
             }
 
             /* put any remaining input in the unhashed data buffer */
@@ -443,7 +443,7 @@ ntru_crypto_sha1(
             memset(d, 0, space);
             ntru_crypto_msbyte_2_uint32(in_blk,
                                         (uint8_t const *) c->unhashed, 16);
-            sha1_blk((uint32_t const *) in_blk, c->state);
+            ntru_crypto_sha1_blk((uint32_t const *) in_blk, c->state);
             memset(c->unhashed, 0, 56);
 
         }
@@ -471,7 +471,7 @@ ntru_crypto_sha1(
 
         /* process last block */
 
-        sha1_blk((uint32_t const *) in_blk, c->state);
+        ntru_crypto_sha1_blk((uint32_t const *) in_blk, c->state);
 
         /* copy result to message digest buffer */
 
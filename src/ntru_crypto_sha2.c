@@ -33,6 +33,7 @@
 #include "ntru_crypto.h"
 #include "ntru_crypto_sha2.h"
 #include "ntru_crypto_msbyte_uint32.h"
+#include "ntru_crypto_cpu.h"
 
 
 /* chaining state elements */
@@ -59,7 +60,7 @@
 #define H7_SHA256_INIT 0x5be0cd19UL
 
 
-/* sha2_blk()
+/* ntru_crypto_sha256_blk_scalar()
  *
  * This routine updates the current hash output (chaining state)
  * by performing SHA-256 on a 512-bit block of data represented
@@ -73,8 +74,8 @@
 #define s1(a)       ( RR((a), 17) ^ RR((a), 19) ^ ((a) >> 10) )
 
 
-static void
-sha2_blk(
+void
+ntru_crypto_sha256_blk_scalar(
     uint32_t const *data,     /*     in - ptr to 16 32-bit word input block */
     uint32_t       *state)    /* in/out - ptr to 8 32-bit word chaining state */
 {
@@ -437,14 +438,14 @@ ntru_crypto_sha2(
             
             ntru_crypto_msbyte_2_uint32(in_blk, (uint8_t const *) c->unhashed,
                                         16);
-            sha2_blk((uint32_t const *) in_blk, c->state);
+            ntru_crypto_sha256_blk((uint32_t const *) in_blk, c->state);
 
             /* process any remaining full blocks */
 
             for (blks = in_len >> 6; blks--; in += 64)
             {
                 ntru_crypto_msbyte_2_uint32(in_blk, in, 16);
-                sha2_blk((uint32_t const *) in_blk, c->state);
+                ntru_crypto_sha256_blk((uint32_t const *) in_blk, c->state);
             }
 
             /* put any remaining input in the unhashed data buffer */
@@ -483,7 +484,7 @@ ntru_crypto_sha2(
             memset(d, 0, space);
             ntru_crypto_msbyte_2_uint32(in_blk,
                                         (uint8_t const *) c->unhashed, 16);
-            sha2_blk((uint32_t const *) in_blk, c->state);
+            ntru_crypto_sha256_blk((uint32_t const *) in_blk, c->state);
             memset(c->unhashed, 0, 56);
 
         }
@@ -510,7 +511,7 @@ ntru_crypto_sha2(
 
         /* process last block */
 
-        sha2_blk((uint32_t const *) in_blk, c->state);
+        ntru_crypto_sha256_blk((uint32_t const *) in_blk, c->state);
 
         /* copy result to message digest buffer */
 
@@ -525,3 +526,175 @@ ntru_crypto_sha2(
     SHA_RET(SHA_OK)
 }
 
+
+
+/* SHA-256 round constants, for the vectorized implementations */
+
+uint32_t const ntru_crypto_sha256_K[64] = {
+    0x428A2F98UL, 0x71374491UL, 0xB5C0FBCFUL, 0xE9B5DBA5UL,
+    0x3956C25BUL, 0x59F111F1UL, 0x923F82A4UL, 0xAB1C5ED5UL,
+    0xD807AA98UL, 0x12835B01UL, 0x243185BEUL, 0x550C7DC3UL,
+    0x72BE5D74UL, 0x80DEB1FEUL, 0x9BDC06A7UL, 0xC19BF174UL,
+    0xE49B69C1UL, 0xEFBE4786UL, 0x0FC19DC6UL, 0x240CA1CCUL,
+    0x2DE92C6FUL, 0x4A7484AAUL, 0x5CB0A9DCUL, 0x76F988DAUL,
+    0x983E5152UL, 0xA831C66DUL, 0xB00327C8UL, 0xBF597FC7UL,
+    0xC6E00BF3UL, 0xD5A79147UL, 0x06CA6351UL, 0x14292967UL,
+    0x27B70A85UL, 0x2E1B2138UL, 0x4D2C6DFCUL, 0x53380D13UL,
+    0x650A7354UL, 0x766A0ABBUL, 0x81C2C92EUL, 0x92722C85UL,
+    0xA2BFE8A1UL, 0xA81A664BUL, 0xC24B8B70UL, 0xC76C51A3UL,
+    0xD192E819UL, 0xD6990624UL, 0xF40E3585UL, 0x106AA070UL,
+    0x19A4C116UL, 0x1E376C08UL, 0x2748774CUL, 0x34B0BCB5UL,
+    0x391C0CB3UL, 0x4ED8AA4AUL, 0x5B9CCA4FUL, 0x682E6FF3UL,
+    0x748F82EEUL, 0x78A5636FUL, 0x84C87814UL, 0x8CC70208UL,
+    0x90BEFFFAUL, 0xA4506CEBUL, 0xBEF9A3F7UL, 0xC67178F2UL,
+};
+
+
+/* ntru_crypto_sha256_ctr_scalar()
+ *
+ * Computes the digests of seed || counter one at a time with
+ * ntru_crypto_sha256_blk(), building the single padded input block once and
+ * changing only the counter word.
+ */
+
+void
+ntru_crypto_sha256_ctr_scalar(
+    uint8_t const *seed,            /*  in - pointer to 32-octet seed */
+    uint32_t       ctr,             /*  in - first counter value */
+    uint32_t       num_digests,     /*  in - no. of digests */
+    uint8_t       *md)              /* out - address for the digests */
+{
+    uint32_t in_blk[16];
+    uint32_t state[8];
+
+    /* seed || counter || 0x80 padding || bit count of 36 octets */
+
+    ntru_crypto_msbyte_2_uint32(in_blk, seed, 8);
+    in_blk[9] = 0x80000000UL;
+    memset(in_blk + 10, 0, 5 * sizeof(uint32_t));
+    in_blk[15] = 36 << 3;
+
+    while (num_digests-- > 0)
+    {
+        in_blk[8] = ctr++;
+        state[0] = H0_SHA256_INIT;
+        state[1] = H1_SHA256_INIT;
+        state[2] = H2_SHA256_INIT;
+        state[3] = H3_SHA256_INIT;
+        state[4] = H4_SHA256_INIT;
+        state[5] = H5_SHA256_INIT;
+        state[6] = H6_SHA256_INIT;
+        state[7] = H7_SHA256_INIT;
+        ntru_crypto_sha256_blk((uint32_t const *) in_blk, state);
+        ntru_crypto_uint32_2_msbyte(md, state, 8);
+        md += 32;
+    }
+
+    /* clear stack variables */
+
+    memset(in_blk, 0, sizeof(in_blk));
+    memset(state, 0, sizeof(state));
+}
+
+
+/* implementation table, indexed by NTRU_CRYPTO_SHA256_CTR_IMPL_ID */
+
+static NTRU_CRYPTO_SHA256_CTR_FN const ntru_crypto_sha256_ctr_impls[] = {
+    ntru_crypto_sha256_ctr_scalar,
+#if defined(NTRU_HAVE_X86_SIMD)
+    ntru_crypto_sha256_ctr_ssse3,
+    ntru_crypto_sha256_ctr_avx2,
+#endif
+};
+
+#define NTRU_CRYPTO_SHA256_CTR_NUM_BUILT                                      \
+    (sizeof(ntru_crypto_sha256_ctr_impls) /                                   \
+     sizeof(ntru_crypto_sha256_ctr_impls[0]))
+
+
+/* NTRU_CPU_ flags required by each implementation, indexed by
+ * NTRU_CRYPTO_SHA256_CTR_IMPL_ID
+ */
+
+static uint32_t const ntru_crypto_sha256_ctr_required[] = {
+    0,
+#if defined(NTRU_HAVE_X86_SIMD)
+    NTRU_CPU_SSSE3,
+    NTRU_CPU_AVX2,
+#endif
+};
+
+
+/* the counter-mode hash in use */
+
+static NTRU_CRYPTO_SHA256_CTR_FN ntru_crypto_sha256_ctr_impl =
+    ntru_crypto_sha256_ctr_scalar;
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* ntru_crypto_sha256_ctr_select()
+ *
+ * Picks the widest SIMD lanes that the CPU supports.  With the SHA
+ * extensions, hashing one block at a time in the scalar implementation is
+ * faster than the SIMD lanes, so that is kept.
+ */
+
+static void ntru_crypto_sha256_ctr_select(void) __attribute__((constructor));
+
+static void
+ntru_crypto_sha256_ctr_select(void)
+{
+    if (ntru_crypto_cpu_supports(NTRU_CPU_SHA))
+    {
+        return;
+    }
+
+    ntru_crypto_sha256_ctr_impl = ntru_crypto_sha256_ctr_impls[
+        ntru_crypto_cpu_best_impl(ntru_crypto_sha256_ctr_required,
+                                  NTRU_CRYPTO_SHA256_CTR_NUM_BUILT)];
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_crypto_sha256_ctr_get_impl()
+ *
+ * Returns the implementation with the given ID, or NULL if it is not built
+ * into the library or not supported by the CPU.  Passing
+ * NTRU_CRYPTO_SHA256_CTR_NUM_IMPLS returns the selected implementation.
+ */
+
+NTRU_CRYPTO_SHA256_CTR_FN
+ntru_crypto_sha256_ctr_get_impl(
+    NTRU_CRYPTO_SHA256_CTR_IMPL_ID id)  /*  in - implementation ID */
+{
+    if (id == NTRU_CRYPTO_SHA256_CTR_NUM_IMPLS)
+    {
+        return ntru_crypto_sha256_ctr_impl;
+    }
+
+    if (((uint32_t)id >= NTRU_CRYPTO_SHA256_CTR_NUM_BUILT) ||
+        !ntru_crypto_cpu_supports(ntru_crypto_sha256_ctr_required[id]))
+    {
+        return NULL;
+    }
+
+    return ntru_crypto_sha256_ctr_impls[id];
+}
+
+
+/* ntru_crypto_sha256_ctr()
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_sha2.h.
+ */
+
+void
+ntru_crypto_sha256_ctr(
+    uint8_t const *seed,            /*  in - pointer to 32-octet seed */
+    uint32_t       ctr,             /*  in - first counter value */
+    uint32_t       num_digests,     /*  in - no. of digests */
+    uint8_t       *md)              /* out - address for the digests */
+{
+    ntru_crypto_sha256_ctr_impl(seed, ctr, num_digests, md);
+}
@@ -95,4 +95,69 @@ ntru_crypto_sha2(
                                                 may be NULL if not FINISH */
 
 
+/* ntru_crypto_sha256_ctr()
+ *
+ * Computes num_digests SHA-256 digests of a 32-octet seed followed by a
+ * 4-octet big-endian counter, for the counter values ctr, ctr + 1, ...,
+ * and writes them consecutively to md.  This is the hashing done by MGF1
+ * with SHA-256.
+ *
+ * Each input fits in a single block, so the digests are independent and
+ * are computed several at a time in SIMD lanes when the CPU supports it.
+ */
+
+extern void
+ntru_crypto_sha256_ctr(
+    uint8_t const *seed,            /*  in - pointer to 32-octet seed */
+    uint32_t       ctr,             /*  in - first counter value */
+    uint32_t       num_digests,     /*  in - no. of digests */
+    uint8_t       *md);             /* out - address for the digests */
+
+
+/* implementations of ntru_crypto_sha256_ctr(), selected for the CPU when
+ * the library is loaded
+ */
+
+typedef enum {
+    NTRU_CRYPTO_SHA256_CTR_SCALAR = 0,
+    NTRU_CRYPTO_SHA256_CTR_SSSE3,
+    NTRU_CRYPTO_SHA256_CTR_AVX2,
+    NTRU_CRYPTO_SHA256_CTR_NUM_IMPLS,
+} NTRU_CRYPTO_SHA256_CTR_IMPL_ID;
+
+typedef void (*NTRU_CRYPTO_SHA256_CTR_FN)(
+    uint8_t const *seed,
+    uint32_t       ctr,
+    uint32_t       num_digests,
+    uint8_t       *md);
+
+
+/* ntru_crypto_sha256_ctr_get_impl()
+ *
+ * Returns the ntru_crypto_sha256_ctr() implementation with the given ID, or
+ * NULL if it is not built into the library or not supported by the CPU.
+ * Passing NTRU_CRYPTO_SHA256_CTR_NUM_IMPLS returns the selected
+ * implementation.
+ */
+
+extern NTRU_CRYPTO_SHA256_CTR_FN
+ntru_crypto_sha256_ctr_get_impl(
+    NTRU_CRYPTO_SHA256_CTR_IMPL_ID id); /*  in - implementation ID */
+
+
+/* implementation variants, see ntru_crypto_sha256_ctr() */
+
+extern uint32_t const ntru_crypto_sha256_K[64];     /* round constants */
+
+extern void
+ntru_crypto_sha256_ctr_scalar(uint8_t const *seed, uint32_t ctr,
+                              uint32_t num_digests, uint8_t *md);
+extern void
+ntru_crypto_sha256_ctr_ssse3(uint8_t const *seed, uint32_t ctr,
+                             uint32_t num_digests, uint8_t *md);
+extern void
+ntru_crypto_sha256_ctr_avx2(uint8_t const *seed, uint32_t ctr,
+                            uint32_t num_digests, uint8_t *md);
+
+
 #endif /* NTRU_CRYPTO_SHA2_H */
@@ -0,0 +1,152 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_sha2.h"
+#include "ntru_crypto_msbyte_uint32.h"
+#include <immintrin.h>
+
+/* SHA-256 in four 32-bit SSE lanes.  Each lane holds one message, so the
+ * four compressions run side by side with the same instruction stream. */
+
+#define LANES 4
+
+#define ADD(x, y)   _mm_add_epi32((x), (y))
+#define XOR(x, y)   _mm_xor_si128((x), (y))
+#define AND(x, y)   _mm_and_si128((x), (y))
+#define OR(x, y)    _mm_or_si128((x), (y))
+#define SET1(x)     _mm_set1_epi32((int)(x))
+#define SHR(x, n)   _mm_srli_epi32((x), (n))
+#define SHL(x, n)   _mm_slli_epi32((x), (n))
+#define ROTR(x, n)  OR(SHR((x), (n)), SHL((x), 32 - (n)))
+
+#define S0(a)       XOR(XOR(ROTR((a),  2), ROTR((a), 13)), ROTR((a), 22))
+#define S1(a)       XOR(XOR(ROTR((a),  6), ROTR((a), 11)), ROTR((a), 25))
+#define s0(a)       XOR(XOR(ROTR((a),  7), ROTR((a), 18)), SHR((a),  3))
+#define s1(a)       XOR(XOR(ROTR((a), 17), ROTR((a), 19)), SHR((a), 10))
+
+static uint32_t const sha256_init[8] = {
+  0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL, 0xa54ff53aUL,
+  0x510e527fUL, 0x9b05688cUL, 0x1f83d9abUL, 0x5be0cd19UL,
+};
+
+/* Compresses one block per lane into the standard initial state. */
+
+static void
+sha256_blk_x4(
+    __m128i *state,              /* out - 8 chaining words per lane */
+    __m128i *w)                  /*  in - 16 message words per lane,
+                                          overwritten */
+{
+  __m128i a, b, c, d, e, f, g, h;
+  __m128i t1, t2;
+  int t;
+
+  a = SET1(sha256_init[0]);
+  b = SET1(sha256_init[1]);
+  c = SET1(sha256_init[2]);
+  d = SET1(sha256_init[3]);
+  e = SET1(sha256_init[4]);
+  f = SET1(sha256_init[5]);
+  g = SET1(sha256_init[6]);
+  h = SET1(sha256_init[7]);
+
+  for(t=0; t<64; t++)
+  {
+    if(t >= 16)
+    {
+      w[t&15] = ADD(ADD(w[t&15], s0(w[(t+1)&15])),
+                    ADD(w[(t+9)&15], s1(w[(t+14)&15])));
+    }
+
+    /* t1 = h + S1(e) + Ch(e, f, g) + K[t] + w[t] */
+    t1 = ADD(ADD(h, S1(e)), XOR(AND(e, XOR(f, g)), g));
+    t1 = ADD(t1, ADD(SET1(ntru_crypto_sha256_K[t]), w[t&15]));
+
+    /* t2 = S0(a) + Maj(a, b, c) */
+    t2 = ADD(S0(a), OR(AND(a, b), AND(c, OR(a, b))));
+
+    h = g;
+    g = f;
+    f = e;
+    e = ADD(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = ADD(t1, t2);
+  }
+
+  state[0] = ADD(a, SET1(sha256_init[0]));
+  state[1] = ADD(b, SET1(sha256_init[1]));
+  state[2] = ADD(c, SET1(sha256_init[2]));
+  state[3] = ADD(d, SET1(sha256_init[3]));
+  state[4] = ADD(e, SET1(sha256_init[4]));
+  state[5] = ADD(f, SET1(sha256_init[5]));
+  state[6] = ADD(g, SET1(sha256_init[6]));
+  state[7] = ADD(h, SET1(sha256_init[7]));
+}
+
+/* ntru_crypto_sha256_ctr_ssse3
+ *
+ * Computes SHA-256(seed || ctr + i) for i in [0, num_digests), four at a
+ * time.  The seed words, padding and length are the same in every lane;
+ * only the counter word differs.  A final group of fewer than four digests
+ * is computed in all four lanes and only the needed ones are stored.
+ */
+void
+ntru_crypto_sha256_ctr_ssse3(
+    uint8_t const *seed,            /*  in - pointer to 32-octet seed */
+    uint32_t       ctr,             /*  in - first counter value */
+    uint32_t       num_digests,     /*  in - no. of digests */
+    uint8_t       *md)              /* out - address for the digests */
+{
+  uint32_t seed_words[8];
+  uint32_t out[8][LANES];
+  uint32_t words[8];
+  __m128i w[16];
+  __m128i state[8];
+  uint32_t i;
+  uint32_t j;
+  uint32_t n;
+
+  ntru_crypto_msbyte_2_uint32(seed_words, seed, 8);
+
+  while(num_digests > 0)
+  {
+    for(i=0; i<8; i++)
+    {
+      w[i] = SET1(seed_words[i]);
+    }
+    w[8] = ADD(SET1(ctr), _mm_setr_epi32(0, 1, 2, 3));
+    w[9] = SET1(0x80000000UL);
+    for(i=10; i<15; i++)
+    {
+      w[i] = _mm_setzero_si128();
+    }
+    w[15] = SET1(36 << 3);
+
+    sha256_blk_x4(state, w);
+
+    for(i=0; i<8; i++)
+    {
+      _mm_storeu_si128((__m128i *) out[i], state[i]);
+    }
+
+    n = (num_digests < LANES) ? num_digests : LANES;
+    for(j=0; j<n; j++)
+    {
+      for(i=0; i<8; i++)
+      {
+        words[i] = out[i][j];
+      }
+      ntru_crypto_uint32_2_msbyte(md, words, 8);
+      md += 32;
+    }
+
+    ctr += n;
+    num_digests -= n;
+  }
+
+  memset(seed_words, 0, sizeof(seed_words));
+  memset(out, 0, sizeof(out));
+  memset(words, 0, sizeof(words));
+  memset(w, 0, sizeof(w));
+  memset(state, 0, sizeof(state));
+}
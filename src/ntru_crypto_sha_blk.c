@@ -0,0 +1,155 @@
+/******************************************************************************
+ * NTRU Cryptography Reference Source Code
+ * Copyright (c) 2009-2013, by Security Innovation, Inc. All rights reserved.
+ *
+ * ntru_crypto_sha_blk.c is a component of ntru-crypto.
+ *
+ * Copyright (C) 2009-2013  Security Innovation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *****************************************************************************/
+
+
+/******************************************************************************
+ *
+ * File: ntru_crypto_sha_blk.c
+ *
+ * Contents: Run-time selection of the SHA-1 and SHA-256 block compression
+ *           implementation.
+ *
+ * The portable C implementation is always built.  When the library is
+ * built for x86 with NTRU_HAVE_X86_SIMD, an implementation using the SHA
+ * extensions is built as well, and is selected when the library is loaded
+ * if the CPU supports it.
+ *
+ *****************************************************************************/
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_sha.h"
+#include "ntru_crypto_cpu.h"
+
+
+/* implementation table, indexed by NTRU_CRYPTO_SHA_BLK_IMPL_ID */
+
+static NTRU_CRYPTO_SHA_BLK_IMPL const ntru_crypto_sha_blk_impls[] = {
+    {
+        "scalar",
+        ntru_crypto_sha1_blk_scalar,
+        ntru_crypto_sha256_blk_scalar,
+    },
+#if defined(NTRU_HAVE_X86_SIMD)
+    {
+        "shani",
+        ntru_crypto_sha1_blk_shani,
+        ntru_crypto_sha256_blk_shani,
+    },
+#endif
+};
+
+#define NTRU_CRYPTO_SHA_BLK_NUM_BUILT                                         \
+    (sizeof(ntru_crypto_sha_blk_impls) / sizeof(ntru_crypto_sha_blk_impls[0]))
+
+
+/* NTRU_CPU_ flags required by each implementation, indexed by
+ * NTRU_CRYPTO_SHA_BLK_IMPL_ID
+ */
+
+static uint32_t const ntru_crypto_sha_blk_required[] = {
+    0,
+#if defined(NTRU_HAVE_X86_SIMD)
+    NTRU_CPU_SHA,
+#endif
+};
+
+
+/* the compression functions in use */
+
+static NTRU_CRYPTO_SHA_BLK_IMPL const *ntru_crypto_sha_blk_impl =
+    ntru_crypto_sha_blk_impls;
+
+
+#if defined(NTRU_HAVE_X86_SIMD)
+
+/* ntru_crypto_sha_blk_select()
+ *
+ * Uses the SHA extensions if the CPU has them.
+ */
+
+static void ntru_crypto_sha_blk_select(void) __attribute__((constructor));
+
+static void
+ntru_crypto_sha_blk_select(void)
+{
+    ntru_crypto_sha_blk_impl = ntru_crypto_sha_blk_impls +
+        ntru_crypto_cpu_best_impl(ntru_crypto_sha_blk_required,
+                                  NTRU_CRYPTO_SHA_BLK_NUM_BUILT);
+}
+
+#endif /* NTRU_HAVE_X86_SIMD */
+
+
+/* ntru_crypto_sha_blk_get_impl()
+ *
+ * Returns the implementation with the given ID, or NULL if it is not built
+ * into the library or not supported by the CPU.  Passing
+ * NTRU_CRYPTO_SHA_BLK_NUM_IMPLS returns the selected implementation.
+ */
+
+NTRU_CRYPTO_SHA_BLK_IMPL const *
+ntru_crypto_sha_blk_get_impl(
+    NTRU_CRYPTO_SHA_BLK_IMPL_ID id)     /*  in - implementation ID */
+{
+    if (id == NTRU_CRYPTO_SHA_BLK_NUM_IMPLS)
+    {
+        return ntru_crypto_sha_blk_impl;
+    }
+
+    if (((uint32_t)id >= NTRU_CRYPTO_SHA_BLK_NUM_BUILT) ||
+        !ntru_crypto_cpu_supports(ntru_crypto_sha_blk_required[id]))
+    {
+        return NULL;
+    }
+
+    return ntru_crypto_sha_blk_impls + id;
+}
+
+
+/* ntru_crypto_sha1_blk()
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_sha.h.
+ */
+
+void
+ntru_crypto_sha1_blk(
+    uint32_t const *data,       /*     in - ptr to 16 32-bit word input block */
+    uint32_t       *state)      /* in/out - ptr to 5 32-bit word chaining state */
+{
+    ntru_crypto_sha_blk_impl->sha1_blk(data, state);
+}
+
+
+/* ntru_crypto_sha256_blk()
+ *
+ * Dispatches to the selected implementation; see ntru_crypto_sha.h.
+ */
+
+void
+ntru_crypto_sha256_blk(
+    uint32_t const *data,     /*     in - ptr to 16 32-bit word input block */
+    uint32_t       *state)    /* in/out - ptr to 8 32-bit word chaining state */
+{
+    ntru_crypto_sha_blk_impl->sha256_blk(data, state);
+}
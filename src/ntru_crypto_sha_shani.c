@@ -0,0 +1,178 @@
+#include "ntru_crypto.h"
+#include "ntru_crypto_sha.h"
+#include "ntru_crypto_sha2.h"
+#include <immintrin.h>
+
+/* ntru_crypto_sha1_blk_shani
+ *
+ * Updates the SHA-1 chaining state with one 512-bit block of data given
+ * as sixteen 32-bit words, using the SHA extensions.
+ *
+ * The SHA1RNDS4 instruction keeps A, B, C, D in one register with A in the
+ * top lane, and SHA1NEXTE folds E into the top lane of the next four
+ * schedule words, so the state and message words are loaded in reverse
+ * lane order.  Four rounds are done at a time, and the schedule for the
+ * next rounds is computed alongside with SHA1MSG1, SHA1MSG2 and XOR.
+ */
+
+#define SHA1_QROUND(e_a, e_b, m0, m1, m2, m3, f)                              \
+  e_a = _mm_sha1nexte_epu32(e_a, m0);                                         \
+  e_b = abcd;                                                                 \
+  m1 = _mm_sha1msg2_epu32(m1, m0);                                            \
+  abcd = _mm_sha1rnds4_epu32(abcd, e_a, f);                                   \
+  m3 = _mm_sha1msg1_epu32(m3, m0);                                            \
+  m2 = _mm_xor_si128(m2, m0)
+
+void
+ntru_crypto_sha1_blk_shani(
+    uint32_t const *data,       /*     in - ptr to 16 32-bit word input block */
+    uint32_t       *state)      /* in/out - ptr to 5 32-bit word chaining state */
+{
+  __m128i abcd, abcd_save;
+  __m128i e0, e1, e_save;
+  __m128i m0, m1, m2, m3;
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) state), 0x1b);
+  e0 = _mm_set_epi32((int) state[4], 0, 0, 0);
+  abcd_save = abcd;
+  e_save = e0;
+
+  m0 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) data), 0x1b);
+  m1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) (data+4)), 0x1b);
+  m2 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) (data+8)), 0x1b);
+  m3 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) (data+12)), 0x1b);
+
+  /* rounds 0 - 11, which start the message schedule */
+
+  e0 = _mm_add_epi32(e0, m0);
+  e1 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+  e1 = _mm_sha1nexte_epu32(e1, m1);
+  e0 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+  m0 = _mm_sha1msg1_epu32(m0, m1);
+
+  e0 = _mm_sha1nexte_epu32(e0, m2);
+  e1 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+  m1 = _mm_sha1msg1_epu32(m1, m2);
+  m0 = _mm_xor_si128(m0, m2);
+
+  /* rounds 12 - 67 */
+
+  SHA1_QROUND(e1, e0, m3, m0, m1, m2, 0);
+  SHA1_QROUND(e0, e1, m0, m1, m2, m3, 0);
+  SHA1_QROUND(e1, e0, m1, m2, m3, m0, 1);
+  SHA1_QROUND(e0, e1, m2, m3, m0, m1, 1);
+  SHA1_QROUND(e1, e0, m3, m0, m1, m2, 1);
+  SHA1_QROUND(e0, e1, m0, m1, m2, m3, 1);
+  SHA1_QROUND(e1, e0, m1, m2, m3, m0, 1);
+  SHA1_QROUND(e0, e1, m2, m3, m0, m1, 2);
+  SHA1_QROUND(e1, e0, m3, m0, m1, m2, 2);
+  SHA1_QROUND(e0, e1, m0, m1, m2, m3, 2);
+  SHA1_QROUND(e1, e0, m1, m2, m3, m0, 2);
+  SHA1_QROUND(e0, e1, m2, m3, m0, m1, 2);
+  SHA1_QROUND(e1, e0, m3, m0, m1, m2, 3);
+  SHA1_QROUND(e0, e1, m0, m1, m2, m3, 3);
+
+  /* rounds 68 - 79, which finish the message schedule */
+
+  e1 = _mm_sha1nexte_epu32(e1, m1);
+  e0 = abcd;
+  m2 = _mm_sha1msg2_epu32(m2, m1);
+  abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+  m3 = _mm_xor_si128(m3, m1);
+
+  e0 = _mm_sha1nexte_epu32(e0, m2);
+  e1 = abcd;
+  m3 = _mm_sha1msg2_epu32(m3, m2);
+  abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+  e1 = _mm_sha1nexte_epu32(e1, m3);
+  e0 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+  /* add in the previous chaining state */
+
+  e0 = _mm_sha1nexte_epu32(e0, e_save);
+  abcd = _mm_add_epi32(abcd, abcd_save);
+
+  _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+/* ntru_crypto_sha256_blk_shani
+ *
+ * Updates the SHA-256 chaining state with one 512-bit block of data given
+ * as sixteen 32-bit words, using the SHA extensions.
+ *
+ * The SHA256RNDS2 instruction keeps the state in two registers, holding
+ * A, B, E, F and C, D, G, H, and does two rounds with the low two lanes
+ * of its message operand.  Four rounds are done at a time, and each group
+ * of four schedule words is computed with SHA256MSG1 and SHA256MSG2 from
+ * the previous four groups.
+ */
+
+#define SHA256_QROUND(w, k)                                                   \
+  msg = _mm_add_epi32(w, _mm_loadu_si128(                                     \
+          (__m128i const *) (ntru_crypto_sha256_K + (k))));                   \
+  s1 = _mm_sha256rnds2_epu32(s1, s0, msg);                                    \
+  s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0e))
+
+#define SHA256_SCHED(w0, w1, w2, w3)                                          \
+  w0 = _mm_sha256msg2_epu32(                                                  \
+         _mm_add_epi32(_mm_sha256msg1_epu32(w0, w1),                          \
+                       _mm_alignr_epi8(w3, w2, 4)), w3)
+
+void
+ntru_crypto_sha256_blk_shani(
+    uint32_t const *data,     /*     in - ptr to 16 32-bit word input block */
+    uint32_t       *state)    /* in/out - ptr to 8 32-bit word chaining state */
+{
+  __m128i s0, s1, s0_save, s1_save;
+  __m128i w0, w1, w2, w3;
+  __m128i msg, tmp;
+
+  /* ABEF and CDGH from DCBA and HGFE */
+
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) state), 0xb1);
+  s1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *) (state+4)), 0x1b);
+  s0 = _mm_alignr_epi8(tmp, s1, 8);
+  s1 = _mm_blend_epi16(s1, tmp, 0xf0);
+  s0_save = s0;
+  s1_save = s1;
+
+  w0 = _mm_loadu_si128((__m128i const *) data);
+  w1 = _mm_loadu_si128((__m128i const *) (data+4));
+  w2 = _mm_loadu_si128((__m128i const *) (data+8));
+  w3 = _mm_loadu_si128((__m128i const *) (data+12));
+
+  SHA256_QROUND(w0, 0);
+  SHA256_QROUND(w1, 4);
+  SHA256_QROUND(w2, 8);
+  SHA256_QROUND(w3, 12);
+
+  SHA256_SCHED(w0, w1, w2, w3);  SHA256_QROUND(w0, 16);
+  SHA256_SCHED(w1, w2, w3, w0);  SHA256_QROUND(w1, 20);
+  SHA256_SCHED(w2, w3, w0, w1);  SHA256_QROUND(w2, 24);
+  SHA256_SCHED(w3, w0, w1, w2);  SHA256_QROUND(w3, 28);
+  SHA256_SCHED(w0, w1, w2, w3);  SHA256_QROUND(w0, 32);
+  SHA256_SCHED(w1, w2, w3, w0);  SHA256_QROUND(w1, 36);
+  SHA256_SCHED(w2, w3, w0, w1);  SHA256_QROUND(w2, 40);
+  SHA256_SCHED(w3, w0, w1, w2);  SHA256_QROUND(w3, 44);
+  SHA256_SCHED(w0, w1, w2, w3);  SHA256_QROUND(w0, 48);
+  SHA256_SCHED(w1, w2, w3, w0);  SHA256_QROUND(w1, 52);
+  SHA256_SCHED(w2, w3, w0, w1);  SHA256_QROUND(w2, 56);
+  SHA256_SCHED(w3, w0, w1, w2);  SHA256_QROUND(w3, 60);
+
+  s0 = _mm_add_epi32(s0, s0_save);
+  s1 = _mm_add_epi32(s1, s1_save);
+
+  /* DCBA and HGFE from ABEF and CDGH */
+
+  tmp = _mm_shuffle_epi32(s0, 0x1b);
+  s1 = _mm_shuffle_epi32(s1, 0xb1);
+  _mm_storeu_si128((__m128i *) state, _mm_blend_epi16(tmp, s1, 0xf0));
+  _mm_storeu_si128((__m128i *) (state+4), _mm_alignr_epi8(s1, tmp, 8));
+}
@@ -22,5 +22,6 @@ Suite * ntruencrypt_internal_poly_suite(void);
 Suite * ntruencrypt_internal_key_suite(void);
 Suite * ntruencrypt_internal_sha_suite(void);
 Suite * ntruencrypt_internal_mgf_suite(void);
+Suite * ntruencrypt_internal_drbg_suite(void);
 
 #endif
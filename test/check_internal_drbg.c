@@ -0,0 +1,688 @@
+#include <check.h>
+#include <unistd.h>
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_aes.h"
+
+#include "test_common.h"
+#include "check_common.h"
+
+/* entropy source that delivers a fixed byte string, for known answers */
+
+static uint8_t const *kat_entropy;
+static size_t kat_entropy_len;
+static size_t kat_entropy_index;
+
+static uint8_t
+kat_get_entropy(
+    ENTROPY_CMD  cmd,
+    uint8_t     *out)
+{
+    if (cmd == INIT)
+    {
+        kat_entropy_index = 0;
+        return 1;
+    }
+
+    if (out == NULL)
+        return 0;
+
+    if (cmd == GET_NUM_BYTES_PER_BYTE_OF_ENTROPY)
+    {
+        *out = 1;
+        return 1;
+    }
+
+    if ((cmd == GET_BYTE_OF_ENTROPY) && (kat_entropy_index < kat_entropy_len))
+    {
+        *out = kat_entropy[kat_entropy_index++];
+        return 1;
+    }
+    return 0;
+}
+
+
+/* bulk entropy source that delivers the same fixed byte string */
+
+static uint32_t kat_bulk_calls;
+
+/* no. of the call that waits until kat_bulk_stall_call is cleared, standing
+ * in for a stalled entropy source, or 0 for none */
+
+static uint32_t kat_bulk_stall_call;
+
+static uint8_t
+kat_get_entropy_bulk(
+    uint8_t  *out,
+    uint32_t  num_bytes,
+    uint32_t  min_entropy_bits)
+{
+    uint32_t n;
+
+    n = __atomic_add_fetch(&kat_bulk_calls, 1, __ATOMIC_SEQ_CST);
+    while (n == __atomic_load_n(&kat_bulk_stall_call, __ATOMIC_SEQ_CST))
+    {
+        usleep(1000);
+    }
+
+    if ((min_entropy_bits > 8 * num_bytes) ||
+        (kat_entropy_index + num_bytes > kat_entropy_len))
+    {
+        return 0;
+    }
+
+    memcpy(out, kat_entropy + kat_entropy_index, num_bytes);
+    kat_entropy_index += num_bytes;
+    return 1;
+}
+
+/* waits for the helper thread of background reseeding to have called
+ * kat_get_entropy_bulk n times in all, and to have finished the last call */
+
+static void
+kat_wait_bulk_calls(
+    uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; (i < 1000) &&
+                (__atomic_load_n(&kat_bulk_calls, __ATOMIC_SEQ_CST) < n); i++)
+    {
+        usleep(1000);
+    }
+    usleep(100000);
+}
+
+START_TEST(test_aes256)
+{
+    uint32_t id;
+    uint32_t i;
+
+    NTRU_CRYPTO_AES_IMPL const *impl;
+    NTRU_CRYPTO_AES_IMPL const *ref;
+    NTRU_CRYPTO_AES256_KEY ks1;
+    NTRU_CRYPTO_AES256_KEY ks2;
+    uint8_t key[AES256_KEY_LEN];
+    uint8_t ct[AES_BLK_LEN];
+    uint8_t ctr1[AES_BLK_LEN];
+    uint8_t ctr2[AES_BLK_LEN];
+    uint8_t out1[19*AES_BLK_LEN];
+    uint8_t out2[19*AES_BLK_LEN];
+
+    /* FIPS 197, appendix C.3 */
+    uint8_t const pt[AES_BLK_LEN] =
+        "\x00\x11\x22\x33\x44\x55\x66\x77\x88\x99\xaa\xbb\xcc\xdd\xee\xff";
+    uint8_t const test[AES_BLK_LEN] =
+        "\x8e\xa2\xb7\xca\x51\x67\x45\xbf\xea\xfc\x49\x90\x4b\x49\x60\x89";
+
+    impl = ntru_crypto_aes_get_impl(NTRU_CRYPTO_AES_NUM_IMPLS);
+    ck_assert_ptr_ne(impl, NULL);
+    ref = ntru_crypto_aes_get_impl(NTRU_CRYPTO_AES_SCALAR);
+    ck_assert_ptr_ne(ref, NULL);
+    impl = ntru_crypto_aes_get_impl((NTRU_CRYPTO_AES_IMPL_ID)-1);
+    ck_assert_ptr_eq(impl, NULL);
+
+    for (id = 0; id <= NTRU_CRYPTO_AES_NUM_IMPLS; id++)
+    {
+        impl = ntru_crypto_aes_get_impl((NTRU_CRYPTO_AES_IMPL_ID)id);
+        if (impl == NULL)
+        {
+            continue;
+        }
+
+        /* known answer */
+
+        for (i = 0; i < sizeof(key); i++)
+        {
+            key[i] = (uint8_t)i;
+        }
+        impl->set_key(key, &ks1);
+        impl->encrypt(&ks1, pt, ct);
+        ck_assert_int_eq(memcmp(ct, test, sizeof(test)), 0);
+
+        /* random keys and counters, with a carry out of the low half of
+         * the counter partway through
+         */
+
+        for (i = 0; i < 10; i++)
+        {
+            randombytes(key, sizeof(key));
+            ref->set_key(key, &ks1);
+            impl->set_key(key, &ks2);
+            ck_assert_int_eq(memcmp(&ks1, &ks2, sizeof(ks1)), 0);
+
+            randombytes(ctr1, sizeof(ctr1));
+            memset(ctr1 + 8, 0xff, 7);
+            ctr1[15] = (uint8_t)(0xff - i);
+            memcpy(ctr2, ctr1, sizeof(ctr1));
+            ref->ctr(&ks1, ctr1, 9 + i, out1);
+            impl->ctr(&ks2, ctr2, 9 + i, out2);
+            ck_assert_int_eq(memcmp(out1, out2, (9 + i) * AES_BLK_LEN), 0);
+            ck_assert_int_eq(memcmp(ctr1, ctr2, sizeof(ctr1)), 0);
+
+            impl->encrypt(&ks2, ctr2, ct);
+            ck_assert_int_eq(memcmp(ct, out2 + (8 + i) * AES_BLK_LEN,
+                                    sizeof(ct)), 0);
+        }
+    }
+}
+END_TEST
+
+
+START_TEST(test_ctr_drbg_kat)
+{
+    uint32_t rc;
+    DRBG_HANDLE handle;
+    uint8_t out[64];
+
+    /* NIST CAVP CTR_DRBG AES-256 with df, no personalization string or
+     * additional input: entropy input || nonce, and the output of the
+     * second generate call
+     */
+    uint8_t const entropy1[48] =
+        "\x36\x40\x19\x40\xfa\x8b\x1f\xba\x91\xa1\x66\x1f\x21\x1d\x78\xa0"\
+        "\xb9\x38\x9a\x74\xe5\xbc\xcf\xec\xe8\xd7\x66\xaf\x1a\x6d\x3b\x14"\
+        "\x49\x6f\x25\xb0\xf1\x30\x1b\x4f\x50\x1b\xe3\x03\x80\xa1\x37\xeb";
+    uint8_t const test1[64] =
+        "\x58\x62\xeb\x38\xbd\x55\x8d\xd9\x78\xa6\x96\xe6\xdf\x16\x47\x82"\
+        "\xdd\xd8\x87\xe7\xe9\xa6\xc9\xf3\xf1\xfb\xaf\xb7\x89\x41\xb5\x35"\
+        "\xa6\x49\x12\xdf\xd2\x24\xc6\xdc\x74\x54\xe5\x25\x0b\x3d\x97\x16"\
+        "\x5e\x16\x26\x0c\x2f\xaf\x1c\xc7\x73\x5c\xb7\x5f\xb4\xf0\x7e\x1d";
+
+    /* with a personalization string, odd request sizes and a reseed, from
+     * the SP 800-90A algorithm run with AES-256 from OpenSSL
+     */
+    uint8_t entropy2[96];
+    uint8_t const pers_str[] = "NTRU CTR_DRBG";
+    uint8_t const test2a[37] =
+        "\x32\x15\x00\xd6\x3b\xf1\xd1\xd6\x16\xf6\xfa\x1d\xc7\x97\x06\x6d"\
+        "\x02\x80\x4c\xb3\x88\x1a\xcd\x1c\xa8\xec\x1f\xe8\x24\xdf\xe7\x26"\
+        "\x5e\x97\x1f\x2e\x84";
+    uint8_t const test2b[64] =
+        "\xff\xbb\x2c\xc3\x56\x26\x84\x75\xd2\x58\x1d\x60\xa5\x52\xd6\xb8"\
+        "\x86\x7c\x39\xce\x5d\x71\xa1\xf8\x39\x55\xc6\x7b\xbd\x85\xcf\x71"\
+        "\x57\x79\x5d\x0c\xec\xdd\x8e\xb6\x3c\x58\xac\xd4\xc4\xe7\xc9\xa9"\
+        "\x79\x27\xe0\x0b\xa4\x83\xbd\xc5\x70\x56\x2e\x5c\x2a\xf8\x50\x30";
+    uint8_t const test2c[40] =
+        "\xa6\xca\xd6\x13\x3f\xa3\x94\x61\xca\x5d\x2a\xda\xff\x68\x99\x4e"\
+        "\x56\x00\xd5\xc1\x87\x7a\xf8\x85\xd3\x4a\xde\x63\x3d\xdf\x2f\xe0"\
+        "\x21\xcf\x8e\x01\x22\xa8\x82\xde";
+    uint32_t i;
+
+    /* security strength 192 takes 48 bytes of entropy input and nonce */
+
+    kat_entropy = entropy1;
+    kat_entropy_len = sizeof(entropy1);
+    rc = ntru_crypto_drbg_instantiate_ex(AES256_CTR_DRBG, 192, NULL, 0,
+            (ENTROPY_FN) kat_get_entropy, &handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handle, 192, sizeof(out), out);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handle, 192, sizeof(out), out);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_int_eq(memcmp(out, test1, sizeof(test1)), 0);
+    rc = ntru_crypto_drbg_uninstantiate(handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    for (i = 0; i < sizeof(entropy2); i++)
+    {
+        entropy2[i] = (uint8_t)i;
+    }
+    kat_entropy = entropy2;
+    kat_entropy_len = sizeof(entropy2);
+    rc = ntru_crypto_drbg_instantiate_ex(AES256_CTR_DRBG, 192, pers_str,
+            sizeof(pers_str) - 1, (ENTROPY_FN) kat_get_entropy, &handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handle, 192, sizeof(test2a), out);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_int_eq(memcmp(out, test2a, sizeof(test2a)), 0);
+    rc = ntru_crypto_drbg_generate(handle, 192, sizeof(test2b), out);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_int_eq(memcmp(out, test2b, sizeof(test2b)), 0);
+    rc = ntru_crypto_drbg_reseed(handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handle, 192, sizeof(test2c), out);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_int_eq(memcmp(out, test2c, sizeof(test2c)), 0);
+
+    /* the entropy source is used up, so the next reseed fails */
+
+    rc = ntru_crypto_drbg_reseed(handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+    rc = ntru_crypto_drbg_uninstantiate(handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+}
+END_TEST
+
+START_TEST(test_drbg_pool)
+{
+    uint32_t rc;
+    uint32_t i;
+    uint32_t off;
+    uint32_t type;
+    DRBG_HANDLE handle;
+    DRBG_RESEED_POLICY policy;
+    static uint8_t entropy[192];
+    uint8_t out1[100];
+    uint8_t out2[100];
+    uint32_t const sizes[] = {10, 20, 1, 33, 36};
+
+    for (i = 0; i < sizeof(entropy); i++)
+    {
+        entropy[i] = (uint8_t)(3 * i);
+    }
+    kat_entropy = entropy;
+    kat_entropy_len = sizeof(entropy);
+
+    for (type = SHA256_HMAC_DRBG; type <= AES256_CTR_DRBG; type++)
+    {
+        /* small requests from a 50-byte pool give the output of two
+         * 50-byte generate calls
+         */
+
+        rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL, 0,
+                (ENTROPY_FN) kat_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 50, out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 50, out1 + 50);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL, 0,
+                (ENTROPY_FN) kat_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_set_pool(handle, 50);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        for (i = 0, off = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            rc = ntru_crypto_drbg_generate(handle, 192, sizes[i], out2 + off);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            off += sizes[i];
+        }
+        ck_assert_uint_eq(off, sizeof(out2));
+        ck_assert_int_eq(memcmp(out1, out2, sizeof(out1)), 0);
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* a reseed for prediction resistance, or from the reseed policy,
+         * discards the 40 bytes left in the pool after a 10-byte request
+         */
+
+        for (i = 0; i < 2; i++)
+        {
+            rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL,
+                    0, (ENTROPY_FN) kat_get_entropy, &handle);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_set_pool(handle, 50);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_generate(handle, 192, 10, out2);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            ck_assert_int_eq(memcmp(out1, out2, 10), 0);
+
+            if (i)
+            {
+                memset(&policy, 0, sizeof(policy));
+                policy.max_requests = 1;
+                rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+                ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+                rc = ntru_crypto_drbg_generate(handle, 192, 60, out2 + 10);
+            }
+            else
+            {
+                rc = ntru_crypto_drbg_generate_ex(handle, 192, TRUE, NULL, 0,
+                                                  10, out2 + 10);
+            }
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+            rc = ntru_crypto_drbg_generate(handle, 192, 40, out2 + 60);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            ck_assert_int_ne(memcmp(out1 + 10, out2 + 60, 40), 0);
+            rc = ntru_crypto_drbg_uninstantiate(handle);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_drbg_additional_input)
+{
+    uint32_t rc;
+    uint32_t i;
+    uint32_t type;
+    DRBG_HANDLE handle;
+    static uint8_t entropy[144];
+    uint8_t addl[DRBG_MAX_ADDITIONAL_INPUT_BYTES + 1];
+    uint8_t out[50];
+
+    /* generate with additional input, reseed with additional input,
+     * generate with prediction resistance and additional input, then
+     * generate with the longest additional input, from the SP 800-90A
+     * algorithms run with HMAC-SHA-256 and AES-256 from OpenSSL
+     */
+    uint8_t const t1[2][40] = {
+        {
+            "\x91\x6d\x66\x3d\x6c\x02\x8c\xee\x7f\x6b\x89\x4e\xca\x6f\x99\x9e"\
+            "\x8c\x62\xc7\x66\x27\xba\x49\x9c\x66\xe7\x23\x19\xef\x12\x01\xee"\
+            "\xfd\x5d\x4e\x25\xd5\xc0\x0b\x97"
+        },
+        {
+            "\x62\x31\x18\x78\x7b\x2c\x21\x17\x0f\x26\x0b\xf6\x51\xc2\xfd\x90"\
+            "\xad\x18\x96\x90\xd0\xee\x26\x48\x3a\x65\xd5\x5f\xc9\xbb\xea\x4a"\
+            "\xa3\x2e\x46\x65\x0d\xfc\x0d\x43"
+        }
+    };
+    uint8_t const t2[2][50] = {
+        {
+            "\xeb\x41\xd8\xfa\x61\x04\xcd\xbc\x16\x8c\x9e\x5c\x6c\xc6\xb7\x1e"\
+            "\x06\xcc\x69\xb9\xcd\x59\xf4\xa3\xb7\x34\x3b\x72\x2c\x32\x26\xb3"\
+            "\x64\x0f\x3f\xf3\xa4\x9b\x3a\x4c\x5f\x21\xd1\x5a\x5e\x6e\x8f\x9c"\
+            "\x0c\x9a"
+        },
+        {
+            "\x16\x43\xf6\x48\x91\x63\x34\xbd\xc5\x74\x76\x15\xb1\x31\x0b\x11"\
+            "\xf2\x64\xb0\x3c\x36\xd9\xc7\x5d\xf4\x15\x43\x69\x4d\x76\xb2\x0d"\
+            "\x8f\xeb\xd8\xcb\x7f\xdd\xc2\x04\xef\x4e\x09\x1b\x5a\x6b\x12\x84"\
+            "\xf9\x70"
+        }
+    };
+    uint8_t const t3[2][32] = {
+        {
+            "\xca\x8a\xe0\x67\x01\x05\xcc\x97\xfa\x2f\xe9\xc1\xd7\xb0\x41\xb0"\
+            "\x47\x56\x51\xb2\x1b\x31\x78\x19\x49\x40\xe3\xf4\x9c\xce\x97\xbd"
+        },
+        {
+            "\x4f\xf5\xc5\xb7\x94\x2c\x78\xef\x97\xe7\x4b\x6c\xb3\xbe\xfb\xdd"\
+            "\x9d\x5c\x95\xc9\xb4\xa6\x36\x7e\x2c\x6d\xd4\x7e\x8a\x9c\x9f\x6e"
+        }
+    };
+
+    for (i = 0; i < sizeof(entropy); i++)
+    {
+        entropy[i] = (uint8_t)(5 * i + 1);
+    }
+    for (i = 0; i < sizeof(addl); i++)
+    {
+        addl[i] = (uint8_t)(7 * i);
+    }
+
+    for (type = SHA256_HMAC_DRBG; type <= AES256_CTR_DRBG; type++)
+    {
+        kat_entropy = entropy;
+        kat_entropy_len = sizeof(entropy);
+        rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL, 0,
+                (ENTROPY_FN) kat_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 192, FALSE,
+                (uint8_t const *)"additional input 1", 18, 40, out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_eq(memcmp(out, t1[type - SHA256_HMAC_DRBG], 40), 0);
+
+        rc = ntru_crypto_drbg_reseed_ex(handle,
+                (uint8_t const *)"additional input 2", 18);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 192, TRUE,
+                (uint8_t const *)"additional input 3", 18, 50, out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_eq(memcmp(out, t2[type - SHA256_HMAC_DRBG], 50), 0);
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 192, FALSE, addl,
+                DRBG_MAX_ADDITIONAL_INPUT_BYTES + 1, 32, out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+        rc = ntru_crypto_drbg_generate_ex(handle, 192, FALSE, addl,
+                DRBG_MAX_ADDITIONAL_INPUT_BYTES, 32, out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_eq(memcmp(out, t3[type - SHA256_HMAC_DRBG], 32), 0);
+
+        /* the entropy source is used up, so prediction resistance fails */
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 192, TRUE, NULL, 0, 32,
+                                          out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+}
+END_TEST
+
+START_TEST(test_drbg_bulk_entropy)
+{
+    uint32_t rc;
+    uint32_t i;
+    uint32_t type;
+    DRBG_HANDLE handle;
+    static uint8_t entropy[96];
+    uint8_t out1[64];
+    uint8_t out2[64];
+
+    for (i = 0; i < sizeof(entropy); i++)
+    {
+        entropy[i] = (uint8_t)(11 * i + 3);
+    }
+    kat_entropy = entropy;
+    kat_entropy_len = sizeof(entropy);
+
+    for (type = SHA256_HMAC_DRBG; type <= AES256_CTR_DRBG; type++)
+    {
+        /* the same entropy gives the same output from either protocol */
+
+        rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL, 0,
+                (ENTROPY_FN) kat_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_reseed(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out1 + 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* with one call to the bulk source for each of the instantiation
+         * and reseed
+         */
+
+        kat_entropy_index = 0;
+        kat_bulk_calls = 0;
+        rc = ntru_crypto_drbg_instantiate_bulk((DRBG_TYPE)type, 192, NULL,
+                0, kat_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_reseed(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_uint_eq(kat_bulk_calls, 2);
+        ck_assert_int_eq(memcmp(out1, out2, sizeof(out1)), 0);
+
+        /* the bulk source is used up, so the next reseed fails */
+
+        rc = ntru_crypto_drbg_reseed(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+}
+END_TEST
+
+START_TEST(test_drbg_reseed_policy)
+{
+    uint32_t rc;
+    uint32_t i;
+    uint32_t type;
+    DRBG_HANDLE handle;
+    DRBG_RESEED_POLICY policy;
+    static uint8_t entropy[96];
+    uint8_t out1[96];
+    uint8_t out2[96];
+
+    for (i = 0; i < sizeof(entropy); i++)
+    {
+        entropy[i] = (uint8_t)(13 * i + 7);
+    }
+    kat_entropy = entropy;
+    kat_entropy_len = sizeof(entropy);
+
+    for (type = SHA256_HMAC_DRBG; type <= AES256_CTR_DRBG; type++)
+    {
+        /* three requests with a reseed before the third */
+
+        rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL, 0,
+                (ENTROPY_FN) kat_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out1 + 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_reseed(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out1 + 64);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* the same from a request budget and from a byte budget */
+
+        for (i = 0; i < 2; i++)
+        {
+            memset(&policy, 0, sizeof(policy));
+            if (i)
+            {
+                policy.max_bytes = 64;
+            }
+            else
+            {
+                policy.max_requests = 2;
+            }
+
+            rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL,
+                    0, (ENTROPY_FN) kat_get_entropy, &handle);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 32);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 64);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            ck_assert_int_eq(memcmp(out1, out2, sizeof(out1)), 0);
+
+            /* the entropy source is used up, so the next reseed fails */
+
+            rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+            rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+            rc = ntru_crypto_drbg_uninstantiate(handle);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        }
+
+        /* the same from an age limit, skipping the second request */
+
+        memset(&policy, 0, sizeof(policy));
+        policy.max_age_secs = 1;
+        rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE)type, 192, NULL, 0,
+                (ENTROPY_FN) kat_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        sleep(1);
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 64);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_eq(memcmp(out1, out2, sizeof(out1)), 0);
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* the same with the reseed's entropy input from the helper thread,
+         * which then fails to get the next one, so that the next reseed is
+         * attempted directly
+         */
+
+        memset(&policy, 0, sizeof(policy));
+        policy.max_requests = 2;
+        policy.background = TRUE;
+        kat_entropy_index = 0;
+        kat_bulk_calls = 0;
+        rc = ntru_crypto_drbg_instantiate_bulk((DRBG_TYPE)type, 192, NULL, 0,
+                kat_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        kat_wait_bulk_calls(2);
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2 + 64);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_eq(memcmp(out1, out2, sizeof(out1)), 0);
+
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        kat_wait_bulk_calls(3);
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+        ck_assert_uint_eq(kat_bulk_calls, 4);
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* a reseed put off while the helper thread waits on a stalled
+         * entropy source is done directly at twice the request budget
+         */
+
+        kat_entropy_index = 0;
+        kat_bulk_calls = 0;
+        __atomic_store_n(&kat_bulk_stall_call, 2, __ATOMIC_SEQ_CST);
+        rc = ntru_crypto_drbg_instantiate_bulk((DRBG_TYPE)type, 192, NULL, 0,
+                kat_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        kat_wait_bulk_calls(2);
+        for (i = 0; i < 4; i++)
+        {
+            rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        }
+        ck_assert_uint_eq(__atomic_load_n(&kat_bulk_calls, __ATOMIC_SEQ_CST),
+                          2);
+        rc = ntru_crypto_drbg_generate(handle, 192, 32, out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_uint_eq(__atomic_load_n(&kat_bulk_calls, __ATOMIC_SEQ_CST),
+                          3);
+        __atomic_store_n(&kat_bulk_stall_call, 0, __ATOMIC_SEQ_CST);
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+}
+END_TEST
+
+Suite *
+ntruencrypt_internal_drbg_suite(void)
+{
+    Suite *s;
+    TCase *tc_drbg;
+
+    s = suite_create("NTRUEncrypt.Internal.DRBG");
+
+    tc_drbg = tcase_create("DRBG");
+    suite_add_tcase(s, tc_drbg);
+
+    tcase_add_test(tc_drbg, test_aes256);
+    tcase_add_test(tc_drbg, test_ctr_drbg_kat);
+    tcase_add_test(tc_drbg, test_drbg_pool);
+    tcase_add_test(tc_drbg, test_drbg_additional_input);
+    tcase_add_test(tc_drbg, test_drbg_bulk_entropy);
+    tcase_add_test(tc_drbg, test_drbg_reseed_policy);
+
+    return s;
+}
@@ -1,6 +1,8 @@
 #include <check.h>
 
 #include "ntru_crypto.h"
+#include "ntru_crypto_cpu.h"
+#include "ntru_crypto_ntru_convert.h"
 #include "ntru_crypto_ntru_encrypt_param_sets.h"
 #include "ntru_crypto_ntru_mgf1.h"
 #include "ntru_crypto_ntru_poly.h"
@@ -136,6 +138,22 @@ START_TEST(test_gen_poly)
     ck_assert_int_eq(
             memcmp(F_buf_1_p, F_buf_2_p, num_indices*sizeof(uint16_t)), 0);
 
+    /* Check that we get the same polynomial from a prehashed seed */
+    rc = ntru_crypto_hash_digest(hash_algid, seed_buf_p, seed_len, mgf_buf_p);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HASH_OK);
+    memset(mgf_buf_p + md_len, 0, 4);
+    memset(F_buf_2_p, 0, num_indices*sizeof(uint16_t));
+    rc = ntru_gen_poly(hash_algid, md_len,
+                       params->min_IGF_hash_calls,
+                       0, NULL, mgf_buf_p,
+                       params->N, params->c_bits,
+                       params->no_bias_limit,
+                       params->is_product_form,
+                       params->dF_r << 1, F_buf_2_p);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_int_eq(
+            memcmp(F_buf_1_p, F_buf_2_p, num_indices*sizeof(uint16_t)), 0);
+
     /* Check some failure cases */
     /* Trigger an mgf failure with an unknown hash_algid */
     rc = ntru_gen_poly(-1, md_len,
@@ -290,10 +308,68 @@ START_TEST(test_lift_inv_mod_pow2)
 END_TEST
 
 
+/* test_mult_impl
+ *
+ * Checks that an implementation is selected and that the scalar one is
+ * always available.
+ */
+START_TEST(test_mult_impl)
+{
+    NTRU_RING_MULT_IMPL const *impl;
+
+    impl = ntru_ring_mult_get_impl(NTRU_RING_MULT_NUM_IMPLS);
+    ck_assert_ptr_ne(impl, NULL);
+    ck_assert_ptr_ne(impl->mult_indices, NULL);
+    ck_assert_ptr_ne(impl->mult_product_indices, NULL);
+    ck_assert_ptr_ne(impl->mult_coefficients, NULL);
+
+    impl = ntru_ring_mult_get_impl(NTRU_RING_MULT_SCALAR);
+    ck_assert_ptr_ne(impl, NULL);
+
+    impl = ntru_ring_mult_get_impl((NTRU_RING_MULT_IMPL_ID)-1);
+    ck_assert_ptr_eq(impl, NULL);
+}
+END_TEST
+
+
+/* test_cpu_best_impl
+ *
+ * Checks that the shared selection skips implementations whose features
+ * the CPU lacks and falls back to the portable one.
+ */
+START_TEST(test_cpu_best_impl)
+{
+    uint32_t features;
+    uint32_t required[3];
+
+    features = ntru_crypto_cpu_features();
+    ck_assert_uint_eq(ntru_crypto_cpu_features(), features);
+    ck_assert(ntru_crypto_cpu_supports(0));
+    ck_assert(ntru_crypto_cpu_supports(features));
+
+    /* no CPU reports a feature flag that is not defined */
+
+    required[0] = 0;
+    required[1] = features;
+    required[2] = 0x40000000;
+    ck_assert(!ntru_crypto_cpu_supports(required[2]));
+    ck_assert_uint_eq(ntru_crypto_cpu_best_impl(required, 3), 1);
+    ck_assert_uint_eq(ntru_crypto_cpu_best_impl(required, 2), 1);
+    ck_assert_uint_eq(ntru_crypto_cpu_best_impl(required, 1), 0);
+
+    required[1] = 0x40000000;
+    ck_assert_uint_eq(ntru_crypto_cpu_best_impl(required, 3), 0);
+}
+END_TEST
+
+
 /* test_mult_indices
  *
  * Performs both ntru_ring_mult_indices and ntru_ring_mult_product_indices
  * and compares the result with a fixed example generated with Pari/GP.
+ *
+ * This is a loop test over the ring multiplication implementations; those
+ * not available on this build or CPU are skipped.
  */
 START_TEST(test_mult_indices)
 {
@@ -322,7 +398,15 @@ START_TEST(test_mult_indices)
 
     uint16_t scratch_polys;
     uint16_t pad_deg;
-    ntru_ring_mult_indices_memreq(N, &scratch_polys, &pad_deg);
+
+    NTRU_RING_MULT_IMPL const *impl;
+    impl = ntru_ring_mult_get_impl((NTRU_RING_MULT_IMPL_ID)_i);
+    if(impl == NULL)
+    {
+        return;
+    }
+
+    impl->mult_indices_memreq(N, &scratch_polys, &pad_deg);
     ck_assert_uint_ge(scratch_polys, 1);
     ck_assert_uint_ge(pad_deg, N);
 
@@ -339,7 +423,7 @@ START_TEST(test_mult_indices)
     randombytes(out.ptr, out.len);
 
     /* Test a single mult_indices first */
-    ntru_ring_mult_indices(pol1_p, b1l, b1l, bi, N, q, t_p, out_p);
+    impl->mult_indices(pol1_p, b1l, b1l, bi, N, q, t_p, out_p);
     /* Check result */
     for(i=0; i<N; i++)
     {
@@ -360,7 +444,7 @@ START_TEST(test_mult_indices)
     randombytes(out.ptr, out.len);
 
     /* Multiply */
-    ntru_ring_mult_product_indices(pol1_p, b1l, b2l, b3l, bi, N, q, t_p, out_p);
+    impl->mult_product_indices(pol1_p, b1l, b2l, b3l, bi, N, q, t_p, out_p);
 
     /* Check result */
     for(i=0; i<N; i++)
@@ -400,7 +484,15 @@ START_TEST(test_mult_coefficients)
     /* Determine proper padding for our mult implementation */
     uint16_t num_polys;
     uint16_t num_coeffs;
-    ntru_ring_mult_coefficients_memreq(N, &num_polys, &num_coeffs);
+
+    NTRU_RING_MULT_IMPL const *impl;
+    impl = ntru_ring_mult_get_impl((NTRU_RING_MULT_IMPL_ID)_i);
+    if(impl == NULL)
+    {
+        return;
+    }
+
+    impl->mult_coefficients_memreq(N, &num_polys, &num_coeffs);
 
     /* Allocate memory */
     NTRU_CK_MEM pol1;
@@ -430,7 +522,7 @@ START_TEST(test_mult_coefficients)
     randombytes(out.ptr, out.len);
 
     /* Multiply */
-    ntru_ring_mult_coefficients(a_p, b_p, N, q, tmp_p, out_p);
+    impl->mult_coefficients(a_p, b_p, N, q, tmp_p, out_p);
 
     /* Check result */
     for(i=0; i<N; i++)
@@ -456,6 +548,759 @@ START_TEST(test_mult_coefficients)
 END_TEST
 
 
+/* Compare each implementation against the scalar one at the degree of
+ * each parameter set, with its q and with q = 2^16 */
+START_TEST(test_mult_coefficients_param_sets)
+{
+    uint32_t i;
+    uint32_t id;
+    uint32_t k;
+
+    uint16_t N;
+    uint16_t q;
+    uint16_t num_polys;
+    uint16_t num_coeffs;
+
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    NTRU_RING_MULT_IMPL const *ref;
+    NTRU_RING_MULT_IMPL const *impl;
+
+    NTRU_CK_MEM pol1;
+    NTRU_CK_MEM pol2;
+    NTRU_CK_MEM tmp;
+    NTRU_CK_MEM out;
+    NTRU_CK_MEM expect;
+
+    uint16_t *a_p;
+    uint16_t *b_p;
+    uint16_t *tmp_p;
+    uint16_t *out_p;
+    uint16_t *expect_p;
+
+    params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[_i]);
+    ck_assert_ptr_ne(params, NULL);
+    N = params->N;
+
+    ref = ntru_ring_mult_get_impl(NTRU_RING_MULT_SCALAR);
+    ck_assert_ptr_ne(ref, NULL);
+
+    for(id=0; id<NTRU_RING_MULT_NUM_IMPLS; id++)
+    {
+        impl = ntru_ring_mult_get_impl((NTRU_RING_MULT_IMPL_ID)id);
+        if(impl == NULL)
+        {
+            continue;
+        }
+
+        for(k=0; k<2; k++)
+        {
+            q = k ? params->q : 0;
+
+            /* Expected result from the scalar implementation */
+            ref->mult_coefficients_memreq(N, &num_polys, &num_coeffs);
+            a_p = (uint16_t*)ntru_ck_malloc(&pol1,
+                    num_coeffs*sizeof(uint16_t));
+            b_p = (uint16_t*)ntru_ck_malloc(&pol2,
+                    num_coeffs*sizeof(uint16_t));
+            tmp_p = (uint16_t*)ntru_ck_malloc(&tmp,
+                    num_polys*num_coeffs*sizeof(uint16_t));
+            expect_p = (uint16_t*)ntru_ck_malloc(&expect,
+                    num_coeffs*sizeof(uint16_t));
+
+            randombytes(pol1.ptr, N*sizeof(uint16_t));
+            randombytes(pol2.ptr, N*sizeof(uint16_t));
+            memset(a_p+N, 0, (num_coeffs-N)*sizeof(uint16_t));
+            memset(b_p+N, 0, (num_coeffs-N)*sizeof(uint16_t));
+
+            ref->mult_coefficients(a_p, b_p, N, q, tmp_p, expect_p);
+            ntru_ck_mem_free(&tmp);
+
+            /* Same inputs through the implementation under test */
+            impl->mult_coefficients_memreq(N, &num_polys, &num_coeffs);
+            tmp_p = (uint16_t*)ntru_ck_malloc(&tmp,
+                    num_polys*num_coeffs*sizeof(uint16_t));
+            out_p = (uint16_t*)ntru_ck_malloc(&out,
+                    num_coeffs*sizeof(uint16_t));
+            randombytes(tmp.ptr, tmp.len);
+            randombytes(out.ptr, out.len);
+
+            impl->mult_coefficients(a_p, b_p, N, q, tmp_p, out_p);
+
+            for(i=0; i<N; i++)
+            {
+                ck_assert_uint_eq(out_p[i], expect_p[i]);
+            } /* Padding should be zero */
+            for(; i<num_coeffs; i++)
+            {
+                ck_assert_uint_eq(out_p[i], 0);
+            }
+
+            ntru_ck_mem_ok(&pol1);
+            ntru_ck_mem_ok(&pol2);
+            ntru_ck_mem_ok(&tmp);
+            ntru_ck_mem_ok(&out);
+            ntru_ck_mem_ok(&expect);
+
+            ntru_ck_mem_free(&pol1);
+            ntru_ck_mem_free(&pol2);
+            ntru_ck_mem_free(&tmp);
+            ntru_ck_mem_free(&out);
+            ntru_ck_mem_free(&expect);
+        }
+    }
+}
+END_TEST
+
+
+/* Compare each implementation's product form multiplication against the
+ * scalar one at the degree of each parameter set, with its q and with
+ * q = 2^16.  Sets not in product form use 8 indices of each sign for each
+ * factor. */
+START_TEST(test_mult_product_indices_param_sets)
+{
+    uint32_t i;
+    uint32_t id;
+    uint32_t k;
+
+    uint16_t N;
+    uint16_t q;
+    uint16_t b1l;
+    uint16_t b2l;
+    uint16_t b3l;
+    uint16_t num_polys;
+    uint16_t num_coeffs;
+
+    NTRU_ENCRYPT_PARAM_SET *params = NULL;
+    NTRU_RING_MULT_IMPL const *ref;
+    NTRU_RING_MULT_IMPL const *impl;
+
+    NTRU_CK_MEM pol1;
+    NTRU_CK_MEM bi;
+    NTRU_CK_MEM tmp;
+    NTRU_CK_MEM out;
+    NTRU_CK_MEM expect;
+
+    uint16_t *a_p;
+    uint16_t *bi_p;
+    uint16_t *tmp_p;
+    uint16_t *out_p;
+    uint16_t *expect_p;
+
+    params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[_i]);
+    ck_assert_ptr_ne(params, NULL);
+    N = params->N;
+
+    if(params->is_product_form)
+    {
+        b1l = (uint16_t)(params->dF_r & 0xff);
+        b2l = (uint16_t)((params->dF_r >> 8) & 0xff);
+        b3l = (uint16_t)((params->dF_r >> 16) & 0xff);
+    }
+    else
+    {
+        b1l = b2l = b3l = 8;
+    }
+
+    ref = ntru_ring_mult_get_impl(NTRU_RING_MULT_SCALAR);
+    ck_assert_ptr_ne(ref, NULL);
+
+    bi_p = (uint16_t*)ntru_ck_malloc(&bi,
+            2*(b1l+b2l+b3l)*sizeof(uint16_t));
+
+    for(id=0; id<NTRU_RING_MULT_NUM_IMPLS; id++)
+    {
+        impl = ntru_ring_mult_get_impl((NTRU_RING_MULT_IMPL_ID)id);
+        if(impl == NULL)
+        {
+            continue;
+        }
+
+        for(k=0; k<2; k++)
+        {
+            q = k ? params->q : 0;
+
+            randombytes(bi.ptr, bi.len);
+            for(i=0; i<2*(b1l+b2l+b3l); i++)
+            {
+                bi_p[i] %= N;
+            }
+
+            /* Expected result from the scalar implementation */
+            ref->mult_indices_memreq(N, &num_polys, &num_coeffs);
+            a_p = (uint16_t*)ntru_ck_malloc(&pol1,
+                    num_coeffs*sizeof(uint16_t));
+            tmp_p = (uint16_t*)ntru_ck_malloc(&tmp,
+                    (num_polys+1)*num_coeffs*sizeof(uint16_t));
+            expect_p = (uint16_t*)ntru_ck_malloc(&expect,
+                    num_coeffs*sizeof(uint16_t));
+
+            randombytes(pol1.ptr, pol1.len);
+
+            ref->mult_product_indices(a_p, b1l, b2l, b3l, bi_p, N, q, tmp_p,
+                                      expect_p);
+            ntru_ck_mem_free(&tmp);
+
+            /* Same inputs through the implementation under test */
+            impl->mult_indices_memreq(N, &num_polys, &num_coeffs);
+            tmp_p = (uint16_t*)ntru_ck_malloc(&tmp,
+                    (num_polys+1)*num_coeffs*sizeof(uint16_t));
+            out_p = (uint16_t*)ntru_ck_malloc(&out,
+                    num_coeffs*sizeof(uint16_t));
+            randombytes(tmp.ptr, tmp.len);
+            randombytes(out.ptr, out.len);
+
+            impl->mult_product_indices(a_p, b1l, b2l, b3l, bi_p, N, q, tmp_p,
+                                       out_p);
+
+            for(i=0; i<N; i++)
+            {
+                ck_assert_uint_eq(out_p[i], expect_p[i]);
+            } /* Padding should be zero */
+            for(; i<num_coeffs; i++)
+            {
+                ck_assert_uint_eq(out_p[i], 0);
+            }
+
+            ntru_ck_mem_ok(&pol1);
+            ntru_ck_mem_ok(&bi);
+            ntru_ck_mem_ok(&tmp);
+            ntru_ck_mem_ok(&out);
+            ntru_ck_mem_ok(&expect);
+
+            ntru_ck_mem_free(&pol1);
+            ntru_ck_mem_free(&tmp);
+            ntru_ck_mem_free(&out);
+            ntru_ck_mem_free(&expect);
+        }
+    }
+
+    ntru_ck_mem_free(&bi);
+}
+END_TEST
+
+
+/* test_convert_pack
+ *
+ * Packs random elements and unpacks random octets with a packing
+ * implementation and compares the results with the scalar implementation,
+ * for each element size and a range of lengths, including the ring
+ * dimensions of the parameter sets.  The output buffers are exactly the
+ * size of the result, so that overruns are detected.
+ *
+ * This is a loop test over the packing implementations; those not
+ * available on this build or CPU are skipped.
+ */
+START_TEST(test_convert_pack)
+{
+    uint16_t lens[64 + NUM_PARAM_SETS];
+    uint16_t num_lens = 0;
+    uint16_t len;
+    uint16_t num_octets;
+    uint16_t num_elements;
+    uint8_t n_bits;
+    uint32_t i;
+    uint32_t j;
+
+    NTRU_CK_MEM elements;
+    NTRU_CK_MEM octets;
+    NTRU_CK_MEM out;
+    NTRU_CK_MEM expect;
+
+    NTRU_ENCRYPT_PARAM_SET *params;
+    NTRU_CONVERT_IMPL const *impl;
+    NTRU_CONVERT_IMPL const *ref;
+
+    impl = ntru_convert_get_impl((NTRU_CONVERT_IMPL_ID)_i);
+    if(impl == NULL)
+    {
+        return;
+    }
+
+    ref = ntru_convert_get_impl(NTRU_CONVERT_SCALAR);
+    ck_assert_ptr_ne(ref, NULL);
+    ck_assert_ptr_ne(ntru_convert_get_impl(NTRU_CONVERT_NUM_IMPLS), NULL);
+    ck_assert_ptr_eq(ntru_convert_get_impl((NTRU_CONVERT_IMPL_ID)-1), NULL);
+
+    for(i=0; i<64; i++)
+    {
+        lens[num_lens++] = (uint16_t)i;
+    }
+    for(i=0; i<NUM_PARAM_SETS; i++)
+    {
+        params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[i]);
+        lens[num_lens++] = params->N;
+    }
+
+    for(n_bits=9; n_bits<16; n_bits++)
+    {
+        for(i=0; i<num_lens; i++)
+        {
+            len = lens[i];
+
+            /* pack len elements */
+            num_octets = (uint16_t)((len * n_bits + 7) >> 3);
+
+            ntru_ck_malloc(&elements, (len+1)*sizeof(uint16_t));
+            ntru_ck_malloc(&out, num_octets);
+            ntru_ck_malloc(&expect, num_octets);
+
+            randombytes(elements.ptr, elements.len);
+            for(j=0; j<len; j++)
+            {
+                ((uint16_t *)elements.ptr)[j] &= (1 << n_bits) - 1;
+            }
+
+            impl->elements_2_octets(len, (uint16_t *)elements.ptr, n_bits,
+                                    out.ptr);
+            ref->elements_2_octets(len, (uint16_t *)elements.ptr, n_bits,
+                                   expect.ptr);
+            ck_assert_int_eq(memcmp(out.ptr, expect.ptr, num_octets), 0);
+
+            ntru_ck_mem_ok(&out);
+            ntru_ck_mem_ok(&expect);
+
+            ntru_ck_mem_free(&elements);
+            ntru_ck_mem_free(&out);
+            ntru_ck_mem_free(&expect);
+
+            /* unpack len octets */
+            num_elements = (uint16_t)((len * 8) / n_bits);
+
+            ntru_ck_malloc(&octets, len+1);
+            ntru_ck_malloc(&out, num_elements*sizeof(uint16_t));
+            ntru_ck_malloc(&expect, num_elements*sizeof(uint16_t));
+
+            randombytes(octets.ptr, octets.len);
+
+            impl->octets_2_elements(len, octets.ptr, n_bits,
+                                    (uint16_t *)out.ptr);
+            ref->octets_2_elements(len, octets.ptr, n_bits,
+                                   (uint16_t *)expect.ptr);
+            ck_assert_int_eq(memcmp(out.ptr, expect.ptr, out.len), 0);
+
+            ntru_ck_mem_ok(&octets);
+            ntru_ck_mem_ok(&out);
+            ntru_ck_mem_ok(&expect);
+
+            ntru_ck_mem_free(&octets);
+            ntru_ck_mem_free(&out);
+            ntru_ck_mem_free(&expect);
+        }
+    }
+}
+END_TEST
+
+
+/* test_convert_trits
+ *
+ * Checks that an implementation converts between bits and trits as the
+ * scalar implementation does, for lengths around the group and vector
+ * sizes and for each parameter set's N.  Trits are converted to bits with
+ * and without an invalid trit pair, and bits are also converted to trits
+ * with the octets at the end of the trit array, as during encryption.
+ *
+ * This is a loop test over the conversion implementations; those not
+ * available on this build or CPU are skipped.
+ */
+START_TEST(test_convert_trits)
+{
+    uint16_t lens[200 + NUM_PARAM_SETS];
+    uint16_t num_lens = 0;
+    uint16_t len;
+    uint16_t num_octets;
+    uint16_t skip;
+    uint32_t i;
+    uint32_t j;
+    bool valid;
+
+    NTRU_CK_MEM trits;
+    NTRU_CK_MEM octets;
+    NTRU_CK_MEM out;
+    NTRU_CK_MEM expect;
+
+    NTRU_ENCRYPT_PARAM_SET *params;
+    NTRU_CONVERT_IMPL const *impl;
+    NTRU_CONVERT_IMPL const *ref;
+
+    impl = ntru_convert_get_impl((NTRU_CONVERT_IMPL_ID)_i);
+    if(impl == NULL)
+    {
+        return;
+    }
+
+    ref = ntru_convert_get_impl(NTRU_CONVERT_SCALAR);
+    ck_assert_ptr_ne(ref, NULL);
+
+    for(i=0; i<200; i++)
+    {
+        lens[num_lens++] = (uint16_t)i;
+    }
+    for(i=0; i<NUM_PARAM_SETS; i++)
+    {
+        params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[i]);
+        lens[num_lens++] = params->N;
+    }
+
+    for(i=0; i<num_lens; i++)
+    {
+        len = lens[i];
+
+        /* bits to len trits */
+        num_octets = (uint16_t)(((len + 15) / 16) * 3);
+
+        ntru_ck_malloc(&octets, num_octets);
+        ntru_ck_malloc(&out, len);
+        ntru_ck_malloc(&expect, len);
+
+        randombytes(octets.ptr, octets.len);
+
+        impl->bits_2_trits(octets.ptr, len, out.ptr);
+        ref->bits_2_trits(octets.ptr, len, expect.ptr);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, len), 0);
+
+        ntru_ck_mem_ok(&octets);
+        ntru_ck_mem_ok(&out);
+        ntru_ck_mem_ok(&expect);
+
+        ntru_ck_mem_free(&octets);
+        ntru_ck_mem_free(&out);
+        ntru_ck_mem_free(&expect);
+
+        /* len trits to bits, then with an invalid pair */
+        num_octets = (uint16_t)((len / 16 + 1) * 3);
+
+        ntru_ck_malloc(&trits, len);
+        ntru_ck_malloc(&out, num_octets);
+        ntru_ck_malloc(&expect, num_octets);
+
+        randombytes(trits.ptr, trits.len);
+        for(j=0; j<len; j++)
+        {
+            trits.ptr[j] %= 3;
+            if((j & 1) && (trits.ptr[j - 1] == 2) && (trits.ptr[j] == 2))
+            {
+                trits.ptr[j] = 1;
+            }
+        }
+
+        valid = impl->trits_2_bits(trits.ptr, len, out.ptr);
+        ck_assert(valid);
+        valid = ref->trits_2_bits(trits.ptr, len, expect.ptr);
+        ck_assert(valid);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, num_octets), 0);
+
+        if(len >= 2)
+        {
+            j = (uint32_t)(trits.ptr[0] % (len >> 1)) << 1;
+            trits.ptr[j] = 2;
+            trits.ptr[j + 1] = 2;
+
+            valid = impl->trits_2_bits(trits.ptr, len, out.ptr);
+            ck_assert(!valid);
+            valid = ref->trits_2_bits(trits.ptr, len, expect.ptr);
+            ck_assert(!valid);
+            ck_assert_int_eq(memcmp(out.ptr, expect.ptr, num_octets), 0);
+        }
+
+        ntru_ck_mem_ok(&trits);
+        ntru_ck_mem_ok(&out);
+        ntru_ck_mem_ok(&expect);
+
+        ntru_ck_mem_free(&trits);
+        ntru_ck_mem_free(&out);
+        ntru_ck_mem_free(&expect);
+    }
+
+    /* bits to trits in place, laid out as in ntru_encrypt_core */
+    for(i=0; i<NUM_PARAM_SETS; i++)
+    {
+        params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[i]);
+        len = params->N;
+        skip = (uint16_t)(len - (params->b_len + params->m_len_len +
+                                 params->m_len_max + 2));
+
+        ntru_ck_malloc(&out, 2 * len);
+        ntru_ck_malloc(&expect, 2 * len);
+
+        randombytes(out.ptr, out.len);
+        memcpy(expect.ptr, out.ptr, out.len);
+
+        impl->bits_2_trits(out.ptr + skip, len, out.ptr);
+        ref->bits_2_trits(expect.ptr + skip, len, expect.ptr);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, out.len), 0);
+
+        ntru_ck_mem_ok(&out);
+        ntru_ck_mem_ok(&expect);
+
+        ntru_ck_mem_free(&out);
+        ntru_ck_mem_free(&expect);
+    }
+}
+END_TEST
+
+
+/* test_msg_rep_add
+ *
+ * Checks that an implementation forms m' = mask + Mtrin (mod 3), adds it
+ * to R mod q and checks its weight as the separate passes it replaces do,
+ * for lengths around the vector sizes and for each parameter set's N,
+ * with minimum weights that m' just meets and just fails.
+ *
+ * This is a loop test over the message representative implementations;
+ * those not available on this build or CPU are skipped.
+ */
+START_TEST(test_msg_rep_add)
+{
+    uint16_t lens[80 + NUM_PARAM_SETS];
+    uint16_t num_lens = 0;
+    uint16_t len;
+    uint16_t q = 2048;
+    uint16_t min_wt;
+    uint16_t wt[3];
+    uint32_t i;
+    uint32_t j;
+    uint8_t m;
+    bool good;
+
+    NTRU_CK_MEM mask;
+    NTRU_CK_MEM trits;
+    NTRU_CK_MEM ringels;
+    NTRU_CK_MEM out;
+    NTRU_CK_MEM expect;
+
+    NTRU_ENCRYPT_PARAM_SET *params;
+    NTRU_MSG_REP_IMPL const *impl;
+
+    impl = ntru_msg_rep_get_impl((NTRU_MSG_REP_IMPL_ID)_i);
+    if(impl == NULL)
+    {
+        return;
+    }
+
+    ck_assert_ptr_ne(ntru_msg_rep_get_impl(NTRU_MSG_REP_SCALAR), NULL);
+    ck_assert_ptr_ne(ntru_msg_rep_get_impl(NTRU_MSG_REP_NUM_IMPLS), NULL);
+    ck_assert_ptr_eq(ntru_msg_rep_get_impl((NTRU_MSG_REP_IMPL_ID)-1), NULL);
+
+    for(i=0; i<80; i++)
+    {
+        lens[num_lens++] = (uint16_t)i;
+    }
+    for(i=0; i<NUM_PARAM_SETS; i++)
+    {
+        params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[i]);
+        lens[num_lens++] = params->N;
+    }
+
+    for(i=0; i<num_lens; i++)
+    {
+        len = lens[i];
+
+        ntru_ck_malloc(&mask, len);
+        ntru_ck_malloc(&trits, len);
+        ntru_ck_malloc(&ringels, len*sizeof(uint16_t));
+        ntru_ck_malloc(&out, len*sizeof(uint16_t));
+        ntru_ck_malloc(&expect, len*sizeof(uint16_t));
+
+        randombytes(mask.ptr, mask.len);
+        randombytes(trits.ptr, trits.len);
+        randombytes(ringels.ptr, ringels.len);
+
+        /* form the expected result as the separate passes did */
+        wt[0] = wt[1] = wt[2] = 0;
+        for(j=0; j<len; j++)
+        {
+            mask.ptr[j] %= 3;
+            trits.ptr[j] %= 3;
+            ((uint16_t *)ringels.ptr)[j] &= q - 1;
+
+            m = (uint8_t)((mask.ptr[j] + trits.ptr[j]) % 3);
+            wt[m]++;
+            ((uint16_t *)expect.ptr)[j] = ((uint16_t *)ringels.ptr)[j];
+            if(m == 1)
+            {
+                ((uint16_t *)expect.ptr)[j] += 1;
+            }
+            else if(m == 2)
+            {
+                ((uint16_t *)expect.ptr)[j] -= 1;
+            }
+            ((uint16_t *)expect.ptr)[j] &= q - 1;
+        }
+
+        min_wt = wt[0];
+        if(wt[1] < min_wt) min_wt = wt[1];
+        if(wt[2] < min_wt) min_wt = wt[2];
+
+        memcpy(out.ptr, ringels.ptr, out.len);
+        good = impl->add_msg_rep(len, mask.ptr, trits.ptr, min_wt, q,
+                                 (uint16_t *)out.ptr);
+        ck_assert(good);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, out.len), 0);
+
+        memcpy(out.ptr, ringels.ptr, out.len);
+        good = impl->add_msg_rep(len, mask.ptr, trits.ptr, min_wt + 1, q,
+                                 (uint16_t *)out.ptr);
+        ck_assert(!good);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, out.len), 0);
+
+        ntru_ck_mem_ok(&mask);
+        ntru_ck_mem_ok(&trits);
+        ntru_ck_mem_ok(&ringels);
+        ntru_ck_mem_ok(&out);
+        ntru_ck_mem_ok(&expect);
+
+        ntru_ck_mem_free(&mask);
+        ntru_ck_mem_free(&trits);
+        ntru_ck_mem_free(&ringels);
+        ntru_ck_mem_free(&out);
+        ntru_ck_mem_free(&expect);
+    }
+}
+END_TEST
+
+
+/* test_msg_rep_recover
+ *
+ * Checks that an implementation recovers cm' from e and F * e, forms cR
+ * and checks the weight of cm' as the separate passes it replaces do, and
+ * that it unmasks cm', for lengths around the vector sizes and for each
+ * parameter set's N.  cm' is recovered both into its own buffer and over
+ * the start of F * e, as during decryption.
+ *
+ * This is a loop test over the message representative implementations;
+ * those not available on this build or CPU are skipped.
+ */
+START_TEST(test_msg_rep_recover)
+{
+    uint16_t lens[80 + NUM_PARAM_SETS];
+    uint16_t num_lens = 0;
+    uint16_t len;
+    uint16_t q = 2048;
+    uint16_t min_wt;
+    uint16_t wt[3];
+    uint32_t i;
+    uint32_t j;
+    int32_t a;
+    uint8_t m;
+    bool good;
+
+    NTRU_CK_MEM Fe;
+    NTRU_CK_MEM ringels;
+    NTRU_CK_MEM mask;
+    NTRU_CK_MEM in_place;
+    NTRU_CK_MEM trits;
+    NTRU_CK_MEM out;
+    NTRU_CK_MEM expect_trits;
+    NTRU_CK_MEM expect;
+
+    NTRU_ENCRYPT_PARAM_SET *params;
+    NTRU_MSG_REP_IMPL const *impl;
+
+    impl = ntru_msg_rep_get_impl((NTRU_MSG_REP_IMPL_ID)_i);
+    if(impl == NULL)
+    {
+        return;
+    }
+
+    for(i=0; i<80; i++)
+    {
+        lens[num_lens++] = (uint16_t)i;
+    }
+    for(i=0; i<NUM_PARAM_SETS; i++)
+    {
+        params = ntru_encrypt_get_params_with_id(PARAM_SET_IDS[i]);
+        lens[num_lens++] = params->N;
+    }
+
+    for(i=0; i<num_lens; i++)
+    {
+        len = lens[i];
+
+        ntru_ck_malloc(&Fe, len*sizeof(uint16_t));
+        ntru_ck_malloc(&ringels, len*sizeof(uint16_t));
+        ntru_ck_malloc(&mask, len);
+        ntru_ck_malloc(&in_place, len*sizeof(uint16_t));
+        ntru_ck_malloc(&trits, len);
+        ntru_ck_malloc(&out, len*sizeof(uint16_t));
+        ntru_ck_malloc(&expect_trits, len);
+        ntru_ck_malloc(&expect, len*sizeof(uint16_t));
+
+        randombytes(Fe.ptr, Fe.len);
+        randombytes(ringels.ptr, ringels.len);
+        randombytes(mask.ptr, mask.len);
+
+        /* form the expected result with a signed lift and % 3 */
+        wt[0] = wt[1] = wt[2] = 0;
+        for(j=0; j<len; j++)
+        {
+            ((uint16_t *)ringels.ptr)[j] &= q - 1;
+
+            a = (((uint16_t *)ringels.ptr)[j] +
+                 3 * ((uint16_t *)Fe.ptr)[j]) & (q - 1);
+            if(a >= q/2)
+            {
+                a -= q;
+            }
+            m = (uint8_t)(((a % 3) + 3) % 3);
+            wt[m]++;
+            expect_trits.ptr[j] = m;
+            ((uint16_t *)expect.ptr)[j] = (((uint16_t *)ringels.ptr)[j] -
+                                           (m == 1) + (m == 2)) & (q - 1);
+        }
+
+        min_wt = wt[0];
+        if(wt[1] < min_wt) min_wt = wt[1];
+        if(wt[2] < min_wt) min_wt = wt[2];
+
+        memcpy(out.ptr, ringels.ptr, out.len);
+        good = impl->recover_msg_rep(len, (uint16_t *)Fe.ptr, min_wt, q,
+                                     (uint16_t *)out.ptr, trits.ptr);
+        ck_assert(good);
+        ck_assert_int_eq(memcmp(trits.ptr, expect_trits.ptr, len), 0);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, out.len), 0);
+
+        memcpy(out.ptr, ringels.ptr, out.len);
+        memcpy(in_place.ptr, Fe.ptr, in_place.len);
+        good = impl->recover_msg_rep(len, (uint16_t *)in_place.ptr,
+                                     min_wt + 1, q, (uint16_t *)out.ptr,
+                                     in_place.ptr);
+        ck_assert(!good);
+        ck_assert_int_eq(memcmp(in_place.ptr, expect_trits.ptr, len), 0);
+        ck_assert_int_eq(memcmp(out.ptr, expect.ptr, out.len), 0);
+
+        /* unmask cm' */
+        for(j=0; j<len; j++)
+        {
+            mask.ptr[j] %= 3;
+            expect_trits.ptr[j] = (uint8_t)((trits.ptr[j] + 3 -
+                                             mask.ptr[j]) % 3);
+        }
+
+        impl->unmask_msg_rep(len, mask.ptr, trits.ptr);
+        ck_assert_int_eq(memcmp(trits.ptr, expect_trits.ptr, len), 0);
+
+        ntru_ck_mem_ok(&Fe);
+        ntru_ck_mem_ok(&ringels);
+        ntru_ck_mem_ok(&mask);
+        ntru_ck_mem_ok(&in_place);
+        ntru_ck_mem_ok(&trits);
+        ntru_ck_mem_ok(&out);
+        ntru_ck_mem_ok(&expect_trits);
+        ntru_ck_mem_ok(&expect);
+
+        ntru_ck_mem_free(&Fe);
+        ntru_ck_mem_free(&ringels);
+        ntru_ck_mem_free(&mask);
+        ntru_ck_mem_free(&in_place);
+        ntru_ck_mem_free(&trits);
+        ntru_ck_mem_free(&out);
+        ntru_ck_mem_free(&expect_trits);
+        ntru_ck_mem_free(&expect);
+    }
+}
+END_TEST
+
+
 Suite *
 ntruencrypt_internal_poly_suite(void)
 {
@@ -470,8 +1315,24 @@ ntruencrypt_internal_poly_suite(void)
     tcase_add_test(tc_poly, test_min_weight);
     tcase_add_test(tc_poly, test_inv_mod_2);
     tcase_add_test(tc_poly, test_lift_inv_mod_pow2);
-    tcase_add_test(tc_poly, test_mult_indices);
-    tcase_add_test(tc_poly, test_mult_coefficients);
+    tcase_add_test(tc_poly, test_mult_impl);
+    tcase_add_test(tc_poly, test_cpu_best_impl);
+    tcase_add_loop_test(tc_poly, test_mult_indices, 0,
+                        NTRU_RING_MULT_NUM_IMPLS);
+    tcase_add_loop_test(tc_poly, test_mult_coefficients, 0,
+                        NTRU_RING_MULT_NUM_IMPLS);
+    tcase_add_loop_test(tc_poly, test_mult_coefficients_param_sets, 0,
+                        NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_poly, test_mult_product_indices_param_sets, 0,
+                        NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_poly, test_convert_pack, 0,
+                        NTRU_CONVERT_NUM_IMPLS);
+    tcase_add_loop_test(tc_poly, test_convert_trits, 0,
+                        NTRU_CONVERT_NUM_IMPLS);
+    tcase_add_loop_test(tc_poly, test_msg_rep_add, 0,
+                        NTRU_MSG_REP_NUM_IMPLS);
+    tcase_add_loop_test(tc_poly, test_msg_rep_recover, 0,
+                        NTRU_MSG_REP_NUM_IMPLS);
 
     suite_add_tcase(s, tc_poly);
 
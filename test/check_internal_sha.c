@@ -39,6 +39,135 @@ do_hmac_sha256_test(
     ck_assert_int_eq(rc, HMAC_RESULT(NTRU_CRYPTO_HMAC_OK));
 }
 
+START_TEST(test_hmac_set_key)
+{
+    uint32_t rc;
+    uint32_t i;
+    uint8_t key1[32];
+    uint8_t key2[32];
+    uint8_t data[100];
+    uint8_t md1[32];
+    uint8_t md2[32];
+
+    NTRU_CRYPTO_HMAC_CTX *ctx1;
+    NTRU_CRYPTO_HMAC_CTX *ctx2;
+
+    randombytes(key1, sizeof(key1));
+    randombytes(key2, sizeof(key2));
+    randombytes(data, sizeof(data));
+
+    rc = ntru_crypto_hmac_create_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256,
+                                     key1, sizeof(key1), &ctx1);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+    rc = ntru_crypto_hmac_create_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256,
+                                     key2, sizeof(key2), &ctx2);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+
+    /* repeated HMACs with one key agree */
+
+    for (i = 0; i < 2; i++)
+    {
+        rc = ntru_crypto_hmac_init(ctx1);
+        ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+        rc = ntru_crypto_hmac_update(ctx1, data, sizeof(data));
+        ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+        rc = ntru_crypto_hmac_final(ctx1, i ? md2 : md1);
+        ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+    }
+    ck_assert_int_eq(memcmp(md1, md2, sizeof(md1)), 0);
+
+    /* changing the key matches a context created with the new key */
+
+    rc = ntru_crypto_hmac_set_key(ctx1, key2);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+
+    rc = ntru_crypto_hmac_init(ctx1);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+    rc = ntru_crypto_hmac_update(ctx1, data, sizeof(data));
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+    rc = ntru_crypto_hmac_final(ctx1, md1);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+
+    rc = ntru_crypto_hmac_init(ctx2);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+    rc = ntru_crypto_hmac_update(ctx2, data, sizeof(data));
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+    rc = ntru_crypto_hmac_final(ctx2, md2);
+    ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+
+    ck_assert_int_eq(memcmp(md1, md2, sizeof(md1)), 0);
+
+    ntru_crypto_hmac_destroy_ctx(ctx1);
+    ntru_crypto_hmac_destroy_ctx(ctx2);
+}
+END_TEST
+
+START_TEST(test_hmac_setup_ctx)
+{
+    uint32_t rc;
+    uint32_t key_len;
+    uint8_t key[100];
+    uint8_t data[100];
+    uint8_t md1[32];
+    uint8_t md2[32];
+    uint8_t zero[sizeof(NTRU_CRYPTO_HMAC_CTX)];
+
+    NTRU_CRYPTO_HMAC_CTX *ctx1;
+    NTRU_CRYPTO_HMAC_CTX ctx2;
+
+    randombytes(key, sizeof(key));
+    randombytes(data, sizeof(data));
+    memset(zero, 0, sizeof(zero));
+
+    /* hmac_setup_ctx: Context or key not provided */
+    rc = ntru_crypto_hmac_setup_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256, key, 1,
+                                    NULL);
+    ck_assert_uint_eq(rc, HMAC_RESULT(NTRU_CRYPTO_HMAC_BAD_PARAMETER));
+    rc = ntru_crypto_hmac_setup_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256, NULL, 1,
+                                    &ctx2);
+    ck_assert_uint_eq(rc, HMAC_RESULT(NTRU_CRYPTO_HMAC_BAD_PARAMETER));
+
+    /* hmac_setup_ctx: Algorithm does not exist */
+    rc = ntru_crypto_hmac_setup_ctx(-1, key, 1, &ctx2);
+    ck_assert_uint_eq(rc, HMAC_RESULT(NTRU_CRYPTO_HMAC_BAD_ALG));
+
+    /* a context on the stack matches an allocated one, for keys shorter
+     * and longer than the block
+     */
+
+    for (key_len = 32; key_len <= sizeof(key); key_len += 68)
+    {
+        rc = ntru_crypto_hmac_create_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256,
+                                         key, key_len, &ctx1);
+        ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+        rc = ntru_crypto_hmac_setup_ctx(NTRU_CRYPTO_HASH_ALGID_SHA256,
+                                        key, key_len, &ctx2);
+        ck_assert_uint_eq(rc, NTRU_CRYPTO_HMAC_OK);
+
+        ck_assert_uint_eq(ntru_crypto_hmac_init(ctx1), NTRU_CRYPTO_HMAC_OK);
+        ck_assert_uint_eq(ntru_crypto_hmac_update(ctx1, data, sizeof(data)),
+                          NTRU_CRYPTO_HMAC_OK);
+        ck_assert_uint_eq(ntru_crypto_hmac_final(ctx1, md1),
+                          NTRU_CRYPTO_HMAC_OK);
+
+        ck_assert_uint_eq(ntru_crypto_hmac_init(&ctx2), NTRU_CRYPTO_HMAC_OK);
+        ck_assert_uint_eq(ntru_crypto_hmac_update(&ctx2, data, sizeof(data)),
+                          NTRU_CRYPTO_HMAC_OK);
+        ck_assert_uint_eq(ntru_crypto_hmac_final(&ctx2, md2),
+                          NTRU_CRYPTO_HMAC_OK);
+
+        ck_assert_int_eq(memcmp(md1, md2, sizeof(md1)), 0);
+
+        ntru_crypto_hmac_destroy_ctx(ctx1);
+
+        /* clearing zeroes the whole context */
+
+        ntru_crypto_hmac_clear_ctx(&ctx2);
+        ck_assert_int_eq(memcmp(&ctx2, zero, sizeof(ctx2)), 0);
+    }
+}
+END_TEST
+
 START_TEST(test_hmac_sha256_tv1)
 {
     uint8_t const key[20] =
@@ -368,7 +497,7 @@ START_TEST(test_sha256)
     NTRU_CRYPTO_HASH_CTX ctx;
     NTRU_CRYPTO_SHA2_CTX sha2ctx;
 
-    uint8_t md[20];
+    uint8_t md[32];
     uint8_t data1[3] = "abc";
     uint8_t data2[56] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
     uint8_t data3[64] =
@@ -561,6 +690,163 @@ START_TEST(test_hash)
 }
 END_TEST
 
+
+/* The constant-time digest must match the ordinary one for every length
+ * up to max_len, including lengths at and around block boundaries */
+START_TEST(test_hash_digest_ct)
+{
+    uint32_t rc;
+    uint32_t len;
+    uint32_t k;
+
+    NTRU_CRYPTO_HASH_ALGID algid;
+    uint8_t data[200];
+    uint8_t md1[32];
+    uint8_t md2[32];
+
+    randombytes(data, sizeof(data));
+
+    for (k = 0; k < 2; k++)
+    {
+        algid = k ? NTRU_CRYPTO_HASH_ALGID_SHA256 : NTRU_CRYPTO_HASH_ALGID_SHA1;
+
+        for (len = 0; len <= sizeof(data); len++)
+        {
+            rc = ntru_crypto_hash_digest(algid, data, len, md1);
+            ck_assert_uint_eq(rc, NTRU_CRYPTO_HASH_OK);
+
+            rc = ntru_crypto_hash_digest_ct(algid, data, len, sizeof(data),
+                                            md2);
+            ck_assert_uint_eq(rc, NTRU_CRYPTO_HASH_OK);
+            ck_assert_int_eq(memcmp(md1, md2, k ? 32 : 20), 0);
+
+            rc = ntru_crypto_hash_digest_ct(algid, data, len, len, md2);
+            ck_assert_uint_eq(rc, NTRU_CRYPTO_HASH_OK);
+            ck_assert_int_eq(memcmp(md1, md2, k ? 32 : 20), 0);
+        }
+    }
+
+    /* Length beyond the maximum */
+    rc = ntru_crypto_hash_digest_ct(NTRU_CRYPTO_HASH_ALGID_SHA256, data, 2, 1,
+                                    md1);
+    ck_assert_uint_eq(rc, HASH_RESULT(NTRU_CRYPTO_HASH_BAD_PARAMETER));
+
+    /* Algorithm doesn't exist */
+    rc = ntru_crypto_hash_digest_ct(-1, data, 1, 1, md1);
+    ck_assert_uint_eq(rc, HASH_RESULT(NTRU_CRYPTO_HASH_BAD_ALG));
+}
+END_TEST
+
+
+/* Every available implementation of the SHA-256 counter digests must match
+ * hashing seed || counter one digest at a time, for counts that are not
+ * multiples of the lane width and across a carry out of the counter */
+START_TEST(test_sha256_ctr)
+{
+    uint32_t rc;
+    uint32_t id;
+    uint32_t num;
+    uint32_t i;
+    uint32_t ctr;
+
+    NTRU_CRYPTO_SHA256_CTR_FN fn;
+    uint8_t in[36];
+    uint8_t md1[19 * 32];
+    uint8_t md2[20 * 32];
+
+    fn = ntru_crypto_sha256_ctr_get_impl(NTRU_CRYPTO_SHA256_CTR_NUM_IMPLS);
+    ck_assert_ptr_ne(fn, NULL);
+    fn = ntru_crypto_sha256_ctr_get_impl(NTRU_CRYPTO_SHA256_CTR_SCALAR);
+    ck_assert_ptr_ne(fn, NULL);
+    fn = ntru_crypto_sha256_ctr_get_impl(
+            (NTRU_CRYPTO_SHA256_CTR_IMPL_ID)-1);
+    ck_assert_ptr_eq(fn, NULL);
+
+    randombytes(in, 32);
+    ctr = 0x00fffff7;
+
+    for (i = 0; i < 19; i++)
+    {
+        in[32] = (uint8_t)((ctr + i) >> 24);
+        in[33] = (uint8_t)((ctr + i) >> 16);
+        in[34] = (uint8_t)((ctr + i) >> 8);
+        in[35] = (uint8_t)(ctr + i);
+        rc = ntru_crypto_hash_digest(NTRU_CRYPTO_HASH_ALGID_SHA256, in, 36,
+                                     md1 + 32 * i);
+        ck_assert_uint_eq(rc, NTRU_CRYPTO_HASH_OK);
+    }
+
+    for (id = 0; id <= NTRU_CRYPTO_SHA256_CTR_NUM_IMPLS; id++)
+    {
+        fn = ntru_crypto_sha256_ctr_get_impl(
+                (NTRU_CRYPTO_SHA256_CTR_IMPL_ID)id);
+        if (fn == NULL)
+        {
+            continue;
+        }
+
+        for (num = 0; num <= 19; num++)
+        {
+            memset(md2, 0, sizeof(md2));
+            fn(in, ctr, num, md2);
+            ck_assert_int_eq(memcmp(md1, md2, 32 * num), 0);
+            ck_assert_uint_eq(md2[32 * num], 0);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_sha_blk)
+{
+    uint32_t id;
+    uint32_t i;
+
+    NTRU_CRYPTO_SHA_BLK_IMPL const *impl;
+    NTRU_CRYPTO_SHA_BLK_IMPL const *ref;
+    uint32_t data[16];
+    uint32_t state1[8];
+    uint32_t state2[8];
+
+    impl = ntru_crypto_sha_blk_get_impl(NTRU_CRYPTO_SHA_BLK_NUM_IMPLS);
+    ck_assert_ptr_ne(impl, NULL);
+    ref = ntru_crypto_sha_blk_get_impl(NTRU_CRYPTO_SHA_BLK_SCALAR);
+    ck_assert_ptr_ne(ref, NULL);
+    impl = ntru_crypto_sha_blk_get_impl((NTRU_CRYPTO_SHA_BLK_IMPL_ID)-1);
+    ck_assert_ptr_eq(impl, NULL);
+
+    for (id = 0; id <= NTRU_CRYPTO_SHA_BLK_NUM_IMPLS; id++)
+    {
+        impl = ntru_crypto_sha_blk_get_impl((NTRU_CRYPTO_SHA_BLK_IMPL_ID)id);
+        if (impl == NULL)
+        {
+            continue;
+        }
+
+        /* chain blocks of random data through both implementations */
+
+        randombytes((uint8_t *)state1, sizeof(state1));
+        memcpy(state2, state1, sizeof(state1));
+        for (i = 0; i < 100; i++)
+        {
+            randombytes((uint8_t *)data, sizeof(data));
+            ref->sha1_blk(data, state1);
+            impl->sha1_blk(data, state2);
+            ck_assert_int_eq(memcmp(state1, state2, sizeof(state1)), 0);
+        }
+
+        randombytes((uint8_t *)state1, sizeof(state1));
+        memcpy(state2, state1, sizeof(state1));
+        for (i = 0; i < 100; i++)
+        {
+            randombytes((uint8_t *)data, sizeof(data));
+            ref->sha256_blk(data, state1);
+            impl->sha256_blk(data, state2);
+            ck_assert_int_eq(memcmp(state1, state2, sizeof(state1)), 0);
+        }
+    }
+}
+END_TEST
+
 Suite *
 ntruencrypt_internal_sha_suite(void)
 {
@@ -574,6 +860,8 @@ ntruencrypt_internal_sha_suite(void)
 
     /* Test HMAC SHA256 vectors from https://www.ietf.org/rfc/rfc4231.txt */
     tcase_add_test(tc_sha, test_hmac);
+    tcase_add_test(tc_sha, test_hmac_set_key);
+    tcase_add_test(tc_sha, test_hmac_setup_ctx);
     tcase_add_test(tc_sha, test_hmac_sha256_tv1);
     tcase_add_test(tc_sha, test_hmac_sha256_tv2);
     tcase_add_test(tc_sha, test_hmac_sha256_tv3);
@@ -582,6 +870,9 @@ ntruencrypt_internal_sha_suite(void)
     tcase_add_test(tc_sha, test_hmac_sha256_tv6);
     tcase_add_test(tc_sha, test_hmac_sha256_tv7);
     tcase_add_test(tc_sha, test_hash);
+    tcase_add_test(tc_sha, test_hash_digest_ct);
+    tcase_add_test(tc_sha, test_sha256_ctr);
+    tcase_add_test(tc_sha, test_sha_blk);
     tcase_add_test(tc_sha, test_sha1);
     tcase_add_test(tc_sha, test_sha256);
 
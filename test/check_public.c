@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <check.h>
 
 #include "ntru_crypto.h"
@@ -430,6 +431,805 @@ START_TEST(test_api_crypto)
 END_TEST
 
 
+/* test_api_crypto_batch
+ *
+ * Encrypts a batch of messages under one public key with
+ * ntru_crypto_ntru_encrypt_batch and checks that each decrypts correctly
+ * and that per-message errors are reported without affecting the rest of
+ * the batch.
+ */
+START_TEST(test_api_crypto_batch)
+{
+    uint32_t rc;
+    uint16_t i;
+
+    NTRU_CK_MEM public_key_mem;
+    NTRU_CK_MEM private_key_mem;
+    NTRU_CK_MEM message_mem;
+    NTRU_CK_MEM ciphertext_mem;
+    NTRU_CK_MEM plaintext_mem;
+
+    uint8_t *public_key = NULL;
+    uint8_t *private_key = NULL;
+    uint8_t *message = NULL;
+    uint8_t *ciphertext = NULL;
+    uint8_t *plaintext = NULL;
+
+    uint16_t max_msg_len = 0;
+    uint16_t public_key_len = 0;
+    uint16_t private_key_len = 0;
+    uint16_t ciphertext_len = 0;
+    uint16_t plaintext_len = 0;
+
+    uint16_t       pt_lens[4];
+    uint8_t const *pts[4];
+    uint16_t       ct_lens[4];
+    uint8_t       *cts[4];
+    uint32_t       results[4];
+
+    NTRU_ENCRYPT_PARAM_SET_ID param_set_id;
+    param_set_id = PARAM_SET_IDS[_i];
+
+    /* Generate a key pair */
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id, &public_key_len,
+                                         NULL, &private_key_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    public_key = ntru_ck_malloc(&public_key_mem, public_key_len);
+    private_key = ntru_ck_malloc(&private_key_mem, private_key_len);
+
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id,
+                                         &public_key_len, public_key,
+                                         &private_key_len, private_key);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key, 0, NULL,
+                                  &max_msg_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    /* Query the ciphertext lengths */
+    rc = ntru_crypto_ntru_encrypt_batch(drbg, public_key_len, public_key,
+                                        4, NULL, NULL, ct_lens, NULL, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key, 0, NULL,
+                                  &ciphertext_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    for(i=0; i<4; i++)
+    {
+        ck_assert_uint_eq(ct_lens[i], ciphertext_len);
+    }
+
+    message = ntru_ck_malloc(&message_mem, 4*(1+max_msg_len));
+    ciphertext = ntru_ck_malloc(&ciphertext_mem, 4*ciphertext_len);
+    plaintext = ntru_ck_malloc(&plaintext_mem, max_msg_len);
+    randombytes(message, 4*(1+max_msg_len));
+
+    for(i=0; i<4; i++)
+    {
+        pt_lens[i] = (i * max_msg_len) / 3;
+        pts[i] = message + i*(1+max_msg_len);
+        ct_lens[i] = ciphertext_len;
+        cts[i] = ciphertext + i*ciphertext_len;
+    }
+
+    /* Encrypt the batch and decrypt each ciphertext */
+    rc = ntru_crypto_ntru_encrypt_batch(drbg, public_key_len, public_key,
+                                        4, pt_lens, pts, ct_lens, cts,
+                                        results);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    for(i=0; i<4; i++)
+    {
+        ck_assert_uint_eq(results[i], NTRU_RESULT(NTRU_OK));
+        ck_assert_uint_eq(ct_lens[i], ciphertext_len);
+
+        plaintext_len = max_msg_len;
+        rc = ntru_crypto_ntru_decrypt(private_key_len, private_key,
+                                      ct_lens[i], cts[i],
+                                      &plaintext_len, plaintext);
+        ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+        ck_assert_uint_eq(plaintext_len, pt_lens[i]);
+        ck_assert_int_eq(memcmp(plaintext, pts[i], pt_lens[i]), 0);
+    }
+
+    /* Per-message errors do not stop the rest of the batch */
+    pts[0] = NULL;
+    pt_lens[1] = 1+max_msg_len;
+    ct_lens[2] = ciphertext_len-1;
+    rc = ntru_crypto_ntru_encrypt_batch(drbg, public_key_len, public_key,
+                                        4, pt_lens, pts, ct_lens, cts,
+                                        results);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_FAIL));
+    ck_assert_uint_eq(results[0], NTRU_RESULT(NTRU_BAD_PARAMETER));
+    ck_assert_uint_eq(results[1], NTRU_RESULT(NTRU_BAD_LENGTH));
+    ck_assert_uint_eq(results[2], NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+    ck_assert_uint_eq(results[3], NTRU_RESULT(NTRU_OK));
+
+    plaintext_len = max_msg_len;
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key,
+                                  ct_lens[3], cts[3],
+                                  &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_uint_eq(plaintext_len, pt_lens[3]);
+    ck_assert_int_eq(memcmp(plaintext, pts[3], pt_lens[3]), 0);
+
+    /* Whole-batch error cases */
+    rc = ntru_crypto_ntru_encrypt_batch(drbg, public_key_len, public_key,
+                                        0, pt_lens, pts, ct_lens, cts,
+                                        results);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+
+    rc = ntru_crypto_ntru_encrypt_batch(drbg, public_key_len, public_key,
+                                        4, pt_lens, pts, ct_lens, cts, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_batch(drbg, public_key_len-1, public_key,
+                                        4, pt_lens, pts, ct_lens, cts,
+                                        results);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PUBLIC_KEY));
+
+    ntru_ck_mem_ok(&message_mem);
+    ntru_ck_mem_ok(&public_key_mem);
+    ntru_ck_mem_ok(&private_key_mem);
+    ntru_ck_mem_ok(&plaintext_mem);
+    ntru_ck_mem_ok(&ciphertext_mem);
+
+    ntru_ck_mem_free(&message_mem);
+    ntru_ck_mem_free(&public_key_mem);
+    ntru_ck_mem_free(&private_key_mem);
+    ntru_ck_mem_free(&plaintext_mem);
+    ntru_ck_mem_free(&ciphertext_mem);
+}
+END_TEST
+
+
+/* test_api_crypto_pubkey_ctx
+ *
+ * Encrypts with a public-key context and checks that the ciphertexts
+ * decrypt correctly, then checks the error cases of the context API.
+ */
+START_TEST(test_api_crypto_pubkey_ctx)
+{
+    uint32_t rc;
+
+    NTRU_CK_MEM public_key_mem;
+    NTRU_CK_MEM private_key_mem;
+    NTRU_CK_MEM message_mem;
+    NTRU_CK_MEM ciphertext_mem;
+    NTRU_CK_MEM plaintext_mem;
+
+    uint8_t *public_key = NULL;
+    uint8_t *private_key = NULL;
+    uint8_t *message = NULL;
+    uint8_t *ciphertext = NULL;
+    uint8_t *plaintext = NULL;
+
+    uint16_t max_msg_len = 0;
+    uint16_t mlen = 0;
+    uint16_t public_key_len = 0;
+    uint16_t private_key_len = 0;
+    uint16_t ciphertext_len = 0;
+    uint16_t plaintext_len = 0;
+
+    NTRU_ENCRYPT_PUBKEY_CTX *ctx = NULL;
+
+    NTRU_ENCRYPT_PARAM_SET_ID param_set_id;
+    param_set_id = PARAM_SET_IDS[_i];
+
+    /* Generate a key pair */
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id, &public_key_len,
+                                         NULL, &private_key_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    public_key = ntru_ck_malloc(&public_key_mem, public_key_len);
+    private_key = ntru_ck_malloc(&private_key_mem, private_key_len);
+
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id,
+                                         &public_key_len, public_key,
+                                         &private_key_len, private_key);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key, 0, NULL,
+                                  &max_msg_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    /* Create the context and scrub the blob; the context must not use it */
+    rc = ntru_crypto_ntru_encrypt_create_pubkey_ctx(public_key_len,
+                                                    public_key, &ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_ptr_ne(ctx, NULL);
+    memset(public_key, 0, public_key_len);
+
+    /* Ciphertext length query */
+    rc = ntru_crypto_ntru_encrypt_with_ctx(drbg, ctx, 0, NULL,
+                                           &ciphertext_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    message = ntru_ck_malloc(&message_mem, (1 + max_msg_len));
+    ciphertext = ntru_ck_malloc(&ciphertext_mem, ciphertext_len);
+    plaintext = ntru_ck_malloc(&plaintext_mem, max_msg_len);
+
+    /* Encrypt/decrypt at a few message lengths */
+    for(mlen=0; mlen<=max_msg_len; mlen+=max_msg_len/4)
+    {
+        plaintext_len = max_msg_len;
+        randombytes(message, mlen);
+
+        rc = ntru_crypto_ntru_encrypt_with_ctx(drbg, ctx, mlen, message,
+                                               &ciphertext_len, ciphertext);
+        ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+        rc = ntru_crypto_ntru_decrypt(private_key_len, private_key,
+                                      ciphertext_len, ciphertext,
+                                      &plaintext_len, plaintext);
+        ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+        ck_assert_uint_eq(plaintext_len, mlen);
+        ck_assert_int_eq(memcmp(plaintext,message,mlen), 0);
+    }
+
+    /* Error cases */
+    rc = ntru_crypto_ntru_encrypt_with_ctx(drbg, NULL, max_msg_len, message,
+                                           &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_with_ctx(drbg, ctx, max_msg_len, NULL,
+                                           &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_with_ctx(drbg, ctx, 1+max_msg_len, message,
+                                           &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+
+    ciphertext_len -= 1;
+    rc = ntru_crypto_ntru_encrypt_with_ctx(drbg, ctx, max_msg_len, message,
+                                           &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+    ciphertext_len += 1;
+
+    rc = ntru_crypto_ntru_encrypt_destroy_pubkey_ctx(ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_encrypt_destroy_pubkey_ctx(NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_create_pubkey_ctx(public_key_len,
+                                                    public_key, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_create_pubkey_ctx(0, public_key, &ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+    ck_assert_ptr_eq(ctx, NULL);
+
+    rc = ntru_crypto_ntru_encrypt_create_pubkey_ctx(public_key_len-1,
+                                                    public_key, &ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PUBLIC_KEY));
+    ck_assert_ptr_eq(ctx, NULL);
+
+    ntru_ck_mem_ok(&message_mem);
+    ntru_ck_mem_ok(&public_key_mem);
+    ntru_ck_mem_ok(&private_key_mem);
+    ntru_ck_mem_ok(&plaintext_mem);
+    ntru_ck_mem_ok(&ciphertext_mem);
+
+    ntru_ck_mem_free(&message_mem);
+    ntru_ck_mem_free(&public_key_mem);
+    ntru_ck_mem_free(&private_key_mem);
+    ntru_ck_mem_free(&plaintext_mem);
+    ntru_ck_mem_free(&ciphertext_mem);
+}
+END_TEST
+
+
+/* test_api_crypto_privkey_ctx
+ *
+ * Decrypts with a private-key context and checks the results against
+ * ntru_crypto_ntru_decrypt, then checks the error cases of the context API.
+ */
+START_TEST(test_api_crypto_privkey_ctx)
+{
+    uint32_t rc;
+
+    NTRU_CK_MEM public_key_mem;
+    NTRU_CK_MEM private_key_mem;
+    NTRU_CK_MEM message_mem;
+    NTRU_CK_MEM ciphertext_mem;
+    NTRU_CK_MEM plaintext_mem;
+
+    uint8_t *public_key = NULL;
+    uint8_t *private_key = NULL;
+    uint8_t *message = NULL;
+    uint8_t *ciphertext = NULL;
+    uint8_t *plaintext = NULL;
+
+    uint16_t max_msg_len = 0;
+    uint16_t mlen = 0;
+    uint16_t public_key_len = 0;
+    uint16_t private_key_len = 0;
+    uint16_t ciphertext_len = 0;
+    uint16_t plaintext_len = 0;
+
+    NTRU_ENCRYPT_PRIVKEY_CTX *ctx = NULL;
+
+    NTRU_ENCRYPT_PARAM_SET_ID param_set_id;
+    param_set_id = PARAM_SET_IDS[_i];
+
+    /* Generate a key pair */
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id, &public_key_len,
+                                         NULL, &private_key_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    public_key = ntru_ck_malloc(&public_key_mem, public_key_len);
+    private_key = ntru_ck_malloc(&private_key_mem, private_key_len);
+
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id,
+                                         &public_key_len, public_key,
+                                         &private_key_len, private_key);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key, 0, NULL,
+                                  &ciphertext_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    /* Create the context and scrub the blob; the context must not use it */
+    rc = ntru_crypto_ntru_encrypt_create_privkey_ctx(private_key_len,
+                                                     private_key, &ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_ptr_ne(ctx, NULL);
+    memset(private_key, 0, private_key_len);
+
+    /* Maximum plaintext length query */
+    rc = ntru_crypto_ntru_decrypt_with_ctx(ctx, 0, NULL, &max_msg_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    message = ntru_ck_malloc(&message_mem, (1 + max_msg_len));
+    ciphertext = ntru_ck_malloc(&ciphertext_mem, ciphertext_len);
+    plaintext = ntru_ck_malloc(&plaintext_mem, max_msg_len);
+
+    /* Encrypt/decrypt at a few message lengths */
+    for(mlen=0; mlen<=max_msg_len; mlen+=max_msg_len/4)
+    {
+        plaintext_len = max_msg_len;
+        randombytes(message, mlen);
+
+        rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key,
+                                      mlen, message,
+                                      &ciphertext_len, ciphertext);
+        ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+        rc = ntru_crypto_ntru_decrypt_with_ctx(ctx, ciphertext_len,
+                                               ciphertext, &plaintext_len,
+                                               plaintext);
+        ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+        ck_assert_uint_eq(plaintext_len, mlen);
+        ck_assert_int_eq(memcmp(plaintext,message,mlen), 0);
+    }
+
+    /* Error cases */
+    rc = ntru_crypto_ntru_decrypt_with_ctx(NULL, ciphertext_len, ciphertext,
+                                           &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_decrypt_with_ctx(ctx, ciphertext_len, NULL,
+                                           &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_decrypt_with_ctx(ctx, ciphertext_len-1, ciphertext,
+                                           &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+
+    /* Plaintext buffer one octet shorter than the last message */
+    plaintext_len = mlen-max_msg_len/4-1;
+    rc = ntru_crypto_ntru_decrypt_with_ctx(ctx, ciphertext_len, ciphertext,
+                                           &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+
+    plaintext_len = max_msg_len;
+    ciphertext[ciphertext_len>>1] ^= 0xff;
+    rc = ntru_crypto_ntru_decrypt_with_ctx(ctx, ciphertext_len, ciphertext,
+                                           &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_FAIL));
+
+    rc = ntru_crypto_ntru_encrypt_destroy_privkey_ctx(ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_encrypt_destroy_privkey_ctx(NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_create_privkey_ctx(private_key_len,
+                                                     private_key, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_create_privkey_ctx(0, private_key, &ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+    ck_assert_ptr_eq(ctx, NULL);
+
+    rc = ntru_crypto_ntru_encrypt_create_privkey_ctx(public_key_len,
+                                                     public_key, &ctx);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PRIVATE_KEY));
+    ck_assert_ptr_eq(ctx, NULL);
+
+    ntru_ck_mem_ok(&message_mem);
+    ntru_ck_mem_ok(&public_key_mem);
+    ntru_ck_mem_ok(&private_key_mem);
+    ntru_ck_mem_ok(&plaintext_mem);
+    ntru_ck_mem_ok(&ciphertext_mem);
+
+    ntru_ck_mem_free(&message_mem);
+    ntru_ck_mem_free(&public_key_mem);
+    ntru_ck_mem_free(&private_key_mem);
+    ntru_ck_mem_free(&plaintext_mem);
+    ntru_ck_mem_free(&ciphertext_mem);
+}
+END_TEST
+
+
+/* test_api_crypto_scratch
+ *
+ * Runs keygen, encryption and decryption with caller-provided workspaces
+ * and checks the error cases of the workspace API.
+ */
+START_TEST(test_api_crypto_scratch)
+{
+    uint32_t rc;
+
+    NTRU_CK_MEM public_key_mem;
+    NTRU_CK_MEM private_key_mem;
+    NTRU_CK_MEM message_mem;
+    NTRU_CK_MEM ciphertext_mem;
+    NTRU_CK_MEM plaintext_mem;
+    NTRU_CK_MEM scratch_mem;
+
+    uint8_t *public_key = NULL;
+    uint8_t *private_key = NULL;
+    uint8_t *message = NULL;
+    uint8_t *ciphertext = NULL;
+    uint8_t *plaintext = NULL;
+    uint8_t *scratch = NULL;
+
+    uint16_t max_msg_len = 0;
+    uint16_t public_key_len = 0;
+    uint16_t private_key_len = 0;
+    uint16_t ciphertext_len = 0;
+    uint16_t plaintext_len = 0;
+
+    uint32_t keygen_scratch_len = 0;
+    uint32_t encrypt_scratch_len = 0;
+    uint32_t decrypt_scratch_len = 0;
+    uint32_t scratch_len = 0;
+
+    NTRU_ENCRYPT_PARAM_SET_ID param_set_id;
+    param_set_id = PARAM_SET_IDS[_i];
+
+    /* Workspace size queries */
+    rc = ntru_crypto_ntru_encrypt_keygen_scratch_size(param_set_id,
+                                                      &keygen_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_ntru_encrypt_scratch_size(param_set_id,
+                                               &encrypt_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_ntru_decrypt_scratch_size(param_set_id,
+                                               &decrypt_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    scratch_len = keygen_scratch_len;
+    if(encrypt_scratch_len > scratch_len)
+        scratch_len = encrypt_scratch_len;
+    if(decrypt_scratch_len > scratch_len)
+        scratch_len = decrypt_scratch_len;
+
+    /* ntru_ck_malloc returns malloc()+16, which is suitably aligned */
+    scratch = ntru_ck_malloc(&scratch_mem, scratch_len+1);
+    ck_assert_uint_eq((size_t)scratch & (NTRU_SCRATCH_ALIGNMENT-1), 0);
+
+    /* Generate a key pair in the workspace */
+    rc = ntru_crypto_ntru_encrypt_keygen_ex(drbg, param_set_id,
+                                            &public_key_len, NULL,
+                                            &private_key_len, NULL,
+                                            NULL, 0);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    public_key = ntru_ck_malloc(&public_key_mem, public_key_len);
+    private_key = ntru_ck_malloc(&private_key_mem, private_key_len);
+
+    rc = ntru_crypto_ntru_encrypt_keygen_ex(drbg, param_set_id,
+                                            &public_key_len, public_key,
+                                            &private_key_len, private_key,
+                                            scratch, keygen_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key, 0, NULL,
+                                  &ciphertext_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key, 0, NULL,
+                                  &max_msg_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    message = ntru_ck_malloc(&message_mem, max_msg_len);
+    ciphertext = ntru_ck_malloc(&ciphertext_mem, ciphertext_len);
+    plaintext = ntru_ck_malloc(&plaintext_mem, max_msg_len);
+
+    /* Encrypt/decrypt round trip through the workspace */
+    randombytes(message, max_msg_len);
+    rc = ntru_crypto_ntru_encrypt_ex(drbg, public_key_len, public_key,
+                                     max_msg_len, message,
+                                     &ciphertext_len, ciphertext,
+                                     scratch, encrypt_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    plaintext_len = max_msg_len;
+    rc = ntru_crypto_ntru_decrypt_ex(private_key_len, private_key,
+                                     ciphertext_len, ciphertext,
+                                     &plaintext_len, plaintext,
+                                     scratch, decrypt_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_uint_eq(plaintext_len, max_msg_len);
+    ck_assert_int_eq(memcmp(plaintext,message,max_msg_len), 0);
+
+    /* Error cases */
+    rc = ntru_crypto_ntru_encrypt_scratch_size(param_set_id, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_decrypt_scratch_size(-1, &scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_INVALID_PARAMETER_SET));
+
+    rc = ntru_crypto_ntru_encrypt_keygen_scratch_size(-1, &scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_INVALID_PARAMETER_SET));
+
+    rc = ntru_crypto_ntru_encrypt_ex(drbg, public_key_len, public_key,
+                                     max_msg_len, message,
+                                     &ciphertext_len, ciphertext,
+                                     scratch, encrypt_scratch_len-1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+
+    rc = ntru_crypto_ntru_encrypt_ex(drbg, public_key_len, public_key,
+                                     max_msg_len, message,
+                                     &ciphertext_len, ciphertext,
+                                     scratch+1, encrypt_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    plaintext_len = max_msg_len;
+    rc = ntru_crypto_ntru_decrypt_ex(private_key_len, private_key,
+                                     ciphertext_len, ciphertext,
+                                     &plaintext_len, plaintext,
+                                     scratch, decrypt_scratch_len-1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+
+    rc = ntru_crypto_ntru_decrypt_ex(private_key_len, private_key,
+                                     ciphertext_len, ciphertext,
+                                     &plaintext_len, plaintext,
+                                     scratch+1, decrypt_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_ntru_encrypt_keygen_ex(drbg, param_set_id,
+                                            &public_key_len, public_key,
+                                            &private_key_len, private_key,
+                                            scratch, keygen_scratch_len-1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+
+    rc = ntru_crypto_ntru_encrypt_keygen_ex(drbg, param_set_id,
+                                            &public_key_len, public_key,
+                                            &private_key_len, private_key,
+                                            scratch+1, keygen_scratch_len);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    ntru_ck_mem_ok(&message_mem);
+    ntru_ck_mem_ok(&public_key_mem);
+    ntru_ck_mem_ok(&private_key_mem);
+    ntru_ck_mem_ok(&plaintext_mem);
+    ntru_ck_mem_ok(&ciphertext_mem);
+    ntru_ck_mem_ok(&scratch_mem);
+
+    ntru_ck_mem_free(&message_mem);
+    ntru_ck_mem_free(&public_key_mem);
+    ntru_ck_mem_free(&private_key_mem);
+    ntru_ck_mem_free(&plaintext_mem);
+    ntru_ck_mem_free(&ciphertext_mem);
+    ntru_ck_mem_free(&scratch_mem);
+}
+END_TEST
+
+
+/* test_api_crypto_kem
+ *
+ * Runs key encapsulation and decapsulation and checks that both sides
+ * derive the same shared key, that the key is bound to the ciphertext,
+ * that the ciphertext is an ordinary SVES ciphertext of a short secret,
+ * and that other ciphertexts are rejected.
+ */
+START_TEST(test_api_crypto_kem)
+{
+    uint32_t rc;
+
+    NTRU_CK_MEM public_key_mem;
+    NTRU_CK_MEM private_key_mem;
+    NTRU_CK_MEM message_mem;
+    NTRU_CK_MEM ciphertext_mem;
+    NTRU_CK_MEM plaintext_mem;
+
+    uint8_t *public_key = NULL;
+    uint8_t *private_key = NULL;
+    uint8_t *message = NULL;
+    uint8_t *ciphertext = NULL;
+    uint8_t *plaintext = NULL;
+
+    uint8_t key1[NTRU_KEM_SHARED_KEY_LEN];
+    uint8_t key2[NTRU_KEM_SHARED_KEY_LEN];
+    uint8_t key3[NTRU_KEM_SHARED_KEY_LEN];
+
+    uint16_t max_msg_len = 0;
+    uint16_t public_key_len = 0;
+    uint16_t private_key_len = 0;
+    uint16_t ciphertext_len = 0;
+    uint16_t encaps_len = 0;
+    uint16_t plaintext_len = 0;
+
+    NTRU_ENCRYPT_PARAM_SET_ID param_set_id;
+    param_set_id = PARAM_SET_IDS[_i];
+
+    /* Generate a key pair */
+    rc = ntru_crypto_kem_keygen(drbg, param_set_id, &public_key_len, NULL,
+                                &private_key_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    public_key = ntru_ck_malloc(&public_key_mem, public_key_len);
+    private_key = ntru_ck_malloc(&private_key_mem, private_key_len);
+
+    rc = ntru_crypto_kem_keygen(drbg, param_set_id,
+                                &public_key_len, public_key,
+                                &private_key_len, private_key);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    /* The ciphertext length query matches that of encryption */
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, public_key,
+                                &encaps_len, NULL, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key, 0, NULL,
+                                  &ciphertext_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_uint_eq(encaps_len, ciphertext_len);
+
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key, 0, NULL,
+                                  &max_msg_len, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+
+    message = ntru_ck_malloc(&message_mem, max_msg_len);
+    ciphertext = ntru_ck_malloc(&ciphertext_mem, ciphertext_len);
+    plaintext = ntru_ck_malloc(&plaintext_mem, max_msg_len);
+
+    /* Encapsulate and decapsulate */
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, public_key,
+                                &ciphertext_len, ciphertext, key1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_uint_eq(ciphertext_len, encaps_len);
+
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_int_eq(memcmp(key1, key2, sizeof(key1)), 0);
+
+    /* The secret decrypts as a plaintext of at most 32 octets */
+    plaintext_len = max_msg_len;
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key,
+                                  ciphertext_len, ciphertext,
+                                  &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_uint_ge(plaintext_len, 14);
+    ck_assert_uint_le(plaintext_len, NTRU_KEM_SHARED_KEY_LEN);
+
+    /* A second encapsulation gives a different key */
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, public_key,
+                                &ciphertext_len, ciphertext, key3);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_int_ne(memcmp(key1, key3, sizeof(key1)), 0);
+
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_int_eq(memcmp(key3, key2, sizeof(key3)), 0);
+
+    /* The key is bound to the ciphertext: another encryption of the same
+     * secret decapsulates to a different key */
+    plaintext_len = max_msg_len;
+    rc = ntru_crypto_ntru_decrypt(private_key_len, private_key,
+                                  ciphertext_len, ciphertext,
+                                  &plaintext_len, plaintext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key,
+                                  plaintext_len, plaintext,
+                                  &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ck_assert_int_ne(memcmp(key3, key2, sizeof(key3)), 0);
+
+    /* Ciphertexts of other plaintexts are rejected */
+    randombytes(message, max_msg_len);
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key,
+                                  max_msg_len, message,
+                                  &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_FAIL));
+
+    rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key,
+                                  1, message, &ciphertext_len, ciphertext);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_FAIL));
+
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, public_key,
+                                &ciphertext_len, ciphertext, key1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_OK));
+    ciphertext[ciphertext_len>>1] ^= 0xff;
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_FAIL));
+
+    /* Error cases */
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, public_key,
+                                &ciphertext_len, ciphertext, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, NULL,
+                                &ciphertext_len, ciphertext, key1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_kem_encaps(drbg, 0, public_key,
+                                &ciphertext_len, ciphertext, key1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+
+    ciphertext_len = encaps_len - 1;
+    rc = ntru_crypto_kem_encaps(drbg, public_key_len, public_key,
+                                &ciphertext_len, ciphertext, key1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BUFFER_TOO_SMALL));
+    ciphertext_len = encaps_len;
+
+    rc = ntru_crypto_kem_encaps(drbg, private_key_len, private_key,
+                                &ciphertext_len, ciphertext, key1);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PUBLIC_KEY));
+
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, ciphertext, NULL);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len, NULL, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PARAMETER));
+
+    rc = ntru_crypto_kem_decaps(0, private_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+
+    rc = ntru_crypto_kem_decaps(private_key_len, private_key,
+                                ciphertext_len-1, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_LENGTH));
+
+    rc = ntru_crypto_kem_decaps(public_key_len, public_key,
+                                ciphertext_len, ciphertext, key2);
+    ck_assert_uint_eq(rc, NTRU_RESULT(NTRU_BAD_PRIVATE_KEY));
+
+    ntru_ck_mem_ok(&message_mem);
+    ntru_ck_mem_ok(&public_key_mem);
+    ntru_ck_mem_ok(&private_key_mem);
+    ntru_ck_mem_ok(&plaintext_mem);
+    ntru_ck_mem_ok(&ciphertext_mem);
+
+    ntru_ck_mem_free(&message_mem);
+    ntru_ck_mem_free(&public_key_mem);
+    ntru_ck_mem_free(&private_key_mem);
+    ntru_ck_mem_free(&plaintext_mem);
+    ntru_ck_mem_free(&ciphertext_mem);
+}
+END_TEST
+
+
 START_TEST(test_api_drbg_sha256_hmac)
 {
     /* We run this as a loop test _i indexes the size */
@@ -437,141 +1237,725 @@ START_TEST(test_api_drbg_sha256_hmac)
     uint32_t s_bits = sizes[_i];
 
     uint32_t i;
-    uint32_t j;
+    uint32_t j;
+    uint32_t rc;
+    DRBG_HANDLE handles[DRBG_MAX_INSTANTIATIONS];
+    DRBG_HANDLE extra;
+    const uint8_t pers_str[] = "test_api_drbg";
+    uint32_t pers_str_bytes = sizeof(pers_str);
+    uint8_t pool[10];
+    uint8_t pool2[sizeof(pool)];
+
+    /* Internal SHA256 DRBG type */
+    /* Bad parameters */
+    rc = ntru_crypto_drbg_instantiate(-1, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    rc = ntru_crypto_drbg_instantiate(s_bits, NULL, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str,
+            HMAC_DRBG_MAX_PERS_STR_BYTES+1,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            NULL, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, NULL);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    /* Bad entropy functions */
+    /* Error in init */
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_init, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+
+    /* Error in get_num */
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_get_num, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+
+    /* get_num reports that source is perfectly predictable */
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_num_eq_zero,
+            handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+
+    /* Error in get_byte */
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_get_byte, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+
+    /* Instantiate as many HMAC DRBGs as we are allowed */
+    for(i=0; i<DRBG_MAX_INSTANTIATIONS; i++)
+    {
+        rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+                (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+i);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+
+    /* Check pairwise distinctness of handles */
+    for(i=0; i<DRBG_MAX_INSTANTIATIONS-1; i++)
+    {
+        for(j=i+1; j<DRBG_MAX_INSTANTIATIONS; j++)
+        {
+            ck_assert_uint_ne(handles[i], handles[j]);
+        }
+    }
+
+    /* Instantiate too many DRBGs */
+    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &extra);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_NOT_AVAILABLE));
+
+    /* drbg_generate input checks */
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, sizeof(pool), NULL);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, 0, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    /* Use a DRBG */
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, sizeof(pool), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Use a second DRBG */
+    rc = ntru_crypto_drbg_generate(handles[1], s_bits, sizeof(pool2), pool2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Hopefully those outputs are different (w/ prob 2^-80) */
+    ck_assert_int_ne(memcmp(pool, pool2, sizeof(pool)), 0);
+
+    /* Reseed an HMAC DRBG (should not fail) */
+    rc = ntru_crypto_drbg_reseed(handles[0]);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Try to get zero bytes */
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, 0, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    /* Request too high of a security level */
+    rc = ntru_crypto_drbg_generate(handles[0], 2*DRBG_MAX_SEC_STRENGTH_BITS,
+                                   sizeof(pool), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    /* Request too many bytes */
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits,
+                                   1+HMAC_DRBG_MAX_BYTES_PER_REQUEST, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    /* Uninstantiate DRBGs */
+    for(i=0; i<DRBG_MAX_INSTANTIATIONS; i++)
+    {
+        rc = ntru_crypto_drbg_uninstantiate(handles[i]);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+
+    /* Reseed a uninstantiated DRBG */
+    rc = ntru_crypto_drbg_reseed(handles[0]);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    /* Double uninstantiate */
+    rc = ntru_crypto_drbg_uninstantiate(handles[0]);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    /* Use an uninstantiated DRBG */
+    rc = ntru_crypto_drbg_generate(handles[0], 0, 10, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    /* Use a DRBG that never existed */
+    handles[0] = 0xaabbccdd;
+    rc = ntru_crypto_drbg_generate(handles[0], 0, 10, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+}
+END_TEST
+
+START_TEST(test_api_drbg_aes256_ctr)
+{
+    /* We run this as a loop test _i indexes the size */
+    uint32_t sizes[] = {112, 128, 192, 256};
+    uint32_t s_bits = sizes[_i];
+
+    uint32_t i;
+    uint32_t rc;
+    DRBG_HANDLE handles[2];
+    const uint8_t pers_str[] = "test_api_drbg";
+    uint32_t pers_str_bytes = sizeof(pers_str);
+    uint8_t *pool;
+    uint8_t pool2[33];
+
+    /* Bad parameters */
+    rc = ntru_crypto_drbg_instantiate_ex(EXTERNAL_DRBG, s_bits, pers_str,
+            pers_str_bytes, (ENTROPY_FN) drbg_sha256_hmac_get_entropy,
+            handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_instantiate_ex((DRBG_TYPE) -1, s_bits, pers_str,
+            pers_str_bytes, (ENTROPY_FN) drbg_sha256_hmac_get_entropy,
+            handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_instantiate_ex(AES256_CTR_DRBG, s_bits, pers_str,
+            CTR_DRBG_MAX_PERS_STR_BYTES+1,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    rc = ntru_crypto_drbg_instantiate_ex(AES256_CTR_DRBG, s_bits, pers_str,
+            pers_str_bytes,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_get_byte,
+            handles+0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+
+    /* Instantiate two CTR DRBGs */
+    for(i=0; i<2; i++)
+    {
+        rc = ntru_crypto_drbg_instantiate_ex(AES256_CTR_DRBG, s_bits,
+                pers_str, pers_str_bytes,
+                (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+i);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+    ck_assert_uint_ne(handles[0], handles[1]);
+
+    /* Requests of whole and partial blocks, up to the maximum */
+    pool = (uint8_t *)malloc(CTR_DRBG_MAX_BYTES_PER_REQUEST);
+    ck_assert_ptr_ne(pool, NULL);
+
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, 1, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, sizeof(pool2), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handles[1], s_bits, sizeof(pool2), pool2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_int_ne(memcmp(pool, pool2, sizeof(pool2)), 0);
+
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits,
+                                   CTR_DRBG_MAX_BYTES_PER_REQUEST, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Request too many bytes, or too high of a security level */
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits,
+                                   1+CTR_DRBG_MAX_BYTES_PER_REQUEST, pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    rc = ntru_crypto_drbg_generate(handles[0], 2*DRBG_MAX_SEC_STRENGTH_BITS,
+                                   sizeof(pool2), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+    /* Reseed and use it again */
+    rc = ntru_crypto_drbg_reseed(handles[0]);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_generate(handles[0], s_bits, sizeof(pool2), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    free(pool);
+
+    /* Uninstantiate DRBGs */
+    for(i=0; i<2; i++)
+    {
+        rc = ntru_crypto_drbg_uninstantiate(handles[i]);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+
+    rc = ntru_crypto_drbg_generate(handles[0], 0, sizeof(pool2), pool2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+}
+END_TEST
+
+START_TEST(test_api_drbg_pool)
+{
+    uint32_t rc;
+    uint32_t i;
+    DRBG_HANDLE handle;
+    DRBG_HANDLE ext;
+    uint8_t pool[100];
+    uint8_t pool2[sizeof(pool)];
+
+    rc = ntru_crypto_drbg_external_instantiate(
+            (RANDOM_BYTES_FN) &randombytes, &ext);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Bad parameters */
+    rc = ntru_crypto_drbg_set_pool(0xaabbccdd, 256);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_set_pool(ext, 256);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_uninstantiate(ext);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    for(i=0; i<2; i++)
+    {
+        rc = ntru_crypto_drbg_instantiate_ex(
+                i ? AES256_CTR_DRBG : SHA256_HMAC_DRBG, 256, NULL, 0,
+                (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_set_pool(handle,
+                1 + (i ? CTR_DRBG_MAX_BYTES_PER_REQUEST :
+                         HMAC_DRBG_MAX_BYTES_PER_REQUEST));
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_set_pool(handle, 256);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* Requests that fit the pool, cross a refill, or bypass it */
+        rc = ntru_crypto_drbg_generate(handle, 256, 10, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, 10, pool2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_ne(memcmp(pool, pool2, 10), 0);
+
+        rc = ntru_crypto_drbg_generate(handle, 2*DRBG_MAX_SEC_STRENGTH_BITS,
+                                       10, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_generate(handle, 256, 0, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(pool), pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(pool), pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(pool), pool2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_ne(memcmp(pool, pool2, sizeof(pool)), 0);
+
+        rc = ntru_crypto_drbg_reseed(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, 10, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* Resize, then turn buffering off */
+        rc = ntru_crypto_drbg_set_pool(handle, 64);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(pool), pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, 10, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_set_pool(handle, 0);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, 10, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* Uninstantiate with a pool */
+        rc = ntru_crypto_drbg_set_pool(handle, 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, 10, pool);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_set_pool(handle, 32);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+    }
+}
+END_TEST
+
+START_TEST(test_api_drbg_bulk_entropy)
+{
+    uint32_t rc;
+    uint32_t i;
+    DRBG_HANDLE handle;
+    uint8_t const pers_str[] = "test_api_drbg";
+    uint8_t out1[32];
+    uint8_t out2[32];
+
+    for(i=0; i<2; i++)
+    {
+        DRBG_TYPE type = i ? AES256_CTR_DRBG : SHA256_HMAC_DRBG;
+
+        /* Bad parameters */
+        rc = ntru_crypto_drbg_instantiate_bulk(type, 256, pers_str,
+                sizeof(pers_str), NULL, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        rc = ntru_crypto_drbg_instantiate_bulk(type, 256, pers_str,
+                sizeof(pers_str), drbg_get_entropy_bulk, NULL);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        rc = ntru_crypto_drbg_instantiate_bulk(EXTERNAL_DRBG, 256, pers_str,
+                sizeof(pers_str), drbg_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        rc = ntru_crypto_drbg_instantiate_bulk(type, 512, pers_str,
+                sizeof(pers_str), drbg_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_instantiate_bulk(type, 256, pers_str,
+                sizeof(pers_str), drbg_get_entropy_bulk_err, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+
+        /* Instantiate, generate and reseed */
+        rc = ntru_crypto_drbg_instantiate_bulk(type, 256, pers_str,
+                sizeof(pers_str), drbg_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(out1), out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_reseed(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(out2), out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_ne(memcmp(out1, out2, sizeof(out1)), 0);
+
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+}
+END_TEST
+
+START_TEST(test_api_drbg_reseed_policy)
+{
     uint32_t rc;
-    DRBG_HANDLE handles[DRBG_MAX_INSTANTIATIONS];
-    DRBG_HANDLE extra;
-    const uint8_t pers_str[] = "test_api_drbg";
-    uint32_t pers_str_bytes = sizeof(pers_str);
-    uint8_t pool[10];
-    uint8_t pool2[sizeof(pool)];
+    uint32_t i, j;
+    DRBG_HANDLE handle;
+    DRBG_HANDLE ext;
+    DRBG_RESEED_POLICY policy;
+    uint8_t out[100];
+
+    memset(&policy, 0, sizeof(policy));
+    policy.max_requests = 3;
 
-    /* Internal SHA256 DRBG type */
     /* Bad parameters */
-    rc = ntru_crypto_drbg_instantiate(-1, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+    rc = ntru_crypto_drbg_set_reseed_policy(0xaabbccdd, &policy);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    rc = ntru_crypto_drbg_instantiate(s_bits, NULL, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
+    rc = ntru_crypto_drbg_external_instantiate(
+            (RANDOM_BYTES_FN) &randombytes, &ext);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_set_reseed_policy(ext, &policy);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+    rc = ntru_crypto_drbg_uninstantiate(ext);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str,
-            HMAC_DRBG_MAX_PERS_STR_BYTES+1,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+0);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+    for(i=0; i<2; i++)
+    {
+        DRBG_TYPE type = i ? AES256_CTR_DRBG : SHA256_HMAC_DRBG;
 
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            NULL, handles+0);
+        /* Background reseeding needs a bulk entropy function */
+        rc = ntru_crypto_drbg_instantiate_ex(type, 256, NULL, 0,
+                (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        policy.background = TRUE;
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        policy.background = FALSE;
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        for (j = 0; j < 10; j++)
+        {
+            rc = ntru_crypto_drbg_generate(handle, 256, sizeof(out), out);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        }
+
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, NULL);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        /* Background reseeding on every budget, with and without a pool,
+         * then turned off and on again and left on at uninstantiation
+         */
+        rc = ntru_crypto_drbg_instantiate_bulk(type, 256, NULL, 0,
+                drbg_get_entropy_bulk, &handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        policy.max_bytes = 250;
+        policy.max_age_secs = 60;
+        policy.background = TRUE;
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        for (j = 0; j < 100; j++)
+        {
+            rc = ntru_crypto_drbg_generate(handle, 256, sizeof(out), out);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        }
+
+        rc = ntru_crypto_drbg_set_pool(handle, 64);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        for (j = 0; j < 100; j++)
+        {
+            rc = ntru_crypto_drbg_generate(handle, 256, 10, out);
+            ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        }
+
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, NULL);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(out), out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_set_reseed_policy(handle, &policy);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_generate(handle, 256, sizeof(out), out);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        memset(&policy, 0, sizeof(policy));
+        policy.max_requests = 3;
+    }
+}
+END_TEST
+
+START_TEST(test_api_drbg_additional_input)
+{
+    uint32_t rc;
+    uint32_t i;
+    DRBG_HANDLE handle;
+    DRBG_HANDLE ext;
+    uint8_t const addl[] = "session 1";
+    uint8_t out1[32];
+    uint8_t out2[32];
+
+    rc = ntru_crypto_drbg_external_instantiate(
+            (RANDOM_BYTES_FN) &randombytes, &ext);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Bad parameters */
+    rc = ntru_crypto_drbg_reseed_ex(0xaabbccdd, addl, sizeof(addl));
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, NULL);
+    rc = ntru_crypto_drbg_generate_ex(0xaabbccdd, 256, FALSE, addl,
+                                      sizeof(addl), sizeof(out1), out1);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    /* Bad entropy functions */
-    /* Error in init */
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_init, handles+0);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+    /* External drbgs support neither extension */
+    rc = ntru_crypto_drbg_reseed_ex(ext, addl, sizeof(addl));
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    /* Error in get_num */
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_get_num, handles+0);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+    rc = ntru_crypto_drbg_generate_ex(ext, 256, FALSE, addl, sizeof(addl),
+                                      sizeof(out1), out1);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    /* get_num reports that source is perfectly predictable */
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_num_eq_zero,
-            handles+0);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+    rc = ntru_crypto_drbg_generate_ex(ext, 256, TRUE, NULL, 0,
+                                      sizeof(out1), out1);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    /* Error in get_byte */
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy_err_get_byte, handles+0);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_ENTROPY_FAIL));
+    rc = ntru_crypto_drbg_generate_ex(ext, 256, FALSE, NULL, 0,
+                                      sizeof(out1), out1);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 
-    /* Instantiate as many HMAC DRBGs as we are allowed */
-    for(i=0; i<DRBG_MAX_INSTANTIATIONS; i++)
+    rc = ntru_crypto_drbg_uninstantiate(ext);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    for(i=0; i<2; i++)
     {
-        rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-                (ENTROPY_FN) drbg_sha256_hmac_get_entropy, handles+i);
+        rc = ntru_crypto_drbg_instantiate_ex(
+                i ? AES256_CTR_DRBG : SHA256_HMAC_DRBG, 256, NULL, 0,
+                (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &handle);
         ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
-    }
 
-    /* Check pairwise distinctness of handles */
-    for(i=0; i<DRBG_MAX_INSTANTIATIONS-1; i++)
-    {
-        for(j=i+1; j<DRBG_MAX_INSTANTIATIONS; j++)
-        {
-            ck_assert_uint_ne(handles[i], handles[j]);
-        }
+        rc = ntru_crypto_drbg_reseed_ex(handle, NULL, 1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        rc = ntru_crypto_drbg_reseed_ex(handle, addl,
+                                        DRBG_MAX_ADDITIONAL_INPUT_BYTES + 1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, FALSE, NULL, 1,
+                                          sizeof(out1), out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, FALSE, addl,
+                                          DRBG_MAX_ADDITIONAL_INPUT_BYTES + 1,
+                                          sizeof(out1), out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, FALSE, addl,
+                                          sizeof(addl), 0, out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, FALSE, addl,
+                                          sizeof(addl), sizeof(out1), NULL);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+        /* Reseed and generate with each extension, also past a pool */
+        rc = ntru_crypto_drbg_set_pool(handle, 256);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_reseed_ex(handle, addl, sizeof(addl));
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, FALSE, addl,
+                                          sizeof(addl), sizeof(out1), out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, TRUE, NULL, 0,
+                                          sizeof(out2), out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_ne(memcmp(out1, out2, sizeof(out1)), 0);
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, TRUE, addl,
+                                          sizeof(addl), sizeof(out1), out1);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_ne(memcmp(out1, out2, sizeof(out1)), 0);
+
+        rc = ntru_crypto_drbg_generate_ex(handle, 256, FALSE, NULL, 0,
+                                          sizeof(out2), out2);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_int_ne(memcmp(out1, out2, sizeof(out1)), 0);
+
+        rc = ntru_crypto_drbg_uninstantiate(handle);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
     }
+}
+END_TEST
 
-    /* Instantiate too many DRBGs */
-    rc = ntru_crypto_drbg_instantiate(s_bits, pers_str, pers_str_bytes,
-            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &extra);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_NOT_AVAILABLE));
+START_TEST(test_api_drbg_max_instantiations)
+{
+    uint32_t i;
+    uint32_t rc;
+    DRBG_HANDLE handles[2*DRBG_MAX_INSTANTIATIONS];
+    DRBG_HANDLE extra;
+    uint8_t pool[10];
 
-    /* drbg_generate input checks */
-    rc = ntru_crypto_drbg_generate(handles[0], s_bits, sizeof(pool), NULL);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+    /* Bad limits */
+    rc = ntru_crypto_drbg_set_max_instantiations(0);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
 
-    rc = ntru_crypto_drbg_generate(handles[0], s_bits, 0, pool);
+    rc = ntru_crypto_drbg_set_max_instantiations(
+            DRBG_MAX_INSTANTIATIONS_LIMIT+1);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
 
-    /* Use a DRBG */
-    rc = ntru_crypto_drbg_generate(handles[0], s_bits, sizeof(pool), pool);
+    /* Raise the limit and use it up */
+    rc = ntru_crypto_drbg_set_max_instantiations(2*DRBG_MAX_INSTANTIATIONS);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 
-    /* Use a second DRBG */
-    rc = ntru_crypto_drbg_generate(handles[1], s_bits, sizeof(pool2), pool2);
+    for(i=0; i<2*DRBG_MAX_INSTANTIATIONS; i++)
+    {
+        rc = ntru_crypto_drbg_external_instantiate(
+                (RANDOM_BYTES_FN) &randombytes, handles+i);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
+
+    rc = ntru_crypto_drbg_external_instantiate(
+            (RANDOM_BYTES_FN) &randombytes, &extra);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_NOT_AVAILABLE));
+
+    /* A reused slot must not revive the old handle */
+    rc = ntru_crypto_drbg_uninstantiate(handles[0]);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 
-    /* Hopefully those outputs are different (w/ prob 2^-80) */
-    ck_assert_int_ne(memcmp(pool, pool2, sizeof(pool)), 0);
+    rc = ntru_crypto_drbg_external_instantiate(
+            (RANDOM_BYTES_FN) &randombytes, &extra);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_uint_ne(extra, handles[0]);
 
-    /* Reseed an HMAC DRBG (should not fail) */
-    rc = ntru_crypto_drbg_reseed(handles[0]);
+    rc = ntru_crypto_drbg_generate(handles[0], 0, sizeof(pool), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_generate(extra, 0, sizeof(pool), pool);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    handles[0] = extra;
 
-    /* Try to get zero bytes */
-    rc = ntru_crypto_drbg_generate(handles[0], s_bits, 0, pool);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+    /* Lowering the limit leaves existing DRBGs alone */
+    rc = ntru_crypto_drbg_set_max_instantiations(DRBG_MAX_INSTANTIATIONS);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 
-    /* Request too high of a security level */
-    rc = ntru_crypto_drbg_generate(handles[0], 2*DRBG_MAX_SEC_STRENGTH_BITS,
+    rc = ntru_crypto_drbg_generate(handles[2*DRBG_MAX_INSTANTIATIONS-1], 0,
                                    sizeof(pool), pool);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
-
-    /* Request too many bytes */
-    rc = ntru_crypto_drbg_generate(handles[0], s_bits,
-                                   1+HMAC_DRBG_MAX_BYTES_PER_REQUEST, pool);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_LENGTH));
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 
-    /* Uninstantiate DRBGs */
-    for(i=0; i<DRBG_MAX_INSTANTIATIONS; i++)
+    for(i=0; i<2*DRBG_MAX_INSTANTIATIONS; i++)
     {
         rc = ntru_crypto_drbg_uninstantiate(handles[i]);
         ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
     }
+}
+END_TEST
 
-    /* Reseed a uninstantiated DRBG */
-    rc = ntru_crypto_drbg_reseed(handles[0]);
-    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+static void *
+drbg_thread_local_worker(void *arg)
+{
+    DRBG_HANDLE *handle = (DRBG_HANDLE *)arg;
+    uint8_t pool[10];
 
-    /* Double uninstantiate */
-    rc = ntru_crypto_drbg_uninstantiate(handles[0]);
+    if(ntru_crypto_drbg_external_thread_local(
+            (RANDOM_BYTES_FN) &randombytes, handle) != DRBG_OK)
+    {
+        *handle = 0;
+    }
+    else if(ntru_crypto_drbg_generate(*handle, 0, sizeof(pool), pool)
+                != DRBG_OK)
+    {
+        *handle = 0;
+    }
+
+    return NULL;
+}
+
+START_TEST(test_api_drbg_thread_local)
+{
+    uint32_t rc;
+    DRBG_HANDLE handle;
+    DRBG_HANDLE handle2;
+    DRBG_HANDLE thread_handle = 0;
+    pthread_t thread;
+    uint8_t pool[10];
+
+    /* Bad parameters */
+    rc = ntru_crypto_drbg_thread_local(256, NULL, 0,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, NULL);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    /* Use an uninstantiated DRBG */
-    rc = ntru_crypto_drbg_generate(handles[0], 0, 10, pool);
+    rc = ntru_crypto_drbg_external_thread_local(NULL, &handle);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
 
-    /* Use a DRBG that never existed */
-    handles[0] = 0xaabbccdd;
-    rc = ntru_crypto_drbg_generate(handles[0], 0, 10, pool);
+    /* Repeated calls on a thread return the same DRBG */
+    rc = ntru_crypto_drbg_thread_local(256, NULL, 0,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    rc = ntru_crypto_drbg_thread_local(256, NULL, 0,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &handle2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_uint_eq(handle, handle2);
+
+    rc = ntru_crypto_drbg_generate(handle, 256, sizeof(pool), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Each DRBG type has its own thread-local instance */
+    rc = ntru_crypto_drbg_external_thread_local(
+            (RANDOM_BYTES_FN) &randombytes, &handle2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_uint_ne(handle, handle2);
+
+    rc = ntru_crypto_drbg_uninstantiate(handle2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* A DRBG uninstantiated by hand is replaced on the next call */
+    rc = ntru_crypto_drbg_uninstantiate(handle);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    rc = ntru_crypto_drbg_thread_local(256, NULL, 0,
+            (ENTROPY_FN) drbg_sha256_hmac_get_entropy, &handle2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    ck_assert_uint_ne(handle, handle2);
+
+    rc = ntru_crypto_drbg_generate(handle2, 256, sizeof(pool), pool);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+
+    /* Another thread gets its own DRBG, released when the thread exits */
+    ck_assert_int_eq(pthread_create(&thread, NULL, drbg_thread_local_worker,
+                                    &thread_handle), 0);
+    ck_assert_int_eq(pthread_join(thread, NULL), 0);
+    ck_assert_uint_ne(thread_handle, 0);
+    ck_assert_uint_ne(thread_handle, handle2);
+
+    rc = ntru_crypto_drbg_generate(thread_handle, 0, sizeof(pool), pool);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    rc = ntru_crypto_drbg_uninstantiate(handle2);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
 }
 END_TEST
 
@@ -655,6 +2039,23 @@ START_TEST(test_api_drbg_external)
     handles[0] = 0xaabbccdd;
     rc = ntru_crypto_drbg_generate(handles[0], 0, 10, pool);
     ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_BAD_PARAMETER));
+
+    /* A stale handle never matches a new one, however often its slot is
+     * reused */
+    rc = ntru_crypto_drbg_external_instantiate(
+            (RANDOM_BYTES_FN) &randombytes, handles);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    rc = ntru_crypto_drbg_uninstantiate(handles[0]);
+    ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    for(i=0; i<0x10000; i++)
+    {
+        rc = ntru_crypto_drbg_external_instantiate(
+                (RANDOM_BYTES_FN) &randombytes, &extra);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+        ck_assert_uint_ne(extra, handles[0]);
+        rc = ntru_crypto_drbg_uninstantiate(extra);
+        ck_assert_uint_eq(rc, DRBG_RESULT(DRBG_OK));
+    }
 }
 END_TEST
 
@@ -681,12 +2082,29 @@ ntruencrypt_public_test_suite(void)
     /* Test publicly accessible DRBG routines */
     tc_api_drbg = tcase_create("drbg");
     tcase_add_test(tc_api_drbg, test_api_drbg_external);
+    tcase_add_test(tc_api_drbg, test_api_drbg_max_instantiations);
+    tcase_add_test(tc_api_drbg, test_api_drbg_thread_local);
     tcase_add_loop_test(tc_api_drbg, test_api_drbg_sha256_hmac, 0, 4);
+    tcase_add_loop_test(tc_api_drbg, test_api_drbg_aes256_ctr, 0, 4);
+    tcase_add_test(tc_api_drbg, test_api_drbg_pool);
+    tcase_add_test(tc_api_drbg, test_api_drbg_bulk_entropy);
+    tcase_add_test(tc_api_drbg, test_api_drbg_additional_input);
+    tcase_add_test(tc_api_drbg, test_api_drbg_reseed_policy);
 
     /* Test publicly accessible crypto routines for each parameter set */
     tc_api_crypto = tcase_create("crypto");
     tcase_add_unchecked_fixture(tc_api_crypto, test_drbg_setup, test_drbg_teardown);
     tcase_add_loop_test(tc_api_crypto, test_api_crypto, 0, NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_api_crypto, test_api_crypto_batch, 0,
+                        NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_api_crypto, test_api_crypto_pubkey_ctx, 0,
+                        NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_api_crypto, test_api_crypto_privkey_ctx, 0,
+                        NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_api_crypto, test_api_crypto_scratch, 0,
+                        NUM_PARAM_SETS);
+    tcase_add_loop_test(tc_api_crypto, test_api_crypto_kem, 0,
+                        NUM_PARAM_SETS);
 
     tc_api_misc = tcase_create("misc");
     tcase_add_test(tc_api_misc, test_get_param_set_name);
@@ -0,0 +1,304 @@
+/* Timing-leakage test for NTRU decryption, in the style of dudect
+ * (Reparaz, Balasch and Verbauwhede, "Dude, is my code constant time?").
+ *
+ * Decryption time is measured for two classes of ciphertext under a fixed
+ * key: class 0 holds valid encryptions of random messages of random length,
+ * class 1 holds random, almost always invalid, ciphertexts.  The classes are
+ * interleaved at random and compared with Welch's t-test, both on the raw
+ * measurements and on measurements cropped at a range of percentiles.  A
+ * |t| above 10 is treated as evidence of a timing leak.
+ *
+ * Usage: dudect_decrypt [param set index [no. of measurements]]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ntru_crypto.h"
+#include "ntru_crypto_drbg.h"
+#include "test_common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define MEASUREMENTS    100000
+#define POOL_SIZE       1000
+#define NUM_CROPS       100
+#define NUM_TESTS       (NUM_CROPS + 1)
+#define T_THRESHOLD     10.0
+
+/* Welch t-test context, updated online */
+
+typedef struct {
+    double mean[2];
+    double m2[2];
+    double n[2];
+} TTEST_CTX;
+
+static void
+ttest_push(TTEST_CTX *ctx, double x, int cls)
+{
+    double delta;
+
+    ctx->n[cls] += 1;
+    delta = x - ctx->mean[cls];
+    ctx->mean[cls] += delta / ctx->n[cls];
+    ctx->m2[cls] += delta * (x - ctx->mean[cls]);
+}
+
+static double
+ttest_compute(TTEST_CTX const *ctx)
+{
+    double var0, var1;
+
+    if (ctx->n[0] < 2 || ctx->n[1] < 2)
+    {
+        return 0;
+    }
+
+    var0 = ctx->m2[0] / (ctx->n[0] - 1);
+    var1 = ctx->m2[1] / (ctx->n[1] - 1);
+
+    if (var0 / ctx->n[0] + var1 / ctx->n[1] == 0)
+    {
+        return 0;
+    }
+
+    return (ctx->mean[0] - ctx->mean[1]) /
+           sqrt(var0 / ctx->n[0] + var1 / ctx->n[1]);
+}
+
+static uint64_t
+cpucycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static int
+cmp_u64(void const *a, void const *b)
+{
+    uint64_t x = *(uint64_t const *)a;
+    uint64_t y = *(uint64_t const *)b;
+
+    return (x > y) - (x < y);
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32_t set = 0;
+    uint32_t measurements = MEASUREMENTS;
+    NTRU_ENCRYPT_PARAM_SET_ID param_set_id;
+    DRBG_HANDLE drbg;
+    uint32_t rc;
+    uint16_t public_key_len;
+    uint16_t private_key_len;
+    uint16_t ct_len;
+    uint16_t max_msg_len;
+    uint16_t msg_len;
+    uint16_t pt_len;
+    uint8_t *public_key;
+    uint8_t *private_key;
+    uint8_t *cts;
+    uint8_t *msg;
+    uint8_t *pt;
+    uint8_t *cls;
+    uint64_t *times;
+    uint64_t *sorted;
+    uint64_t crops[NUM_CROPS];
+    uint64_t t0;
+    TTEST_CTX tests[NUM_TESTS];
+    uint32_t i, j, k;
+    uint32_t ok[2] = {0, 0};
+    double t, max_t = 0;
+    int max_k = 0;
+
+    if (argc > 1)
+    {
+        set = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    if (argc > 2)
+    {
+        measurements = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+
+    if (set >= NUM_PARAM_SETS || measurements < 1000)
+    {
+        fprintf(stderr, "usage: %s [param set index (< %u) "
+                "[no. of measurements (>= 1000)]]\n", argv[0],
+                (unsigned)NUM_PARAM_SETS);
+        return 2;
+    }
+
+    param_set_id = PARAM_SET_IDS[set];
+
+    rc = ntru_crypto_drbg_external_instantiate(
+                                    (RANDOM_BYTES_FN) &randombytes, &drbg);
+    if (rc != DRBG_OK)
+    {
+        fprintf(stderr, "Error: could not instantiate the DRBG\n");
+        return 2;
+    }
+
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id, &public_key_len,
+                                         NULL, &private_key_len, NULL);
+    if (rc != NTRU_OK)
+    {
+        fprintf(stderr, "Error: could not get the key lengths\n");
+        return 2;
+    }
+
+    public_key = (uint8_t *)malloc(public_key_len);
+    private_key = (uint8_t *)malloc(private_key_len);
+    rc = ntru_crypto_ntru_encrypt_keygen(drbg, param_set_id, &public_key_len,
+                                         public_key, &private_key_len,
+                                         private_key);
+    if (rc == NTRU_OK)
+    {
+        rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key, 0,
+                                      NULL, &ct_len, NULL);
+    }
+    if (rc == NTRU_OK)
+    {
+        rc = ntru_crypto_ntru_decrypt(private_key_len, private_key, 0, NULL,
+                                      &max_msg_len, NULL);
+    }
+    if (rc != NTRU_OK)
+    {
+        fprintf(stderr, "Error: could not set up the key\n");
+        return 2;
+    }
+
+    /* precompute the ciphertexts so that only decryption is timed */
+
+    cts = (uint8_t *)malloc((size_t)POOL_SIZE * ct_len);
+    cls = (uint8_t *)malloc(measurements);
+    msg = (uint8_t *)malloc(max_msg_len);
+    pt = (uint8_t *)malloc(max_msg_len);
+    times = (uint64_t *)malloc(measurements * sizeof(uint64_t));
+    sorted = (uint64_t *)malloc(measurements * sizeof(uint64_t));
+
+    for (i = 0; i < POOL_SIZE; i++)
+    {
+        uint8_t *ct = cts + (size_t)i * ct_len;
+
+        if (i & 1)
+        {
+            randombytes(ct, ct_len);
+        }
+        else
+        {
+            randombytes((uint8_t *)&msg_len, sizeof(msg_len));
+            msg_len %= max_msg_len + 1;
+            randombytes(msg, msg_len);
+            rc = ntru_crypto_ntru_encrypt(drbg, public_key_len, public_key,
+                                          msg_len, msg, &ct_len, ct);
+            if (rc != NTRU_OK)
+            {
+                fprintf(stderr, "Error: encryption failed\n");
+                return 2;
+            }
+        }
+    }
+
+    randombytes(cls, measurements);
+
+    /* measure; ciphertext i of the pool has class i & 1 */
+
+    for (i = 0; i < measurements; i++)
+    {
+        cls[i] &= 1;
+        randombytes((uint8_t *)&j, sizeof(j));
+        j = ((j % (POOL_SIZE / 2)) << 1) | cls[i];
+        pt_len = max_msg_len;
+
+        t0 = cpucycles();
+        rc = ntru_crypto_ntru_decrypt(private_key_len, private_key, ct_len,
+                                      cts + (size_t)j * ct_len, &pt_len, pt);
+        times[i] = cpucycles() - t0;
+
+        ok[cls[i]] += (rc == NTRU_OK);
+    }
+
+    /* discard the first tenth as warm-up, and set the crops from the rest */
+
+    k = measurements / 10;
+    memcpy(sorted, times + k, (measurements - k) * sizeof(uint64_t));
+    qsort(sorted, measurements - k, sizeof(uint64_t), cmp_u64);
+
+    for (i = 0; i < NUM_CROPS; i++)
+    {
+        double p = 1 - pow(0.5, 10.0 * (i + 1) / NUM_CROPS);
+
+        crops[i] = sorted[(size_t)(p * (measurements - k - 1))];
+    }
+
+    memset(tests, 0, sizeof(tests));
+    for (i = k; i < measurements; i++)
+    {
+        ttest_push(&tests[0], (double)times[i], cls[i]);
+
+        for (j = 0; j < NUM_CROPS; j++)
+        {
+            if (times[i] < crops[j])
+            {
+                ttest_push(&tests[j + 1], (double)times[i], cls[i]);
+            }
+        }
+    }
+
+    for (i = 0; i < NUM_TESTS; i++)
+    {
+        t = fabs(ttest_compute(&tests[i]));
+        if (t > max_t)
+        {
+            max_t = t;
+            max_k = (int)i;
+        }
+    }
+
+    printf("%s: %u measurements, class 0 mean %.0f (%u ok), "
+           "class 1 mean %.0f (%u ok)\n",
+           ntru_encrypt_get_param_set_name(param_set_id),
+           (unsigned)(measurements - k), tests[0].mean[0], (unsigned)ok[0],
+           tests[0].mean[1], (unsigned)ok[1]);
+    if (max_k)
+    {
+        printf("max |t| = %.2f (crop %d)\n", max_t, max_k - 1);
+    }
+    else
+    {
+        printf("max |t| = %.2f (uncropped)\n", max_t);
+    }
+
+    ntru_crypto_drbg_uninstantiate(drbg);
+    free(public_key);
+    free(private_key);
+    free(cts);
+    free(cls);
+    free(msg);
+    free(pt);
+    free(times);
+    free(sorted);
+
+    if (max_t > T_THRESHOLD)
+    {
+        printf("timing leak detected\n");
+        return 1;
+    }
+
+    printf("no timing leak detected\n");
+    return 0;
+}
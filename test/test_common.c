@@ -132,3 +132,28 @@ drbg_sha256_hmac_get_entropy_err_get_byte(
 
     return drbg_sha256_hmac_get_entropy(cmd, out);
 }
+
+uint8_t
+drbg_get_entropy_bulk(
+    uint8_t  *out,
+    uint32_t  num_bytes,
+    uint32_t  min_entropy_bits)
+{
+    /* treat this as a perfectly random source */
+    if (min_entropy_bits > 8 * num_bytes)
+        return 0;
+
+    return randombytes(out, num_bytes) == DRBG_OK;
+}
+
+uint8_t
+drbg_get_entropy_bulk_err(
+    uint8_t  *out,
+    uint32_t  num_bytes,
+    uint32_t  min_entropy_bits)
+{
+    (void)out;
+    (void)num_bytes;
+    (void)min_entropy_bits;
+    return 0;
+}
@@ -21,6 +21,15 @@ drbg_sha256_hmac_get_entropy_err_num_eq_zero(ENTROPY_CMD cmd, uint8_t *out);
 uint8_t
 drbg_sha256_hmac_get_entropy_err_get_byte(ENTROPY_CMD cmd, uint8_t *out);
 
+/* Bulk entropy functions */
+uint8_t
+drbg_get_entropy_bulk(uint8_t *out, uint32_t num_bytes,
+                      uint32_t min_entropy_bits);
+
+uint8_t
+drbg_get_entropy_bulk_err(uint8_t *out, uint32_t num_bytes,
+                          uint32_t min_entropy_bits);
+
 /* List of parameter sets */
 
 static const NTRU_ENCRYPT_PARAM_SET_ID PARAM_SET_IDS[] = {